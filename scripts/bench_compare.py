@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""
+bench_compare.py — Compare two swipetype-bench JSON result files.
+
+Usage:
+    python3 bench_compare.py baseline.json current.json [--threshold 0.10]
+
+Both files are Google Benchmark JSON output, as written by the
+swipetype-bench-json target (or swipetype-bench --benchmark_out=<file>
+--benchmark_out_format=json). For every benchmark present in both, prints
+the mean time and, where reported, the p50/p99 latency counters, with the
+relative change. With --benchmark_repetitions the per-run "mean" aggregate
+is compared instead of the individual runs.
+
+Exits with status 1 if any compared value is slower than the baseline by
+more than the threshold, so the script can gate a CI job.
+"""
+
+import argparse
+import json
+import sys
+
+# Conversion of Google Benchmark time units to nanoseconds
+TIME_UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+# Latency counters reported by BM_Recognize (microseconds)
+LATENCY_COUNTERS = ("p50_us", "p99_us")
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description="Compare two swipetype-bench JSON result files."
+    )
+    parser.add_argument("baseline", help="Results of the reference commit")
+    parser.add_argument("current", help="Results to check")
+    parser.add_argument(
+        "--threshold", type=float, default=0.10,
+        help="Relative slowdown reported as a regression (default: 0.10)"
+    )
+    return parser.parse_args()
+
+
+def load_results(path):
+    """Return {benchmark name: {metric: value}} for one result file."""
+    with open(path, "r", encoding="utf-8") as f:
+        data = json.load(f)
+
+    benchmarks = data.get("benchmarks", [])
+    has_means = any(b.get("aggregate_name") == "mean" for b in benchmarks)
+
+    results = {}
+    for b in benchmarks:
+        if has_means:
+            if b.get("aggregate_name") != "mean":
+                continue
+            name = b.get("run_name", b["name"])
+        else:
+            if b.get("run_type", "iteration") != "iteration":
+                continue
+            name = b["name"]
+        if b.get("error_occurred"):
+            continue
+
+        scale = TIME_UNIT_NS.get(b.get("time_unit", "ns"), 1.0)
+        metrics = {"time_ns": b["real_time"] * scale}
+        for counter in LATENCY_COUNTERS:
+            if counter in b:
+                metrics[counter] = b[counter]
+        results[name] = metrics
+    return results
+
+
+def format_value(metric, value):
+    if metric == "time_ns":
+        if value >= 1e6:
+            return f"{value / 1e6:.3f} ms"
+        if value >= 1e3:
+            return f"{value / 1e3:.3f} us"
+        return f"{value:.1f} ns"
+    return f"{value:.3f} us"
+
+
+def main():
+    args = parse_args()
+    baseline = load_results(args.baseline)
+    current = load_results(args.current)
+
+    regressions = []
+    print(f"{'Benchmark':<48} {'Metric':<8} {'Baseline':>12} {'Current':>12} {'Change':>8}")
+    for name in sorted(baseline.keys() & current.keys()):
+        for metric, base in baseline[name].items():
+            if metric not in current[name] or base <= 0:
+                continue
+            value = current[name][metric]
+            change = value / base - 1.0
+            flag = ""
+            if change > args.threshold:
+                flag = "  REGRESSION"
+                regressions.append((name, metric, change))
+            print(f"{name:<48} {metric:<8} {format_value(metric, base):>12} "
+                  f"{format_value(metric, value):>12} {change:>+7.1%}{flag}")
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<48} missing from {args.current}")
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:<48} new (no baseline)")
+
+    if regressions:
+        print(f"\n{len(regressions)} value(s) slower than baseline by more than "
+              f"{args.threshold:.0%}", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -13,6 +13,11 @@ Input format (TSV):
 
 One word per line. Frequency is a positive integer (higher = more common).
 Lines starting with # are comments. Empty lines are skipped.
+
+Output is format version 2: the version-1 header and records plus a record
+offset table, the (first letter, last letter, length) bucket index and a
+lookup hash table, so the loader can use a mapped file without parsing it.
+See docs/ARCHITECTURE.md for the layout.
 """
 
 import argparse
@@ -22,9 +27,13 @@ import os
 
 # Constants matching SwipeTypeTypes.h
 DICT_MAGIC = 0x474C4944  # "GLID"
-DICT_VERSION = 1
+DICT_VERSION = 2
 DICT_HEADER_SIZE = 32
+DICT_HEADER_V2_SIZE = 64
 MAX_WORD_LENGTH = 64
+DICT_BUCKET_LETTERS = 27
+DICT_BUCKET_COUNT = DICT_BUCKET_LETTERS * DICT_BUCKET_LETTERS
+DICT_HASH_EMPTY = 0xFFFFFFFF
 
 
 def parse_args():
@@ -116,8 +125,68 @@ def read_tsv(filepath):
     return entries
 
 
+def fold_byte(b):
+    """ASCII case folding used by the bucket index and lookup hash."""
+    return b + 32 if 0x41 <= b <= 0x5A else b
+
+
+def letter_class(b):
+    """Bucket letter class of a byte: 'a'-'z' -> 0-25, anything else -> 26."""
+    b = fold_byte(b)
+    return b - 0x61 if 0x61 <= b <= 0x7A else DICT_BUCKET_LETTERS - 1
+
+
+def hash_word(word_bytes):
+    """FNV-1a over the case-folded bytes. Must match DictionaryLoader.cpp."""
+    h = 2166136261
+    for b in word_bytes:
+        h ^= fold_byte(b)
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def build_bucket_index(words, frequencies):
+    """Return (bucket_offsets, bucket_order) for a list of encoded words.
+
+    Entry indices are ordered by (first letter, last letter, length), then
+    by frequency descending and entry order within each group, exactly like
+    the loader's DictionaryLoader::Impl::buildBucketIndex().
+    """
+    keyed = []
+    for index, word_bytes in enumerate(words):
+        if not word_bytes:
+            continue
+        bucket = letter_class(word_bytes[0]) * DICT_BUCKET_LETTERS + letter_class(word_bytes[-1])
+        keyed.append((bucket, len(word_bytes), -frequencies[index], index))
+    keyed.sort()
+
+    order = [index for _, _, _, index in keyed]
+    offsets = [0] * (DICT_BUCKET_COUNT + 1)
+    for bucket, _, _, _ in keyed:
+        offsets[bucket + 1] += 1
+    for b in range(DICT_BUCKET_COUNT):
+        offsets[b + 1] += offsets[b]
+    return offsets, order
+
+
+def build_hash_table(words):
+    """Open-addressing table (linear probing) of entry indices, load <= 1/2."""
+    size = 1
+    while size < 2 * len(words):
+        size <<= 1
+    slots = [DICT_HASH_EMPTY] * size
+    for index, word_bytes in enumerate(words):
+        if not word_bytes:
+            continue
+        slot = hash_word(word_bytes) & (size - 1)
+        while slots[slot] != DICT_HASH_EMPTY:
+            slot = (slot + 1) & (size - 1)
+        slots[slot] = index
+    return slots
+
+
 def write_glide(entries, output_path, language_tag, sorted_flag):
-    """Write entries to a binary .glide file."""
+    """Write entries to a binary .glide file (format version 2)."""
     lang_bytes = language_tag.encode("utf-8")
     if len(lang_bytes) > 18:
         print(f"ERROR: Language tag '{language_tag}' exceeds 18 bytes",
@@ -128,10 +197,34 @@ def write_glide(entries, output_path, language_tag, sorted_flag):
     hdr_flags = 0
     if sorted_flag:
         hdr_flags |= 0x01  # bit 0: sorted alphabetically
+    hdr_flags |= 0x02      # bit 1: buckets frequency-ordered
+
+    words = [word.encode("utf-8") for word, _, _ in entries]
+    bucket_offsets, bucket_order = build_bucket_index(
+        words, [frequency for _, frequency, _ in entries])
+    hash_slots = build_hash_table(words)
+    max_freq = max((freq for _, freq, _ in entries), default=0)
+
+    # Section layout: every table is a little-endian uint32 array, 4-aligned
+    offsets_at = DICT_HEADER_V2_SIZE
+    buckets_at = offsets_at + 4 * len(entries)
+    order_at = buckets_at + 4 * len(bucket_offsets)
+    hash_at = order_at + 4 * len(bucket_order)
+    records_at = hash_at + 4 * len(hash_slots)
+
+    # Records: wordLen(1) word(N) frequency(4) flags(1), same as version 1
+    records = bytearray()
+    record_offsets = []
+    for (word, frequency, entry_flags), word_bytes in zip(entries, words):
+        record_offsets.append(records_at + len(records))
+        records += struct.pack("<B", len(word_bytes))
+        records += word_bytes
+        records += struct.pack("<I", frequency)
+        records += struct.pack("<B", entry_flags)
 
     with open(output_path, "wb") as f:
-        # === Write header (32 bytes) ===
-        header = bytearray(DICT_HEADER_SIZE)
+        # === Write header (64 bytes) ===
+        header = bytearray(DICT_HEADER_V2_SIZE)
 
         # Magic (bytes 0-3)
         struct.pack_into("<I", header, 0, DICT_MAGIC)
@@ -143,25 +236,21 @@ def write_glide(entries, output_path, language_tag, sorted_flag):
         struct.pack_into("<I", header, 8, len(entries))
         # Language tag length (bytes 12-13)
         struct.pack_into("<H", header, 12, len(lang_bytes))
-        # Language tag (bytes 14+)
+        # Language tag (bytes 14+), zero-padded to byte 32
         header[14:14 + len(lang_bytes)] = lang_bytes
-        # Remaining bytes stay zero (padding to 32-byte boundary)
+        # Section directory (bytes 32-63)
+        struct.pack_into("<8I", header, 32,
+                         max_freq, offsets_at, buckets_at, order_at,
+                         hash_at, len(hash_slots), records_at, 0)
 
         f.write(header)
 
-        # === Write entries ===
-        for word, frequency, entry_flags in entries:
-            word_bytes = word.encode("utf-8")
-            word_len = len(word_bytes)
-
-            # Word length (1 byte)
-            f.write(struct.pack("<B", word_len))
-            # Word bytes (variable length)
-            f.write(word_bytes)
-            # Frequency (4 bytes, little-endian uint32)
-            f.write(struct.pack("<I", frequency))
-            # Flags (1 byte)
-            f.write(struct.pack("<B", entry_flags))
+        # === Write index sections ===
+        for table in (record_offsets, bucket_offsets, bucket_order, hash_slots):
+            f.write(struct.pack(f"<{len(table)}I", *table))
+
+        # === Write records ===
+        f.write(records)
 
 
 def main():
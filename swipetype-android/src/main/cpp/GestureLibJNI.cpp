@@ -1,9 +1,20 @@
 #include <jni.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
+#include <sys/stat.h>
 #include <android/log.h>
 
 #include "swipetype/GestureEngine.h"
+#include "swipetype/DictionaryStore.h"
 #include "swipetype/GesturePath.h"
 #include "swipetype/GestureCandidate.h"
 #include "swipetype/KeyboardLayout.h"
@@ -19,14 +30,247 @@
  * @brief JNI bridge between SwipeTypeEngine.java and swipetype-core C++ library.
  *
  * This file:
- * - Converts Java arrays to C++ data structures
- * - Manages GestureEngine lifetime via opaque handles (jlong pointers)
- * - Converts C++ results back to Java arrays/strings
+ * - Reads gesture points from, and writes candidates into, direct ByteBuffers
+ *   preallocated by SwipeTypeEngine.java (layouts below)
+ * - Converts Java layout arrays to C++ data structures
+ * - Manages GestureEngine lifetime via opaque handles (jlong NativeEngine pointers)
+ * - Shares one DictionaryStore between handles that load the same file
+ * - Runs asynchronous recognition on a dedicated worker thread (AsyncWorker)
  * - Handles all JNI exceptions to prevent native crashes from reaching Java
  *
- * Threading: All methods assume external synchronization (provided by
- * SwipeTypeEngine.java's synchronized blocks).
+ * Threading: Handle creation and destruction assume external synchronization
+ * (SwipeTypeEngine.java's synchronized blocks). Every call into the engine
+ * takes NativeEngine::mutex, so the worker thread and the Java-side calls
+ * (layout updates, trimming) never overlap. A layout update only holds it
+ * to start the rebuild, which runs on the engine's own background thread.
+ *
+ * Point buffer: POINT_BYTES (16) per point in native byte order, laid out
+ * like swipetype::GesturePoint: float x, float y, int64 timestamp.
+ *
+ * Result buffer: int32 count (-1 = error), then per candidate float32
+ * confidence, int32 sourceFlags, int32 byteLength and byteLength bytes of
+ * UTF-8, unpadded, in native byte order. RESULT_BUFFER_BYTES always holds
+ * MAX_MAX_CANDIDATES words of MAX_WORD_LENGTH bytes.
+ */
+
+static constexpr size_t POINT_BYTES = 16;
+static constexpr size_t RESULT_HEADER_BYTES = 4;
+static constexpr size_t RESULT_ENTRY_BYTES = 12;  // before the word bytes
+static constexpr size_t RESULT_BUFFER_BYTES = RESULT_HEADER_BYTES +
+    swipetype::MAX_MAX_CANDIDATES * (RESULT_ENTRY_BYTES + swipetype::MAX_WORD_LENGTH);
+
+static_assert(sizeof(swipetype::GesturePoint) == POINT_BYTES &&
+              offsetof(swipetype::GesturePoint, x) == 0 &&
+              offsetof(swipetype::GesturePoint, y) == 4 &&
+              offsetof(swipetype::GesturePoint, timestamp) == 8,
+              "point buffer layout must match GesturePoint");
+
+/**
+ * Points of a direct point buffer, or nullptr if it is not direct or holds
+ * fewer than count points.
+ */
+static const uint8_t* pointBytes(JNIEnv* env, jobject buffer, jint count) {
+    if (buffer == nullptr || count < 0) return nullptr;
+    auto* bytes = static_cast<const uint8_t*>(env->GetDirectBufferAddress(buffer));
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (bytes == nullptr || capacity < static_cast<jlong>(count) * static_cast<jlong>(POINT_BYTES)) {
+        return nullptr;
+    }
+    return bytes;
+}
+
+/** The points at bytes as GesturePoints, copied into raw. */
+static void copyPoints(const uint8_t* bytes, jint count, swipetype::RawGesturePath& raw) {
+    raw.points.resize(static_cast<size_t>(count));
+    if (count > 0) std::memcpy(raw.points.data(), bytes, static_cast<size_t>(count) * POINT_BYTES);
+}
+
+/**
+ * Write candidates (or an error, if count < 0) into a result buffer of
+ * capacity bytes. Stops early rather than overrun it.
+ *
+ * @return Number of candidates written.
  */
+static jint writeResults(uint8_t* out, size_t capacity,
+                         const std::vector<swipetype::GestureCandidate>& candidates,
+                         int count) {
+    if (out == nullptr || capacity < RESULT_HEADER_BYTES) return -1;
+    size_t pos = RESULT_HEADER_BYTES;
+    int32_t written = 0;
+    for (int i = 0; i < count; ++i) {
+        const swipetype::GestureCandidate& c = candidates[static_cast<size_t>(i)];
+        const auto length = static_cast<int32_t>(c.word.size());
+        if (pos + RESULT_ENTRY_BYTES + c.word.size() > capacity) break;
+        const float confidence = c.confidence;
+        const auto flags = static_cast<int32_t>(c.sourceFlags);
+        std::memcpy(out + pos, &confidence, 4);
+        std::memcpy(out + pos + 4, &flags, 4);
+        std::memcpy(out + pos + 8, &length, 4);
+        std::memcpy(out + pos + RESULT_ENTRY_BYTES, c.word.data(), c.word.size());
+        pos += RESULT_ENTRY_BYTES + c.word.size();
+        ++written;
+    }
+    const int32_t header = count < 0 ? -1 : written;
+    std::memcpy(out, &header, 4);
+    return header;
+}
+
+// ============================================================================
+// Native Engine Context
+// ============================================================================
+
+class AsyncWorker;
+
+/** What a jlong handle points to. */
+struct NativeEngine {
+    swipetype::GestureEngine engine;
+    std::mutex mutex;                  // held for every call into engine
+    swipetype::RawGesturePath raw;     // nativeRecognize() points; guarded by mutex
+    AsyncWorker* worker = nullptr;     // async recognition, or nullptr
+};
+
+/** One gesture submitted for asynchronous recognition. */
+struct AsyncRequest {
+    jlong id = 0;
+    swipetype::RawGesturePath raw;
+    int maxCandidates = swipetype::DEFAULT_MAX_CANDIDATES;
+};
+
+/**
+ * Dedicated recognition thread of one NativeEngine.
+ *
+ * The request queue is bounded at one pending gesture: submitting replaces
+ * a gesture that has not started yet, and marks the one being recognized
+ * stale so its result is dropped instead of delivered. Results are written
+ * into the worker's own result buffer, then SwipeTypeEngine.onNativeCandidates()
+ * reads them on the worker thread.
+ */
+class AsyncWorker {
+public:
+    AsyncWorker(JavaVM* vm, jobject listener, jobject results, uint8_t* resultBytes,
+                size_t resultCapacity, jmethodID onCandidates, NativeEngine& owner)
+        : vm_(vm), listener_(listener), results_(results), resultBytes_(resultBytes),
+          resultCapacity_(resultCapacity), onCandidates_(onCandidates), owner_(owner),
+          thread_(&AsyncWorker::run, this) {}
+
+    ~AsyncWorker() { stop(); }
+
+    AsyncWorker(const AsyncWorker&) = delete;
+    AsyncWorker& operator=(const AsyncWorker&) = delete;
+
+    /** Queue a gesture, cancelling every earlier one. */
+    void submit(AsyncRequest&& request) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        latest_.store(request.id, std::memory_order_relaxed);
+        pending_ = std::move(request);
+        hasPending_ = true;
+        wake_.notify_one();
+    }
+
+    /** Drop the results of every gesture up to and including id. */
+    void cancel(jlong id) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (hasPending_ && pending_.id <= id) hasPending_ = false;
+        cancelled_.store(id, std::memory_order_relaxed);
+    }
+
+    /** Finish the gesture in progress (its result is dropped) and join.
+     *  Must not be called from the worker thread. */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            stopping_ = true;
+            hasPending_ = false;
+            wake_.notify_one();
+        }
+        if (thread_.joinable()) thread_.join();
+    }
+
+    /** The SwipeTypeEngine and result buffer global references; valid until
+     *  the worker is deleted. */
+    jobject listener() const { return listener_; }
+    jobject results() const { return results_; }
+
+private:
+    /** True if a newer gesture or a cancel superseded id. queueMutex_ held. */
+    bool isStale(jlong id) const {
+        return stopping_ || id != latest_.load(std::memory_order_relaxed) ||
+               id <= cancelled_.load(std::memory_order_relaxed);
+    }
+
+    void run() {
+        JNIEnv* env = nullptr;
+        if (vm_->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+            LOGE("AsyncWorker: failed to attach thread");
+            return;
+        }
+        AsyncRequest request;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(queueMutex_);
+                wake_.wait(lock, [this] { return stopping_ || hasPending_; });
+                if (stopping_) break;
+                request = std::move(pending_);
+                hasPending_ = false;
+            }
+            recognize(env, request);
+        }
+        vm_->DetachCurrentThread();
+    }
+
+    void recognize(JNIEnv* env, const AsyncRequest& request) {
+        std::vector<swipetype::GestureCandidate> candidates;
+        bool ok = true;
+        try {
+            std::lock_guard<std::mutex> lock(owner_.mutex);
+            candidates = owner_.engine.recognize(request.raw, request.maxCandidates);
+        } catch (...) {
+            LOGE("Exception in asynchronous recognition");
+            ok = false;
+        }
+
+        {
+            // A gesture submitted after this check is caught in Java
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (isStale(request.id)) return;
+        }
+        jint count = writeResults(resultBytes_, resultCapacity_, candidates,
+                                  ok ? static_cast<int>(candidates.size()) : -1);
+        env->CallVoidMethod(listener_, onCandidates_, request.id, count);
+        if (env->ExceptionCheck()) {
+            LOGE("Exception in onNativeCandidates");
+            env->ExceptionClear();
+        }
+    }
+
+    JavaVM* vm_;
+    jobject listener_;
+    jobject results_;            // keeps resultBytes_ alive
+    uint8_t* resultBytes_;       // written and read on the worker thread only
+    size_t resultCapacity_;
+    jmethodID onCandidates_;
+    NativeEngine& owner_;
+
+    std::mutex queueMutex_;
+    std::condition_variable wake_;
+    AsyncRequest pending_;
+    bool hasPending_ = false;
+    bool stopping_ = false;
+    std::atomic<jlong> latest_{0};
+    std::atomic<jlong> cancelled_{0};
+
+    std::thread thread_;  // last: starts once the members above exist
+};
+
+/** Stop and delete the worker of native, releasing its listener reference. */
+static void stopWorker(JNIEnv* env, NativeEngine* native) {
+    if (native->worker == nullptr) return;
+    native->worker->stop();
+    env->DeleteGlobalRef(native->worker->listener());
+    env->DeleteGlobalRef(native->worker->results());
+    delete native->worker;
+    native->worker = nullptr;
+}
 
 // ============================================================================
 // Helper Functions
@@ -90,6 +334,52 @@ static swipetype::KeyboardLayout buildLayout(
     return layout;
 }
 
+/**
+ * The DictionaryStore of a dictionary file, shared by every handle that
+ * loads it (e.g. the IME and a floating keyboard). A store is reused while
+ * any engine holds it and the file's size and modification time are
+ * unchanged; loadDictionary() rewriting the file gets a fresh one.
+ */
+static std::shared_ptr<const swipetype::DictionaryStore> sharedStore(
+        const std::string& path, swipetype::ErrorInfo& error) {
+    struct Entry {
+        std::weak_ptr<const swipetype::DictionaryStore> store;
+        off_t size = 0;
+        time_t mtime = 0;
+    };
+    static std::mutex storesMutex;
+    static std::map<std::string, Entry> stores;
+
+    struct stat st {};
+    const bool exists = ::stat(path.c_str(), &st) == 0;
+
+    std::lock_guard<std::mutex> lock(storesMutex);
+    Entry& entry = stores[path];
+    if (exists && entry.size == st.st_size && entry.mtime == st.st_mtime) {
+        if (auto store = entry.store.lock()) return store;
+    }
+    auto store = std::make_shared<swipetype::DictionaryStore>();
+    if (!store->load(path)) {
+        error = store->getLastError();
+        stores.erase(path);
+        return nullptr;
+    }
+    entry.store = store;
+    entry.size = exists ? st.st_size : 0;
+    entry.mtime = exists ? st.st_mtime : 0;
+    return store;
+}
+
+/** Set the warm-up of a new engine before it is initialized. */
+static void configureWarmup(swipetype::GestureEngine& engine, jint level, jint wordsPerBucket) {
+    swipetype::ScoringConfig config;
+    config.warmup = static_cast<swipetype::WarmupLevel>(
+        std::max(0, std::min(static_cast<int>(level),
+                             static_cast<int>(swipetype::WarmupLevel::FULL))));
+    config.warmupWordsPerBucket = static_cast<int>(wordsPerBucket);
+    engine.configure(config);
+}
+
 // ============================================================================
 // JNI Method Implementations
 // ============================================================================
@@ -98,8 +388,11 @@ extern "C" {
 
 /**
  * Initialize the native engine with layout and dictionary file path.
+ * Handles created from the same unchanged file share its dictionary store.
+ * warmupLevel (a WarmupLevel) and warmupWordsPerBucket set the background
+ * warm-up started by the engine; init does not wait for it.
  *
- * @return Native handle (cast GestureEngine* to jlong), or 0 on failure.
+ * @return Native handle (cast NativeEngine* to jlong), or 0 on failure.
  */
 JNIEXPORT jlong JNICALL
 Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInit(
@@ -108,7 +401,8 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInit(
         jfloatArray keyWidths, jfloatArray keyHeights,
         jintArray keyCodePoints, jint keyCount,
         jfloat layoutWidth, jfloat layoutHeight,
-        jstring languageTag, jstring dictPath) {
+        jstring languageTag, jstring dictPath,
+        jint warmupLevel, jint warmupWordsPerBucket) {
 
     try {
         swipetype::KeyboardLayout layout = buildLayout(
@@ -119,16 +413,24 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInit(
         std::string dictPathStr(pathStr ? pathStr : "");
         if (pathStr) env->ReleaseStringUTFChars(dictPath, pathStr);
 
-        auto* engine = new swipetype::GestureEngine();
-        if (!engine->init(layout, dictPathStr)) {
+        swipetype::ErrorInfo error;
+        auto store = sharedStore(dictPathStr, error);
+        if (!store) {
+            LOGE("Failed to load dictionary: %s", error.message.c_str());
+            return 0;
+        }
+
+        auto* native = new NativeEngine();
+        configureWarmup(native->engine, warmupLevel, warmupWordsPerBucket);
+        if (!native->engine.initWithStore(layout, std::move(store))) {
             LOGE("Failed to initialize engine: %s",
-                 engine->getLastError().message.c_str());
-            delete engine;
+                 native->engine.getLastError().message.c_str());
+            delete native;
             return 0;
         }
 
         LOGI("Engine initialized with dictionary: %s", dictPathStr.c_str());
-        return reinterpret_cast<jlong>(engine);
+        return reinterpret_cast<jlong>(native);
     } catch (...) {
         LOGE("Exception in nativeInit");
         return 0;
@@ -136,7 +438,8 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInit(
 }
 
 /**
- * Initialize with dictionary data from memory (byte array).
+ * Initialize with dictionary data from memory (byte array). Warm-up
+ * arguments as for nativeInit.
  */
 JNIEXPORT jlong JNICALL
 Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInitWithData(
@@ -145,7 +448,8 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInitWithData(
         jfloatArray keyWidths, jfloatArray keyHeights,
         jintArray keyCodePoints, jint keyCount,
         jfloat layoutWidth, jfloat layoutHeight,
-        jstring languageTag, jbyteArray dictData) {
+        jstring languageTag, jbyteArray dictData,
+        jint warmupLevel, jint warmupWordsPerBucket) {
 
     try {
         swipetype::KeyboardLayout layout = buildLayout(
@@ -155,8 +459,9 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInitWithData(
         jsize dataSize = env->GetArrayLength(dictData);
         jbyte* dataPtr = env->GetByteArrayElements(dictData, nullptr);
 
-        auto* engine = new swipetype::GestureEngine();
-        bool ok = engine->initWithData(layout,
+        auto* native = new NativeEngine();
+        configureWarmup(native->engine, warmupLevel, warmupWordsPerBucket);
+        bool ok = native->engine.initWithData(layout,
             reinterpret_cast<const uint8_t*>(dataPtr),
             static_cast<size_t>(dataSize));
 
@@ -164,13 +469,13 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInitWithData(
 
         if (!ok) {
             LOGE("Failed to initialize engine from memory: %s",
-                 engine->getLastError().message.c_str());
-            delete engine;
+                 native->engine.getLastError().message.c_str());
+            delete native;
             return 0;
         }
 
         LOGI("Engine initialized from memory (%d bytes)", (int)dataSize);
-        return reinterpret_cast<jlong>(engine);
+        return reinterpret_cast<jlong>(native);
     } catch (...) {
         LOGE("Exception in nativeInitWithData");
         return 0;
@@ -178,80 +483,140 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeInitWithData(
 }
 
 /**
- * Recognize a gesture path and write results to output arrays.
+ * Recognize the points of a point buffer and write the candidates into a
+ * result buffer (see the layouts above). The points are copied into the
+ * engine's reused RawGesturePath and recognized in one call; the streaming
+ * API would rank again on touch-up.
  *
  * @return Number of candidates written, or -1 on error.
  */
 JNIEXPORT jint JNICALL
 Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeRecognize(
         JNIEnv* env, jclass /*clazz*/,
-        jlong handle,
-        jfloatArray xCoords, jfloatArray yCoords, jlongArray timestamps,
-        jint pointCount, jint maxCandidates,
-        jobjectArray outWords, jfloatArray outScores, jintArray outFlags) {
+        jlong handle, jobject points, jint pointCount, jint maxCandidates,
+        jobject results) {
 
     try {
-        auto* engine = reinterpret_cast<swipetype::GestureEngine*>(handle);
-        if (engine == nullptr) return -1;
-
-        // Build raw path from JNI arrays
-        jfloat* xArr = env->GetFloatArrayElements(xCoords, nullptr);
-        jfloat* yArr = env->GetFloatArrayElements(yCoords, nullptr);
-        jlong*  tArr = env->GetLongArrayElements(timestamps, nullptr);
-
-        swipetype::RawGesturePath raw;
-        raw.points.reserve(pointCount);
-        if (xArr && yArr && tArr) {
-            for (jint i = 0; i < pointCount; ++i) {
-                raw.points.emplace_back(xArr[i], yArr[i], static_cast<int64_t>(tArr[i]));
-            }
+        auto* native = reinterpret_cast<NativeEngine*>(handle);
+        if (native == nullptr) return -1;
+        const uint8_t* bytes = pointBytes(env, points, pointCount);
+        auto* out = static_cast<uint8_t*>(env->GetDirectBufferAddress(results));
+        jlong capacity = env->GetDirectBufferCapacity(results);
+        if (bytes == nullptr || out == nullptr || capacity < 0) return -1;
+
+        std::vector<swipetype::GestureCandidate> candidates;
+        {
+            std::lock_guard<std::mutex> lock(native->mutex);
+            copyPoints(bytes, pointCount, native->raw);
+            candidates = native->engine.recognize(native->raw, maxCandidates);
         }
+        int count = static_cast<int>(
+            std::min(candidates.size(), static_cast<size_t>(std::max(0, maxCandidates))));
+        return writeResults(out, static_cast<size_t>(capacity), candidates, count);
+    } catch (...) {
+        LOGE("Exception in nativeRecognize");
+        return -1;
+    }
+}
 
-        if (xArr) env->ReleaseFloatArrayElements(xCoords,    xArr, JNI_ABORT);
-        if (yArr) env->ReleaseFloatArrayElements(yCoords,    yArr, JNI_ABORT);
-        if (tArr) env->ReleaseLongArrayElements(timestamps,  tArr, JNI_ABORT);
+/**
+ * Start the asynchronous recognition thread of an engine.
+ *
+ * @param listener  SwipeTypeEngine receiving onNativeCandidates() calls.
+ * @param results   Direct result buffer the worker writes into; read by
+ *                  onNativeCandidates() only.
+ * @return false if the thread could not be started.
+ */
+JNIEXPORT jboolean JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeStartWorker(
+        JNIEnv* env, jclass clazz, jlong handle, jobject listener, jobject results) {
 
-        // Recognize
-        auto candidates = engine->recognize(raw, maxCandidates);
-        int count = static_cast<int>(
-            std::min(candidates.size(), static_cast<size_t>(maxCandidates)));
-
-        // Debug: log all candidates with scores
-        LOGD("recognize: %d pts -> %d candidates", (int)pointCount, count);
-        for (int i = 0; i < count; ++i) {
-            LOGD("  #%d %-12s  conf=%.4f  dtw=%.4f  freq=%.4f",
-                 i + 1,
-                 candidates[i].word.c_str(),
-                 candidates[i].confidence,
-                 candidates[i].dtwScore,
-                 candidates[i].frequencyScore);
+    try {
+        auto* native = reinterpret_cast<NativeEngine*>(handle);
+        if (native == nullptr || listener == nullptr || results == nullptr) return JNI_FALSE;
+        if (native->worker != nullptr) return JNI_TRUE;
+
+        auto* resultBytes = static_cast<uint8_t*>(env->GetDirectBufferAddress(results));
+        jlong resultCapacity = env->GetDirectBufferCapacity(results);
+        if (resultBytes == nullptr || resultCapacity < static_cast<jlong>(RESULT_BUFFER_BYTES)) {
+            LOGE("nativeStartWorker: result buffer too small");
+            return JNI_FALSE;
         }
 
-        // Write results back to Java arrays
-        jfloat* scoreArr = env->GetFloatArrayElements(outScores, nullptr);
-        jint*   flagArr  = env->GetIntArrayElements(outFlags, nullptr);
+        JavaVM* vm = nullptr;
+        if (env->GetJavaVM(&vm) != JNI_OK) return JNI_FALSE;
+        jmethodID onCandidates = env->GetMethodID(
+            clazz, "onNativeCandidates", "(JI)V");
+        if (onCandidates == nullptr) {
+            env->ExceptionClear();
+            LOGE("onNativeCandidates not found");
+            return JNI_FALSE;
+        }
 
-        for (int i = 0; i < count; ++i) {
-            jstring word = env->NewStringUTF(candidates[i].word.c_str());
-            env->SetObjectArrayElement(outWords, i, word);
-            env->DeleteLocalRef(word);
+        native->worker = new AsyncWorker(vm, env->NewGlobalRef(listener),
+                                         env->NewGlobalRef(results), resultBytes,
+                                         static_cast<size_t>(resultCapacity),
+                                         onCandidates, *native);
+        LOGI("Async recognition thread started");
+        return JNI_TRUE;
+    } catch (...) {
+        LOGE("Exception in nativeStartWorker");
+        return JNI_FALSE;
+    }
+}
 
-            if (scoreArr) scoreArr[i] = candidates[i].confidence;
-            if (flagArr)  flagArr[i]  = static_cast<jint>(candidates[i].sourceFlags);
-        }
+/**
+ * Stop the asynchronous recognition thread, dropping pending results.
+ */
+JNIEXPORT void JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeStopWorker(
+        JNIEnv* env, jclass /*clazz*/, jlong handle) {
+    auto* native = reinterpret_cast<NativeEngine*>(handle);
+    if (native != nullptr) stopWorker(env, native);
+}
 
-        if (scoreArr) env->ReleaseFloatArrayElements(outScores, scoreArr, 0);
-        if (flagArr)  env->ReleaseIntArrayElements(outFlags,   flagArr,  0);
+/**
+ * Queue the points of a point buffer for the worker thread, cancelling
+ * earlier gestures. The points are copied, so Java may reuse the buffer.
+ *
+ * @return false if no worker is running or the buffer is unusable.
+ */
+JNIEXPORT jboolean JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeSubmitGesture(
+        JNIEnv* env, jclass /*clazz*/,
+        jlong handle, jlong requestId, jobject points, jint pointCount, jint maxCandidates) {
 
-        return count;
+    try {
+        auto* native = reinterpret_cast<NativeEngine*>(handle);
+        if (native == nullptr || native->worker == nullptr) return JNI_FALSE;
+        const uint8_t* bytes = pointBytes(env, points, pointCount);
+        if (bytes == nullptr) return JNI_FALSE;
+
+        AsyncRequest request;
+        request.id = requestId;
+        copyPoints(bytes, pointCount, request.raw);
+        request.maxCandidates = maxCandidates;
+        native->worker->submit(std::move(request));
+        return JNI_TRUE;
     } catch (...) {
-        LOGE("Exception in nativeRecognize");
-        return -1;
+        LOGE("Exception in nativeSubmitGesture");
+        return JNI_FALSE;
     }
 }
 
 /**
- * Update keyboard layout without reloading dictionary.
+ * Drop the results of every gesture submitted up to requestId.
+ */
+JNIEXPORT void JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeCancelGestures(
+        JNIEnv* /*env*/, jclass /*clazz*/, jlong handle, jlong requestId) {
+    auto* native = reinterpret_cast<NativeEngine*>(handle);
+    if (native != nullptr && native->worker != nullptr) native->worker->cancel(requestId);
+}
+
+/**
+ * Update keyboard layout without reloading dictionary. The new layout is
+ * indexed in the background; gestures recognized meanwhile use the old one.
  */
 JNIEXPORT jboolean JNICALL
 Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeUpdateLayout(
@@ -263,14 +628,18 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeUpdateLayout(
         jfloat layoutWidth, jfloat layoutHeight) {
 
     try {
-        auto* engine = reinterpret_cast<swipetype::GestureEngine*>(handle);
-        if (engine == nullptr) return JNI_FALSE;
+        auto* native = reinterpret_cast<NativeEngine*>(handle);
+        if (native == nullptr) return JNI_FALSE;
 
         swipetype::KeyboardLayout layout = buildLayout(
             env, keyPositionsX, keyPositionsY, keyWidths, keyHeights,
             keyCodePoints, keyCount, layoutWidth, layoutHeight, nullptr);
 
-        return engine->updateLayout(layout) ? JNI_TRUE : JNI_FALSE;
+        std::lock_guard<std::mutex> lock(native->mutex);
+        auto done = [](bool swapped, const swipetype::ErrorInfo& error) {
+            if (!swapped) LOGE("Layout update failed: %s", error.message.c_str());
+        };
+        return native->engine.updateLayoutAsync(layout, done) ? JNI_TRUE : JNI_FALSE;
     } catch (...) {
         LOGE("Exception in nativeUpdateLayout");
         return JNI_FALSE;
@@ -278,28 +647,74 @@ Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeUpdateLayout(
 }
 
 /**
- * Shut down the engine and free resources.
+ * Release rebuildable memory (see GestureEngine::trimMemory()).
+ * level: 0 = moderate, 1 = complete.
+ */
+JNIEXPORT void JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeTrimMemory(
+        JNIEnv* /*env*/, jclass /*clazz*/, jlong handle, jint level) {
+    try {
+        auto* native = reinterpret_cast<NativeEngine*>(handle);
+        if (native == nullptr) return;
+        std::lock_guard<std::mutex> lock(native->mutex);
+        native->engine.trimMemory(level > 0 ? swipetype::MemoryTrimLevel::COMPLETE
+                                            : swipetype::MemoryTrimLevel::MODERATE);
+    } catch (...) {
+        LOGE("Exception in nativeTrimMemory");
+    }
+}
+
+/**
+ * Shut down the engine and free resources, stopping its worker thread first.
  */
 JNIEXPORT void JNICALL
 Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeShutdown(
-        JNIEnv* /*env*/, jclass /*clazz*/, jlong handle) {
-    auto* engine = reinterpret_cast<swipetype::GestureEngine*>(handle);
-    if (engine != nullptr) {
-        engine->shutdown();
-        delete engine;
+        JNIEnv* env, jclass /*clazz*/, jlong handle) {
+    auto* native = reinterpret_cast<NativeEngine*>(handle);
+    if (native != nullptr) {
+        stopWorker(env, native);
+        native->engine.shutdown();
+        delete native;
         LOGI("Native engine shut down");
     }
 }
 
+/**
+ * Write the warm-up progress into out: state (a WarmupState), words done,
+ * words total. Reads counters only, so it does not wait for a recognition.
+ */
+JNIEXPORT void JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeGetWarmupProgress(
+        JNIEnv* env, jclass /*clazz*/, jlong handle, jintArray out) {
+    auto* native = reinterpret_cast<NativeEngine*>(handle);
+    if (native == nullptr || out == nullptr || env->GetArrayLength(out) < 3) return;
+    swipetype::WarmupProgress progress = native->engine.getWarmupProgress();
+    const jint values[3] = {static_cast<jint>(progress.state),
+                            static_cast<jint>(progress.wordsDone),
+                            static_cast<jint>(progress.wordsTotal)};
+    env->SetIntArrayRegion(out, 0, 3, values);
+}
+
+/**
+ * Stop the warm-up early; returns without waiting for it.
+ */
+JNIEXPORT void JNICALL
+Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeCancelWarmup(
+        JNIEnv* /*env*/, jclass /*clazz*/, jlong handle) {
+    auto* native = reinterpret_cast<NativeEngine*>(handle);
+    if (native != nullptr) native->engine.cancelWarmup();
+}
+
 /**
  * Check if engine is initialized.
  */
 JNIEXPORT jboolean JNICALL
 Java_dev_dettmer_swipetype_android_SwipeTypeEngine_nativeIsInitialized(
         JNIEnv* /*env*/, jclass /*clazz*/, jlong handle) {
-    auto* engine = reinterpret_cast<swipetype::GestureEngine*>(handle);
-    if (engine == nullptr) return JNI_FALSE;
-    return engine->isInitialized() ? JNI_TRUE : JNI_FALSE;
+    auto* native = reinterpret_cast<NativeEngine*>(handle);
+    if (native == nullptr) return JNI_FALSE;
+    std::lock_guard<std::mutex> lock(native->mutex);
+    return native->engine.isInitialized() ? JNI_TRUE : JNI_FALSE;
 }
 
 // ============================================================================
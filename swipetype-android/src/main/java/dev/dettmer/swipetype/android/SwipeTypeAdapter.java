@@ -11,8 +11,9 @@ import java.util.List;
  * the generic swipetype API.</p>
  *
  * <p>Thread safety: All callbacks are invoked on the thread that called
- * {@link SwipeTypeEngine#processGesture}. Implementations must be prepared for
- * calls from any thread.</p>
+ * {@link SwipeTypeEngine#processGesture} or {@link SwipeTypeEngine#endGesture}, or, after
+ * {@link SwipeTypeEngine#setResultLooper}, recognition results and errors on
+ * that Looper. Implementations must be prepared for calls from any thread.</p>
  *
  * <p>Lifecycle: The adapter is passed to {@link SwipeTypeEngine#init} and retained
  * for the lifetime of the engine. The adapter must outlive the engine.</p>
@@ -1,12 +1,18 @@
 package dev.dettmer.swipetype.android;
 
+import android.content.ComponentCallbacks2;
 import android.content.Context;
+import android.os.Handler;
+import android.os.Looper;
 import android.util.Log;
 
 import java.io.File;
 import java.io.InputStream;
 import java.io.FileOutputStream;
 import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
 import java.util.ArrayList;
 import java.util.List;
 
@@ -21,6 +27,7 @@ import java.util.List;
  * <pre>{@code
  * SwipeTypeEngine engine = new SwipeTypeEngine();
  * engine.init(context, myAdapter);
+ * engine.setWarmup(SwipeTypeEngine.WARMUP_FREQUENT, 4);  // optional
  * engine.loadDictionary("en-US", dictInputStream);
  *
  * // When user swipes:
@@ -28,13 +35,21 @@ import java.util.List;
  * engine.processGesture(points);
  * // Results delivered via adapter.onCandidatesReady()
  *
+ * // Or append points as the touch events arrive:
+ * engine.beginGesture();
+ * engine.addGesturePoint(x, y, eventTimeMs);  // on every ACTION_MOVE
+ * engine.endGesture();
+ *
  * // When done:
  * engine.shutdown();
  * }</pre>
  *
  * <p>Thread safety: All public methods are synchronized on the engine instance.
- * {@code processGesture()} can be called from any thread; results are delivered
- * on the caller's thread via the adapter callback.</p>
+ * {@code processGesture()} can be called from any thread; by default it
+ * recognizes the gesture before returning and results are delivered on the
+ * caller's thread via the adapter callback. After
+ * {@link #setResultLooper(Looper)} it only queues the gesture for a dedicated
+ * native thread and returns, and results arrive on that Looper.</p>
  */
 public class SwipeTypeEngine {
 
@@ -42,10 +57,49 @@ public class SwipeTypeEngine {
     private static final String NATIVE_LIB = "glide_jni";
     private static final int DEFAULT_MAX_CANDIDATES = 8;
 
+    /** No warm-up: ideal paths are generated as the first gestures need them. */
+    public static final int WARMUP_OFF = 0;
+    /** Warm the ideal paths of the most frequent words of every start/end letter pair. */
+    public static final int WARMUP_FREQUENT = 1;
+    /** As {@link #WARMUP_FREQUENT}, then compile templates for the whole dictionary. */
+    public static final int WARMUP_FULL = 2;
+    /** Default words warmed per start/end letter pair (DEFAULT_WARMUP_WORDS_PER_BUCKET). */
+    public static final int DEFAULT_WARMUP_WORDS_PER_BUCKET = 4;
+
+    // WarmupState values reported by nativeGetWarmupProgress
+    private static final int WARMUP_STATE_RUNNING = 1;
+
+    // Direct buffer layouts shared with GestureLibJNI.cpp, in native byte order.
+    // Point: float x, float y, long timestamp. Result: int count, then per
+    // candidate float confidence, int flags, int byteLength and the UTF-8 word.
+    private static final int POINT_BYTES = 16;
+    private static final int INITIAL_POINT_CAPACITY = 512;
+    private static final int MAX_WORD_BYTES = 64;       // MAX_WORD_LENGTH
+    private static final int RESULT_BUFFER_BYTES = 4 + 20 * (12 + MAX_WORD_BYTES);
+
     private long nativeHandle = 0;
-    private SwipeTypeAdapter adapter;
+    private volatile SwipeTypeAdapter adapter;
     private boolean initialized = false;
     private Context appContext;
+    private int warmupLevel = WARMUP_OFF;
+    private int warmupWordsPerBucket = DEFAULT_WARMUP_WORDS_PER_BUCKET;
+    /** [state, words done, words total], filled by nativeGetWarmupProgress. */
+    private final int[] warmupProgress = new int[3];
+
+    /** Receives asynchronous results; null = synchronous recognition. */
+    private volatile Handler resultHandler;
+    /** Id of the newest gesture; results of any other id are stale. */
+    private volatile long latestRequestId = 0;
+
+    /** Points of the gesture being built; grown by doubling, never shrunk. */
+    private ByteBuffer pointBuffer = allocateBuffer(INITIAL_POINT_CAPACITY * POINT_BYTES);
+    private int pointCount = 0;
+    /** Synchronous results, decoded under the engine lock. */
+    private final ByteBuffer resultBuffer = allocateBuffer(RESULT_BUFFER_BYTES);
+    private final byte[] wordScratch = new byte[MAX_WORD_BYTES];
+    /** Asynchronous results, written and decoded on the native thread only. */
+    private final ByteBuffer workerResultBuffer = allocateBuffer(RESULT_BUFFER_BYTES);
+    private final byte[] workerWordScratch = new byte[MAX_WORD_BYTES];
 
     static {
         System.loadLibrary(NATIVE_LIB);
@@ -60,20 +114,20 @@ public class SwipeTypeEngine {
             float[] keyWidths, float[] keyHeights,
             int[] keyCodePoints, int keyCount,
             float layoutWidth, float layoutHeight,
-            String languageTag, String dictPath);
+            String languageTag, String dictPath,
+            int warmupLevel, int warmupWordsPerBucket);
 
     private static native long nativeInitWithData(
             float[] keyPositionsX, float[] keyPositionsY,
             float[] keyWidths, float[] keyHeights,
             int[] keyCodePoints, int keyCount,
             float layoutWidth, float layoutHeight,
-            String languageTag, byte[] dictData);
+            String languageTag, byte[] dictData,
+            int warmupLevel, int warmupWordsPerBucket);
 
     private static native int nativeRecognize(
-            long handle,
-            float[] xCoords, float[] yCoords, long[] timestamps,
-            int pointCount, int maxCandidates,
-            String[] outWords, float[] outScores, int[] outFlags);
+            long handle, ByteBuffer points, int pointCount, int maxCandidates,
+            ByteBuffer results);
 
     private static native boolean nativeUpdateLayout(
             long handle,
@@ -82,6 +136,22 @@ public class SwipeTypeEngine {
             int[] keyCodePoints, int keyCount,
             float layoutWidth, float layoutHeight);
 
+    private static native boolean nativeStartWorker(
+            long handle, SwipeTypeEngine listener, ByteBuffer results);
+
+    private static native void nativeStopWorker(long handle);
+
+    private static native boolean nativeSubmitGesture(
+            long handle, long requestId, ByteBuffer points, int pointCount, int maxCandidates);
+
+    private static native void nativeCancelGestures(long handle, long requestId);
+
+    private static native void nativeTrimMemory(long handle, int level);
+
+    private static native void nativeGetWarmupProgress(long handle, int[] out);
+
+    private static native void nativeCancelWarmup(long handle);
+
     private static native void nativeShutdown(long handle);
 
     private static native boolean nativeIsInitialized(long handle);
@@ -162,10 +232,16 @@ public class SwipeTypeEngine {
             keyCps[i] = k.codePoint;
         }
 
-        // Step 4: Initialize native engine
+        // Step 4: Initialize native engine, replacing the previous one
+        if (nativeHandle != 0) {
+            nativeShutdown(nativeHandle);
+            nativeHandle = 0;
+            initialized = false;
+        }
         nativeHandle = nativeInit(keyX, keyY, keyW, keyH, keyCps, keyCount,
                 layout.layoutWidth, layout.layoutHeight,
-                languageTag, dictFile.getAbsolutePath());
+                languageTag, dictFile.getAbsolutePath(),
+                warmupLevel, warmupWordsPerBucket);
 
         if (nativeHandle == 0) {
             Log.e(TAG, "Native engine initialization failed");
@@ -174,73 +250,203 @@ public class SwipeTypeEngine {
         }
 
         initialized = true;
+        if (resultHandler != null) startWorker();
         Log.i(TAG, "Dictionary loaded: " + languageTag);
         adapter.onInit(this);
         return true;
     }
 
+    /**
+     * Choose how much the engine prepares in the background after
+     * {@link #loadDictionary}.
+     *
+     * <p>{@code loadDictionary()} returns as soon as the dictionary is
+     * usable either way. A warm-up then keeps a background thread busy for
+     * a few milliseconds ({@link #WARMUP_FREQUENT}) or, for a large
+     * dictionary, a few seconds ({@link #WARMUP_FULL}) so that the first
+     * swipes of a session are as fast as later ones. Applies from the next
+     * {@code loadDictionary()}.</p>
+     *
+     * @param level           {@link #WARMUP_OFF} (default), {@link #WARMUP_FREQUENT}
+     *                        or {@link #WARMUP_FULL}
+     * @param wordsPerBucket  Most frequent words warmed per start/end letter
+     *                        pair, bounded by half the path cache
+     */
+    public synchronized void setWarmup(int level, int wordsPerBucket) {
+        this.warmupLevel = level;
+        this.warmupWordsPerBucket = wordsPerBucket;
+    }
+
+    /**
+     * @return Fraction of the warm-up done, from 0 to 1; 1 once it is no
+     *         longer running (finished, cancelled or never started).
+     */
+    public synchronized float getWarmupProgress() {
+        if (nativeHandle == 0) return 1.0f;
+        nativeGetWarmupProgress(nativeHandle, warmupProgress);
+        if (warmupProgress[0] != WARMUP_STATE_RUNNING) return 1.0f;
+        int total = warmupProgress[2];
+        return total > 0 ? (float) warmupProgress[1] / total : 0.0f;
+    }
+
+    /**
+     * @return true once no warm-up is running, so that gestures are
+     *         recognized at their steady-state speed.
+     */
+    public synchronized boolean isWarmedUp() {
+        if (nativeHandle == 0) return false;
+        nativeGetWarmupProgress(nativeHandle, warmupProgress);
+        return warmupProgress[0] != WARMUP_STATE_RUNNING;
+    }
+
+    /**
+     * Stop a running warm-up, e.g. when the keyboard is hidden before it
+     * finishes. Returns at once; what was warmed by then is kept.
+     */
+    public synchronized void cancelWarmup() {
+        if (nativeHandle != 0) nativeCancelWarmup(nativeHandle);
+    }
+
     /**
      * Process a gesture (swipe) and deliver word candidates to the adapter.
      *
-     * <p>Results are delivered synchronously via
-     * {@link SwipeTypeAdapter#onCandidatesReady} on the calling thread.</p>
+     * <p>Equivalent to {@link #beginGesture()}, {@link #addGesturePoint} for
+     * each point and {@link #endGesture()}.</p>
      *
      * @param points  Ordered list of touch points. Must contain >= 2 points.
      */
     public synchronized void processGesture(List<GesturePoint> points) {
+        beginGesture();
+        if (points != null) {
+            for (int i = 0; i < points.size(); i++) {
+                GesturePoint p = points.get(i);
+                addGesturePoint(p.x, p.y, p.timestamp);
+            }
+        }
+        endGesture();
+    }
+
+    /**
+     * Start a new gesture, discarding the points of an unfinished one.
+     */
+    public synchronized void beginGesture() {
+        pointCount = 0;
+    }
+
+    /**
+     * Append a touch point to the gesture started by {@link #beginGesture()}.
+     *
+     * <p>Points are written straight into a direct buffer the native engine
+     * reads in place, so a stroke allocates nothing once the buffer has grown
+     * to fit it.</p>
+     *
+     * @param x          X coordinate in dp, in the layout's coordinate space.
+     * @param y          Y coordinate in dp.
+     * @param timestamp  Time in milliseconds.
+     */
+    public synchronized void addGesturePoint(float x, float y, long timestamp) {
+        int offset = pointCount * POINT_BYTES;
+        if (offset + POINT_BYTES > pointBuffer.capacity()) {
+            ByteBuffer grown = allocateBuffer(pointBuffer.capacity() * 2);
+            pointBuffer.position(0).limit(offset);
+            grown.put(pointBuffer);
+            pointBuffer.clear();
+            pointBuffer = grown;
+        }
+        pointBuffer.putFloat(offset, x);
+        pointBuffer.putFloat(offset + 4, y);
+        pointBuffer.putLong(offset + 8, timestamp);
+        pointCount++;
+    }
+
+    /**
+     * Recognize the gesture built since {@link #beginGesture()} and deliver
+     * word candidates to the adapter.
+     *
+     * <p>By default results are delivered synchronously via
+     * {@link SwipeTypeAdapter#onCandidatesReady} on the calling thread. After
+     * {@link #setResultLooper(Looper)} the gesture is queued for the native
+     * recognition thread and this returns at once; candidates and errors are
+     * then posted to the result Looper, and only for the newest gesture.</p>
+     */
+    public synchronized void endGesture() {
+        int n = pointCount;
+        pointCount = 0;
         if (!initialized || nativeHandle == 0) {
-            if (adapter != null) adapter.onError(SwipeTypeError.ENGINE_NOT_INITIALIZED);
+            deliverError(SwipeTypeError.ENGINE_NOT_INITIALIZED);
             return;
         }
-        if (points == null || points.size() < 2) {
-            if (adapter != null) adapter.onError(SwipeTypeError.PATH_TOO_SHORT);
+        if (n < 2) {
+            deliverError(SwipeTypeError.PATH_TOO_SHORT);
             return;
         }
 
-        // Convert list to arrays
-        int n = points.size();
-        float[] xCoords    = new float[n];
-        float[] yCoords    = new float[n];
-        long[]  timestamps = new long[n];
-        for (int i = 0; i < n; i++) {
-            GesturePoint p = points.get(i);
-            xCoords[i]    = p.x;
-            yCoords[i]    = p.y;
-            timestamps[i] = p.timestamp;
+        if (resultHandler != null) {
+            // A new gesture cancels the ones still queued or running; the
+            // points are copied, so the buffer is free for the next stroke
+            long requestId = ++latestRequestId;
+            if (!nativeSubmitGesture(nativeHandle, requestId,
+                    pointBuffer, n, DEFAULT_MAX_CANDIDATES)) {
+                deliverError(SwipeTypeError.JNI_ERROR);
+            }
+            return;
         }
 
-        // Allocate output arrays
-        String[] outWords  = new String[DEFAULT_MAX_CANDIDATES];
-        float[]  outScores = new float[DEFAULT_MAX_CANDIDATES];
-        int[]    outFlags  = new int[DEFAULT_MAX_CANDIDATES];
-
-        int count = nativeRecognize(nativeHandle,
-                xCoords, yCoords, timestamps, n, DEFAULT_MAX_CANDIDATES,
-                outWords, outScores, outFlags);
-
+        int count = nativeRecognize(nativeHandle, pointBuffer, n, DEFAULT_MAX_CANDIDATES,
+                resultBuffer);
         if (count < 0) {
             if (adapter != null) adapter.onError(SwipeTypeError.JNI_ERROR);
             return;
         }
 
-        // Build candidate list
-        List<SwipeTypeCandidate> candidates = new ArrayList<>(count);
-        for (int i = 0; i < count; i++) {
-            if (outWords[i] != null) {
-                candidates.add(new SwipeTypeCandidate(outWords[i], outScores[i], outFlags[i]));
-            }
-        }
-
+        List<SwipeTypeCandidate> candidates = readCandidates(resultBuffer, wordScratch);
         if (adapter != null) {
             adapter.onCandidatesReady(candidates);
         }
     }
 
+    /**
+     * Recognize gestures on a dedicated native thread and deliver results on
+     * a Looper, so that {@link #processGesture} never blocks its caller.
+     *
+     * <p>The thread holds at most one pending gesture: a new gesture replaces
+     * one that has not started, and the result of one still being recognized
+     * is dropped. {@link SwipeTypeAdapter#onCandidatesReady} and errors from
+     * {@code processGesture()} are posted to {@code looper}. Initialization
+     * callbacks stay on the calling thread. The setting survives
+     * {@link #loadDictionary} and is cleared by {@link #shutdown()}.</p>
+     *
+     * @param looper  Looper receiving results, e.g. the IME's main Looper.
+     *                Pass null to recognize synchronously again.
+     */
+    public synchronized void setResultLooper(Looper looper) {
+        latestRequestId++;  // results of earlier gestures are stale
+        if (looper == null) {
+            resultHandler = null;
+            if (nativeHandle != 0) nativeStopWorker(nativeHandle);
+            return;
+        }
+        resultHandler = new Handler(looper);
+        if (nativeHandle != 0) startWorker();
+    }
+
+    /**
+     * Drop the results of every gesture submitted so far in asynchronous
+     * mode, e.g. when the user taps a key before the candidates arrive.
+     */
+    public synchronized void cancelPendingGestures() {
+        long requestId = ++latestRequestId;
+        if (nativeHandle != 0) nativeCancelGestures(nativeHandle, requestId);
+    }
+
     /**
      * Notify the engine that the keyboard layout has changed.
      *
      * <p>Call this when the user switches languages, rotates the device, or
      * the keyboard layout changes for any reason.</p>
+     *
+     * <p>Returns without waiting for the engine to index the new layout.
+     * Gestures recognized in the meantime still use the previous one.</p>
      */
     public synchronized void notifyLayoutChanged() {
         if (!initialized || nativeHandle == 0 || adapter == null) return;
@@ -271,7 +477,25 @@ public class SwipeTypeEngine {
                 keyX, keyY, keyW, keyH, keyCps, keyCount,
                 layout.layoutWidth, layout.layoutHeight);
 
-        Log.i(TAG, "Layout updated: " + (ok ? "success" : "failed"));
+        Log.i(TAG, "Layout update " + (ok ? "started" : "failed"));
+    }
+
+    /**
+     * Release native memory the engine can rebuild, such as cached ideal paths.
+     *
+     * <p>Forward {@code onTrimMemory()} of the input method service here.
+     * While the keyboard is in use the path cache is halved; once the app is
+     * in the background or memory is critical it is emptied. The dictionary
+     * stays loaded.</p>
+     *
+     * @param level the {@link ComponentCallbacks2} trim level
+     */
+    public synchronized void onTrimMemory(int level) {
+        if (nativeHandle == 0) return;
+        boolean complete = level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL
+                || level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND;
+        nativeTrimMemory(nativeHandle, complete ? 1 : 0);
+        Log.i(TAG, "Trimmed native memory (level " + level + ")");
     }
 
     /**
@@ -280,6 +504,8 @@ public class SwipeTypeEngine {
      * <p>Safe to call multiple times.</p>
      */
     public synchronized void shutdown() {
+        resultHandler = null;
+        latestRequestId++;  // drop results already posted
         if (nativeHandle != 0) {
             nativeShutdown(nativeHandle);
             nativeHandle = 0;
@@ -294,4 +520,82 @@ public class SwipeTypeEngine {
     public synchronized boolean isInitialized() {
         return initialized && nativeHandle != 0;
     }
+
+    // ========================================================================
+    // Internals
+    // ========================================================================
+
+    /** Start the native recognition thread; on failure fall back to synchronous. */
+    private void startWorker() {
+        if (!nativeStartWorker(nativeHandle, this, workerResultBuffer)) {
+            Log.e(TAG, "Failed to start the recognition thread; recognizing synchronously");
+            resultHandler = null;
+        }
+    }
+
+    /** Report an endGesture() error on the result Looper, or right away. */
+    private void deliverError(final SwipeTypeError error) {
+        final SwipeTypeAdapter target = adapter;
+        if (target == null) return;
+        Handler handler = resultHandler;
+        if (handler == null) {
+            target.onError(error);
+            return;
+        }
+        final long requestId = latestRequestId;
+        handler.post(() -> {
+            if (requestId == latestRequestId) target.onError(error);
+        });
+    }
+
+    private static ByteBuffer allocateBuffer(int bytes) {
+        return ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder());
+    }
+
+    /**
+     * Decode a result buffer written by native code.
+     *
+     * @return The candidates, or null if native code reported an error.
+     */
+    private static List<SwipeTypeCandidate> readCandidates(ByteBuffer results, byte[] scratch) {
+        int count = results.getInt(0);
+        if (count < 0) return null;
+        List<SwipeTypeCandidate> candidates = new ArrayList<>(count);
+        int offset = 4;
+        for (int i = 0; i < count; i++) {
+            float score = results.getFloat(offset);
+            int flags = results.getInt(offset + 4);
+            int length = results.getInt(offset + 8);
+            offset += 12;
+            results.position(offset);
+            results.get(scratch, 0, length);
+            candidates.add(new SwipeTypeCandidate(
+                    new String(scratch, 0, length, StandardCharsets.UTF_8), score, flags));
+            offset += length;
+        }
+        results.clear();
+        return candidates;
+    }
+
+    /**
+     * Result of an asynchronous gesture, called on the native recognition
+     * thread after it filled the worker result buffer with count candidates.
+     * A negative count means recognition failed.
+     */
+    @SuppressWarnings("unused")  // called from GestureLibJNI.cpp
+    private void onNativeCandidates(final long requestId, int count) {
+        Handler handler = resultHandler;
+        if (handler == null || requestId != latestRequestId) return;
+        final List<SwipeTypeCandidate> candidates =
+                count >= 0 ? readCandidates(workerResultBuffer, workerWordScratch) : null;
+        handler.post(() -> {
+            SwipeTypeAdapter target = adapter;
+            if (target == null || requestId != latestRequestId) return;
+            if (candidates != null) {
+                target.onCandidatesReady(candidates);
+            } else {
+                target.onError(SwipeTypeError.JNI_ERROR);
+            }
+        });
+    }
 }
@@ -28,6 +28,9 @@ public enum SwipeTypeError {
     /** Out of memory during processing. */
     OUT_OF_MEMORY(7, "Out of memory during processing"),
 
+    /** An argument is out of range or refers to something already in use. */
+    INVALID_ARGUMENT(8, "Invalid argument"),
+
     /** Internal JNI bridge error. */
     JNI_ERROR(100, "JNI bridge error"),
 
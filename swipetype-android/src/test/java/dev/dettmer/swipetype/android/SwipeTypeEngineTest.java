@@ -1,5 +1,7 @@
 package dev.dettmer.swipetype.android;
 
+import android.os.Looper;
+
 import org.junit.Before;
 import org.junit.Test;
 import org.junit.runner.RunWith;
@@ -11,6 +13,7 @@ import java.util.ArrayList;
 import java.util.List;
 
 import static org.junit.Assert.*;
+import static org.robolectric.Shadows.shadowOf;
 
 /**
  * Unit tests for {@link SwipeTypeEngine} using Robolectric.
@@ -91,6 +94,42 @@ public class SwipeTypeEngineTest {
         org.junit.Assume.assumeTrue("TODO(sonnet): implement", false);
     }
 
+    @Test
+    public void streamedGestureBeforeInitDeliversError() {
+        engine.init(RuntimeEnvironment.getApplication(), adapter);
+
+        // More points than the initial buffer holds, to exercise growth
+        engine.beginGesture();
+        for (int i = 0; i < 1200; i++) engine.addGesturePoint(i, i * 0.5f, i * 8L);
+        engine.endGesture();
+        assertEquals(SwipeTypeError.ENGINE_NOT_INITIALIZED, adapter.lastError);
+    }
+
+    // ----- Asynchronous delivery -----
+
+    @Test
+    public void asyncErrorsArePostedToResultLooper() {
+        engine.init(RuntimeEnvironment.getApplication(), adapter);
+        engine.setResultLooper(Looper.getMainLooper());
+
+        engine.processGesture(new ArrayList<>());
+        assertNull("delivered before the Looper ran", adapter.lastError);
+
+        shadowOf(Looper.getMainLooper()).idle();
+        assertEquals(SwipeTypeError.ENGINE_NOT_INITIALIZED, adapter.lastError);
+    }
+
+    @Test
+    public void cancelPendingGesturesDropsPostedResults() {
+        engine.init(RuntimeEnvironment.getApplication(), adapter);
+        engine.setResultLooper(Looper.getMainLooper());
+
+        engine.processGesture(new ArrayList<>());
+        engine.cancelPendingGestures();
+        shadowOf(Looper.getMainLooper()).idle();
+        assertNull(adapter.lastError);
+    }
+
     // =========================================================================
     // Internal test adapter implementation
     // =========================================================================
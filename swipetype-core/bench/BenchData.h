@@ -0,0 +1,281 @@
+#pragma once
+// BenchData.h — Inputs for the benchmark suite: test-data readers, synthetic
+// dictionaries and generated gestures.
+
+#include <swipetype/SwipeTypeTypes.h>
+#include <swipetype/KeyboardLayout.h>
+#include <swipetype/GesturePath.h>
+#include <swipetype/GesturePoint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifndef SWIPETYPE_TEST_DATA_DIR
+#define SWIPETYPE_TEST_DATA_DIR "test-data"
+#endif
+
+namespace swipetype::bench {
+
+using WordList = std::vector<std::pair<std::string, uint32_t>>;
+
+/// A recorded gesture from gesture-scenarios.json.
+struct Scenario {
+    std::string id;
+    std::string word;
+    RawGesturePath path;
+};
+
+inline std::string dataPath(const std::string& name) {
+    return std::string(SWIPETYPE_TEST_DATA_DIR) + "/" + name;
+}
+
+inline std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// ============================================================
+// JSON field scanning
+//
+// The test-data files are flat arrays of flat objects, so the readers find
+// each object's braces and pick fields out by name instead of parsing JSON
+// in general.
+// ============================================================
+
+/// Position just past `"name":` at or after from, or npos.
+inline size_t findField(const std::string& json, const char* name, size_t from, size_t end) {
+    std::string needle = std::string("\"") + name + "\"";
+    size_t pos = json.find(needle, from);
+    if (pos == std::string::npos || pos >= end) return std::string::npos;
+    pos = json.find(':', pos + needle.size());
+    return (pos == std::string::npos || pos >= end) ? std::string::npos : pos + 1;
+}
+
+inline double numberField(const std::string& json, const char* name, size_t from, size_t end,
+                          double fallback = 0.0) {
+    size_t pos = findField(json, name, from, end);
+    return pos == std::string::npos ? fallback : std::strtod(json.c_str() + pos, nullptr);
+}
+
+inline std::string stringField(const std::string& json, const char* name, size_t from, size_t end) {
+    size_t pos = findField(json, name, from, end);
+    if (pos == std::string::npos) return std::string();
+    size_t open = json.find('"', pos);
+    size_t close = json.find('"', open + 1);
+    if (open == std::string::npos || close == std::string::npos || close >= end) return std::string();
+    return json.substr(open + 1, close - open - 1);
+}
+
+/// The [begin, end) ranges of the innermost objects in the array field name.
+inline std::vector<std::pair<size_t, size_t>> objectsIn(const std::string& json, const char* name,
+                                                        size_t from, size_t end) {
+    std::vector<std::pair<size_t, size_t>> objects;
+    size_t pos = findField(json, name, from, end);
+    if (pos == std::string::npos) return objects;
+    size_t open = json.find('[', pos);
+    if (open == std::string::npos || open >= end) return objects;
+
+    int depth = 0;
+    size_t begin = 0;
+    for (size_t i = open; i < end; ++i) {
+        char c = json[i];
+        if (c == '[' || c == '{') {
+            if (c == '{') begin = i;
+            ++depth;
+        } else if (c == ']' || c == '}') {
+            if (c == '}' && depth == 2) objects.emplace_back(begin, i + 1);
+            if (--depth == 0) break;
+        }
+    }
+    return objects;
+}
+
+// ============================================================
+// test-data readers
+// ============================================================
+
+/// Read a layout such as qwerty-standard.json.
+inline KeyboardLayout loadLayout(const std::string& path) {
+    std::string json = readFile(path);
+    KeyboardLayout layout;
+    size_t end = json.size();
+    size_t keysPos = findField(json, "keys", 0, end);
+    layout.languageTag  = stringField(json, "languageTag", 0, end);
+    layout.layoutWidth  = static_cast<float>(numberField(json, "layoutWidth", 0, keysPos));
+    layout.layoutHeight = static_cast<float>(numberField(json, "layoutHeight", 0, keysPos));
+    for (const auto& [b, e] : objectsIn(json, "keys", 0, end)) {
+        layout.keys.push_back(KeyDescriptor(
+            stringField(json, "label", b, e),
+            static_cast<int32_t>(numberField(json, "codePoint", b, e)),
+            static_cast<float>(numberField(json, "centerX", b, e)),
+            static_cast<float>(numberField(json, "centerY", b, e)),
+            static_cast<float>(numberField(json, "width", b, e)),
+            static_cast<float>(numberField(json, "height", b, e))));
+    }
+    return layout;
+}
+
+/// Read the scenarios of gesture-scenarios.json.
+inline std::vector<Scenario> loadScenarios(const std::string& path) {
+    std::string json = readFile(path);
+    std::vector<Scenario> scenarios;
+    size_t end = json.size();
+    size_t pos = findField(json, "scenarios", 0, end);
+    size_t idPos = (pos == std::string::npos) ? pos : json.find("\"id\"", pos);
+    while (idPos != std::string::npos) {
+        size_t next = json.find("\"id\"", idPos + 4);
+        size_t limit = (next == std::string::npos) ? end : next;
+
+        Scenario s;
+        s.id   = stringField(json, "id", idPos, limit);
+        s.word = stringField(json, "word", idPos, limit);
+        for (const auto& [b, e] : objectsIn(json, "points", idPos, limit)) {
+            s.path.points.push_back(GesturePoint(
+                static_cast<float>(numberField(json, "x", b, e)),
+                static_cast<float>(numberField(json, "y", b, e)),
+                static_cast<int64_t>(numberField(json, "t", b, e))));
+        }
+        scenarios.push_back(std::move(s));
+        idPos = next;
+    }
+    return scenarios;
+}
+
+/// Read a word<TAB>frequency list; # comments and blank lines are skipped.
+inline WordList loadWordList(const std::string& path) {
+    WordList words;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0) continue;
+        words.emplace_back(line.substr(0, tab),
+                           static_cast<uint32_t>(std::strtoul(line.c_str() + tab + 1, nullptr, 10)));
+    }
+    return words;
+}
+
+// ============================================================
+// Synthetic inputs
+// ============================================================
+
+/// Reproducible LCG, as in the tests' addNoise().
+struct Lcg {
+    uint32_t state;
+    explicit Lcg(uint32_t seed) : state(seed) {}
+    uint32_t next() { state = state * 1664525u + 1013904223u; return state; }
+    /// Uniform in [0, 1).
+    float unit() { return static_cast<float>(next() >> 8) / 16777216.0f; }
+};
+
+/**
+ * count distinct lowercase words of 2..12 letters, with letters drawn by
+ * rough English frequency and Zipf-distributed frequencies (rank 1 most
+ * common). Reproducible for a given seed.
+ */
+inline WordList syntheticWords(size_t count, uint32_t seed = 42) {
+    static const char kLetters[] = "eeeeeeeeeeeettttttttaaaaaaaooooooiiiiiinnnnnnsssssshhhhhh"
+                                   "rrrrrrddddllllcccuuummwwffggyyppbbvkjxqz";
+    const size_t letterCount = sizeof(kLetters) - 1;
+
+    Lcg rng(seed);
+    WordList words;
+    words.reserve(count);
+    std::unordered_set<std::string> seen;
+    seen.reserve(count * 2);
+    while (words.size() < count) {
+        size_t len = 2 + (rng.next() >> 16) % 11;
+        std::string w;
+        for (size_t i = 0; i < len; ++i) w.push_back(kLetters[(rng.next() >> 16) % letterCount]);
+        if (!seen.insert(w).second) continue;
+        uint32_t rank = static_cast<uint32_t>(words.size()) + 1;
+        words.emplace_back(std::move(w), std::max<uint32_t>(1u, 10000000u / rank));
+    }
+    return words;
+}
+
+/**
+ * Serialize words as a version-1 .glide file (32-byte header, then
+ * wordLen(1) word(N) frequency(4) flags(1) records). The loader indexes it
+ * on load; DictionaryLoader::serialize() converts it to version 2.
+ */
+inline std::vector<uint8_t> buildDictionaryV1(const WordList& words, const std::string& lang) {
+    std::vector<uint8_t> buf(DICT_HEADER_SIZE, 0);
+    auto putU16 = [&](size_t at, uint16_t v) {
+        buf[at] = static_cast<uint8_t>(v & 0xFF);
+        buf[at + 1] = static_cast<uint8_t>(v >> 8);
+    };
+    auto putU32 = [&](size_t at, uint32_t v) {
+        for (int i = 0; i < 4; ++i) buf[at + static_cast<size_t>(i)] = static_cast<uint8_t>(v >> (8 * i));
+    };
+    putU32(0, DICT_MAGIC);
+    putU16(4, DICT_VERSION_V1);
+    putU16(6, 0);
+    putU32(8, static_cast<uint32_t>(words.size()));
+    uint16_t langLen = static_cast<uint16_t>(std::min(lang.size(), size_t(18)));
+    putU16(12, langLen);
+    for (size_t i = 0; i < langLen; ++i) buf[14 + i] = static_cast<uint8_t>(lang[i]);
+
+    for (const auto& [word, freq] : words) {
+        size_t len = std::min(word.size(), static_cast<size_t>(MAX_WORD_LENGTH));
+        buf.push_back(static_cast<uint8_t>(len));
+        buf.insert(buf.end(), word.begin(), word.begin() + static_cast<std::ptrdiff_t>(len));
+        for (int i = 0; i < 4; ++i) buf.push_back(static_cast<uint8_t>(freq >> (8 * i)));
+        buf.push_back(0x00);
+    }
+    return buf;
+}
+
+/**
+ * A gesture through the key centers of word, pointsPerSegment samples per
+ * key-to-key segment at 10 ms intervals, with up to jitterDp of uniform
+ * noise on each coordinate.
+ */
+inline RawGesturePath gestureForWord(const KeyboardLayout& layout, const std::string& word,
+                                     int pointsPerSegment = 8, float jitterDp = 4.0f,
+                                     uint32_t seed = 7) {
+    RawGesturePath raw;
+    std::vector<std::pair<float, float>> centers;
+    for (char c : word) {
+        int32_t idx = layout.findKeyByCodePoint(static_cast<unsigned char>(c));
+        if (idx < 0) continue;
+        const KeyDescriptor& key = layout.keys[static_cast<size_t>(idx)];
+        centers.emplace_back(key.centerX, key.centerY);
+    }
+    if (centers.empty()) return raw;
+
+    Lcg rng(seed);
+    auto jitter = [&]() { return (rng.unit() * 2.0f - 1.0f) * jitterDp; };
+    int64_t ts = 0;
+    for (size_t i = 0; i + 1 < centers.size(); ++i) {
+        for (int j = 0; j < pointsPerSegment; ++j) {
+            float t = static_cast<float>(j) / static_cast<float>(pointsPerSegment);
+            float x = centers[i].first + (centers[i + 1].first - centers[i].first) * t;
+            float y = centers[i].second + (centers[i + 1].second - centers[i].second) * t;
+            raw.points.push_back(GesturePoint(x + jitter(), y + jitter(), ts));
+            ts += 10;
+        }
+    }
+    raw.points.push_back(GesturePoint(centers.back().first, centers.back().second, ts));
+    return raw;
+}
+
+/// Percentile q in [0, 1] of samples (nearest rank); sorts samples.
+inline double percentile(std::vector<double>& samples, double q) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(samples.size())));
+    return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+} // namespace swipetype::bench
@@ -0,0 +1,715 @@
+// PipelineBench.cpp — Latency benchmarks for each stage of the recognition
+// pipeline and for recognize() end to end.
+//
+// Inputs: test-data/qwerty-standard.json, test-data/gesture-scenarios.json,
+// test-data/en-us-full.tsv and a synthetic 200k-word dictionary. Run with
+// --benchmark_out=<file> --benchmark_out_format=json (or build the
+// swipetype-bench-json target) and compare runs with scripts/bench_compare.py.
+
+#include <benchmark/benchmark.h>
+#include <swipetype/GestureEngine.h>
+#include <swipetype/DictionaryLoader.h>
+#include <swipetype/IdealPathGenerator.h>
+#include <swipetype/LexiconTrie.h>
+#include <swipetype/PathProcessor.h>
+#include <swipetype/Scorer.h>
+#include <swipetype/SwipeTypeTypes.h>
+#include "BenchData.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace swipetype;
+using namespace swipetype::bench;
+
+namespace {
+
+// ============================================================
+// Shared inputs, built once per process
+// ============================================================
+
+/// Dictionary corpus, the first benchmark argument where one applies.
+enum Corpus : int64_t { kFull = 0, kSynthetic = 1 };
+
+constexpr size_t kSyntheticWords = 200000;
+
+const KeyboardLayout& qwerty() {
+    static const KeyboardLayout layout = [] {
+        KeyboardLayout l = loadLayout(dataPath("qwerty-standard.json"));
+        l.buildLookup();
+        return l;
+    }();
+    return layout;
+}
+
+const std::vector<Scenario>& scenarios() {
+    static const std::vector<Scenario> s = loadScenarios(dataPath("gesture-scenarios.json"));
+    return s;
+}
+
+const WordList& words(int64_t corpus) {
+    static const WordList full = loadWordList(dataPath("en-us-full.tsv"));
+    static const WordList synthetic = syntheticWords(kSyntheticWords);
+    return corpus == kSynthetic ? synthetic : full;
+}
+
+/// The corpus as a .glide file of the given format version (1 or 2).
+const std::vector<uint8_t>& dictionaryBytes(int64_t corpus, int64_t version) {
+    static std::map<std::pair<int64_t, int64_t>, std::vector<uint8_t>> files;
+    auto key = std::make_pair(corpus, version);
+    auto it = files.find(key);
+    if (it != files.end()) return it->second;
+
+    std::vector<uint8_t> bytes = buildDictionaryV1(words(corpus), "en-US");
+    if (version >= 2) {
+        DictionaryLoader loader;
+        std::vector<uint8_t> v2;
+        if (loader.loadFromMemory(bytes.data(), bytes.size()) && loader.serialize(v2)) {
+            bytes = std::move(v2);
+        }
+    }
+    return files.emplace(key, std::move(bytes)).first->second;
+}
+
+const DictionaryLoader& loadedDictionary(int64_t corpus) {
+    static std::map<int64_t, std::unique_ptr<DictionaryLoader>> loaders;
+    auto& slot = loaders[corpus];
+    if (!slot) {
+        slot = std::make_unique<DictionaryLoader>();
+        const auto& bytes = dictionaryBytes(corpus, 2);
+        slot->loadFromMemory(bytes.data(), bytes.size(), DictionaryStorage::BORROW);
+    }
+    return *slot;
+}
+
+/**
+ * Gestures for recognize(): the recorded scenarios, then generated gestures
+ * for words spread over the corpus frequency ranks, 64 in all.
+ */
+const std::vector<RawGesturePath>& recognitionGestures(int64_t corpus) {
+    static std::map<int64_t, std::vector<RawGesturePath>> sets;
+    auto& set = sets[corpus];
+    if (!set.empty()) return set;
+
+    constexpr size_t kGestures = 64;
+    for (const auto& s : scenarios()) set.push_back(s.path);
+    const WordList& list = words(corpus);
+    // Favour common words the way real typing does: ranks grow quadratically
+    size_t generated = kGestures - set.size();
+    for (size_t i = 0; i < generated && !list.empty(); ++i) {
+        size_t rank = (i * i * (list.size() - 1)) / ((generated - 1) * (generated - 1));
+        set.push_back(gestureForWord(qwerty(), list[rank].first, 8, 4.0f,
+                                     static_cast<uint32_t>(i + 1)));
+    }
+    return set;
+}
+
+std::vector<GesturePath> normalizedScenarios(int points = RESAMPLE_COUNT) {
+    PathProcessor processor;
+    processor.setResampleCount(points);
+    std::vector<GesturePath> paths;
+    for (const auto& s : scenarios()) paths.push_back(processor.normalize(s.path, qwerty()));
+    return paths;
+}
+
+/// Report p50/p90/p99 of per-call latencies, in microseconds.
+void reportLatency(benchmark::State& state, std::vector<double>& samplesUs) {
+    state.counters["p50_us"] = percentile(samplesUs, 0.50);
+    state.counters["p90_us"] = percentile(samplesUs, 0.90);
+    state.counters["p99_us"] = percentile(samplesUs, 0.99);
+}
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// ============================================================
+// PathProcessor::normalize
+// ============================================================
+
+void BM_NormalizeScenarios(benchmark::State& state) {
+    PathProcessor processor;
+    GesturePath out;
+    const auto& gestures = scenarios();
+    size_t i = 0;
+    for (auto _ : state) {
+        processor.normalize(gestures[i].path, qwerty(), out);
+        benchmark::DoNotOptimize(out.points.data());
+        if (++i == gestures.size()) i = 0;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_NormalizeScenarios);
+
+/// Arg: samples per key-to-key segment of an 8-letter gesture.
+void BM_NormalizeLong(benchmark::State& state) {
+    RawGesturePath raw = gestureForWord(qwerty(), "keyboard", static_cast<int>(state.range(0)));
+    PathProcessor processor;
+    GesturePath out;
+    for (auto _ : state) {
+        processor.normalize(raw, qwerty(), out);
+        benchmark::DoNotOptimize(out.points.data());
+    }
+    state.counters["raw_points"] = static_cast<double>(raw.points.size());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * raw.points.size()));
+}
+BENCHMARK(BM_NormalizeLong)->ArgName("per_segment")->Arg(8)->Arg(64)->Arg(512);
+
+// ============================================================
+// Scorer::computeDTWDistance
+// ============================================================
+
+/// Ideal paths of the 256 most frequent dictionary words, resampled to points.
+std::vector<GesturePath> idealPaths(int points) {
+    IdealPathGenerator generator;
+    generator.setLayout(qwerty());
+    generator.setResampleCount(points);
+    std::vector<GesturePath> paths;
+    for (const auto& [word, freq] : words(kFull)) {
+        GesturePath p = generator.generatePath(word);
+        if (p.points.size() == static_cast<size_t>(points)) paths.push_back(std::move(p));
+        if (paths.size() == 256) break;
+    }
+    return paths;
+}
+
+/// Ideal paths of the most frequent dictionary words, as DTW templates.
+const std::vector<GesturePath>& dtwTemplates() {
+    static const std::vector<GesturePath> templates = idealPaths(RESAMPLE_COUNT);
+    return templates;
+}
+
+void BM_DTWDistance(benchmark::State& state) {
+    Scorer scorer;
+    std::vector<GesturePath> gestures = normalizedScenarios();
+    const auto& templates = dtwTemplates();
+    size_t g = 0, t = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scorer.computeDTWDistance(gestures[g], templates[t]));
+        if (++t == templates.size()) { t = 0; if (++g == gestures.size()) g = 0; }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_DTWDistance);
+
+/// The SoA overload that compiled templates are scored with.
+void BM_DTWDistanceSoA(benchmark::State& state) {
+    Scorer scorer;
+    std::vector<GesturePath> gestures = normalizedScenarios();
+    const auto& templates = dtwTemplates();
+
+    auto toSoA = [](const GesturePath& p, std::vector<float>& xs, std::vector<float>& ys) {
+        xs.clear();
+        ys.clear();
+        for (const auto& pt : p.points) { xs.push_back(pt.x); ys.push_back(pt.y); }
+    };
+    std::vector<std::vector<float>> gx(gestures.size()), gy(gestures.size());
+    for (size_t i = 0; i < gestures.size(); ++i) toSoA(gestures[i], gx[i], gy[i]);
+    std::vector<std::vector<float>> tx(templates.size()), ty(templates.size());
+    for (size_t i = 0; i < templates.size(); ++i) toSoA(templates[i], tx[i], ty[i]);
+
+    size_t g = 0, t = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scorer.computeDTWDistance(gx[g].data(), gy[g].data(),
+                                                           tx[t].data(), ty[t].data()));
+        if (++t == templates.size()) { t = 0; if (++g == gestures.size()) g = 0; }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_DTWDistanceSoA);
+
+/// DTW at other resample counts: 32, 64 and 96 use prebuilt kernels, 48 the generic one.
+void BM_DTWDistancePoints(benchmark::State& state) {
+    const int points = static_cast<int>(state.range(0));
+    ScoringConfig config;
+    config.resampleCount = points;
+    Scorer scorer;
+    scorer.configure(config);
+    std::vector<GesturePath> gestures = normalizedScenarios(points);
+    std::vector<GesturePath> templates = idealPaths(points);
+    size_t g = 0, t = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scorer.computeDTWDistance(gestures[g], templates[t]));
+        if (++t == templates.size()) { t = 0; if (++g == gestures.size()) g = 0; }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_DTWDistancePoints)->ArgName("points")->Arg(32)->Arg(48)->Arg(64)->Arg(96);
+
+// ============================================================
+// KeyboardLayout::findNearestKey
+// ============================================================
+
+/// Public nearest-key call on points spread over the keyboard; the
+/// argument selects the lookup tables (1) or the scan (0).
+void BM_FindNearestKey(benchmark::State& state) {
+    KeyboardLayout layout = qwerty();
+    if (state.range(0) == 0) layout.lookup.reset();
+    std::vector<GesturePoint> points;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 4096; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        float fx = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        seed = seed * 1664525u + 1013904223u;
+        float fy = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        points.push_back(GesturePoint(fx * layout.layoutWidth, fy * layout.layoutHeight, 0));
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(layout.findNearestKey(points[i].x, points[i].y));
+        if (++i == points.size()) i = 0;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_FindNearestKey)->ArgName("tables")->Arg(0)->Arg(1);
+
+// ============================================================
+// IdealPathGenerator::getIdealPath
+// ============================================================
+
+/// Cache misses: every word is new to the cache, so each call generates.
+void BM_IdealPathCold(benchmark::State& state) {
+    IdealPathGenerator generator;
+    generator.setLayout(qwerty());
+    const WordList& list = words(kSynthetic);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.getIdealPath(list[i].first).points.data());
+        if (++i == list.size()) {
+            i = 0;
+            state.PauseTiming();
+            generator.clearCache();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_IdealPathCold);
+
+/// Cache hits on the full word list; getIdealPath() returns a copy.
+void BM_IdealPathWarm(benchmark::State& state) {
+    IdealPathGenerator generator;
+    generator.setLayout(qwerty());
+    const WordList& list = words(kFull);
+    for (const auto& [word, freq] : list) generator.getIdealPathRef(word);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.getIdealPath(list[i].first).points.data());
+        if (++i == list.size()) i = 0;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_IdealPathWarm);
+
+/// Cache hits through getIdealPathRef(), as the lazy scoring path reads them.
+void BM_IdealPathWarmRef(benchmark::State& state) {
+    IdealPathGenerator generator;
+    generator.setLayout(qwerty());
+    const WordList& list = words(kFull);
+    for (const auto& [word, freq] : list) generator.getIdealPathRef(word);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.getIdealPathRef(list[i].first).points.data());
+        if (++i == list.size()) i = 0;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_IdealPathWarmRef);
+
+// ============================================================
+// DictionaryLoader load
+// ============================================================
+
+/// Args: corpus, format version. Version 1 is indexed on load; version 2
+/// is borrowed in place.
+void BM_DictionaryLoad(benchmark::State& state) {
+    const auto& bytes = dictionaryBytes(state.range(0), state.range(1));
+    DictionaryStorage storage = state.range(1) >= 2 ? DictionaryStorage::BORROW
+                                                    : DictionaryStorage::COPY;
+    DictionaryLoader loader;
+    for (auto _ : state) {
+        if (!loader.loadFromMemory(bytes.data(), bytes.size(), storage)) {
+            state.SkipWithError("dictionary failed to load");
+            break;
+        }
+        benchmark::DoNotOptimize(loader.getEntryCount());
+    }
+    state.counters["entries"] = static_cast<double>(loader.getEntryCount());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_DictionaryLoad)
+    ->ArgNames({"corpus", "version"})
+    ->Args({kFull, 1})->Args({kFull, 2})
+    ->Args({kSynthetic, 1})->Args({kSynthetic, 2})
+    ->Unit(benchmark::kMicrosecond);
+
+// ============================================================
+// Start/end candidate filtering
+// ============================================================
+
+/// Start+end bucket sliced to a length window, over every letter pair.
+void BM_StartEndFilter(benchmark::State& state) {
+    const DictionaryLoader& dict = loadedDictionary(state.range(0));
+    int pair = 0;
+    uint32_t len = 3;
+    for (auto _ : state) {
+        char s = static_cast<char>('a' + pair / 26);
+        char e = static_cast<char>('a' + pair % 26);
+        benchmark::DoNotOptimize(dict.getBucket(s, e, len - 1, len + 1).size());
+        if (++pair == 26 * 26) { pair = 0; len = len % 10 + 3; }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_StartEndFilter)->ArgName("corpus")->Arg(kFull)->Arg(kSynthetic);
+
+/// The start-letter fallback: the whole start bucket filtered by length
+/// entry by entry, as recognize() does when the start+end bucket is empty.
+void BM_StartFilterFallback(benchmark::State& state) {
+    const DictionaryLoader& dict = loadedDictionary(state.range(0));
+    std::vector<uint32_t> filtered;
+    int letter = 0;
+    for (auto _ : state) {
+        DictionaryIndexSpan bucket = dict.getStartBucket(static_cast<char>('a' + letter));
+        filtered.clear();
+        for (uint32_t idx : bucket) {
+            size_t len = dict.getEntry(idx).word.size();
+            if (len >= 4 && len <= 6) filtered.push_back(idx);
+        }
+        benchmark::DoNotOptimize(filtered.data());
+        if (++letter == 26) letter = 0;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_StartFilterFallback)
+    ->ArgName("corpus")->Arg(kFull)->Arg(kSynthetic)
+    ->Unit(benchmark::kMicrosecond);
+
+/// Building the lexicon trie, as init() does.
+void BM_LexiconBuild(benchmark::State& state) {
+    const DictionaryLoader& dict = loadedDictionary(state.range(0));
+    LexiconTrie trie;
+    for (auto _ : state) {
+        trie.build(dict);
+        benchmark::DoNotOptimize(trie.nodeCount());
+    }
+    state.counters["nodes"] = static_cast<double>(trie.nodeCount());
+    state.counters["bytes"] = static_cast<double>(trie.memoryUsage());
+}
+BENCHMARK(BM_LexiconBuild)
+    ->ArgName("corpus")->Arg(kFull)->Arg(kSynthetic)
+    ->Unit(benchmark::kMillisecond);
+
+/// The lexicon walk along the keys each recognition gesture crosses.
+void BM_LexiconWalk(benchmark::State& state) {
+    const DictionaryLoader& dict = loadedDictionary(state.range(0));
+    LexiconTrie trie;
+    trie.build(dict);
+    std::vector<std::vector<uint32_t>> traces;
+    for (const auto& g : recognitionGestures(state.range(0))) {
+        std::vector<uint32_t> keys;
+        int32_t prev = -1;
+        for (const auto& pt : g.points) {
+            int32_t key = qwerty().findNearestKey(pt.x, pt.y);
+            if (key < 0 || key == prev) continue;
+            prev = key;
+            int32_t cp = qwerty().keys[static_cast<size_t>(key)].codePoint;
+            keys.push_back(cp >= 'a' && cp <= 'z' ? 1u << (cp - 'a') : 0u);
+        }
+        traces.push_back(std::move(keys));
+    }
+
+    std::vector<uint32_t> entries;
+    double visited = 0.0;
+    size_t i = 0;
+    for (auto _ : state) {
+        uint32_t nodes = 0;
+        trie.collect(traces[i].data(), traces[i].size(), entries, &nodes);
+        benchmark::DoNotOptimize(entries.data());
+        visited += nodes;
+        if (++i == traces.size()) i = 0;
+    }
+    state.counters["nodes"] = visited / static_cast<double>(state.iterations());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LexiconWalk)
+    ->ArgName("corpus")->Arg(kFull)->Arg(kSynthetic)
+    ->Unit(benchmark::kMicrosecond);
+
+// ============================================================
+// GestureEngine::recognize end to end
+// ============================================================
+
+/// Engines are costly to build (the 200k templates compile for seconds),
+/// so each configuration is built once and kept for the process.
+/// mode: 0 = lazy ideal paths, 1 = compiled templates, 2 = compiled
+/// templates without the coarse pre-filter, 3 / 4 = UINT16 / UINT8
+/// compiled templates, 5 = compiled templates without the lexicon walk.
+GestureEngine& engineFor(int64_t corpus, int64_t mode) {
+    static std::map<std::pair<int64_t, int64_t>, std::unique_ptr<GestureEngine>> engines;
+    auto& slot = engines[std::make_pair(corpus, mode)];
+    if (!slot) {
+        const bool compiled = mode != 0;
+        slot = std::make_unique<GestureEngine>();
+        ScoringConfig config;
+        if (mode == 2) config.coarseCandidates = 0;
+        if (mode == 3) config.templatePrecision = TemplatePrecision::UINT16;
+        if (mode == 4) config.templatePrecision = TemplatePrecision::UINT8;
+        if (mode == 5) config.lexiconCandidates = false;
+        slot->configure(config);
+        const auto& bytes = dictionaryBytes(corpus, 2);
+        slot->initWithData(qwerty(), bytes.data(), bytes.size(), DictionaryStorage::BORROW);
+        if (compiled) slot->compileTemplates();
+    }
+    return *slot;
+}
+
+/**
+ * One gesture per iteration, timed individually: p50/p90/p99 per-swipe
+ * latency are reported as counters alongside the mean.
+ * Args: corpus, compiled templates (0 = lazy ideal paths, 1 = compiled,
+ * 2 = compiled with ScoringConfig::coarseCandidates = 0, 3 / 4 = compiled
+ * with ScoringConfig::templatePrecision UINT16 / UINT8, 5 = compiled with
+ * ScoringConfig::lexiconCandidates = false).
+ */
+void BM_Recognize(benchmark::State& state) {
+    GestureEngine& engine = engineFor(state.range(0), state.range(1));
+    if (!engine.isInitialized()) {
+        state.SkipWithError("engine failed to initialize");
+        return;
+    }
+    const auto& gestures = recognitionGestures(state.range(0));
+
+    // Warm the ideal path cache and scratch buffers, as a running keyboard is
+    for (const auto& g : gestures) engine.recognize(g);
+
+    std::vector<double> samplesUs;
+    size_t i = 0;
+    for (auto _ : state) {
+        Clock::time_point start = Clock::now();
+        auto candidates = engine.recognize(gestures[i]);
+        benchmark::DoNotOptimize(candidates.data());
+        samplesUs.push_back(elapsedUs(start));
+        if (++i == gestures.size()) i = 0;
+    }
+    reportLatency(state, samplesUs);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Recognize)
+    ->ArgNames({"corpus", "compiled"})
+    ->Args({kFull, 0})->Args({kFull, 1})
+    ->Args({kSynthetic, 0})->Args({kSynthetic, 1})->Args({kSynthetic, 2})
+    ->Args({kSynthetic, 3})->Args({kSynthetic, 4})->Args({kSynthetic, 5})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * A gesture recognized right after an earlier one, as a suggestion strip
+ * refresh or a word swiped again does. Only the second call is timed.
+ * Args: corpus, near (0 = the same gesture again, answered by the result
+ * cache; 1 = the gesture moved by up to 1 dp per point, scored with a
+ * threshold seeded from the first).
+ */
+void BM_RecognizeRepeated(benchmark::State& state) {
+    GestureEngine& engine = engineFor(state.range(0), 1);
+    if (!engine.isInitialized()) {
+        state.SkipWithError("engine failed to initialize");
+        return;
+    }
+    const auto& gestures = recognitionGestures(state.range(0));
+    std::vector<RawGesturePath> again = gestures;
+    if (state.range(1) != 0) {
+        for (auto& g : again) {
+            for (size_t p = 0; p < g.points.size(); ++p) {
+                g.points[p].x += static_cast<float>(p % 3) - 1.0f;
+                g.points[p].y += static_cast<float>(p % 2) - 0.5f;
+            }
+        }
+    }
+    for (const auto& g : gestures) engine.recognize(g);
+
+    std::vector<double> samplesUs;
+    size_t i = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        engine.recognize(gestures[i]);
+        state.ResumeTiming();
+        Clock::time_point start = Clock::now();
+        auto candidates = engine.recognize(again[i]);
+        benchmark::DoNotOptimize(candidates.data());
+        samplesUs.push_back(elapsedUs(start));
+        if (++i == gestures.size()) i = 0;
+    }
+    const ResultCacheStats cache = engine.getResultCacheStats();
+    state.counters["hits"] = static_cast<double>(cache.hits);
+    state.counters["nearHits"] = static_cast<double>(cache.nearHits);
+    reportLatency(state, samplesUs);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_RecognizeRepeated)
+    ->ArgNames({"corpus", "near"})
+    ->Args({kFull, 0})->Args({kFull, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Recognition under ScoringConfig::scoringBudgetUs, on compiled templates.
+ * Reports the latency percentiles, the share of gestures the budget cut
+ * short, and the share whose top word is still that of full scoring.
+ * Args: corpus, budget in µs (0 = none).
+ */
+void BM_RecognizeBudget(benchmark::State& state) {
+    GestureEngine& engine = engineFor(state.range(0), 1);
+    if (!engine.isInitialized()) {
+        state.SkipWithError("engine failed to initialize");
+        return;
+    }
+    const auto& gestures = recognitionGestures(state.range(0));
+    std::vector<std::string> fullTop;
+    for (const auto& g : gestures) {
+        auto candidates = engine.recognize(g);
+        fullTop.push_back(candidates.empty() ? std::string() : candidates[0].word);
+    }
+    ScoringConfig config;
+    config.scoringBudgetUs = static_cast<int>(state.range(1));
+    config.resultCacheSize = 0;
+    engine.configure(config);
+
+    std::vector<double> samplesUs;
+    size_t truncated = 0, sameTop = 0;
+    size_t i = 0;
+    for (auto _ : state) {
+        Clock::time_point start = Clock::now();
+        auto candidates = engine.recognize(gestures[i]);
+        benchmark::DoNotOptimize(candidates.data());
+        samplesUs.push_back(elapsedUs(start));
+        truncated += engine.wasLastRecognitionTruncated() ? 1 : 0;
+        sameTop += !candidates.empty() && candidates[0].word == fullTop[i] ? 1 : 0;
+        if (++i == gestures.size()) i = 0;
+    }
+    engine.configure(ScoringConfig());
+    const double n = static_cast<double>(std::max<size_t>(1, samplesUs.size()));
+    state.counters["truncated"] = static_cast<double>(truncated) / n;
+    state.counters["sameTop"] = static_cast<double>(sameTop) / n;
+    reportLatency(state, samplesUs);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_RecognizeBudget)
+    ->ArgNames({"corpus", "budgetUs"})
+    ->Args({kSynthetic, 0})->Args({kSynthetic, 300})->Args({kSynthetic, 150})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Touch-up latency of a streamed gesture: the points are passed to
+ * addPoints() one by one, then 40 ms more on the last key as a finger
+ * settling before it lifts, and only endGesture() is timed. The result cache
+ * is off, so every gesture is scored.
+ * Args: corpus, compiled templates (0 / 1), ScoringConfig::inFlightRanking.
+ */
+void BM_StreamTouchUp(benchmark::State& state) {
+    GestureEngine& engine = engineFor(state.range(0), state.range(1));
+    if (!engine.isInitialized()) {
+        state.SkipWithError("engine failed to initialize");
+        return;
+    }
+    std::vector<RawGesturePath> gestures = recognitionGestures(state.range(0));
+    for (auto& g : gestures) {
+        const GesturePoint last = g.points.back();
+        for (int64_t hold = 10; hold <= 40; hold += 10) {
+            g.points.push_back(GesturePoint(last.x, last.y, last.timestamp + hold));
+        }
+    }
+    ScoringConfig config;
+    config.inFlightRanking = state.range(2) != 0;
+    config.resultCacheSize = 0;
+    engine.configure(config);
+    for (const auto& g : gestures) engine.recognize(g);
+
+    std::vector<double> samplesUs;
+    size_t seeded = 0;
+    size_t i = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        engine.beginGesture();
+        for (const auto& pt : gestures[i].points) engine.addPoints(&pt, 1);
+        state.ResumeTiming();
+        Clock::time_point start = Clock::now();
+        auto candidates = engine.endGesture();
+        benchmark::DoNotOptimize(candidates.data());
+        samplesUs.push_back(elapsedUs(start));
+        seeded += engine.getLastRecognitionStats().streamSeeds;
+        if (++i == gestures.size()) i = 0;
+    }
+    engine.configure(ScoringConfig());
+    state.counters["seeded"] =
+        static_cast<double>(seeded) / static_cast<double>(std::max<size_t>(1, samplesUs.size()));
+    reportLatency(state, samplesUs);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_StreamTouchUp)
+    ->ArgNames({"corpus", "compiled", "inFlight"})
+    ->Args({kFull, 0, 0})->Args({kFull, 0, 1})
+    ->Args({kSynthetic, 0, 0})->Args({kSynthetic, 0, 1})
+    ->Args({kSynthetic, 1, 0})->Args({kSynthetic, 1, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * The first gestures after init, as when the keyboard appears: a new engine
+ * per iteration, its warm-up (if any) finished before the first swipe, and
+ * the first 16 gestures timed. Latency over all of them. FULL on the
+ * synthetic corpus compiles its templates for seconds per iteration, so it
+ * runs a fixed 4.
+ * Args: corpus, ScoringConfig::warmup (0 = OFF, 1 = FREQUENT, 2 = FULL).
+ */
+void BM_SessionStart(benchmark::State& state) {
+    constexpr size_t kFirstGestures = 16;
+    const auto& bytes = dictionaryBytes(state.range(0), 2);
+    const auto& gestures = recognitionGestures(state.range(0));
+    ScoringConfig config;
+    config.warmup = static_cast<WarmupLevel>(state.range(1));
+
+    std::vector<double> samplesUs;
+    for (auto _ : state) {
+        state.PauseTiming();
+        GestureEngine engine;
+        engine.configure(config);
+        if (!engine.initWithData(qwerty(), bytes.data(), bytes.size(),
+                                 DictionaryStorage::BORROW)) {
+            state.SkipWithError("engine failed to initialize");
+            return;
+        }
+        while (engine.getWarmupProgress().state == WarmupState::RUNNING) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // Every level idles before its first gesture, not only those that
+        // wait for a warm-up: an idle core starts with cold caches
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        state.ResumeTiming();
+        for (size_t i = 0; i < kFirstGestures && i < gestures.size(); ++i) {
+            Clock::time_point start = Clock::now();
+            auto candidates = engine.recognize(gestures[i]);
+            benchmark::DoNotOptimize(candidates.data());
+            samplesUs.push_back(elapsedUs(start));
+        }
+    }
+    reportLatency(state, samplesUs);
+    state.SetItemsProcessed(static_cast<int64_t>(samplesUs.size()));
+}
+BENCHMARK(BM_SessionStart)
+    ->ArgNames({"corpus", "warmup"})
+    ->Args({kFull, 0})->Args({kFull, 1})->Args({kFull, 2})
+    ->Args({kSynthetic, 0})->Args({kSynthetic, 1})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SessionStart)
+    ->ArgNames({"corpus", "warmup"})
+    ->Args({kSynthetic, 2})
+    ->Iterations(4)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <optional>
 #include <vector>
 #include <cstdint>
 #include "SwipeTypeTypes.h"
@@ -10,8 +12,20 @@
  * @brief Loads binary .glide dictionary files.
  *
  * The dictionary loader reads the custom binary format produced by
- * scripts/gen_dict.py. It validates the file header, reads all entries,
- * and provides lookup by word and iteration over all entries.
+ * scripts/gen_dict.py and provides lookup by word and access by index.
+ *
+ * Entry indices are also ordered by a bucket index (first letter, last
+ * letter, word length). Candidate lookups during recognition are contiguous
+ * spans of that order instead of scans over the whole dictionary.
+ *
+ * Version-2 files carry the record offset table, the bucket index and a
+ * lookup hash table as sections, so opening one only validates the header
+ * and section bounds; nothing is parsed. Version-1 files are still accepted:
+ * they are walked once at load to build the same tables in memory.
+ *
+ * Entries do not own their strings: DictionaryEntry::word is a view into the
+ * dictionary bytes, which are memory-mapped from the file, copied once into a
+ * single buffer, or borrowed from the caller (see DictionaryStorage).
  *
  * Thread safety: After loading, read-only operations (lookup, iteration)
  * are thread-safe. Loading/unloading are NOT thread-safe.
@@ -23,22 +37,52 @@ namespace swipetype {
  * @brief A single dictionary entry.
  */
 struct DictionaryEntry {
-    std::string word;        ///< UTF-8 encoded word string
+    std::string_view word;   ///< UTF-8 word; view into the dictionary bytes
     uint32_t frequency = 0;  ///< Frequency (higher = more common)
     uint8_t flags = 0;       ///< Bitmask: DICT_FLAG_PROPER_NOUN, DICT_FLAG_PROFANITY
 };
 
+/**
+ * @brief Where the bytes behind DictionaryEntry views live.
+ */
+enum class DictionaryStorage : int {
+    /** Copy the input into one loader-owned buffer. */
+    COPY = 0,
+    /** mmap() the file read-only. Pages are shared and evictable. File loads only. */
+    MEMORY_MAP = 1,
+    /** Use the caller's buffer directly. It must outlive the loaded dictionary. */
+    BORROW = 2
+};
+
 /**
  * @brief Parsed dictionary file header.
  */
 struct DictionaryHeader {
     uint32_t magic = 0;
     uint16_t version = 0;
-    uint16_t flags = 0;
+    uint16_t flags = 0;      ///< Bitmask: DICT_HEADER_SORTED, DICT_HEADER_FREQUENCY_BUCKETS
     uint32_t entryCount = 0;
     std::string languageTag;
 };
 
+/**
+ * @brief A contiguous, read-only run of entry indices.
+ *
+ * Returned by the bucket index queries of DictionaryLoader. Each value is an
+ * entry index for DictionaryLoader::getEntry(). The span stays valid until
+ * the dictionary is unloaded or reloaded.
+ */
+struct DictionaryIndexSpan {
+    const uint32_t* data = nullptr;
+    size_t count = 0;
+
+    const uint32_t* begin() const { return data; }
+    const uint32_t* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    uint32_t operator[](size_t i) const { return data[i]; }
+};
+
 /**
  * @brief Loads and provides access to a binary .glide dictionary.
  *
@@ -66,23 +110,32 @@ public:
     /**
      * @brief Load a dictionary from a binary .glide file.
      *
-     * Validates the header (magic, version) and reads all entries into memory.
+     * Validates the header (magic, version) and section bounds. Version-1
+     * files are additionally walked once to index their records.
      * If a dictionary is already loaded, it is unloaded first.
      *
      * @param filePath  Absolute path to the .glide dictionary file.
+     * @param storage   MEMORY_MAP (default) maps the file; COPY reads it into
+     *                  one owned buffer. If mapping fails the loader falls back
+     *                  to COPY. BORROW is treated as MEMORY_MAP.
      * @return true on success; false on file not found, corrupt header,
      *         or version mismatch. Check getLastError() for details.
      */
-    bool load(const std::string& filePath);
+    bool load(const std::string& filePath,
+              DictionaryStorage storage = DictionaryStorage::MEMORY_MAP);
 
     /**
      * @brief Load a dictionary from a memory buffer.
      *
-     * @param data  Pointer to the buffer containing the dictionary file contents.
-     * @param size  Size of the buffer in bytes.
+     * @param data     Pointer to the buffer containing the dictionary file contents.
+     * @param size     Size of the buffer in bytes.
+     * @param storage  COPY (default) takes one copy of the buffer; BORROW keeps
+     *                 views into it, so the caller must keep it alive and
+     *                 unchanged until unload(). MEMORY_MAP is treated as COPY.
      * @return true on success; false on invalid data.
      */
-    bool loadFromMemory(const uint8_t* data, size_t size);
+    bool loadFromMemory(const uint8_t* data, size_t size,
+                        DictionaryStorage storage = DictionaryStorage::COPY);
 
     /**
      * @brief Unload the current dictionary and free memory.
@@ -117,13 +170,76 @@ public:
 
     /**
      * @brief Get all dictionary entries.
-     * @return Reference to the internal entry vector. Empty if not loaded.
+     *
+     * The vector is built on the first call after each load (thread-safe).
+     * Hot paths should use getEntry() with index spans instead.
+     *
+     * @return Reference to the entry vector. Empty if not loaded.
      */
     const std::vector<DictionaryEntry>& getAllEntries() const;
 
+    /**
+     * @brief Get a single entry by index.
+     *
+     * Decodes the record in place; no allocation.
+     *
+     * @param index  Entry index, e.g. a value from a DictionaryIndexSpan.
+     * @return The entry. Empty (word empty, frequency 0) if index is out of
+     *         range or the record is damaged.
+     */
+    DictionaryEntry getEntry(uint32_t index) const;
+
+    /**
+     * @brief Get the indices of all non-empty entries in bucket order.
+     *
+     * Ordered by first letter, then last letter, then word length.
+     * @return Span over the whole bucket index. Empty if not loaded.
+     */
+    DictionaryIndexSpan getIndexedEntries() const;
+
+    /**
+     * @brief Get the indices of entries whose word starts with startChar.
+     *
+     * Letters are matched case-insensitively. For characters outside 'a'–'z'
+     * the span covers every entry whose first byte is not an ASCII letter,
+     * so callers must check the exact character themselves.
+     *
+     * @param startChar  First character (ASCII)
+     * @return Span ordered by last letter, then word length, then
+     *         frequency descending (ties by index).
+     */
+    DictionaryIndexSpan getStartBucket(char startChar) const;
+
+    /**
+     * @brief Get the indices of entries starting with startChar and ending with endChar.
+     *
+     * Same letter-class rules as getStartBucket().
+     *
+     * @param startChar  First character (ASCII)
+     * @param endChar    Last character (ASCII)
+     * @return Span ordered by word length ascending, then frequency
+     *         descending (ties by index).
+     */
+    DictionaryIndexSpan getBucket(char startChar, char endChar) const;
+
+    /**
+     * @brief Get a start/end bucket sliced to a word length range.
+     *
+     * @param startChar  First character (ASCII)
+     * @param endChar    Last character (ASCII)
+     * @param minLength  Minimum word length in bytes (inclusive)
+     * @param maxLength  Maximum word length in bytes (inclusive)
+     * @return Sub-span of getBucket(startChar, endChar): one run in
+     *         frequency order per length. Empty if minLength > maxLength.
+     */
+    DictionaryIndexSpan getBucket(char startChar, char endChar,
+                                  uint32_t minLength, uint32_t maxLength) const;
+
     /**
      * @brief Get entries whose word starts with the given character.
      *
+     * Thin wrapper over getStartBucket().
+     *
      * @param startChar  Starting character (lowercase ASCII expected).
      * @return Vector of matching entries. Empty if none found or not loaded.
      */
@@ -132,7 +248,7 @@ public:
     /**
      * @brief Get entries whose word starts with startChar and ends with endChar.
      *
-     * This is the primary candidate filtering method used during recognition.
+     * Thin wrapper over getBucket(). GestureEngine uses the span form directly.
      *
      * @param startChar  First character (lowercase ASCII)
      * @param endChar    Last character (lowercase ASCII)
@@ -144,10 +260,32 @@ public:
     /**
      * @brief Look up a specific word.
      *
-     * @param word  Word to look up (case-insensitive).
-     * @return Pointer to the entry, or nullptr if not found.
+     * One probe sequence in the case-folded hash table (read from version-2
+     * files, built at load for version 1); no allocation.
+     * ASCII letters are compared case-insensitively. If several entries fold
+     * to the same word, the one with the lowest index is returned.
+     *
+     * @param word  Word to look up.
+     * @return The entry, or std::nullopt if not found.
+     */
+    std::optional<DictionaryEntry> lookup(std::string_view word) const;
+
+    /**
+     * @brief Write the loaded dictionary in the current (version-2) format.
+     *
+     * Entry order, bucket order and lookup results are preserved, so this
+     * also converts version-1 files. The output matches scripts/gen_dict.py.
+     *
+     * @param out  Receives the file bytes (replaced).
+     * @return false if no dictionary is loaded.
+     */
+    bool serialize(std::vector<uint8_t>& out) const;
+
+    /**
+     * @return How the currently loaded dictionary bytes are stored.
+     *         MEMORY_MAP only if the file was actually mapped.
      */
-    const DictionaryEntry* lookup(const std::string& word) const;
+    DictionaryStorage getStorage() const;
 
     /**
      * @brief Get the last error that occurred.
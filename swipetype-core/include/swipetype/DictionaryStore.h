@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "DictionaryLoader.h"
+#include "LexiconTrie.h"
+#include "SwipeTypeTypes.h"
+
+/**
+ * @file DictionaryStore.h
+ * @brief Loaded dictionary and its lexicon trie, shareable between engines.
+ *
+ * A store holds the layout-independent data of one dictionary: the
+ * DictionaryLoader and the LexiconTrie built from it. Load it once, then
+ * hand it to any number of GestureEngines as a
+ * std::shared_ptr<const DictionaryStore>; each engine keeps only its own
+ * layout, configuration, path cache and scratch buffers. The store is freed
+ * when the last engine releases it.
+ *
+ * Thread safety: After load() or loadFromMemory(), every const method is
+ * thread-safe, so engines sharing a store recognize concurrently without
+ * locking. load(), loadFromMemory() and unload() are NOT thread-safe and
+ * must not be called once the store is shared.
+ */
+
+namespace swipetype {
+
+/**
+ * @brief Read-only dictionary data shared by several GestureEngines.
+ *
+ * Usage:
+ * @code
+ *   auto store = std::make_shared<DictionaryStore>();
+ *   if (store->load("/path/to/dictionary.glide")) {
+ *       imeEngine.initWithStore(imeLayout, store);
+ *       floatingEngine.initWithStore(floatingLayout, store);
+ *   }
+ * @endcode
+ */
+class DictionaryStore {
+public:
+    DictionaryStore();
+    ~DictionaryStore();
+
+    // Non-copyable, movable
+    DictionaryStore(const DictionaryStore&) = delete;
+    DictionaryStore& operator=(const DictionaryStore&) = delete;
+    DictionaryStore(DictionaryStore&&) noexcept;
+    DictionaryStore& operator=(DictionaryStore&&) noexcept;
+
+    /**
+     * @brief Load a .glide file and build its lexicon trie.
+     *
+     * @param filePath  Absolute path to the .glide dictionary file.
+     * @param storage   See DictionaryLoader::load().
+     * @return false if the file is missing or invalid; see getLastError().
+     */
+    bool load(const std::string& filePath,
+              DictionaryStorage storage = DictionaryStorage::MEMORY_MAP);
+
+    /**
+     * @brief Load a dictionary from memory and build its lexicon trie.
+     *
+     * @param data     Dictionary file contents.
+     * @param size     Size of data in bytes.
+     * @param storage  See DictionaryLoader::loadFromMemory(). With BORROW the
+     *                 caller keeps data alive until the store is destroyed.
+     * @return false on invalid data; see getLastError().
+     */
+    bool loadFromMemory(const uint8_t* data, size_t size,
+                        DictionaryStorage storage = DictionaryStorage::COPY);
+
+    /**
+     * @brief Release the dictionary and the trie.
+     */
+    void unload();
+
+    /**
+     * @return true if a dictionary is loaded.
+     */
+    bool isLoaded() const;
+
+    /**
+     * @return The dictionary; not loaded until load() succeeds.
+     */
+    const DictionaryLoader& getDictionary() const;
+
+    /**
+     * @return The lexicon trie of the dictionary; not built until load()
+     *         succeeds.
+     */
+    const LexiconTrie& getLexicon() const;
+
+    /**
+     * @return Error of the last failed load.
+     */
+    ErrorInfo getLastError() const;
+
+private:
+    struct Impl;
+    Impl* pImpl;
+};
+
+} // namespace swipetype
@@ -25,8 +25,10 @@ struct GestureCandidate {
 
     /** Source flags bitmask:
      *  - SOURCE_MAIN_DICT (0x01): word from main dictionary
-     *  - SOURCE_USER_DICT (0x02): word from user dictionary (future)
-     *  - SOURCE_COMPLETION (0x04): prefix completion (future) */
+     *  - SOURCE_USER_DICT (0x02): word from the UserDictionary (GestureEngine::setUserDictionary())
+     *  - SOURCE_COMPLETION (0x04): prefix completion (future)
+     *  Words of a dictionary added with GestureEngine::addDictionary() carry
+     *  the flags given there, OR-ed when several dictionaries have the word. */
     uint32_t sourceFlags = 0;
 
     /** Raw DTW distance (for debugging/tuning). Lower = better match.
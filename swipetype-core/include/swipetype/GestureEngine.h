@@ -1,10 +1,16 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include "GesturePath.h"
 #include "GestureCandidate.h"
 #include "KeyboardLayout.h"
+#include "DictionaryLoader.h"
+#include "DictionaryStore.h"
+#include "TemplateStore.h"
+#include "UserDictionary.h"
 #include "SwipeTypeTypes.h"
 
 /**
@@ -13,7 +19,7 @@
  *
  * GestureEngine orchestrates the entire recognition pipeline:
  * 1. Path normalization (PathProcessor)
- * 2. Candidate generation (DictionaryLoader + start/end key filtering)
+ * 2. Candidate generation (LexiconTrie walk, or start/end key buckets)
  * 3. Ideal path generation (IdealPathGenerator)
  * 4. DTW scoring (Scorer)
  * 5. Ranking and pruning
@@ -33,15 +39,81 @@
  *   engine.shutdown();
  * @endcode
  *
+ * A gesture can also be streamed while the finger moves, so that only the
+ * final scoring is left for touch-up:
+ * @code
+ *   engine.beginGesture();
+ *   engine.addPoints(batch);            // on every touch-move batch
+ *   auto candidates = engine.endGesture(5);
+ * @endcode
+ *
+ * Several engines (e.g. one per keyboard surface) can share one copy of the
+ * dictionary and, for equal layouts, of the compiled templates:
+ * @code
+ *   second.initWithStore(otherLayout, first.getDictionaryStore());
+ *   third.initWithStore(layout, first.getDictionaryStore());
+ *   third.attachTemplates(first.getTemplateStore());
+ * @endcode
+ *
+ * A bilingual keyboard recognizes against several dictionaries at once,
+ * merged into one ranking:
+ * @code
+ *   engine.init(layout, "en.glide");
+ *   engine.addDictionary(germanStore, 0.8f, SOURCE_MAIN_DICT);
+ * @endcode
+ *
+ * Words the user adds, and frequencies learned from accepted suggestions,
+ * are kept in a UserDictionary recognized with the others:
+ * @code
+ *   engine.setUserDictionary(user);
+ *   user->bumpFrequency(accepted.word, 1'000);
+ * @endcode
+ *
+ * A new layout or dictionary can be prepared in the background while the
+ * engine keeps recognizing with the old one:
+ * @code
+ *   engine.updateLayoutAsync(landscape, [](bool swapped, const ErrorInfo&) { ... });
+ *   engine.reloadDictionaryAsync(updatedDictPath);
+ * @endcode
+ *
+ * So that the first gestures of a session are not scored against a cold
+ * path cache, init can return as soon as the dictionary is usable and
+ * leave the rest to a background warm-up:
+ * @code
+ *   config.warmup = WarmupLevel::FULL;
+ *   engine.configure(config);
+ *   engine.init(layout, "en.glide");           // returns once indexed
+ *   engine.getWarmupProgress();                // poll, e.g. for a readiness flag
+ * @endcode
+ *
  * Thread safety: NOT thread-safe. External synchronization required.
  * Callers must not call recognize() concurrently on the same instance.
+ * Different instances may recognize concurrently, also while they share a
+ * DictionaryStore or TemplateStore; shared stores are read-only. The
+ * exceptions are updateLayoutAsync(), reloadDictionaryAsync(),
+ * waitForSwap(), getDictionaryStore(), getTemplateStore(),
+ * getWarmupProgress() and cancelWarmup(), which may be called from another
+ * thread while this instance recognizes. A
+ * UserDictionary must only be changed while no engine using it recognizes.
  *
  * Ownership: Caller retains ownership of all passed objects.
- * The engine copies layout and dictionary data internally.
+ * The engine copies layout and dictionary data internally, unless
+ * initWithData() is called with DictionaryStorage::BORROW. Shared stores
+ * are reference-counted and freed with their last engine.
  */
 
 namespace swipetype {
 
+/** Receives intermediate candidates for a gesture in progress. */
+using PreviewCallback = std::function<void(const std::vector<GestureCandidate>& candidates)>;
+
+/**
+ * Reports the end of a background swap: swapped is true once the new layout
+ * or dictionary is in use, false (with the reason in error) if it was not
+ * loaded and the engine keeps the old one.
+ */
+using SwapCallback = std::function<void(bool swapped, const ErrorInfo& error)>;
+
 class GestureEngine {
 public:
     GestureEngine();
@@ -57,11 +129,14 @@ public:
      * @brief Initialize the engine with a keyboard layout and dictionary.
      *
      * Must be called before any recognize() invocation. Can be called
-     * again to change layout or dictionary (re-initialization).
+     * again to change layout or dictionary (re-initialization). Starts the
+     * warm-up set by ScoringConfig::warmup (see getWarmupProgress()), after
+     * cancelling one still running, and returns without waiting for it.
      *
      * @param layout    Keyboard layout descriptor. Must have at least one
      *                  character key. Coordinates in dp units.
      * @param dictPath  Absolute path to the binary .glide dictionary file.
+     *                  The file is memory-mapped read-only.
      * @return true on success; false if dictionary file not found, corrupt,
      *         or layout is invalid.
      *
@@ -75,16 +150,119 @@ public:
      * @param layout  Keyboard layout descriptor.
      * @param dictData  Pointer to dictionary file contents in memory.
      * @param dictSize  Size of dictionary data in bytes.
+     * @param storage   COPY (default) keeps one private copy of the data.
+     *                  BORROW uses dictData in place; the caller must keep it
+     *                  alive and unchanged until shutdown() or re-init.
      * @return true on success.
      */
     bool initWithData(const KeyboardLayout& layout,
-                      const uint8_t* dictData, size_t dictSize);
+                      const uint8_t* dictData, size_t dictSize,
+                      DictionaryStorage storage = DictionaryStorage::COPY);
+
+    /**
+     * @brief Initialize with a loaded dictionary shared with other engines.
+     *
+     * init() and initWithData() load a private store; this attaches to an
+     * existing one instead. The engine keeps its own layout, configuration,
+     * ideal-path cache, scratch buffers, warm-up and last error.
+     *
+     * @param layout  Keyboard layout descriptor.
+     * @param store   Loaded store, e.g. another engine's getDictionaryStore().
+     * @return false if the layout is invalid or the store is null or not loaded.
+     */
+    bool initWithStore(const KeyboardLayout& layout,
+                       std::shared_ptr<const DictionaryStore> store);
+
+    /**
+     * @return The main dictionary store in use, to share with another
+     *         engine; null if not initialized.
+     */
+    std::shared_ptr<const DictionaryStore> getDictionaryStore() const;
+
+    /**
+     * @brief Recognize against another dictionary as well.
+     *
+     * Each gesture is normalized once; candidates are then gathered from
+     * every dictionary, scored against the same path (spread over the
+     * scoring pool together, see ScoringConfig::scoringThreads) and ranked
+     * in one list. A word's frequency counts relative to its own
+     * dictionary's most frequent word, times weight, so a weight below 1
+     * favours the other dictionaries when shapes are close. A word in
+     * several dictionaries is returned once, with their flags combined.
+     *
+     * Templates are compiled for the dictionary if compileTemplates() is in
+     * use. Kept across updateLayout() and the background swaps; dropped by
+     * init(), initWithData(), initWithStore() and shutdown().
+     *
+     * @param store        Loaded store; may be shared with other engines.
+     * @param weight       Frequency prior of its words, >= 0. The main
+     *                     dictionary's is 1.
+     * @param sourceFlags  GestureCandidate::sourceFlags of its words, e.g.
+     *                     SOURCE_MAIN_DICT or SOURCE_USER_DICT.
+     * @return false if the engine is not initialized, the store is not
+     *         loaded (DICT_NOT_FOUND), or it is already in use or weight is
+     *         negative or not finite (INVALID_ARGUMENT).
+     */
+    bool addDictionary(std::shared_ptr<const DictionaryStore> store, float weight = 1.0f,
+                       uint32_t sourceFlags = SOURCE_MAIN_DICT);
+
+    /**
+     * @brief Stop recognizing against a dictionary added by addDictionary().
+     *
+     * @return false if store is not an added dictionary.
+     */
+    bool removeDictionary(const std::shared_ptr<const DictionaryStore>& store);
+
+    /**
+     * @return Number of dictionaries in use, the main one included and the
+     *         user dictionary not; 0 if not initialized.
+     */
+    size_t getDictionaryCount() const;
+
+    /**
+     * @brief Recognize the words of a user dictionary as well.
+     *
+     * Its words are candidates by their first and last letter (no lexicon
+     * walk) and are returned with SOURCE_USER_DICT. Their frequencies count
+     * in the units of the main dictionary: one as frequent as the main
+     * dictionary's most frequent word scores the full frequency prior. A
+     * word also in another dictionary is returned once, with both flags, so
+     * bumping the frequency of an accepted dictionary word raises it too.
+     *
+     * Changes to the user dictionary take effect with the next recognition;
+     * no reload is needed. The engine keeps its templates for the current
+     * layout, regenerating them on the recognizing thread when the layout
+     * changes; engines sharing one should therefore use the same layout.
+     * Kept across updateLayout() and the background swaps; dropped by
+     * init(), initWithData(), initWithStore() and shutdown().
+     *
+     * @param user  The user dictionary, or null to stop using one.
+     * @return false if the engine is not initialized.
+     */
+    bool setUserDictionary(std::shared_ptr<UserDictionary> user);
+
+    /**
+     * @return The user dictionary in use, or null.
+     */
+    std::shared_ptr<UserDictionary> getUserDictionary() const;
 
     /**
      * @brief Recognize a gesture path and return ranked word candidates.
      *
      * Pipeline: normalize → filter candidates → score → rank → return.
      *
+     * A gesture that normalizes to the same points (to 1/RESULT_CACHE_QUANTUM)
+     * and keys as one of the last ScoringConfig::resultCacheSize gestures
+     * gets that gesture's ranking back without being scored; a gesture
+     * close to one starts scoring with the threshold that one's words give
+     * it, which prunes more but returns the same ranking. Cached rankings
+     * are dropped whenever the layout, dictionaries, templates, user
+     * dictionary or configuration change (see getResultCacheStats()).
+     *
+     * With a scoring budget (ScoringConfig::scoringBudgetUs,
+     * scoringBudgetDtwCalls), candidates are scored in frequency order
+     * until it is used up; see wasLastRecognitionTruncated().
+     *
      * @param rawPath        Raw gesture path. Must contain >= 2 points.
      * @param maxCandidates  Maximum results to return. Clamped to [1, 20].
      *                       Default: 8.
@@ -98,6 +276,95 @@ public:
     std::vector<GestureCandidate> recognize(const RawGesturePath& rawPath,
                                              int maxCandidates = DEFAULT_MAX_CANDIDATES);
 
+    /**
+     * @brief Recognize many gestures at once, e.g. to replay logged input.
+     *
+     * Each result equals recognize() on the same gesture. Gestures are
+     * normalized, then sorted by start/end key and length so gestures that
+     * share a candidate bucket are scored back to back, keeping its ideal
+     * paths in cache. With ScoringConfig::scoringThreads > 1 the pool
+     * spreads gestures (not candidates) across its threads.
+     *
+     * @param paths          Raw gesture paths.
+     * @param count          Number of paths.
+     * @param maxCandidates  Maximum results per gesture. Clamped to [1, 20].
+     * @return One candidate list per gesture, in input order. A list is empty
+     *         if its gesture is too short; all are empty if the engine is
+     *         not initialized.
+     */
+    std::vector<std::vector<GestureCandidate>> recognizeBatch(
+            const RawGesturePath* paths, size_t count,
+            int maxCandidates = DEFAULT_MAX_CANDIDATES);
+
+    /** @copydoc recognizeBatch(const RawGesturePath*, size_t, int) */
+    std::vector<std::vector<GestureCandidate>> recognizeBatch(
+            const std::vector<RawGesturePath>& paths,
+            int maxCandidates = DEFAULT_MAX_CANDIDATES);
+
+    /**
+     * @brief Start streaming a gesture.
+     *
+     * Discards any gesture already in progress. Points are then added with
+     * addPoints() as they arrive; deduplication, arc length, the start key
+     * and the key-transition length estimate are updated per point, and
+     * ideal paths of plausible candidates are generated ahead of touch-up.
+     *
+     * @return false if the engine is not initialized.
+     */
+    bool beginGesture();
+
+    /**
+     * @brief Append raw points to the gesture in progress.
+     *
+     * May invoke the preview callback (see setPreviewCallback()) before
+     * returning.
+     *
+     * @param points  Points in drawing order, continuing the earlier ones.
+     * @param count   Number of points.
+     * @return false if no gesture is in progress.
+     */
+    bool addPoints(const GesturePoint* points, size_t count);
+
+    /** @copydoc addPoints(const GesturePoint*, size_t) */
+    bool addPoints(const std::vector<GesturePoint>& points);
+
+    /**
+     * @brief Finish the gesture in progress and recognize it.
+     *
+     * Returns the same candidates as recognize() on all streamed points.
+     *
+     * @param maxCandidates  Maximum results to return. Clamped to [1, 20].
+     * @return Ranked candidates, best first. Empty if no gesture was in
+     *         progress or it has fewer than MIN_GESTURE_POINTS points.
+     */
+    std::vector<GestureCandidate> endGesture(int maxCandidates = DEFAULT_MAX_CANDIDATES);
+
+    /**
+     * @brief Abandon the gesture in progress without recognizing it.
+     */
+    void cancelGesture();
+
+    /**
+     * @return true between beginGesture() and endGesture()/cancelGesture().
+     */
+    bool isGestureInProgress() const;
+
+    /**
+     * @brief Receive candidates while a gesture is still being drawn.
+     *
+     * During streaming, addPoints() recognizes the partial gesture whenever
+     * its latest timestamp is at least intervalMs past the previous preview
+     * (or the first point), and passes the result to callback on the calling
+     * thread. Each preview costs one recognition of the points so far.
+     *
+     * @param callback       Preview receiver. Pass nullptr to disable previews.
+     * @param intervalMs     Gesture time between previews (minimum 1).
+     * @param maxCandidates  Candidates per preview. Clamped to [1, 20].
+     */
+    void setPreviewCallback(PreviewCallback callback,
+                            int intervalMs = DEFAULT_PREVIEW_INTERVAL_MS,
+                            int maxCandidates = DEFAULT_MAX_CANDIDATES);
+
     /**
      * @brief Shut down the engine and free all resources.
      *
@@ -114,27 +381,197 @@ public:
      */
     bool isInitialized() const;
 
+    /**
+     * @brief Precompile the ideal-path template of every dictionary word.
+     *
+     * Afterwards recognize() reads templates by entry index from a
+     * TemplateStore instead of generating and caching paths per word.
+     * Costs 584 bytes per dictionary entry, or 328 / 200 with
+     * ScoringConfig::templatePrecision UINT16 / UINT8. Templates are dropped
+     * by init(), initWithData() and shutdown(), and recompiled by
+     * updateLayout() and by configure() with a different precision. Cancels
+     * the warm-up, whose templates this replaces.
+     *
+     * @param cacheDir  Optional existing directory for a persisted cache. The
+     *                  file name contains the layout hash and precision; a
+     *                  matching file is loaded instead of compiling,
+     *                  otherwise the compiled store is written there.
+     *                  Empty = memory only.
+     * @return true if templates are available; false if not initialized.
+     */
+    bool compileTemplates(const std::string& cacheDir = std::string());
+
+    /**
+     * @return true if compileTemplates() succeeded for the current layout.
+     */
+    bool hasCompiledTemplates() const;
+
+    /**
+     * @brief Use templates compiled by another engine.
+     *
+     * The store is shared, not copied. It is replaced by a private one when
+     * updateLayout() or a precision change in configure() recompiles, and
+     * dropped like compiled templates otherwise.
+     *
+     * @param templates  Compiled store for this engine's dictionary store,
+     *                   e.g. another engine's getTemplateStore().
+     * @return false (templates unchanged) if not initialized, or if the
+     *         store is not compiled for this layout and dictionary size.
+     */
+    bool attachTemplates(std::shared_ptr<const TemplateStore> templates);
+
+    /**
+     * @return The compiled templates in use, to share with another engine
+     *         with the same layout; null if none are compiled.
+     */
+    std::shared_ptr<const TemplateStore> getTemplateStore() const;
+
     /**
      * @brief Update the keyboard layout without reloading the dictionary.
      *
-     * Clears cached ideal paths (since key positions changed).
-     * The engine must already be initialized.
+     * Clears cached ideal paths and recompiles templates (if
+     * compileTemplates() was used) when key positions or letters changed,
+     * and then restarts the warm-up (see getWarmupProgress()). Cancels a
+     * streamed gesture. The engine must already be initialized.
+     * Waits for a background swap first (see waitForSwap()).
      *
      * @param layout  New keyboard layout.
      * @return true on success; false if layout is invalid.
      */
     bool updateLayout(const KeyboardLayout& layout);
 
+    /**
+     * @brief Switch to a new layout without blocking recognition.
+     *
+     * The key index, templates (if compileTemplates() was used) and a path
+     * cache warmed with the most frequent words are built on a background
+     * thread, then published as a whole. Recognition continues on the old
+     * layout until then; the next recognize(), recognizeBatch() or
+     * beginGesture() after publication uses the new one, and a gesture
+     * streamed since before finishes on the old one. The old layout's data
+     * is freed when no recognition uses it any more.
+     *
+     * Requests made while a swap is being built are merged and applied
+     * together once it is published. Unlike the synchronous methods, errors
+     * are not reported through the error callback or getLastError().
+     *
+     * @param layout  New keyboard layout.
+     * @param done    Optional; invoked on the background thread once the
+     *                swap is published or has failed.
+     * @return false if the engine is not initialized or layout is invalid
+     *         (done is not invoked); true if the swap was started.
+     */
+    bool updateLayoutAsync(const KeyboardLayout& layout, SwapCallback done = nullptr);
+
+    /**
+     * @brief Load a new dictionary without blocking recognition.
+     *
+     * Like updateLayoutAsync(), for the dictionary: the file is loaded and
+     * indexed, and templates recompiled, on the background thread. If the
+     * file cannot be loaded, done receives its error and the engine keeps
+     * the old dictionary.
+     *
+     * @param dictPath  Path to the new .glide dictionary.
+     * @param done      Optional; see updateLayoutAsync().
+     * @return false if the engine is not initialized.
+     */
+    bool reloadDictionaryAsync(const std::string& dictPath, SwapCallback done = nullptr);
+
+    /**
+     * @brief Switch to an already loaded, possibly shared, dictionary
+     *        without blocking recognition.
+     *
+     * @param store  Loaded dictionary store.
+     * @param done   Optional; see updateLayoutAsync().
+     * @return false if the engine is not initialized or store is not loaded.
+     */
+    bool reloadDictionaryAsync(std::shared_ptr<const DictionaryStore> store,
+                               SwapCallback done = nullptr);
+
+    /**
+     * @brief Block until background swaps have been published.
+     *
+     * Their callbacks have returned when this does. Called by the
+     * synchronous layout, dictionary, template and configuration methods.
+     * Must not be called from a SwapCallback.
+     */
+    void waitForSwap();
+
+    /**
+     * @brief Follow the background warm-up started by init.
+     *
+     * With ScoringConfig::warmup FREQUENT or FULL, init returns once the
+     * dictionary is indexed, and a background thread then generates the
+     * ideal paths of the ScoringConfig::warmupWordsPerBucket most frequent
+     * words of every start/end bucket, most frequent first and up to half
+     * the path cache. FULL then compiles templates for the whole dictionary,
+     * in memory only, as compileTemplates() without a cache directory.
+     * compileTemplates() with a cache directory loads them faster where a
+     * saved file exists.
+     *
+     * Gestures are recognized meanwhile as without a warm-up. Each stage's
+     * results are taken up by the first recognize(), recognizeBatch() or
+     * beginGesture() after it finishes: warmed paths are merged into the
+     * path cache, keeping those already looked up. They are dropped if the
+     * layout, dictionary, point count or template precision changed since
+     * init. The warm-up is cancelled by init, shutdown(), compileTemplates(),
+     * attachTemplates(), updateLayoutAsync() and an updateLayout() that
+     * moves keys, which then restarts it for the new layout.
+     *
+     * @return State and words done; IDLE if none was started.
+     */
+    WarmupProgress getWarmupProgress() const;
+
+    /**
+     * @brief Stop the warm-up early, e.g. when the keyboard is hidden
+     *        before it finishes.
+     *
+     * Returns at once; the background thread stops within a few hundred
+     * words. The paths it generated by then are still used.
+     */
+    void cancelWarmup();
+
     /**
      * @brief Configure scoring parameters.
      *
      * Can be called before or after init(). Parameters take effect
-     * on the next recognize() call.
+     * on the next recognize() call. After init(), a new resampleCount
+     * regenerates ideal paths and recompiles compiled templates before
+     * this returns. Cached rankings are dropped.
      *
      * @param config  Scoring configuration.
      */
     void configure(const ScoringConfig& config);
 
+    /**
+     * @brief Release memory the engine can rebuild on demand.
+     *
+     * Meant for Android's onTrimMemory(). MODERATE evicts the ideal-path
+     * cache down to half of ScoringConfig::pathCacheBytes; COMPLETE empties
+     * it, the result cache and the recognizeBatch() scratch buffers. The
+     * dictionary and compiled templates are kept, and later recognitions
+     * refill the caches up to their budgets.
+     *
+     * Must not be called while a recognition is running.
+     *
+     * @param level  How much to release.
+     */
+    void trimMemory(MemoryTrimLevel level);
+
+    /**
+     * @return Occupancy and hit/miss/eviction counters of the ideal-path
+     *         cache. The cache is bypassed while templates are compiled or
+     *         a scoring pool generates paths.
+     */
+    PathCacheStats getPathCacheStats() const;
+
+    /**
+     * @return Occupancy and hit/near-hit/miss/invalidation counters of the
+     *         result cache, which recognize() and endGesture() use (not
+     *         previews or recognizeBatch()).
+     */
+    ResultCacheStats getResultCacheStats() const;
+
     /**
      * @brief Set an error callback for asynchronous error reporting.
      *
@@ -145,6 +582,44 @@ public:
      */
     void setErrorCallback(ErrorCallback callback);
 
+    /**
+     * @brief Stats of the last recognize(), endGesture() or recognizeBatch().
+     *
+     * Previews (see setPreviewCallback()) do not replace them. A call
+     * that returns before scoring (not initialized, path too short)
+     * replaces them with zeros.
+     *
+     * @return Stage timings and counters; all zero before the first
+     *         recognition or when stats are compiled out.
+     */
+    RecognitionStats getLastRecognitionStats() const;
+
+    /**
+     * @brief Whether the scoring budget cut the last recognition short.
+     *
+     * With ScoringConfig::scoringBudgetUs or scoringBudgetDtwCalls set, a
+     * gesture stops being scored once the budget is used up, and its
+     * ranking covers only the candidates scored so far (the most frequent
+     * words first). Set for the same calls as getLastRecognitionStats(),
+     * for a batch if any of its gestures was cut short, and also when
+     * stats are compiled out.
+     *
+     * @return true if at least one candidate was left unscored.
+     */
+    bool wasLastRecognitionTruncated() const;
+
+    /**
+     * @brief Set a sink that receives the stats of every recognition.
+     *
+     * Invoked once per recognize(), endGesture() and recognizeBatch(), on
+     * the calling thread, after the results are complete. Formatting or
+     * logging belongs here (e.g. RecognitionStats::toString()), not in the
+     * pipeline. Never invoked when stats are compiled out.
+     *
+     * @param callback  Stats sink. Pass nullptr to clear.
+     */
+    void setStatsCallback(StatsCallback callback);
+
     /**
      * @brief Get the last error that occurred.
      * @return ErrorInfo with code and message.
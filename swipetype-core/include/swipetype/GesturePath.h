@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 #include "GesturePoint.h"
 
@@ -32,11 +33,11 @@ struct RawGesturePath {
  * @brief Normalized gesture path — the input to the scoring algorithm.
  *
  * After processing by PathProcessor::normalize(), this path has exactly
- * RESAMPLE_COUNT (64) points in a [0.0, 1.0] bounding box with
- * preserved aspect ratio.
+ * ScoringConfig::resampleCount (by default RESAMPLE_COUNT, 64) points in a
+ * [0.0, 1.0] bounding box with preserved aspect ratio.
  */
 struct GesturePath {
-    /** Exactly RESAMPLE_COUNT normalized points. */
+    /** Exactly resampleCount normalized points. */
     std::vector<NormalizedPoint> points;
 
     /** Original aspect ratio (width/height) before normalization.
@@ -55,9 +56,10 @@ struct GesturePath {
      *  last raw touch point. -1 if not determined. */
     int32_t endKeyIndex = -1;
 
-    /** @return true if the path has the expected number of points. */
+    /** @return true if the path has a supported number of points. */
     bool isValid() const {
-        return static_cast<int>(points.size()) == 64; // RESAMPLE_COUNT
+        const int count = static_cast<int>(points.size());
+        return count >= 16 && count <= 128; // MIN_RESAMPLE_COUNT .. MAX_RESAMPLE_COUNT
     }
 };
 
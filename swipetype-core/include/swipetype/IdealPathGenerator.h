@@ -1,8 +1,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include "GesturePath.h"
 #include "KeyboardLayout.h"
 #include "SwipeTypeTypes.h"
@@ -13,9 +13,13 @@
  *
  * For each word, the ideal path connects the key centers of each character
  * in sequence, then resamples and normalizes the result to match the format
- * of a normalized gesture path.
+ * of a normalized gesture path (setResampleCount() points).
  *
- * Ideal paths are cached after first generation for performance.
+ * Ideal paths are cached after first generation for performance. The cache
+ * has a fixed memory budget (ScoringConfig::pathCacheBytes): the points of
+ * every cached path live in one contiguous slab, indexed by slot, and once it
+ * is full CLOCK eviction replaces words that have not been looked up again
+ * since they were cached.
  *
  * Thread safety: NOT thread-safe.
  */
@@ -45,6 +49,21 @@ public:
      */
     void setLayout(const KeyboardLayout& layout);
 
+    /**
+     * @brief Set the number of points paths are resampled to.
+     *
+     * Clears the path cache if the count changes. Counts outside
+     * [MIN_RESAMPLE_COUNT, MAX_RESAMPLE_COUNT] are ignored.
+     *
+     * @param count  Points per path. Default: RESAMPLE_COUNT.
+     */
+    void setResampleCount(int count);
+
+    /**
+     * @return Number of points paths are resampled to.
+     */
+    int getResampleCount() const;
+
     /**
      * @brief Generate or retrieve the ideal path for a word.
      *
@@ -56,7 +75,32 @@ public:
      * @return Normalized ideal path. Empty path if word has no mappable characters
      *         or layout not set.
      */
-    GesturePath getIdealPath(const std::string& word);
+    GesturePath getIdealPath(std::string_view word);
+
+    /**
+     * @brief Like getIdealPath(), but returns a path the generator reuses.
+     *
+     * The cached points are copied into it from the slab, into storage kept
+     * from earlier lookups. Once a word is cached, looking it up again does
+     * not allocate memory, and neither does caching a word into a slot freed
+     * by eviction.
+     *
+     * @param word  UTF-8 encoded word string.
+     * @return Ideal path. It stays valid until the next lookup or the
+     *         generator's destruction.
+     */
+    const GesturePath& getIdealPathRef(std::string_view word);
+
+    /**
+     * @brief Generate the ideal path for a word without using the cache.
+     *
+     * Same result as getIdealPath(). Used for bulk template compilation
+     * (see TemplateStore), where caching every path would double memory.
+     *
+     * @param word  UTF-8 encoded word string.
+     * @return Normalized ideal path, or an empty path (see getIdealPath()).
+     */
+    GesturePath generatePath(std::string_view word) const;
 
     /**
      * @brief Pre-generate ideal paths for a batch of words.
@@ -68,9 +112,30 @@ public:
     void pregenerate(const std::vector<std::string>& words);
 
     /**
-     * @brief Clear the path cache.
+     * @brief Take over the paths another generator has cached.
+     *
+     * For paths prepared away from this generator, e.g. on another
+     * thread. Both must have the same layout and point count; paths of
+     * another count are dropped. Words already cached here keep their
+     * path. Merged paths count as looked up, so the CLOCK hand passes them
+     * once before they can be evicted. Once the cache is full, a merged
+     * path only replaces an entry that has not been looked up since the
+     * hand last passed, so merging never displaces recently used paths.
      *
-     * Call when the keyboard layout changes or to free memory.
+     * The smaller of the two caches is moved into the larger, whose
+     * storage this generator then keeps: merging into an empty cache takes
+     * no copies. The budget and counters stay this generator's.
+     *
+     * @param other  Generator to take cached paths from; left with an
+     *               empty cache.
+     */
+    void mergeCache(IdealPathGenerator&& other);
+
+    /**
+     * @brief Clear the path cache and free its memory.
+     *
+     * Call when the keyboard layout changes or to free memory. The hit, miss
+     * and eviction counters are kept.
      */
     void clearCache();
 
@@ -79,6 +144,34 @@ public:
      */
     size_t cacheSize() const;
 
+    /**
+     * @brief Set the memory budget of the path cache.
+     *
+     * The cache holds at most bytes / PathCacheStats::entryBytes paths,
+     * evicting in CLOCK order if it currently holds more. 0 disables caching:
+     * every lookup then generates the path.
+     *
+     * @param bytes  Budget in bytes. Default: DEFAULT_PATH_CACHE_BYTES.
+     */
+    void setCacheBudget(size_t bytes);
+
+    /**
+     * @brief Evict cached paths until they use at most bytes of memory.
+     *
+     * The remaining paths are compacted and the memory of the evicted ones
+     * is freed (see PathCacheStats::reservedBytes). The budget is unchanged:
+     * the cache grows back as words are looked up, doubling its storage as
+     * it refills. trimCache(0) is the same as clearCache().
+     *
+     * @param bytes  Memory the cache may keep.
+     */
+    void trimCache(size_t bytes);
+
+    /**
+     * @return Occupancy and hit/miss/eviction counters of the path cache.
+     */
+    PathCacheStats getCacheStats() const;
+
 private:
     struct Impl;
     Impl* pImpl;
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
-#include <cstdint>
 
 /**
  * @file KeyboardLayout.h
@@ -70,10 +71,38 @@ struct KeyboardLayout {
     /** Total keyboard height in dp. */
     float layoutHeight = 0.0f;
 
+    /** Lookup tables built by buildLookup(), shared between copies. */
+    struct Lookup;
+    std::shared_ptr<const Lookup> lookup;
+
+    /**
+     * @brief Build lookup tables for findNearestKey() and findKeyByCodePoint().
+     *
+     * A uniform grid over the keyboard lists, for each cell, the few keys
+     * that can be nearest to a point inside it, and a table maps code points
+     * to key indices. Both lookups then return the same results as the
+     * linear scan they use without tables.
+     *
+     * Call again after editing keys, or reset lookup to go back to the
+     * scan. Only tables built for a different number of keys are ignored:
+     * moving, resizing or relabelling keys, or resizing the layout, keeps
+     * the stale tables in use. GestureEngine and IdealPathGenerator build
+     * them for their own copies of the layout.
+     */
+    void buildLookup();
+
+    /**
+     * @return true if lookup tables are built for as many keys as the
+     *         layout has. Does not check their geometry (see buildLookup()).
+     */
+    bool hasLookup() const;
+
     /**
      * @brief Find the index of the key nearest to the given point.
      *
-     * Only considers character keys (codePoint >= 0).
+     * Only considers character keys (codePoint >= 0). O(1) with lookup
+     * tables (see buildLookup()) for points on the keyboard, otherwise a
+     * scan over all keys.
      *
      * @param x  X coordinate in dp
      * @param y  Y coordinate in dp
@@ -84,6 +113,8 @@ struct KeyboardLayout {
     /**
      * @brief Find the index of the key with the given code point.
      *
+     * If several keys share the code point, the first one is returned.
+     *
      * @param codePoint  Unicode code point to search for (case-insensitive for ASCII).
      * @return Index into keys vector, or -1 if not found.
      */
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "DictionaryLoader.h"
+#include "SwipeTypeTypes.h"
+
+/**
+ * @file LexiconTrie.h
+ * @brief Letter trie over a dictionary, walked along a gesture's key path.
+ *
+ * The trie is keyed by the lowercased ASCII letters of each word; other
+ * bytes (apostrophes, digits, non-ASCII) are left out, so "don't" and "dont"
+ * share a node. Nodes are stored depth-first in one array, with each node's
+ * children contiguous and sorted by letter.
+ *
+ * collect() takes the sequence of keys a gesture crossed, each as the set of
+ * letters near that key, and returns the words that can be traced along it:
+ * the first letter near the first key, the last letter near the last key,
+ * and every letter in between near a later key than the one before it. A
+ * subtree is abandoned as soon as its letter is near none of the remaining
+ * keys, so the walk only visits prefixes the gesture could have drawn.
+ *
+ * Memory: 16 bytes per node plus 4 bytes per entry.
+ *
+ * Thread safety: After build(), collect() is thread-safe. build() and
+ * clear() are NOT thread-safe.
+ */
+
+namespace swipetype {
+
+/**
+ * @brief Letter trie of a dictionary for key-path candidate generation.
+ *
+ * Usage:
+ * @code
+ *   LexiconTrie trie;
+ *   trie.build(dict);
+ *   std::vector<uint32_t> entries;
+ *   trie.collect(nearLetters.data(), nearLetters.size(), entries);
+ * @endcode
+ */
+class LexiconTrie {
+public:
+    LexiconTrie();
+    ~LexiconTrie();
+
+    // Non-copyable, movable
+    LexiconTrie(const LexiconTrie&) = delete;
+    LexiconTrie& operator=(const LexiconTrie&) = delete;
+    LexiconTrie(LexiconTrie&&) noexcept;
+    LexiconTrie& operator=(LexiconTrie&&) noexcept;
+
+    /**
+     * @brief Build the trie of every entry in dict.
+     *
+     * Replaces any previous contents. Entries without an ASCII letter are
+     * not in the trie.
+     *
+     * @param dict  Loaded dictionary. Entry indices refer to it.
+     * @return false if the dictionary is not loaded.
+     */
+    bool build(const DictionaryLoader& dict);
+
+    /**
+     * @brief Release the trie.
+     */
+    void clear();
+
+    /**
+     * @return true if build() succeeded.
+     */
+    bool isBuilt() const;
+
+    /**
+     * @brief Collect the entries that can be traced along a key path.
+     *
+     * Key p of the path is given as nearLetters[p], a letter mask ('a' =
+     * bit 0 … 'z' = bit 25) of the letters near it. A word matches if its
+     * letters can be assigned to keys in order: the first to key 0, the last
+     * to key count - 1, each other letter to a later key than the one
+     * before it, or to the same key when the letter repeats ("ll").
+     *
+     * @param nearLetters   Letter masks of the crossed keys, in order.
+     * @param count         Number of keys, at most LEXICON_MAX_KEYS.
+     * @param out           Cleared, then receives the matching entry
+     *                      indices in trie (alphabetical) order.
+     * @param nodesVisited  Optional; receives the number of nodes walked.
+     * @return false (and out empty) if the trie is not built or count is 0
+     *         or above LEXICON_MAX_KEYS.
+     */
+    bool collect(const uint32_t* nearLetters, size_t count, std::vector<uint32_t>& out,
+                 uint32_t* nodesVisited = nullptr) const;
+
+    /**
+     * @return Number of trie nodes, including the root; 0 if not built.
+     */
+    size_t nodeCount() const;
+
+    /**
+     * @return Bytes held by the node and entry arrays.
+     */
+    size_t memoryUsage() const;
+
+private:
+    struct Impl;
+    Impl* pImpl;
+};
+
+} // namespace swipetype
@@ -19,6 +19,27 @@
 
 namespace swipetype {
 
+/**
+ * @brief Deduplicated points of a gesture that is still being drawn.
+ *
+ * Built one raw point at a time with PathProcessor::appendPoint(). After
+ * every point, points holds exactly what normalize() would deduplicate the
+ * raw points so far to, so the incremental and batch paths normalize to the
+ * same result.
+ */
+struct DeduplicatedPath {
+    std::vector<GesturePoint> points;  ///< Kept points; the last is the latest raw point
+    float keptArcLength = 0.0f;        ///< Arc length through points[size() - 2]
+    size_t rawCount = 0;               ///< Raw points appended so far
+
+    /** Forget all points, keeping the allocation. */
+    void clear() {
+        points.clear();
+        keptArcLength = 0.0f;
+        rawCount = 0;
+    }
+};
+
 /**
  * @brief Converts raw gesture input to a normalized, resampled path.
  *
@@ -52,6 +73,48 @@ public:
     GesturePath normalize(const RawGesturePath& raw,
                           const KeyboardLayout& layout) const;
 
+    /**
+     * @brief Normalize into an existing path, reusing its storage.
+     *
+     * Same result as the returning overload. With a reused out and the
+     * processor's internal buffers warm, no memory is allocated.
+     *
+     * @param raw     Raw gesture path
+     * @param layout  Keyboard layout for start/end key detection
+     * @param out     Receives the normalized path (empty on failure).
+     */
+    void normalize(const RawGesturePath& raw, const KeyboardLayout& layout,
+                   GesturePath& out) const;
+
+    /**
+     * @brief Append one raw point to a gesture in progress.
+     *
+     * Deduplicates against the kept points and extends the arc length in
+     * O(1), with the same rules as normalize().
+     *
+     * @param path   Incremental path state.
+     * @param point  Next raw point.
+     */
+    void appendPoint(DeduplicatedPath& path, const GesturePoint& point) const;
+
+    /**
+     * @brief Normalize an incrementally built path.
+     *
+     * Equal to normalize() on the raw points that were appended, without
+     * repeating the deduplication.
+     *
+     * @param path    Path built with appendPoint().
+     * @param layout  Keyboard layout for start/end key detection
+     * @return Normalized path, or an empty GesturePath if fewer than
+     *         MIN_GESTURE_POINTS raw points were appended.
+     */
+    GesturePath normalize(const DeduplicatedPath& path,
+                          const KeyboardLayout& layout) const;
+
+    /** @brief Normalize an incrementally built path into out, reusing its storage. */
+    void normalize(const DeduplicatedPath& path, const KeyboardLayout& layout,
+                   GesturePath& out) const;
+
     /**
      * @brief Configure the minimum point distance for deduplication.
      *
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cfloat>
 #include <vector>
 #include "GesturePath.h"
 #include "GestureCandidate.h"
@@ -13,11 +15,57 @@
  * (Sakoe & Chiba, 1978) to compute similarity between a user's gesture
  * and the ideal swipe path for each candidate word.
  *
- * Thread safety: NOT thread-safe. Use one instance per thread.
+ * Paths have ScoringConfig::resampleCount points. The DTW kernel is a
+ * template over the point count and band width; configure() picks a
+ * prebuilt instantiation for 32, 64 or 96 points and band ratios 0.05 to
+ * 0.20 (in steps of 0.05), where the compiler unrolls the band rows, and a
+ * generic one for any other configuration. Both give identical distances.
+ *
+ * Thread safety: const member functions may run concurrently (recognize()
+ * scores on several workers with one Scorer); configure() must not overlap
+ * them.
  */
 
 namespace swipetype {
 
+/**
+ * @brief A normalized gesture prepared for scoring against many templates.
+ *
+ * Holds the gesture in SoA form and its Sakoe-Chiba envelope: for template
+ * index j, the bounding box of the gesture points the band lets j align with
+ * (indices j - bandwidth .. j + bandwidth). Built once per gesture by
+ * Scorer::prepareQuery().
+ */
+struct DTWQuery {
+    std::array<float, MAX_RESAMPLE_COUNT> x{};
+    std::array<float, MAX_RESAMPLE_COUNT> y{};
+    std::array<float, MAX_RESAMPLE_COUNT> lowerX{};
+    std::array<float, MAX_RESAMPLE_COUNT> upperX{};
+    std::array<float, MAX_RESAMPLE_COUNT> lowerY{};
+    std::array<float, MAX_RESAMPLE_COUNT> upperY{};
+    int count = 0;        // points in use
+    int bandwidth = 0;    // Sakoe-Chiba band the envelope was built for
+
+    /** @return true if built by prepareQuery(). */
+    bool isValid() const { return count > 0 && bandwidth > 0; }
+};
+
+/**
+ * @brief Coarse summary of a path for the pre-filter ahead of DTW.
+ *
+ * SIGNATURE_POINTS normalized points (evenly spaced path points, first and
+ * last included; see signaturePointIndex()), the arc length in dp and
+ * a bitmask of letters ('a' = bit 0 … 'z' = bit 25). For a gesture the
+ * letters are the keys its raw points crossed; for a template, the letters
+ * of the word. Built by Scorer::prepareSignature() or TemplateStore.
+ */
+struct PathSignature {
+    std::array<float, SIGNATURE_POINTS> x{};
+    std::array<float, SIGNATURE_POINTS> y{};
+    float arcLength = 0.0f;
+    uint32_t letterMask = 0;
+};
+
 /**
  * @brief Scores gesture paths against ideal reference paths using DTW.
  */
@@ -35,27 +83,126 @@ public:
     /**
      * @brief Configure the scorer with custom parameters.
      *
+     * Selects the DTW kernel for the resample count and band width.
+     *
      * @param config  Scoring configuration. See ScoringConfig for defaults.
      */
     void configure(const ScoringConfig& config);
 
+    /**
+     * @return Points per path: ScoringConfig::resampleCount, clamped to
+     *         [MIN_RESAMPLE_COUNT, MAX_RESAMPLE_COUNT].
+     */
+    int getResampleCount() const;
+
     /**
      * @brief Compute the DTW distance between two normalized paths.
      *
-     * Uses Sakoe-Chiba band constraint with bandwidth = DTW_BANDWIDTH.
-     * Both paths must have exactly RESAMPLE_COUNT points.
+     * Uses Sakoe-Chiba band constraint with bandwidth
+     * ceil(dtwBandwidthRatio × getResampleCount()), at least 1.
+     * Both paths must have exactly getResampleCount() points.
      *
      * @param gesture      Normalized gesture path from user input
      * @param idealPath    Normalized ideal path for a candidate word
      * @return DTW distance (>= 0.0). Lower = better match.
      *         Returns FLT_MAX if either path is invalid.
      *
-     * @pre gesture.points.size() == RESAMPLE_COUNT
-     * @pre idealPath.points.size() == RESAMPLE_COUNT
+     * @pre gesture.points.size() == getResampleCount()
+     * @pre idealPath.points.size() == getResampleCount()
      */
     float computeDTWDistance(const GesturePath& gesture,
                              const GesturePath& idealPath) const;
 
+    /**
+     * @brief Compute the DTW distance between two paths in SoA form.
+     *
+     * Same result as the GesturePath overload. Each pointer addresses
+     * getResampleCount() floats; the template side is typically a TemplateView
+     * into a TemplateStore, so no path is copied.
+     *
+     * @param gestureX   Gesture x coordinates
+     * @param gestureY   Gesture y coordinates
+     * @param templateX  Ideal path x coordinates
+     * @param templateY  Ideal path y coordinates
+     * @return DTW distance (>= 0.0), or FLT_MAX if any pointer is null.
+     */
+    float computeDTWDistance(const float* gestureX, const float* gestureY,
+                             const float* templateX, const float* templateY) const;
+
+    /**
+     * @brief Prepare a gesture for lowerBound() and thresholded DTW.
+     *
+     * Uses the resample count and bandwidth of the current configuration;
+     * prepare again after configure().
+     *
+     * @param gesture  Normalized gesture path.
+     * @param query    Receives the gesture and its envelope.
+     * @return false if the gesture does not have getResampleCount() points.
+     */
+    bool prepareQuery(const GesturePath& gesture, DTWQuery& query) const;
+
+    /**
+     * @brief Cheap lower bound of the DTW distance to a template.
+     *
+     * The larger of two bounds: the cost of the first and last cells, which
+     * every warping path contains, and the LB_Keogh sum of each template
+     * point's distance to the query envelope. Never greater than
+     * computeDTWDistance() for the same pair, in floating point as well.
+     * The envelope bound is skipped once the endpoint bound exceeds threshold.
+     *
+     * @param query      Prepared gesture.
+     * @param templateX  Ideal path x coordinates (query.count floats)
+     * @param templateY  Ideal path y coordinates (query.count floats)
+     * @param threshold  Bound above which the exact value does not matter.
+     * @return Lower bound (>= 0.0), or FLT_MAX if the inputs are invalid.
+     */
+    float lowerBound(const DTWQuery& query, const float* templateX, const float* templateY,
+                     float threshold = FLT_MAX) const;
+
+    /**
+     * @brief DTW distance with early abandoning.
+     *
+     * Stops as soon as every cell of a band row exceeds threshold (per point),
+     * since the final distance can then only be larger. A distance that is
+     * not above threshold is returned exactly, equal to the other overloads.
+     *
+     * @param query      Prepared gesture.
+     * @param templateX  Ideal path x coordinates (query.count floats)
+     * @param templateY  Ideal path y coordinates (query.count floats)
+     * @param threshold  Best-so-far distance; FLT_MAX disables abandoning.
+     * @return DTW distance, or FLT_MAX if it exceeds threshold or the inputs
+     *         are invalid.
+     */
+    float computeDTWDistance(const DTWQuery& query, const float* templateX,
+                             const float* templateY, float threshold = FLT_MAX) const;
+
+    /**
+     * @brief Build the signature of a normalized gesture.
+     *
+     * @param gesture     Normalized gesture path.
+     * @param letterMask  Letters of the keys the raw gesture crossed, or 0
+     *                    if unknown (the letter term is then skipped).
+     * @param signature   Receives the signature.
+     * @return false if the gesture does not have getResampleCount() points.
+     */
+    bool prepareSignature(const GesturePath& gesture, uint32_t letterMask,
+                          PathSignature& signature) const;
+
+    /**
+     * @brief Cheap dissimilarity of a gesture and a template signature.
+     *
+     * The mean point-to-point distance of the two signatures (no warping),
+     * plus COARSE_ARC_WEIGHT × (longer arc / shorter arc - 1), plus
+     * COARSE_LETTER_WEIGHT for every template letter missing from the
+     * gesture's mask. Only comparable with other coarseDistance() values;
+     * it is not a bound on the DTW distance.
+     *
+     * @param gesture    Signature from prepareSignature().
+     * @param candidate  Template signature.
+     * @return Coarse distance (>= 0.0). Lower = better match.
+     */
+    float coarseDistance(const PathSignature& gesture, const PathSignature& candidate) const;
+
     /**
      * @brief Score a candidate by combining DTW distance with frequency.
      *
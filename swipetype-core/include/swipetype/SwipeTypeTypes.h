@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <functional>
@@ -18,9 +19,15 @@ namespace swipetype {
 // Path Processing Constants
 // ============================================================================
 
-/** Number of points after resampling. All normalized paths have exactly this many points. */
+/** Default number of points after resampling (ScoringConfig::resampleCount). */
 static constexpr int RESAMPLE_COUNT = 64;
 
+/** Smallest supported ScoringConfig::resampleCount. */
+static constexpr int MIN_RESAMPLE_COUNT = 16;
+
+/** Largest supported ScoringConfig::resampleCount. */
+static constexpr int MAX_RESAMPLE_COUNT = 128;
+
 /** Minimum Euclidean distance (in dp) between consecutive points to keep. */
 static constexpr float MIN_POINT_DISTANCE_DP = 2.0f;
 
@@ -34,11 +41,11 @@ static constexpr int MAX_GESTURE_POINTS = 10000;
 // Scoring Constants
 // ============================================================================
 
-/** Sakoe-Chiba band width as a fraction of RESAMPLE_COUNT. */
+/** Sakoe-Chiba band width as a fraction of the resample count. */
 static constexpr float DTW_BANDWIDTH_RATIO = 0.10f;
 
-/** Absolute Sakoe-Chiba band width: ceil(RESAMPLE_COUNT * DTW_BANDWIDTH_RATIO). */
-static constexpr int DTW_BANDWIDTH = 6;
+/** Absolute Sakoe-Chiba band width at RESAMPLE_COUNT: ceil(RESAMPLE_COUNT * DTW_BANDWIDTH_RATIO). */
+static constexpr int DTW_BANDWIDTH = 7;
 
 /** Weight of dictionary frequency in final score (α). Range [0.0, 1.0].
  *  finalScore = (1 - α) * dtwScore + α * freqScore */
@@ -59,6 +66,93 @@ static constexpr float LENGTH_FILTER_TOLERANCE = 3.0f;
  *  A good gesture match typically yields DTW ~0.2–0.5; poor ~2–4. */
 static constexpr float MAX_DTW_FLOOR = 3.0f;
 
+/** Points in a coarse path signature (see PathSignature). */
+static constexpr int SIGNATURE_POINTS = 8;
+
+/** Stride between signature points: they are path points 0, 9, ..., 63. */
+static constexpr int SIGNATURE_STRIDE = (RESAMPLE_COUNT - 1) / (SIGNATURE_POINTS - 1);
+
+/**
+ * Path point of signature point k for a path of pointCount points: evenly
+ * spaced from the first to the last, k * SIGNATURE_STRIDE at RESAMPLE_COUNT.
+ */
+constexpr int signaturePointIndex(int k, int pointCount) {
+    return k * (pointCount - 1) / (SIGNATURE_POINTS - 1);
+}
+
+/** Default ScoringConfig::coarseCandidates. */
+static constexpr int DEFAULT_COARSE_CANDIDATES = 256;
+
+/** Coarse score weight of the arc-length ratio (longer / shorter - 1). */
+static constexpr float COARSE_ARC_WEIGHT = 0.05f;
+
+/** Coarse score added per word letter whose key the gesture never crossed. */
+static constexpr float COARSE_LETTER_WEIGHT = 0.02f;
+
+/** Quantization steps over [0, 1] of a TemplatePrecision::UINT16 coordinate. */
+static constexpr float TEMPLATE_UINT16_SCALE = 65535.0f;
+
+/** Quantization steps over [0, 1] of a TemplatePrecision::UINT8 coordinate. */
+static constexpr float TEMPLATE_UINT8_SCALE = 255.0f;
+
+/** Radius, in key widths/heights, around a crossed key whose letters a
+ *  widened lexicon walk treats as near the path (1.25 = the adjacent keys).
+ *  The walk first admits only the crossed keys, and widens when that finds
+ *  no word. */
+static constexpr float LEXICON_KEY_RADIUS = 1.25f;
+
+/** Longest key trace (key transitions) the lexicon trie is walked against. */
+static constexpr int LEXICON_MAX_KEYS = 254;
+
+/** Upper limit for ScoringConfig::scoringThreads. */
+static constexpr int MAX_SCORING_THREADS = 16;
+
+/** Candidates per work chunk when scoring in parallel. */
+static constexpr int SCORING_CHUNK_SIZE = 64;
+
+/** Gestures per work chunk in GestureEngine::recognizeBatch(). */
+static constexpr int BATCH_CHUNK_SIZE = 16;
+
+/** Default gesture time between streaming previews, in ms. */
+static constexpr int DEFAULT_PREVIEW_INTERVAL_MS = 100;
+
+/** Ideal paths warmed per GestureEngine::addPoints() call while streaming. */
+static constexpr int STREAM_PREFETCH_BATCH = 64;
+
+/** Gesture time on one key after which a streamed gesture is ranked in flight
+ *  (ScoringConfig::inFlightRanking), so the ranking usually ends on the key
+ *  the finger lifts from. */
+static constexpr int STREAM_SEED_DWELL_MS = 30;
+
+/** Default memory budget of the ideal-path cache, in bytes (about 880 words). */
+static constexpr size_t DEFAULT_PATH_CACHE_BYTES = 768 * 1024;
+
+/** Default number of recent rankings GestureEngine keeps for repeated gestures. */
+static constexpr int DEFAULT_RESULT_CACHE_SIZE = 16;
+
+/** Entries TemplateStore::compile() generates between progress updates. */
+static constexpr uint32_t TEMPLATE_COMPILE_STRIDE = 256;
+
+/** Default ScoringConfig::warmupWordsPerBucket. */
+static constexpr int DEFAULT_WARMUP_WORDS_PER_BUCKET = 4;
+
+/** Upper limit for ScoringConfig::resultCacheSize. */
+static constexpr int MAX_RESULT_CACHE_SIZE = 256;
+
+/** Steps per normalized unit of the result cache key. Gestures whose points
+ *  all round to the same steps share a ranking; their DTW distances differ
+ *  by less than 1.5 / RESULT_CACHE_QUANTUM. */
+static constexpr int RESULT_CACHE_QUANTUM = 1024;
+
+/** Largest per-coordinate difference (normalized units) at which a cached
+ *  gesture is near enough to seed the DTW threshold of a new one. */
+static constexpr float RESULT_CACHE_NEAR_TOLERANCE = 0.05f;
+
+/** A near cached gesture seeds the threshold only if there are at least this
+ *  many shortlists' worth of candidates; on fewer, scoring its words costs
+ *  more than the pruning saves. */
+static constexpr int RESULT_CACHE_SEED_FACTOR = 4;
+
 // ============================================================================
 // Dictionary Constants
 // ============================================================================
@@ -66,15 +160,38 @@ static constexpr float MAX_DTW_FLOOR = 3.0f;
 /** Magic bytes for .glide dictionary files: ASCII "GLID". */
 static constexpr uint32_t DICT_MAGIC = 0x474C4944;
 
-/** Current dictionary format version. */
-static constexpr uint16_t DICT_VERSION = 1;
+/** Current dictionary format version (written by scripts/gen_dict.py). */
+static constexpr uint16_t DICT_VERSION = 2;
+
+/** Legacy flat-record dictionary format version. Still readable. */
+static constexpr uint16_t DICT_VERSION_V1 = 1;
 
-/** Fixed size of the dictionary file header in bytes. */
+/** Size of the base header shared by all format versions, in bytes. */
 static constexpr uint32_t DICT_HEADER_SIZE = 32;
 
+/** Size of the version-2 header (base header + section directory), in bytes. */
+static constexpr uint32_t DICT_HEADER_V2_SIZE = 64;
+
+/** Header flag: entries are sorted alphabetically. */
+static constexpr uint16_t DICT_HEADER_SORTED = 0x0001;
+
+/** Header flag: within each (bucket, length) group of the version-2 bucket
+ *  order, entries are ordered by frequency descending, ties by index.
+ *  Files without it get their bucket order rebuilt at load. */
+static constexpr uint16_t DICT_HEADER_FREQUENCY_BUCKETS = 0x0002;
+
+/** Empty slot marker in the version-2 lookup hash table. */
+static constexpr uint32_t DICT_HASH_EMPTY = 0xFFFFFFFF;
+
 /** Maximum allowed word length in UTF-8 bytes. */
 static constexpr uint32_t MAX_WORD_LENGTH = 64;
 
+/** Letter classes per bucket axis: 'a'–'z' plus one class for everything else. */
+static constexpr uint32_t DICT_BUCKET_LETTERS = 27;
+
+/** Number of (first letter, last letter) buckets in the dictionary index. */
+static constexpr uint32_t DICT_BUCKET_COUNT = DICT_BUCKET_LETTERS * DICT_BUCKET_LETTERS;
+
 // ============================================================================
 // Candidate Source Flags (bitmask)
 // ============================================================================
@@ -105,7 +222,8 @@ enum class ErrorCode : int {
     LAYOUT_INVALID = 4,
     PATH_TOO_SHORT = 5,
     ENGINE_NOT_INITIALIZED = 6,
-    OUT_OF_MEMORY = 7
+    OUT_OF_MEMORY = 7,
+    INVALID_ARGUMENT = 8
 };
 
 /**
@@ -128,19 +246,189 @@ using ErrorCallback = std::function<void(const ErrorInfo& error)>;
 // Scoring Configuration
 // ============================================================================
 
+/**
+ * @brief Coordinate format of compiled templates (see TemplateStore).
+ *
+ * Normalized coordinates lie in [0, 1]. A quantized coordinate is rounded to
+ * the nearest of SCALE + 1 steps, so it is off by at most 0.5 / SCALE, and a
+ * DTW distance against the quantized template differs from the FLOAT32 one
+ * by less than 1.5 / SCALE: about 2.3e-5 for UINT16 and 5.9e-3 for UINT8.
+ */
+enum class TemplatePrecision : int {
+    FLOAT32 = 0,    ///< 512 bytes per template; exact
+    UINT16 = 1,     ///< 256 bytes per template
+    UINT8 = 2       ///< 128 bytes per template
+};
+
+/**
+ * @brief How much GestureEngine prepares in the background after init.
+ *
+ * The warm-up starts when init(), initWithData() or initWithStore() return
+ * and never delays them. The first gestures of a session are otherwise
+ * scored against a cold ideal-path cache.
+ */
+enum class WarmupLevel : int {
+    OFF = 0,        ///< Nothing; paths are generated as gestures need them
+    FREQUENT = 1,   ///< Ideal paths of the most frequent words of every start/end bucket
+    FULL = 2        ///< FREQUENT, then templates for the whole dictionary (as compileTemplates())
+};
+
 /**
  * @brief Tunable parameters for the scoring algorithm.
  *
  * All fields have sensible defaults. Override via GestureEngine::configure().
  */
 struct ScoringConfig {
-    int resampleCount = RESAMPLE_COUNT;
+    int resampleCount = RESAMPLE_COUNT;  // points per normalized path, clamped to [MIN_RESAMPLE_COUNT, MAX_RESAMPLE_COUNT]
     float minPointDistance = MIN_POINT_DISTANCE_DP;
     float dtwBandwidthRatio = DTW_BANDWIDTH_RATIO;
     float frequencyWeight = FREQUENCY_WEIGHT;
-    int maxCandidatesEvaluated = MAX_MAX_CANDIDATES;
+    int maxCandidatesEvaluated = MAX_MAX_CANDIDATES;  // DTW shortlist size (at least maxCandidates)
     float lengthFilterTolerance = LENGTH_FILTER_TOLERANCE;
     float maxDTWFloor = MAX_DTW_FLOOR;
+    int scoringThreads = 1;  // threads per gesture or batch (1 = serial, 0 = one per core)
+    bool lexiconCandidates = true;  // walk the lexicon trie along the key path (false = buckets only)
+    bool inFlightRanking = true;  // rank a streamed gesture while it is drawn, to seed endGesture()
+    int coarseCandidates = DEFAULT_COARSE_CANDIDATES;  // kept by the signature pre-filter (0 = off)
+    size_t pathCacheBytes = DEFAULT_PATH_CACHE_BYTES;  // ideal-path cache budget (0 = no cache)
+    int resultCacheSize = DEFAULT_RESULT_CACHE_SIZE;  // recent rankings kept, up to MAX_RESULT_CACHE_SIZE (0 = no cache)
+    int scoringBudgetUs = 0;  // stop scoring this many µs after ranking starts (0 = no limit)
+    int scoringBudgetDtwCalls = 0;  // stop scoring after this many DTW calls (0 = no limit)
+    TemplatePrecision templatePrecision = TemplatePrecision::FLOAT32;  // of compileTemplates()
+    WarmupLevel warmup = WarmupLevel::OFF;  // background warm-up after init
+    int warmupWordsPerBucket = DEFAULT_WARMUP_WORDS_PER_BUCKET;  // per start/end bucket, most frequent first
+};
+
+// ============================================================================
+// Memory Management
+// ============================================================================
+
+/**
+ * @brief How much memory GestureEngine::trimMemory() gives back.
+ *
+ * Mirrors the Android onTrimMemory() levels: MODERATE while the app is
+ * still in use, COMPLETE when it is in the background or memory is critical.
+ */
+enum class MemoryTrimLevel : int {
+    MODERATE = 0,   ///< Halve the ideal-path cache
+    COMPLETE = 1    ///< Empty the ideal-path and result caches, free batch scratch buffers
+};
+
+/**
+ * @brief Occupancy and counters of the ideal-path cache.
+ *
+ * Returned by IdealPathGenerator::getCacheStats() and
+ * GestureEngine::getPathCacheStats(). Counters are cumulative since the
+ * generator was created; clearing or trimming the cache does not reset them.
+ */
+struct PathCacheStats {
+    size_t entries = 0;         ///< Paths currently cached
+    size_t capacity = 0;        ///< Paths the budget allows
+    size_t bytes = 0;           ///< Memory charged for the cached paths
+    size_t reservedBytes = 0;   ///< Memory the cache holds, used or not
+    size_t budgetBytes = 0;     ///< Configured budget
+    size_t entryBytes = 0;      ///< Memory charged per path
+    uint64_t hits = 0;          ///< Lookups served from the cache
+    uint64_t misses = 0;        ///< Lookups that generated a path
+    uint64_t evictions = 0;     ///< Paths dropped to stay within the budget
+};
+
+/**
+ * @brief Occupancy and counters of the recognition result cache.
+ *
+ * Returned by GestureEngine::getResultCacheStats(). Counters are cumulative
+ * since the engine was created; trimming the cache does not reset them.
+ * Every lookup is exactly one of a hit, a near hit or a miss.
+ */
+struct ResultCacheStats {
+    size_t entries = 0;         ///< Rankings currently cached
+    size_t capacity = 0;        ///< ScoringConfig::resultCacheSize
+    uint64_t hits = 0;          ///< Gestures answered from the cache
+    uint64_t nearHits = 0;      ///< Gestures scored with a threshold seeded from a near one
+    uint64_t misses = 0;        ///< Gestures with no exact or near cached gesture
+    uint64_t invalidations = 0; ///< Times cached rankings were dropped as stale
 };
 
+/**
+ * @brief Where the warm-up of a GestureEngine stands.
+ */
+enum class WarmupState : int {
+    IDLE = 0,       ///< None started (WarmupLevel::OFF, or not initialized)
+    RUNNING = 1,    ///< Working in the background
+    DONE = 2,       ///< Finished; the next recognition uses its results
+    CANCELLED = 3   ///< Stopped early; what was finished is still used
+};
+
+/**
+ * @brief Progress of the warm-up, from GestureEngine::getWarmupProgress().
+ *
+ * Words count the frequent words' ideal paths first, then (WarmupLevel::FULL)
+ * every dictionary entry's template.
+ */
+struct WarmupProgress {
+    WarmupState state = WarmupState::IDLE;
+    uint32_t wordsDone = 0;     ///< Paths and templates generated so far
+    uint32_t wordsTotal = 0;    ///< Of all stages; 0 until the warm-up has planned them
+};
+
+// ============================================================================
+// Recognition Statistics
+// ============================================================================
+
+/**
+ * @brief Stage timings and counters of one recognition.
+ *
+ * Filled in by GestureEngine::recognize(), endGesture() and recognizeBatch().
+ * A batch reports sums over its gestures. Times are steady-clock nanoseconds.
+ * With a scoring pool, templateNs and dtwNs add up every worker's time, so
+ * together they can exceed totalNs. A gesture answered from the result
+ * cache counts no candidates and no scoring time. Every field stays zero
+ * when the library is built with SWIPETYPE_ENABLE_STATS=OFF.
+ */
+struct RecognitionStats {
+    uint32_t gestures = 0;              ///< Gestures recognized (1, or the batch size)
+    uint32_t rawPoints = 0;             ///< Raw input points
+    float estimatedLength = 0.0f;       ///< Key-transition length estimate (last gesture)
+
+    uint64_t normalizeNs = 0;           ///< Deduplication, resampling, normalization
+    uint64_t filterNs = 0;              ///< Bucket lookup and length filter
+    uint64_t coarseNs = 0;              ///< Signature pre-filter
+    uint64_t templateNs = 0;            ///< Lazy ideal path lookup and generation
+    uint64_t dtwNs = 0;                 ///< Lower bounds and DTW (and compiled template reads)
+    uint64_t rankNs = 0;                ///< Shortlist merge, confidence, sort
+    uint64_t totalNs = 0;               ///< Whole call
+
+    uint32_t lexiconNodes = 0;          ///< Lexicon trie nodes walked
+    uint32_t lexiconWidened = 0;        ///< Walks repeated with neighbouring keys
+    uint32_t bucketCandidates = 0;      ///< Candidates before the length filter (lexicon or bucket)
+    uint32_t filteredCandidates = 0;    ///< Candidates left by the length filter
+    uint32_t lengthFilterFallbacks = 0; ///< Filter removed everything; the bucket was scored
+    uint32_t coarseScored = 0;          ///< Candidates scored by the signature pre-filter
+    uint32_t coarseKept = 0;            ///< Candidates the pre-filter passed on to DTW
+
+    uint32_t dtwCalls = 0;              ///< DTW computations started
+    uint32_t boundPruned = 0;           ///< Candidates skipped on their lower bound
+    uint32_t rejected = 0;              ///< Candidates scored but not shortlisted
+    uint32_t shortlisted = 0;           ///< Shortlist entries ranked
+    uint32_t pathCacheHits = 0;         ///< Ideal paths found in the path cache
+    uint32_t pathsGenerated = 0;        ///< Ideal paths generated (cache misses included)
+    uint32_t templateReads = 0;         ///< Compiled templates read
+    uint32_t resultCacheHits = 0;       ///< Gestures answered from the result cache
+    uint32_t resultCacheSeeds = 0;      ///< Gestures whose DTW threshold a near cached gesture seeded
+    uint32_t streamSeeds = 0;           ///< Streamed gestures whose DTW threshold their in-flight ranking seeded
+    uint32_t budgetTruncated = 0;       ///< Gestures whose scoring stopped at the scoring budget
+    uint32_t budgetSkipped = 0;         ///< Candidates the scoring budget left unscored
+
+    /** @return One-line summary for logs. Allocates; keep it off the hot path. */
+    std::string toString() const;
+};
+
+/**
+ * @brief Stats callback function type.
+ *
+ * Set via GestureEngine::setStatsCallback(). Called synchronously from the
+ * recognizing thread, after the results are complete.
+ */
+using StatsCallback = std::function<void(const RecognitionStats& stats)>;
+
 } // namespace swipetype
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "KeyboardLayout.h"
+#include "DictionaryLoader.h"
+#include "Scorer.h"
+#include "SwipeTypeTypes.h"
+
+/**
+ * @file TemplateStore.h
+ * @brief Precompiled ideal-path templates for a whole dictionary.
+ *
+ * The store holds the ideal path of every dictionary entry for one keyboard
+ * layout, resampled to one point count (RESAMPLE_COUNT by default), in two
+ * contiguous coordinate buffers in the store's precision (all x, all y),
+ * addressed by entry index. Recognition reads a template as a pair of
+ * pointers: no hashing, copying or allocation.
+ *
+ * A compiled store can be saved to disk and loaded again. The file records a
+ * hash of the layout's key geometry, a fingerprint of the dictionary words
+ * and the point count, and load() rejects files that do not match all three.
+ *
+ * Templates can be compiled quantized (TemplatePrecision): each coordinate
+ * is then a 16- or 8-bit fixed-point code over [0, 1], and recognition
+ * decodes a template into floats on the stack before scoring it with the
+ * float DTW kernel. The accuracy bound is documented at TemplatePrecision.
+ *
+ * Next to each template the store keeps its PathSignature for the coarse
+ * pre-filter. Signatures are derived from the templates, the word and the
+ * layout, so they are rebuilt on load() rather than saved.
+ *
+ * Memory: 2 × points × 4 bytes (512 bytes at 64 points) per entry as
+ * FLOAT32, 256 as UINT16 or 128 as UINT8, plus sizeof(PathSignature)
+ * (72 bytes) for its signature.
+ *
+ * Thread safety: After compile() or load(), read-only access is thread-safe.
+ * compile(), load() and clear() are NOT thread-safe. A compile() running on
+ * another thread is observed and stopped through a TemplateCompileProgress.
+ */
+
+namespace swipetype {
+
+/**
+ * @brief Read-only view of one template in a TemplateStore.
+ *
+ * Exactly one pair of pointers is set, for the store's precision: x and y
+ * (FLOAT32), x16 and y16 (UINT16) or x8 and y8 (UINT8), each addressing
+ * count coordinates. All are null if the entry has no template
+ * (fewer than two of its characters map to keys). The view stays valid until
+ * the store is recompiled, reloaded, cleared or destroyed.
+ */
+struct TemplateView {
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const uint16_t* x16 = nullptr;  // code / TEMPLATE_UINT16_SCALE
+    const uint16_t* y16 = nullptr;
+    const uint8_t* x8 = nullptr;    // code / TEMPLATE_UINT8_SCALE
+    const uint8_t* y8 = nullptr;
+    int count = 0;                  // points of the template
+
+    /** @return true if the view refers to a template. */
+    bool isValid() const { return x || x16 || x8; }
+
+    /**
+     * @brief Write the template's coordinates as floats.
+     *
+     * Quantized codes are multiplied by the reciprocal of their scale, with
+     * the same result on every SIMD target.
+     *
+     * @param outX  count floats.
+     * @param outY  count floats.
+     * @return false (and nothing written) if the view is invalid.
+     */
+    bool decode(float* outX, float* outY) const;
+};
+
+/**
+ * @brief Lets another thread follow and stop a running compile().
+ */
+struct TemplateCompileProgress {
+    std::atomic<uint32_t> compiled{0};  ///< Entries done so far; the entry count once finished
+    std::atomic<bool> cancel{false};    ///< Set to make compile() stop and fail
+};
+
+/**
+ * @brief Dense, index-addressed store of ideal-path templates.
+ *
+ * Usage:
+ * @code
+ *   TemplateStore store;
+ *   if (!store.load(cacheFile, layout, dict)) {
+ *       store.compile(layout, dict);
+ *       store.save(cacheFile);
+ *   }
+ *   TemplateView t = store.getTemplate(entryIndex);
+ * @endcode
+ */
+class TemplateStore {
+public:
+    TemplateStore();
+    ~TemplateStore();
+
+    // Non-copyable, movable
+    TemplateStore(const TemplateStore&) = delete;
+    TemplateStore& operator=(const TemplateStore&) = delete;
+    TemplateStore(TemplateStore&&) noexcept;
+    TemplateStore& operator=(TemplateStore&&) noexcept;
+
+    /**
+     * @brief Generate the template of every entry in dict for layout.
+     *
+     * FLOAT32 templates are identical to IdealPathGenerator::getIdealPath();
+     * quantized ones round each coordinate to the nearest code. Replaces any
+     * previous contents.
+     *
+     * @param layout     Keyboard layout with character key positions.
+     * @param dict       Loaded dictionary. Template i belongs to entry i.
+     * @param precision   Coordinate format.
+     * @param pointCount  Points per template, MIN_RESAMPLE_COUNT to
+     *                    MAX_RESAMPLE_COUNT (ScoringConfig::resampleCount).
+     * @param progress    Optional; updated every TEMPLATE_COMPILE_STRIDE
+     *                    entries, when its cancel flag is also checked.
+     * @return false if the layout is invalid, the dictionary is not loaded,
+     *         pointCount is out of range or the compile was cancelled (the
+     *         store is then empty).
+     */
+    bool compile(const KeyboardLayout& layout, const DictionaryLoader& dict,
+                 TemplatePrecision precision = TemplatePrecision::FLOAT32,
+                 int pointCount = RESAMPLE_COUNT,
+                 TemplateCompileProgress* progress = nullptr);
+
+    /**
+     * @brief Write the compiled store to a file.
+     *
+     * The file is in host byte order; it is a cache, not an exchange format.
+     *
+     * @param filePath  Destination path (overwritten).
+     * @return false if nothing is compiled or the file cannot be written.
+     */
+    bool save(const std::string& filePath) const;
+
+    /**
+     * @brief Load a store written by save().
+     *
+     * Fails without modifying the store if the file is missing, damaged, or
+     * was compiled for a different layout, dictionary, precision or point
+     * count.
+     *
+     * @param filePath    Path of the cache file.
+     * @param layout      Layout the templates must belong to.
+     * @param dict        Dictionary the templates must belong to.
+     * @param precision   Coordinate format the file must have.
+     * @param pointCount  Points per template the file must have.
+     * @return true if the templates were loaded.
+     */
+    bool load(const std::string& filePath, const KeyboardLayout& layout,
+              const DictionaryLoader& dict,
+              TemplatePrecision precision = TemplatePrecision::FLOAT32,
+              int pointCount = RESAMPLE_COUNT);
+
+    /**
+     * @brief Release all templates.
+     */
+    void clear();
+
+    /**
+     * @return true if the store holds templates from compile() or load().
+     */
+    bool isCompiled() const;
+
+    /**
+     * @return Number of templates (the dictionary entry count), or 0.
+     */
+    uint32_t size() const;
+
+    /**
+     * @return Coordinate format of the compiled templates (FLOAT32 if empty).
+     */
+    TemplatePrecision getPrecision() const;
+
+    /**
+     * @return Points per template (RESAMPLE_COUNT if empty).
+     */
+    int getPointCount() const;
+
+    /**
+     * @brief Get the template of one dictionary entry.
+     *
+     * @param index  Dictionary entry index.
+     * @return View of the template. Invalid if index is out of range or the
+     *         entry has no template.
+     */
+    TemplateView getTemplate(uint32_t index) const;
+
+    /**
+     * @brief Get the coarse signature of one dictionary entry.
+     *
+     * Its points are the decoded template points at signaturePointIndex()
+     * (0, SIGNATURE_STRIDE, …, 63 at 64 points);
+     * its arc length is that of the key-center path before normalization.
+     *
+     * @param index  Dictionary entry index.
+     * @return Signature, or nullptr if getTemplate(index) is invalid. Valid
+     *         as long as the template is.
+     */
+    const PathSignature* getSignature(uint32_t index) const;
+
+    /**
+     * @return Layout hash of the compiled templates (see layoutHash()), or 0.
+     */
+    uint64_t getLayoutHash() const;
+
+    /**
+     * @return Bytes held by the template and signature buffers.
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Hash of the layout properties that templates depend on.
+     *
+     * Covers the code point and center of every character key, in order.
+     * Labels, key sizes and the language tag do not affect templates.
+     *
+     * @param layout  Keyboard layout.
+     * @return 64-bit FNV-1a hash.
+     */
+    static uint64_t layoutHash(const KeyboardLayout& layout);
+
+private:
+    struct Impl;
+    Impl* pImpl;
+};
+
+} // namespace swipetype
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "DictionaryLoader.h"
+#include "KeyboardLayout.h"
+#include "TemplateStore.h"
+#include "SwipeTypeTypes.h"
+
+/**
+ * @file UserDictionary.h
+ * @brief Mutable word layer learned on the device, recognized next to the
+ *        main dictionary.
+ *
+ * A .glide dictionary is immutable once loaded. The words a user adds, and
+ * the frequencies learned from accepted suggestions, live in a
+ * UserDictionary instead. Each change costs O(1): words sit in reusable
+ * slots found through a hash map, and the start+end and start-letter bucket
+ * indices are updated in place (a removed slot is swapped with the last one
+ * of its buckets). When a layout is set, every word's ideal path is kept
+ * per slot and regenerated only for the word that changed.
+ *
+ * Changes are appended to a journal file as they are made, so nothing is
+ * ever rewritten wholesale: a record is 7 bytes plus the word. open()
+ * replays it; compact() shrinks it to one record per word.
+ *
+ * Journal layout: "GLUJ", version byte (1), three zero bytes, then records
+ * of uint8 op (1 = set frequency, 2 = remove, 3 = add to frequency), uint8
+ * flags, uint8 word length, uint32 value (little-endian), word bytes. A
+ * truncated last record, as left by a crash, is dropped on open().
+ *
+ * Memory: about 150 bytes per word, plus 8 per template point (512 at 64
+ * points) once a layout is set.
+ *
+ * Thread safety: NOT thread-safe. Const methods may run concurrently with
+ * each other, so engines sharing a UserDictionary may recognize in
+ * parallel, but no change may overlap a recognition that uses it.
+ */
+
+namespace swipetype {
+
+/**
+ * @brief Words and frequencies learned on the device.
+ *
+ * Usage:
+ * @code
+ *   auto user = std::make_shared<UserDictionary>();
+ *   user->open(filesDir + "/user.gluj");
+ *   engine.setUserDictionary(user);
+ *   user->addWord("Dettmer", 20'000);
+ *   user->bumpFrequency(acceptedWord, 1'000);   // on every accepted suggestion
+ * @endcode
+ */
+class UserDictionary {
+public:
+    UserDictionary();
+    ~UserDictionary();
+
+    // Non-copyable, movable
+    UserDictionary(const UserDictionary&) = delete;
+    UserDictionary& operator=(const UserDictionary&) = delete;
+    UserDictionary(UserDictionary&&) noexcept;
+    UserDictionary& operator=(UserDictionary&&) noexcept;
+
+    /**
+     * @brief Load the words of a journal and append later changes to it.
+     *
+     * Replaces the current words. A missing file is created. A journal
+     * whose last record is truncated is compacted.
+     *
+     * @param journalPath  Journal file path.
+     * @return false if the file cannot be created or read
+     *         (DICT_NOT_FOUND), is not a journal (DICT_CORRUPT) or has
+     *         another version (DICT_VERSION_MISMATCH); see getLastError().
+     *         The dictionary is then empty and not journaled.
+     */
+    bool open(const std::string& journalPath);
+
+    /**
+     * @brief Stop journaling. The words stay.
+     */
+    void close();
+
+    /**
+     * @return true while changes are journaled.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Add a word, or set the frequency of one already present.
+     *
+     * @param word       UTF-8 word, 1 to MAX_WORD_LENGTH bytes.
+     * @param frequency  Frequency in the units of the main dictionary.
+     * @param flags      DICT_FLAG_* bits.
+     * @return false if the word is empty or too long, or the journal
+     *         cannot be written (then nothing changes).
+     */
+    bool addWord(std::string_view word, uint32_t frequency, uint8_t flags = 0);
+
+    /**
+     * @brief Remove a word.
+     *
+     * @return false if the word is not present, or the journal cannot be
+     *         written.
+     */
+    bool removeWord(std::string_view word);
+
+    /**
+     * @brief Add to a word's frequency, adding the word if it is missing.
+     *
+     * The frequency saturates at UINT32_MAX.
+     *
+     * @return false if the word is empty or too long, or the journal
+     *         cannot be written.
+     */
+    bool bumpFrequency(std::string_view word, uint32_t delta = 1);
+
+    /**
+     * @return true if word (exact bytes) is present.
+     */
+    bool contains(std::string_view word) const;
+
+    /**
+     * @return The word's frequency, 0 if it is not present.
+     */
+    uint32_t getFrequency(std::string_view word) const;
+
+    /**
+     * @return Number of words.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Rewrite the journal with one record per word.
+     *
+     * Written to a temporary file next to it, then renamed over it.
+     *
+     * @return false if the dictionary is not open or the file cannot be
+     *         written (the old journal is kept).
+     */
+    bool compact();
+
+    /**
+     * @return Records in the journal, to decide when to compact(); 0 if
+     *         not open.
+     */
+    size_t getJournalRecordCount() const;
+
+    /**
+     * @brief Generate the ideal-path template of every word for layout.
+     *
+     * Later changes generate the template of the changed word only. Done
+     * by GestureEngine::setUserDictionary(), updateLayout() and
+     * configure() with another resample count.
+     *
+     * @param layout      Keyboard layout.
+     * @param pointCount  Points per template (ScoringConfig::resampleCount);
+     *                    ignored, like the call, if out of range.
+     */
+    void setLayout(const KeyboardLayout& layout, int pointCount = RESAMPLE_COUNT);
+
+    /**
+     * @return TemplateStore::layoutHash() of the layout the templates
+     *         belong to; 0 if no layout is set.
+     */
+    uint64_t getLayoutHash() const;
+
+    /**
+     * @return Points per template (RESAMPLE_COUNT until setLayout()).
+     */
+    int getPointCount() const;
+
+    /**
+     * @return A counter bumped by every change of the words or templates,
+     *         so a caller can tell that results it kept are stale.
+     */
+    uint64_t getRevision() const;
+
+    // ---- Index access for recognition. Indices are slots; they stay
+    //      valid until the next change. ----
+
+    /**
+     * @return Slots of the words whose first and last letter are startChar
+     *         and endChar (case-insensitive), in no particular order.
+     */
+    DictionaryIndexSpan getBucket(char startChar, char endChar) const;
+
+    /**
+     * @return Slots of the words whose first letter is startChar.
+     */
+    DictionaryIndexSpan getStartBucket(char startChar) const;
+
+    /**
+     * @return Slots of all words.
+     */
+    DictionaryIndexSpan getEntries() const;
+
+    /**
+     * @return The word in a slot; the view stays valid until the next change.
+     */
+    DictionaryEntry getEntry(uint32_t slot) const;
+
+    /**
+     * @return Float template of a slot's word; invalid if no layout is set
+     *         or the word has no letter on it.
+     */
+    TemplateView getTemplate(uint32_t slot) const;
+
+    /**
+     * @return Last error from open(), compact() or a journal write.
+     */
+    ErrorInfo getLastError() const;
+
+private:
+    struct Impl;
+    Impl* pImpl;
+};
+
+} // namespace swipetype
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @file WorkerPool.h
+ * @brief Persistent threads for splitting one call's work into chunks.
+ *
+ * The pool starts its threads once and parks them between calls, so a call
+ * to run() costs a wake-up rather than a thread spawn. The calling thread
+ * takes part as worker 0.
+ *
+ * Chunks are dealt out as one contiguous run per worker. A worker that
+ * finishes its own run steals the remaining chunks of the others, one at a
+ * time, so uneven chunks do not leave threads idle.
+ *
+ * Thread safety: run() must not be called concurrently on the same pool.
+ */
+
+namespace swipetype {
+
+/**
+ * @brief Fixed-size pool of worker threads with chunked work stealing.
+ *
+ * Usage:
+ * @code
+ *   WorkerPool pool(4);                 // caller + 3 threads
+ *   pool.run(chunks, [&](int worker, size_t chunk) {
+ *       process(chunk, perWorkerState[worker]);
+ *   });
+ * @endcode
+ */
+class WorkerPool {
+public:
+    /**
+     * @param threadCount  Number of workers including the calling thread;
+     *                     values below 1 are treated as 1 (no threads).
+     */
+    explicit WorkerPool(int threadCount = 1);
+    ~WorkerPool();
+
+    // Non-copyable, movable
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) noexcept;
+    WorkerPool& operator=(WorkerPool&&) noexcept;
+
+    /**
+     * @return Number of workers, including the calling thread.
+     */
+    int threadCount() const;
+
+    /**
+     * @brief Run task once for every chunk in [0, chunkCount) and wait.
+     *
+     * task receives the worker index in [0, threadCount()) and the chunk
+     * index. Each chunk runs exactly once; the order is unspecified. Tasks for
+     * the same worker never run concurrently, so per-worker state needs no
+     * locking.
+     *
+     * @param chunkCount  Number of chunks.
+     * @param task        Work for one chunk. Must not throw.
+     */
+    void run(size_t chunkCount, const std::function<void(int worker, size_t chunk)>& task);
+
+private:
+    struct Impl;
+    Impl* pImpl;
+};
+
+} // namespace swipetype
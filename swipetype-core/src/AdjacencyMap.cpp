@@ -2,11 +2,48 @@
 #include <cmath>
 #include <cfloat>
 #include <algorithm>
+#include <array>
 #include <cctype>
+#include <unordered_map>
 
 namespace swipetype {
 
-int32_t KeyboardLayout::findNearestKey(float x, float y) const {
+/**
+ * Uniform grid over the character keys plus a code-point table.
+ *
+ * Cell c covers [originX + col*cellW, +cellW) x [originY + row*cellH, +cellH)
+ * and owns cellKeys[cellStart[c], cellStart[c+1]): every key that can be
+ * nearest to some point of the cell, in key order.
+ */
+struct KeyboardLayout::Lookup {
+    size_t keyCount = 0;
+
+    float originX = 0.0f, originY = 0.0f;
+    float cellW = 1.0f, cellH = 1.0f;
+    int cols = 0, rows = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<int32_t> cellKeys;
+
+    std::array<int32_t, 128> asciiKeys;             // lowercased ASCII -> key
+    std::unordered_map<int32_t, int32_t> otherKeys;  // everything else
+};
+
+namespace {
+
+// Upper bound on grid cells per axis
+constexpr int MAX_GRID_CELLS = 64;
+
+inline int32_t foldCodePoint(int32_t cp) {
+    return (cp >= 'A' && cp <= 'Z') ? cp - 'A' + 'a' : cp;
+}
+
+inline float keyDistance(const KeyDescriptor& key, float x, float y) {
+    float dx = key.centerX - x;
+    float dy = key.centerY - y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+int32_t scanNearestKey(const std::vector<KeyDescriptor>& keys, float x, float y) {
     int32_t bestIndex = -1;
     float bestDist = FLT_MAX;
 
@@ -14,10 +51,7 @@ int32_t KeyboardLayout::findNearestKey(float x, float y) const {
         const KeyDescriptor& key = keys[i];
         if (!key.isCharacterKey()) continue;
 
-        float dx = key.centerX - x;
-        float dy = key.centerY - y;
-        float dist = std::sqrt(dx * dx + dy * dy);
-
+        float dist = keyDistance(key, x, y);
         if (dist < bestDist) {
             bestDist = dist;
             bestIndex = static_cast<int32_t>(i);
@@ -27,23 +61,144 @@ int32_t KeyboardLayout::findNearestKey(float x, float y) const {
     return bestIndex;
 }
 
-int32_t KeyboardLayout::findKeyByCodePoint(int32_t codePoint) const {
-    // Lowercase the search code point if ASCII uppercase
-    int32_t searchCp = codePoint;
-    if (searchCp >= 'A' && searchCp <= 'Z') {
-        searchCp = searchCp - 'A' + 'a';
+int32_t scanKeyByCodePoint(const std::vector<KeyDescriptor>& keys, int32_t codePoint) {
+    int32_t searchCp = foldCodePoint(codePoint);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (foldCodePoint(keys[i].codePoint) == searchCp) {
+            return static_cast<int32_t>(i);
+        }
     }
+    return -1;
+}
+
+} // namespace
+
+void KeyboardLayout::buildLookup() {
+    auto table = std::make_shared<Lookup>();
+    table->keyCount = keys.size();
 
+    // Code points: the first key wins, as in the scan
+    table->asciiKeys.fill(-1);
     for (size_t i = 0; i < keys.size(); ++i) {
-        int32_t kcp = keys[i].codePoint;
-        if (kcp >= 'A' && kcp <= 'Z') {
-            kcp = kcp - 'A' + 'a';
+        int32_t cp = foldCodePoint(keys[i].codePoint);
+        if (cp >= 0 && cp < 128) {
+            if (table->asciiKeys[static_cast<size_t>(cp)] < 0) {
+                table->asciiKeys[static_cast<size_t>(cp)] = static_cast<int32_t>(i);
+            }
+        } else {
+            table->otherKeys.emplace(cp, static_cast<int32_t>(i));
         }
-        if (kcp == searchCp) {
-            return static_cast<int32_t>(i);
+    }
+
+    // Grid extent: the layout plus every character key's bounds
+    std::vector<int32_t> charKeys;
+    float minX = 0.0f, minY = 0.0f;
+    float maxX = std::max(0.0f, layoutWidth), maxY = std::max(0.0f, layoutHeight);
+    float minKeySize = FLT_MAX;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const KeyDescriptor& key = keys[i];
+        if (!key.isCharacterKey()) continue;
+        charKeys.push_back(static_cast<int32_t>(i));
+        minX = std::min(minX, key.centerX - key.width * 0.5f);
+        maxX = std::max(maxX, key.centerX + key.width * 0.5f);
+        minY = std::min(minY, key.centerY - key.height * 0.5f);
+        maxY = std::max(maxY, key.centerY + key.height * 0.5f);
+        if (key.width > 0.0f) minKeySize = std::min(minKeySize, key.width);
+        if (key.height > 0.0f) minKeySize = std::min(minKeySize, key.height);
+    }
+
+    if (!charKeys.empty() && maxX > minX && maxY > minY &&
+        std::isfinite(maxX - minX) && std::isfinite(maxY - minY)) {
+        // About two cells per key side, so most cells hold one or two keys
+        float cellSize = (minKeySize < FLT_MAX) ? minKeySize * 0.5f
+                                                : std::max(maxX - minX, maxY - minY) / 16.0f;
+        auto cellsFor = [&](float extent) {
+            float n = std::ceil(extent / cellSize);
+            return static_cast<int>(std::max(1.0f, std::min(n, static_cast<float>(MAX_GRID_CELLS))));
+        };
+        table->cols = cellsFor(maxX - minX);
+        table->rows = cellsFor(maxY - minY);
+        table->originX = minX;
+        table->originY = minY;
+        table->cellW = (maxX - minX) / static_cast<float>(table->cols);
+        table->cellH = (maxY - minY) / static_cast<float>(table->rows);
+
+        // A key can be nearest somewhere in a cell only if its closest distance
+        // to the cell is within the smallest farthest distance of any key. The
+        // slack absorbs rounding when a point is binned into its cell.
+        const double slack = 1e-3 * std::hypot(table->cellW, table->cellH);
+        std::vector<double> nearDist(charKeys.size());
+        table->cellStart.reserve(static_cast<size_t>(table->cols * table->rows) + 1);
+        table->cellStart.push_back(0);
+        for (int row = 0; row < table->rows; ++row) {
+            double y0 = minY + static_cast<double>(row) * table->cellH;
+            double y1 = y0 + table->cellH;
+            for (int col = 0; col < table->cols; ++col) {
+                double x0 = minX + static_cast<double>(col) * table->cellW;
+                double x1 = x0 + table->cellW;
+
+                double bound = DBL_MAX;
+                for (size_t k = 0; k < charKeys.size(); ++k) {
+                    const KeyDescriptor& key = keys[static_cast<size_t>(charKeys[k])];
+                    double cx = key.centerX, cy = key.centerY;
+                    double nx = std::max({x0 - cx, 0.0, cx - x1});
+                    double ny = std::max({y0 - cy, 0.0, cy - y1});
+                    double fx = std::max(std::abs(cx - x0), std::abs(cx - x1));
+                    double fy = std::max(std::abs(cy - y0), std::abs(cy - y1));
+                    nearDist[k] = std::hypot(nx, ny);
+                    bound = std::min(bound, std::hypot(fx, fy));
+                }
+                bound += slack + bound * 1e-5;
+                for (size_t k = 0; k < charKeys.size(); ++k) {
+                    if (nearDist[k] <= bound) table->cellKeys.push_back(charKeys[k]);
+                }
+                table->cellStart.push_back(static_cast<uint32_t>(table->cellKeys.size()));
+            }
         }
     }
-    return -1;
+
+    lookup = std::move(table);
+}
+
+bool KeyboardLayout::hasLookup() const {
+    return lookup && lookup->keyCount == keys.size();
+}
+
+int32_t KeyboardLayout::findNearestKey(float x, float y) const {
+    if (!hasLookup() || lookup->cols == 0) return scanNearestKey(keys, x, y);
+
+    const Lookup& t = *lookup;
+    float gx = (x - t.originX) / t.cellW;
+    float gy = (y - t.originY) / t.cellH;
+    // Off the keyboard (or NaN): scan
+    if (!(gx >= 0.0f && gx <= static_cast<float>(t.cols) &&
+          gy >= 0.0f && gy <= static_cast<float>(t.rows))) {
+        return scanNearestKey(keys, x, y);
+    }
+    int col = std::min(static_cast<int>(gx), t.cols - 1);
+    int row = std::min(static_cast<int>(gy), t.rows - 1);
+    size_t cell = static_cast<size_t>(row * t.cols + col);
+
+    int32_t bestIndex = -1;
+    float bestDist = FLT_MAX;
+    for (uint32_t c = t.cellStart[cell]; c < t.cellStart[cell + 1]; ++c) {
+        int32_t i = t.cellKeys[c];
+        float dist = keyDistance(keys[static_cast<size_t>(i)], x, y);
+        if (dist < bestDist) {
+            bestDist = dist;
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+int32_t KeyboardLayout::findKeyByCodePoint(int32_t codePoint) const {
+    if (!hasLookup()) return scanKeyByCodePoint(keys, codePoint);
+
+    int32_t cp = foldCodePoint(codePoint);
+    if (cp >= 0 && cp < 128) return lookup->asciiKeys[static_cast<size_t>(cp)];
+    auto it = lookup->otherKeys.find(cp);
+    return it != lookup->otherKeys.end() ? it->second : -1;
 }
 
 bool KeyboardLayout::isValid() const {
@@ -4,16 +4,62 @@
 #include <algorithm>
 #include <cstring>
 #include <cctype>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace swipetype {
 
 struct DictionaryLoader::Impl {
-    std::vector<DictionaryEntry> entries;
     DictionaryHeader header;
+    uint32_t entryCount = 0;
     uint32_t maxFrequency = 0;
     ErrorInfo lastError;
     bool loaded = false;
 
+    // Bytes behind the entry views. bytes/byteCount point into ownedBuffer,
+    // the mapping, or a borrowed caller buffer, depending on storage.
+    DictionaryStorage storage = DictionaryStorage::COPY;
+    std::vector<uint8_t> ownedBuffer;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    const uint8_t* bytes = nullptr;
+    size_t byteCount = 0;
+
+    // Index tables. For version-2 files they point straight into the
+    // dictionary bytes; for version-1 files (or when the file tables cannot
+    // be used in place) they point into the owned vectors below.
+    //
+    // recordOffsets[i] is the byte offset of entry i's record.
+    // bucketOrder holds the indices of non-empty entries ordered by
+    // (first letter class, last letter class, word length, frequency
+    // descending, index), and
+    // bucketOffsets[b]..bucketOffsets[b + 1] is the range of bucket b.
+    // hashSlots is an open-addressing table of entry indices keyed by the
+    // case-folded word (hashWord), linear probing, hashSize a power of two.
+    const uint32_t* recordOffsets = nullptr;
+    const uint32_t* bucketOffsets = nullptr;
+    const uint32_t* bucketOrder = nullptr;
+    const uint32_t* hashSlots = nullptr;
+    uint32_t hashSize = 0;
+    size_t recordsBegin = 0;
+    std::vector<uint32_t> ownedRecordOffsets;
+    std::vector<uint32_t> ownedBucketOffsets;
+    std::vector<uint32_t> ownedBucketOrder;
+    std::vector<uint32_t> ownedHashSlots;
+
+    // Materialized entries for getAllEntries() and the pointer-returning
+    // wrappers. Built at most once per load.
+    struct EntryCache {
+        std::once_flag once;
+        std::vector<DictionaryEntry> entries;
+    };
+    std::unique_ptr<EntryCache> entryCache;
+
     void setError(ErrorCode code, const std::string& msg) {
         lastError.code = code;
         lastError.message = msg;
@@ -24,6 +70,58 @@ struct DictionaryLoader::Impl {
         lastError.message.clear();
     }
 
+    void releaseStorage() {
+        if (mapping) {
+            munmap(mapping, mappingSize);
+            mapping = nullptr;
+            mappingSize = 0;
+        }
+        std::vector<uint8_t>().swap(ownedBuffer);
+        bytes = nullptr;
+        byteCount = 0;
+        storage = DictionaryStorage::COPY;
+    }
+
+    void resetTables() {
+        header = DictionaryHeader();
+        entryCount = 0;
+        maxFrequency = 0;
+        loaded = false;
+        recordOffsets = bucketOffsets = bucketOrder = hashSlots = nullptr;
+        hashSize = 0;
+        recordsBegin = 0;
+        std::vector<uint32_t>().swap(ownedRecordOffsets);
+        std::vector<uint32_t>().swap(ownedBucketOffsets);
+        std::vector<uint32_t>().swap(ownedBucketOrder);
+        std::vector<uint32_t>().swap(ownedHashSlots);
+        entryCache.reset();
+    }
+
+    /** Map a file read-only. Returns false if the file cannot be opened or mapped. */
+    bool mapFile(const std::string& filePath, bool& opened) {
+        opened = false;
+        int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        opened = true;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        size_t fileSize = static_cast<size_t>(st.st_size);
+        void* addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping keeps its own reference to the file
+        if (addr == MAP_FAILED) return false;
+
+        mapping = addr;
+        mappingSize = fileSize;
+        bytes = static_cast<const uint8_t*>(addr);
+        byteCount = fileSize;
+        storage = DictionaryStorage::MEMORY_MAP;
+        return true;
+    }
+
     // Read uint16_t little-endian from buffer at offset
     static uint16_t readU16LE(const uint8_t* buf, size_t offset) {
         return static_cast<uint16_t>(buf[offset]) |
@@ -38,13 +136,190 @@ struct DictionaryLoader::Impl {
                (static_cast<uint32_t>(buf[offset + 3]) << 24);
     }
 
-    bool parseFromBuffer(const uint8_t* data, size_t size) {
+    static void writeU16LE(std::vector<uint8_t>& buf, size_t offset, uint16_t val) {
+        buf[offset]     = static_cast<uint8_t>(val & 0xFF);
+        buf[offset + 1] = static_cast<uint8_t>((val >> 8) & 0xFF);
+    }
+
+    static void writeU32LE(std::vector<uint8_t>& buf, size_t offset, uint32_t val) {
+        buf[offset]     = static_cast<uint8_t>(val & 0xFF);
+        buf[offset + 1] = static_cast<uint8_t>((val >> 8) & 0xFF);
+        buf[offset + 2] = static_cast<uint8_t>((val >> 16) & 0xFF);
+        buf[offset + 3] = static_cast<uint8_t>((val >> 24) & 0xFF);
+    }
+
+    // Map a character to its bucket letter class: 'a'–'z' → 0–25, anything else → 26.
+    static uint32_t letterClass(char ch) {
+        int lc = std::tolower(static_cast<unsigned char>(ch));
+        return (lc >= 'a' && lc <= 'z') ? static_cast<uint32_t>(lc - 'a')
+                                        : DICT_BUCKET_LETTERS - 1;
+    }
+
+    static uint32_t bucketOf(char first, char last) {
+        return letterClass(first) * DICT_BUCKET_LETTERS + letterClass(last);
+    }
+
+    // ASCII case folding used by lookup and the hash table.
+    static uint8_t foldByte(char ch) {
+        uint8_t c = static_cast<uint8_t>(ch);
+        return (c >= 'A' && c <= 'Z') ? static_cast<uint8_t>(c + ('a' - 'A')) : c;
+    }
+
+    /** FNV-1a over the case-folded bytes. Must match scripts/gen_dict.py. */
+    static uint32_t hashWord(std::string_view word) {
+        uint32_t h = 2166136261u;
+        for (char ch : word) {
+            h ^= foldByte(ch);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    static bool equalsFolded(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (foldByte(a[i]) != foldByte(b[i])) return false;
+        }
+        return true;
+    }
+
+    /** Smallest power of two holding count entries at a load factor of at most 1/2. */
+    static uint32_t hashTableSizeFor(uint32_t count) {
+        uint64_t slots = 1;
+        while (slots < 2ull * count) slots <<= 1;
+        return static_cast<uint32_t>(slots);
+    }
+
+    /** Decode entry index from its record. Out-of-range or damaged records decode empty. */
+    DictionaryEntry entryAt(uint32_t index) const {
+        DictionaryEntry entry;
+        if (index >= entryCount) return entry;
+
+        size_t pos = recordOffsets[index];
+        if (pos < recordsBegin || pos >= byteCount) return entry;
+        uint8_t wordLen = bytes[pos];
+        if (wordLen > MAX_WORD_LENGTH || pos + 1 + wordLen + 4 + 1 > byteCount) return entry;
+
+        entry.word = std::string_view(reinterpret_cast<const char*>(bytes + pos + 1), wordLen);
+        entry.frequency = readU32LE(bytes, pos + 1 + wordLen);
+        entry.flags = bytes[pos + 1 + wordLen + 4];
+        return entry;
+    }
+
+    /**
+     * View a little-endian u32 table in the dictionary bytes. Used in place
+     * when the host is little-endian and the table is aligned; otherwise it
+     * is decoded into fallback.
+     */
+    const uint32_t* tableAt(size_t offset, size_t count, std::vector<uint32_t>& fallback) const {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        const uint8_t* p = bytes + offset;
+        if (reinterpret_cast<uintptr_t>(p) % alignof(uint32_t) == 0) {
+            return reinterpret_cast<const uint32_t*>(p);
+        }
+#endif
+        fallback.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            fallback[i] = readU32LE(bytes, offset + i * 4);
+        }
+        return fallback.data();
+    }
+
+    /**
+     * Build the bucket index with a counting sort on (bucket, length), then
+     * order each (bucket, length) group by frequency descending, ties by
+     * index, so the most likely words of a length slice come first.
+     */
+    void buildBucketIndex() {
+        constexpr uint32_t lengthSlots = MAX_WORD_LENGTH + 1;
+        std::vector<uint32_t> counts(DICT_BUCKET_COUNT * lengthSlots + 1, 0);
+        std::vector<uint32_t> keys(entryCount, 0);
+
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            std::string_view word = entryAt(i).word;
+            if (word.empty()) continue;
+            keys[i] = bucketOf(word.front(), word.back()) * lengthSlots +
+                      static_cast<uint32_t>(word.size());
+            counts[keys[i] + 1]++;
+        }
+        for (size_t k = 1; k < counts.size(); ++k) {
+            counts[k] += counts[k - 1];
+        }
+
+        ownedBucketOffsets.assign(DICT_BUCKET_COUNT + 1, 0);
+        for (uint32_t b = 0; b <= DICT_BUCKET_COUNT; ++b) {
+            ownedBucketOffsets[b] = counts[b * lengthSlots];
+        }
+
+        ownedBucketOrder.assign(counts.back(), 0);
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            // keys[i] == 0 only for empty words: a zero length never occurs otherwise
+            if (keys[i] == 0) continue;
+            ownedBucketOrder[counts[keys[i]]++] = i;
+        }
+
+        // After the scatter counts[k] is the end of group k (and the start
+        // of group k + 1)
+        std::vector<uint32_t> frequencies(entryCount, 0);
+        for (uint32_t i = 0; i < entryCount; ++i) frequencies[i] = entryAt(i).frequency;
+        uint32_t begin = 0;
+        for (size_t k = 0; k + 1 < counts.size(); ++k) {
+            const uint32_t end = counts[k];
+            if (end - begin > 1) {
+                std::sort(ownedBucketOrder.begin() + begin, ownedBucketOrder.begin() + end,
+                    [&frequencies](uint32_t a, uint32_t b) {
+                        if (frequencies[a] != frequencies[b]) return frequencies[a] > frequencies[b];
+                        return a < b;
+                    });
+            }
+            begin = end;
+        }
+
+        bucketOffsets = ownedBucketOffsets.data();
+        bucketOrder = ownedBucketOrder.data();
+    }
+
+    /** Fill slots with the lookup hash table for the loaded entries. */
+    void buildHashTable(std::vector<uint32_t>& slots) const {
+        uint32_t size = hashTableSizeFor(entryCount);
+        uint32_t mask = size - 1;
+        slots.assign(size, DICT_HASH_EMPTY);
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            std::string_view word = entryAt(i).word;
+            if (word.empty()) continue;
+            uint32_t slot = hashWord(word) & mask;
+            while (slots[slot] != DICT_HASH_EMPTY) slot = (slot + 1) & mask;
+            slots[slot] = i;
+        }
+    }
+
+    DictionaryIndexSpan bucketRange(uint32_t firstBucket, uint32_t lastBucket) const {
+        if (!loaded || !bucketOffsets) return DictionaryIndexSpan();
+        DictionaryIndexSpan span;
+        span.data = bucketOrder + bucketOffsets[firstBucket];
+        span.count = bucketOffsets[lastBucket + 1] - bucketOffsets[firstBucket];
+        return span;
+    }
+
+    /** Open the bytes already in storage; on failure the storage is released. */
+    bool parseStorage() {
+        if (parseFromBuffer()) {
+            entryCache.reset(new EntryCache());
+            loaded = true;
+            return true;
+        }
+        resetTables();
+        releaseStorage();
+        return false;
+    }
+
+    bool parseFromBuffer() {
         clearError();
-        entries.clear();
-        header = DictionaryHeader();
-        maxFrequency = 0;
+        resetTables();
 
-        if (size < DICT_HEADER_SIZE) {
+        const uint8_t* data = bytes;
+        size_t size = byteCount;
+        if (!data || size < DICT_HEADER_SIZE) {
             setError(ErrorCode::DICT_CORRUPT, "File too small for header");
             return false;
         }
@@ -66,15 +341,28 @@ struct DictionaryLoader::Impl {
             setError(ErrorCode::DICT_CORRUPT, "Invalid magic bytes");
             return false;
         }
-        if (header.version != DICT_VERSION) {
-            setError(ErrorCode::DICT_VERSION_MISMATCH,
-                     "Unsupported dictionary version: " + std::to_string(header.version));
+        if (size > UINT32_MAX) {
+            setError(ErrorCode::DICT_CORRUPT, "File too large");
             return false;
         }
+        if (header.version == DICT_VERSION) return openV2();
+        if (header.version == DICT_VERSION_V1) return parseV1();
+
+        setError(ErrorCode::DICT_VERSION_MISMATCH,
+                 "Unsupported dictionary version: " + std::to_string(header.version));
+        return false;
+    }
 
-        // Parse entries
+    /** Version 1: walk the flat records once and build the tables in memory. */
+    bool parseV1() {
+        const uint8_t* data = bytes;
+        size_t size = byteCount;
         size_t pos = DICT_HEADER_SIZE;
-        entries.reserve(header.entryCount);
+        if (header.entryCount > (size - pos) / 6) {
+            setError(ErrorCode::DICT_CORRUPT, "Entry count exceeds file size");
+            return false;
+        }
+        ownedRecordOffsets.reserve(header.entryCount);
 
         for (uint32_t i = 0; i < header.entryCount; ++i) {
             if (pos + 1 > size) {
@@ -82,42 +370,119 @@ struct DictionaryLoader::Impl {
                 return false;
             }
 
-            uint8_t wordLen = data[pos++];
+            uint8_t wordLen = data[pos];
             if (wordLen > MAX_WORD_LENGTH) {
                 setError(ErrorCode::DICT_CORRUPT, "Word length exceeds maximum");
                 return false;
             }
-            if (pos + wordLen + 4 + 1 > size) {
+            if (pos + 1 + wordLen + 4 + 1 > size) {
                 setError(ErrorCode::DICT_CORRUPT, "Truncated entry at index " + std::to_string(i));
                 return false;
             }
 
-            DictionaryEntry entry;
-            entry.word = std::string(reinterpret_cast<const char*>(data + pos), wordLen);
-            pos += wordLen;
-            entry.frequency = readU32LE(data, pos);
-            pos += 4;
-            entry.flags = data[pos++];
+            ownedRecordOffsets.push_back(static_cast<uint32_t>(pos));
+            uint32_t frequency = readU32LE(data, pos + 1 + wordLen);
+            if (frequency > maxFrequency) {
+                maxFrequency = frequency;
+            }
+            pos += 1 + wordLen + 4 + 1;
+        }
+
+        entryCount = header.entryCount;
+        recordOffsets = ownedRecordOffsets.data();
+        recordsBegin = DICT_HEADER_SIZE;
+        buildBucketIndex();
+        buildHashTable(ownedHashSlots);
+        hashSlots = ownedHashSlots.data();
+        hashSize = static_cast<uint32_t>(ownedHashSlots.size());
+        return true;
+    }
+
+    /** True if a u32 table of count entries at offset lies inside the file. */
+    bool sectionFits(uint32_t offset, uint64_t count) const {
+        return offset >= DICT_HEADER_V2_SIZE && offset % 4 == 0 &&
+               static_cast<uint64_t>(offset) + count * 4 <= byteCount;
+    }
+
+    /**
+     * Version 2: validate the section directory and use the tables in place.
+     * Only the bucket table is read (its size is fixed); records are bounds-
+     * checked as they are decoded.
+     */
+    bool openV2() {
+        const uint8_t* data = bytes;
+        if (byteCount < DICT_HEADER_V2_SIZE) {
+            setError(ErrorCode::DICT_CORRUPT, "File too small for version-2 header");
+            return false;
+        }
 
-            if (entry.frequency > maxFrequency) {
-                maxFrequency = entry.frequency;
+        uint32_t maxFreq      = readU32LE(data, 32);
+        uint32_t offsetsAt    = readU32LE(data, 36);
+        uint32_t bucketsAt    = readU32LE(data, 40);
+        uint32_t orderAt      = readU32LE(data, 44);
+        uint32_t hashAt       = readU32LE(data, 48);
+        uint32_t hashSlotsLen = readU32LE(data, 52);
+        uint32_t recordsAt    = readU32LE(data, 56);
+        uint32_t count        = header.entryCount;
+
+        if (!sectionFits(offsetsAt, count) ||
+            !sectionFits(bucketsAt, DICT_BUCKET_COUNT + 1)) {
+            setError(ErrorCode::DICT_CORRUPT, "Index section out of bounds");
+            return false;
+        }
+        const uint32_t* buckets = tableAt(bucketsAt, DICT_BUCKET_COUNT + 1, ownedBucketOffsets);
+        if (buckets[0] != 0) {
+            setError(ErrorCode::DICT_CORRUPT, "Bucket table does not start at zero");
+            return false;
+        }
+        for (uint32_t b = 0; b < DICT_BUCKET_COUNT; ++b) {
+            if (buckets[b + 1] < buckets[b]) {
+                setError(ErrorCode::DICT_CORRUPT, "Bucket table is not monotonic");
+                return false;
             }
-            entries.push_back(std::move(entry));
+        }
+        uint32_t ordered = buckets[DICT_BUCKET_COUNT];
+        if (ordered > count || !sectionFits(orderAt, ordered)) {
+            setError(ErrorCode::DICT_CORRUPT, "Bucket order section out of bounds");
+            return false;
+        }
+        if (hashSlotsLen == 0 || (hashSlotsLen & (hashSlotsLen - 1)) != 0 ||
+            hashSlotsLen <= count || !sectionFits(hashAt, hashSlotsLen)) {
+            setError(ErrorCode::DICT_CORRUPT, "Hash table section invalid");
+            return false;
+        }
+        if (recordsAt < DICT_HEADER_V2_SIZE || recordsAt > byteCount) {
+            setError(ErrorCode::DICT_CORRUPT, "Record section out of bounds");
+            return false;
         }
 
-        loaded = true;
+        entryCount = count;
+        maxFrequency = maxFreq;
+        recordsBegin = recordsAt;
+        bucketOffsets = buckets;
+        recordOffsets = tableAt(offsetsAt, count, ownedRecordOffsets);
+        bucketOrder = tableAt(orderAt, ordered, ownedBucketOrder);
+        hashSlots = tableAt(hashAt, hashSlotsLen, ownedHashSlots);
+        hashSize = hashSlotsLen;
+        // Files written before buckets were frequency-ordered keep entry
+        // order within a length group; their bucket order is rebuilt
+        if (!(header.flags & DICT_HEADER_FREQUENCY_BUCKETS)) buildBucketIndex();
         return true;
     }
 };
 
 DictionaryLoader::DictionaryLoader() : pImpl(new Impl()) {}
-DictionaryLoader::~DictionaryLoader() { delete pImpl; }
+DictionaryLoader::~DictionaryLoader() {
+    if (pImpl) pImpl->releaseStorage();
+    delete pImpl;
+}
 
 DictionaryLoader::DictionaryLoader(DictionaryLoader&& other) noexcept
     : pImpl(other.pImpl) { other.pImpl = nullptr; }
 
 DictionaryLoader& DictionaryLoader::operator=(DictionaryLoader&& other) noexcept {
     if (this != &other) {
+        if (pImpl) pImpl->releaseStorage();
         delete pImpl;
         pImpl = other.pImpl;
         other.pImpl = nullptr;
@@ -125,10 +490,23 @@ DictionaryLoader& DictionaryLoader::operator=(DictionaryLoader&& other) noexcept
     return *this;
 }
 
-bool DictionaryLoader::load(const std::string& filePath) {
+bool DictionaryLoader::load(const std::string& filePath, DictionaryStorage storage) {
     if (!pImpl) return false;
     unload();
 
+    if (storage != DictionaryStorage::COPY) {
+        bool opened = false;
+        if (pImpl->mapFile(filePath, opened)) {
+            return pImpl->parseStorage();
+        }
+        if (!opened) {
+            pImpl->setError(ErrorCode::DICT_NOT_FOUND,
+                            "Cannot open file: " + filePath);
+            return false;
+        }
+        // Mapping failed (e.g. empty file): fall through to a plain read.
+    }
+
     std::ifstream file(filePath, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         pImpl->setError(ErrorCode::DICT_NOT_FOUND,
@@ -139,27 +517,41 @@ bool DictionaryLoader::load(const std::string& filePath) {
     std::streamsize fileSize = file.tellg();
     file.seekg(0, std::ios::beg);
 
-    std::vector<uint8_t> buffer(static_cast<size_t>(fileSize));
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), fileSize)) {
+    pImpl->ownedBuffer.resize(static_cast<size_t>(fileSize));
+    if (!file.read(reinterpret_cast<char*>(pImpl->ownedBuffer.data()), fileSize)) {
         pImpl->setError(ErrorCode::DICT_CORRUPT, "Failed to read file: " + filePath);
+        pImpl->releaseStorage();
         return false;
     }
+    pImpl->bytes = pImpl->ownedBuffer.data();
+    pImpl->byteCount = pImpl->ownedBuffer.size();
+    pImpl->storage = DictionaryStorage::COPY;
 
-    return pImpl->parseFromBuffer(buffer.data(), buffer.size());
+    return pImpl->parseStorage();
 }
 
-bool DictionaryLoader::loadFromMemory(const uint8_t* data, size_t size) {
+bool DictionaryLoader::loadFromMemory(const uint8_t* data, size_t size,
+                                      DictionaryStorage storage) {
     if (!pImpl) return false;
     unload();
-    return pImpl->parseFromBuffer(data, size);
+
+    if (storage == DictionaryStorage::BORROW) {
+        pImpl->bytes = data;
+        pImpl->storage = DictionaryStorage::BORROW;
+    } else {
+        if (data && size > 0) pImpl->ownedBuffer.assign(data, data + size);
+        pImpl->bytes = pImpl->ownedBuffer.data();
+        pImpl->storage = DictionaryStorage::COPY;
+    }
+    pImpl->byteCount = size;
+
+    return pImpl->parseStorage();
 }
 
 void DictionaryLoader::unload() {
     if (pImpl) {
-        pImpl->entries.clear();
-        pImpl->header = DictionaryHeader();
-        pImpl->maxFrequency = 0;
-        pImpl->loaded = false;
+        pImpl->resetTables();
+        pImpl->releaseStorage();
         pImpl->clearError();
     }
 }
@@ -173,7 +565,7 @@ DictionaryHeader DictionaryLoader::getHeader() const {
 }
 
 uint32_t DictionaryLoader::getEntryCount() const {
-    return pImpl ? static_cast<uint32_t>(pImpl->entries.size()) : 0;
+    return pImpl ? pImpl->entryCount : 0;
 }
 
 uint32_t DictionaryLoader::getMaxFrequency() const {
@@ -182,18 +574,71 @@ uint32_t DictionaryLoader::getMaxFrequency() const {
 
 const std::vector<DictionaryEntry>& DictionaryLoader::getAllEntries() const {
     static const std::vector<DictionaryEntry> empty;
-    return (pImpl && pImpl->loaded) ? pImpl->entries : empty;
+    if (!pImpl || !pImpl->loaded) return empty;
+
+    Impl::EntryCache& cache = *pImpl->entryCache;
+    const Impl& impl = *pImpl;
+    std::call_once(cache.once, [&cache, &impl] {
+        cache.entries.reserve(impl.entryCount);
+        for (uint32_t i = 0; i < impl.entryCount; ++i) {
+            cache.entries.push_back(impl.entryAt(i));
+        }
+    });
+    return cache.entries;
+}
+
+DictionaryEntry DictionaryLoader::getEntry(uint32_t index) const {
+    return (pImpl && pImpl->loaded) ? pImpl->entryAt(index) : DictionaryEntry();
+}
+
+DictionaryIndexSpan DictionaryLoader::getIndexedEntries() const {
+    if (!pImpl) return DictionaryIndexSpan();
+    return pImpl->bucketRange(0, DICT_BUCKET_COUNT - 1);
+}
+
+DictionaryIndexSpan DictionaryLoader::getStartBucket(char startChar) const {
+    if (!pImpl) return DictionaryIndexSpan();
+    uint32_t first = Impl::letterClass(startChar) * DICT_BUCKET_LETTERS;
+    return pImpl->bucketRange(first, first + DICT_BUCKET_LETTERS - 1);
+}
+
+DictionaryIndexSpan DictionaryLoader::getBucket(char startChar, char endChar) const {
+    if (!pImpl) return DictionaryIndexSpan();
+    uint32_t bucket = Impl::bucketOf(startChar, endChar);
+    return pImpl->bucketRange(bucket, bucket);
+}
+
+DictionaryIndexSpan DictionaryLoader::getBucket(char startChar, char endChar,
+                                                uint32_t minLength, uint32_t maxLength) const {
+    DictionaryIndexSpan span = getBucket(startChar, endChar);
+    if (span.empty() || minLength > maxLength) return DictionaryIndexSpan();
+
+    const Impl& impl = *pImpl;
+    const uint32_t* lo = std::lower_bound(span.begin(), span.end(), minLength,
+        [&impl](uint32_t idx, uint32_t len) { return impl.entryAt(idx).word.size() < len; });
+    const uint32_t* hi = std::upper_bound(lo, span.end(), maxLength,
+        [&impl](uint32_t len, uint32_t idx) { return len < impl.entryAt(idx).word.size(); });
+
+    DictionaryIndexSpan result;
+    result.data = lo;
+    result.count = static_cast<size_t>(hi - lo);
+    return result;
 }
 
 std::vector<const DictionaryEntry*> DictionaryLoader::getEntriesStartingWith(char startChar) const {
     std::vector<const DictionaryEntry*> result;
     if (!pImpl || !pImpl->loaded) return result;
 
-    char lc = static_cast<char>(std::tolower(static_cast<unsigned char>(startChar)));
-    for (const auto& entry : pImpl->entries) {
-        if (!entry.word.empty() &&
-            std::tolower(static_cast<unsigned char>(entry.word[0])) ==
-                static_cast<unsigned char>(lc)) {
+    // The letter-class bucket is exact for 'a'–'z'; the shared "other" class
+    // still needs the byte comparison.
+    const auto& entries = getAllEntries();
+    int lc = std::tolower(static_cast<unsigned char>(startChar));
+    DictionaryIndexSpan span = getStartBucket(startChar);
+    result.reserve(span.size());
+    for (uint32_t idx : span) {
+        if (idx >= entries.size() || entries[idx].word.empty()) continue;
+        const DictionaryEntry& entry = entries[idx];
+        if (std::tolower(static_cast<unsigned char>(entry.word.front())) == lc) {
             result.push_back(&entry);
         }
     }
@@ -205,43 +650,100 @@ std::vector<const DictionaryEntry*> DictionaryLoader::getEntriesWithStartEnd(
     std::vector<const DictionaryEntry*> result;
     if (!pImpl || !pImpl->loaded) return result;
 
-    char lcS = static_cast<char>(std::tolower(static_cast<unsigned char>(startChar)));
-    char lcE = static_cast<char>(std::tolower(static_cast<unsigned char>(endChar)));
-
-    for (const auto& entry : pImpl->entries) {
-        if (entry.word.empty()) continue;
-        char first = static_cast<char>(std::tolower(
-            static_cast<unsigned char>(entry.word.front())));
-        char last  = static_cast<char>(std::tolower(
-            static_cast<unsigned char>(entry.word.back())));
-        if (first == lcS && last == lcE) {
+    const auto& entries = getAllEntries();
+    int lcS = std::tolower(static_cast<unsigned char>(startChar));
+    int lcE = std::tolower(static_cast<unsigned char>(endChar));
+    DictionaryIndexSpan span = getBucket(startChar, endChar);
+    result.reserve(span.size());
+    for (uint32_t idx : span) {
+        if (idx >= entries.size() || entries[idx].word.empty()) continue;
+        const DictionaryEntry& entry = entries[idx];
+        if (std::tolower(static_cast<unsigned char>(entry.word.front())) == lcS &&
+            std::tolower(static_cast<unsigned char>(entry.word.back())) == lcE) {
             result.push_back(&entry);
         }
     }
     return result;
 }
 
-const DictionaryEntry* DictionaryLoader::lookup(const std::string& word) const {
-    if (!pImpl || !pImpl->loaded || word.empty()) return nullptr;
+std::optional<DictionaryEntry> DictionaryLoader::lookup(std::string_view word) const {
+    if (!pImpl || !pImpl->loaded || word.empty()) return std::nullopt;
+    const Impl& impl = *pImpl;
+
+    // Single probe sequence; the table always has an empty slot (load factor
+    // at most 1/2), the bound only guards against damaged files.
+    uint32_t mask = impl.hashSize - 1;
+    uint32_t slot = Impl::hashWord(word) & mask;
+    for (uint32_t probe = 0; probe < impl.hashSize; ++probe) {
+        uint32_t idx = impl.hashSlots[slot];
+        if (idx == DICT_HASH_EMPTY) break;
+        DictionaryEntry entry = impl.entryAt(idx);
+        if (Impl::equalsFolded(entry.word, word)) return entry;
+        slot = (slot + 1) & mask;
+    }
+    return std::nullopt;
+}
 
-    // Create lowercase query
-    std::string lcWord;
-    lcWord.reserve(word.size());
-    for (char ch : word) {
-        lcWord.push_back(static_cast<char>(
-            std::tolower(static_cast<unsigned char>(ch))));
+bool DictionaryLoader::serialize(std::vector<uint8_t>& out) const {
+    out.clear();
+    if (!pImpl || !pImpl->loaded) return false;
+    const Impl& impl = *pImpl;
+
+    std::vector<uint32_t> hash;
+    impl.buildHashTable(hash);
+
+    const uint32_t count = impl.entryCount;
+    const uint32_t ordered = impl.bucketOffsets[DICT_BUCKET_COUNT];
+    const size_t offsetsAt = DICT_HEADER_V2_SIZE;
+    const size_t bucketsAt = offsetsAt + size_t(count) * 4;
+    const size_t orderAt   = bucketsAt + size_t(DICT_BUCKET_COUNT + 1) * 4;
+    const size_t hashAt    = orderAt + size_t(ordered) * 4;
+    const size_t recordsAt = hashAt + hash.size() * 4;
+
+    out.assign(recordsAt, 0);
+
+    // Header: base fields as in version 1, then the section directory
+    const std::string& lang = impl.header.languageTag;
+    Impl::writeU32LE(out, 0, DICT_MAGIC);
+    Impl::writeU16LE(out, 4, DICT_VERSION);
+    Impl::writeU16LE(out, 6, impl.header.flags | DICT_HEADER_FREQUENCY_BUCKETS);
+    Impl::writeU32LE(out, 8, count);
+    Impl::writeU16LE(out, 12, static_cast<uint16_t>(lang.size()));
+    std::memcpy(out.data() + 14, lang.data(), lang.size());
+    Impl::writeU32LE(out, 32, impl.maxFrequency);
+    Impl::writeU32LE(out, 36, static_cast<uint32_t>(offsetsAt));
+    Impl::writeU32LE(out, 40, static_cast<uint32_t>(bucketsAt));
+    Impl::writeU32LE(out, 44, static_cast<uint32_t>(orderAt));
+    Impl::writeU32LE(out, 48, static_cast<uint32_t>(hashAt));
+    Impl::writeU32LE(out, 52, static_cast<uint32_t>(hash.size()));
+    Impl::writeU32LE(out, 56, static_cast<uint32_t>(recordsAt));
+
+    for (uint32_t b = 0; b <= DICT_BUCKET_COUNT; ++b) {
+        Impl::writeU32LE(out, bucketsAt + size_t(b) * 4, impl.bucketOffsets[b]);
+    }
+    for (uint32_t i = 0; i < ordered; ++i) {
+        Impl::writeU32LE(out, orderAt + size_t(i) * 4, impl.bucketOrder[i]);
+    }
+    for (size_t i = 0; i < hash.size(); ++i) {
+        Impl::writeU32LE(out, hashAt + i * 4, hash[i]);
     }
 
-    for (const auto& entry : pImpl->entries) {
-        std::string lcEntry;
-        lcEntry.reserve(entry.word.size());
-        for (char ch : entry.word) {
-            lcEntry.push_back(static_cast<char>(
-                std::tolower(static_cast<unsigned char>(ch))));
-        }
-        if (lcEntry == lcWord) return &entry;
+    // Records, in entry order: wordLen(1) word(N) frequency(4) flags(1)
+    for (uint32_t i = 0; i < count; ++i) {
+        DictionaryEntry entry = impl.entryAt(i);
+        Impl::writeU32LE(out, offsetsAt + size_t(i) * 4, static_cast<uint32_t>(out.size()));
+        out.push_back(static_cast<uint8_t>(entry.word.size()));
+        out.insert(out.end(), entry.word.begin(), entry.word.end());
+        size_t freqAt = out.size();
+        out.resize(freqAt + 4);
+        Impl::writeU32LE(out, freqAt, entry.frequency);
+        out.push_back(entry.flags);
     }
-    return nullptr;
+    return true;
+}
+
+DictionaryStorage DictionaryLoader::getStorage() const {
+    return pImpl ? pImpl->storage : DictionaryStorage::COPY;
 }
 
 ErrorInfo DictionaryLoader::getLastError() const {
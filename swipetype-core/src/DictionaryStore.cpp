@@ -0,0 +1,61 @@
+#include "swipetype/DictionaryStore.h"
+
+namespace swipetype {
+
+struct DictionaryStore::Impl {
+    DictionaryLoader dict;
+    LexiconTrie lexicon;
+
+    bool finishLoad(bool loaded) {
+        lexicon.clear();
+        return loaded && lexicon.build(dict);
+    }
+};
+
+DictionaryStore::DictionaryStore() : pImpl(new Impl()) {}
+DictionaryStore::~DictionaryStore() { delete pImpl; }
+
+DictionaryStore::DictionaryStore(DictionaryStore&& other) noexcept
+    : pImpl(other.pImpl) { other.pImpl = nullptr; }
+
+DictionaryStore& DictionaryStore::operator=(DictionaryStore&& other) noexcept {
+    if (this != &other) {
+        delete pImpl;
+        pImpl = other.pImpl;
+        other.pImpl = nullptr;
+    }
+    return *this;
+}
+
+bool DictionaryStore::load(const std::string& filePath, DictionaryStorage storage) {
+    return pImpl && pImpl->finishLoad(pImpl->dict.load(filePath, storage));
+}
+
+bool DictionaryStore::loadFromMemory(const uint8_t* data, size_t size,
+                                     DictionaryStorage storage) {
+    return pImpl && pImpl->finishLoad(pImpl->dict.loadFromMemory(data, size, storage));
+}
+
+void DictionaryStore::unload() {
+    if (!pImpl) return;
+    pImpl->lexicon.clear();
+    pImpl->dict.unload();
+}
+
+bool DictionaryStore::isLoaded() const {
+    return pImpl && pImpl->dict.isLoaded();
+}
+
+const DictionaryLoader& DictionaryStore::getDictionary() const {
+    return pImpl->dict;
+}
+
+const LexiconTrie& DictionaryStore::getLexicon() const {
+    return pImpl->lexicon;
+}
+
+ErrorInfo DictionaryStore::getLastError() const {
+    return pImpl ? pImpl->dict.getLastError() : ErrorInfo();
+}
+
+} // namespace swipetype
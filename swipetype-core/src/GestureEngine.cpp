@@ -3,62 +3,2091 @@
 #include "swipetype/IdealPathGenerator.h"
 #include "swipetype/Scorer.h"
 #include "swipetype/DictionaryLoader.h"
+#include "swipetype/DictionaryStore.h"
+#include "swipetype/TemplateStore.h"
+#include "swipetype/UserDictionary.h"
+#include "swipetype/LexiconTrie.h"
+#include "swipetype/WorkerPool.h"
 #include "swipetype/SwipeTypeTypes.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
 #include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
 
-#ifdef __ANDROID__
-#include <android/log.h>
-#define ST_LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "SwipeTypeCore", __VA_ARGS__)
+namespace swipetype {
+
+namespace {
+
+#ifdef SWIPETYPE_NO_STATS
+constexpr bool kCollectStats = false;
 #else
-#define ST_LOGD(...) do { std::fprintf(stderr, __VA_ARGS__); std::fprintf(stderr, "\n"); } while(0)
+constexpr bool kCollectStats = true;
 #endif
 
-namespace swipetype {
+/** Lap timer for RecognitionStats; never reads the clock when stats are off. */
+class StageClock {
+public:
+    StageClock() {
+        if constexpr (kCollectStats) last = std::chrono::steady_clock::now();
+    }
+
+    /** Nanoseconds since construction or the previous lap(). */
+    uint64_t lap() {
+        if constexpr (kCollectStats) {
+            auto now = std::chrono::steady_clock::now();
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+            last = now;
+            return static_cast<uint64_t>(ns);
+        } else {
+            return 0;
+        }
+    }
+
+private:
+    std::chrono::steady_clock::time_point last;
+};
+
+struct ScoredEntry {
+    uint32_t position;      // index into the candidate span
+    uint32_t entryIndex;
+    float dtwDistance;
+    uint32_t source = 0;    // dictionary the entry belongs to
+};
+
+/** Shortlist order: lower distance first, ties by candidate position. */
+inline bool rankedBefore(const ScoredEntry& a, const ScoredEntry& b) {
+    return a.dtwDistance < b.dtwDistance ||
+           (a.dtwDistance == b.dtwDistance && a.position < b.position);
+}
+
+/** A shortlisted entry's confidence, before its GestureCandidate is built. */
+struct RankedEntry {
+    float confidence;
+    float frequency;            // normalized frequency prior
+    uint32_t scored;            // index into the shortlist, in candidate order
+    std::string_view word;      // into its dictionary
+    uint32_t sourceFlags = 0;   // of duplicates merged into it
+};
+
+/** Result order: higher confidence first, ties by candidate position. */
+inline bool byConfidence(const RankedEntry& a, const RankedEntry& b) {
+    return a.confidence > b.confidence ||
+           (a.confidence == b.confidence && a.scored < b.scored);
+}
+
+/**
+ * The best `capacity` entries offered so far, as a max-heap under
+ * rankedBefore, so the worst kept entry is at the front.
+ */
+struct Shortlist {
+    size_t capacity = 0;
+    std::vector<ScoredEntry> heap;
+    size_t boundPruned = 0;
+    size_t rejected = 0;
+
+    // RecognitionStats counters of the worker filling this list
+    uint64_t templateNs = 0;
+    uint64_t dtwNs = 0;
+    uint32_t dtwCalls = 0;
+    uint32_t pathCacheHits = 0;
+    uint32_t pathsGenerated = 0;
+    uint32_t templateReads = 0;
+    uint32_t budgetSkipped = 0;
+
+    /** Empty the list for a new gesture, keeping the heap's storage. */
+    void reset(size_t cap) {
+        capacity = cap;
+        heap.clear();
+        heap.reserve(cap);
+        boundPruned = 0;
+        rejected = 0;
+        templateNs = 0;
+        dtwNs = 0;
+        dtwCalls = 0;
+        pathCacheHits = 0;
+        pathsGenerated = 0;
+        templateReads = 0;
+        budgetSkipped = 0;
+    }
+
+    bool full() const { return heap.size() >= capacity; }
+
+    /** Distance a candidate must not exceed to enter, FLT_MAX until full. */
+    float threshold() const { return full() ? heap.front().dtwDistance : FLT_MAX; }
+
+    void offer(const ScoredEntry& e) {
+        if (!full()) {
+            heap.push_back(e);
+            std::push_heap(heap.begin(), heap.end(), rankedBefore);
+        } else if (rankedBefore(e, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), rankedBefore);
+            heap.back() = e;
+            std::push_heap(heap.begin(), heap.end(), rankedBefore);
+        } else {
+            ++rejected;
+        }
+    }
+};
+
+/**
+ * ScoringConfig::scoringBudgetUs and scoringBudgetDtwCalls of one gesture,
+ * shared by every worker scoring it. Once either is used up, no worker
+ * scores another candidate, except that a worker always shortlists its
+ * first `guaranteed` candidates, so even a spent budget returns a full
+ * ranking.
+ */
+struct ScoringBudget {
+    /** The clock is read once per this many candidates (and chunk). */
+    static constexpr size_t kClockStride = 8;
+
+    size_t guaranteed = 0;  // the gesture's maxCandidates
+    bool timed = false;
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<int64_t> dtwLeft{INT64_MAX};
+    std::atomic<bool> spent{false};
+
+    /** true if the budget is used up; scored candidates of the caller's run so far. */
+    bool exhausted(size_t scored) {
+        if (spent.load(std::memory_order_relaxed)) return true;
+        if (timed && scored % kClockStride == 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            spent.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /** Take one DTW call from the budget; false if none is left. */
+    bool takeDtwCall() {
+        if (dtwLeft.fetch_sub(1, std::memory_order_relaxed) > 0) return true;
+        spent.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    /** Take count DTW calls at once; false, taking none, if fewer are left. */
+    bool reserveDtwCalls(int64_t count) {
+        int64_t left = dtwLeft.load(std::memory_order_relaxed);
+        while (left >= count) {
+            if (dtwLeft.compare_exchange_weak(left, left - count, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Give back DTW calls reserved but not used. */
+    void returnDtwCalls(int64_t count) { dtwLeft.fetch_add(count, std::memory_order_relaxed); }
+};
+
+/** Lower target to value if value is smaller. */
+inline void lowerTo(std::atomic<float>& target, float value) {
+    float current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+struct GestureEngine::Impl {
+    /**
+     * Everything a recognition reads that depends on the layout or the
+     * dictionary. Published whole by a single pointer swap, and never
+     * modified afterwards, except for the path cache, which only the
+     * recognizing thread touches.
+     */
+    struct Snapshot {
+        /** One dictionary taking part in recognition. */
+        struct Source {
+            std::shared_ptr<const DictionaryStore> store;    // may be shared
+            std::shared_ptr<const TemplateStore> templates;  // null unless compiled; may be shared
+            std::shared_ptr<const UserDictionary> user;      // instead of store; no templates
+            float weight = 1.0f;                             // scales the frequency prior
+            uint32_t sourceFlags = SOURCE_MAIN_DICT;
+
+            DictionaryEntry entry(uint32_t idx) const {
+                return user ? user->getEntry(idx) : store->getDictionary().getEntry(idx);
+            }
+        };
+        std::vector<Source> sources;  // [0] the main dictionary, then addDictionary() order
+        KeyboardLayout layout;        // lookup built
+        uint64_t layoutHash = 0;
+        int resampleCount = RESAMPLE_COUNT;  // points of every path and template
+        std::vector<uint32_t> keyLetters;    // per key: its own letter
+        std::vector<uint32_t> keyNeighbors;  // per key: letters within LEXICON_KEY_RADIUS
+        std::shared_ptr<IdealPathGenerator> paths;  // kept across snapshots of one layout
+
+        /** true if paths and templates built for base are valid for this snapshot. */
+        bool sameGeometry(const Snapshot* base) const {
+            return base && base->layoutHash == layoutHash && base->resampleCount == resampleCount;
+        }
+    };
+
+    /** What a snapshot build needs from the engine, copied when it is requested. */
+    struct BuildOptions {
+        bool templates = false;
+        bool keepTemplates = false;  // reuse base's valid templates even if not requested
+        std::string templateCacheDir;
+        TemplatePrecision precision = TemplatePrecision::FLOAT32;
+        size_t pathCacheBytes = DEFAULT_PATH_CACHE_BYTES;
+        int resampleCount = RESAMPLE_COUNT;
+    };
+
+    /** A pending swap; later requests are merged into one not yet started. */
+    struct SwapRequest {
+        bool hasLayout = false;
+        KeyboardLayout layout;
+        std::string dictPath;                          // load this dictionary, or
+        std::shared_ptr<const DictionaryStore> store;  // use this one; neither = keep
+        BuildOptions options;
+        std::vector<SwapCallback> done;
+    };
+
+    PathProcessor pathProcessor;
+    Scorer scorer;
+    std::shared_ptr<const Snapshot> published;  // atomic_load / atomic_store only
+    std::shared_ptr<const Snapshot> current;    // the recognizing thread's pin of published
+    std::shared_ptr<UserDictionary> userDictionary;  // also a source of current, if set
+    bool templatesRequested = false;
+    std::atomic<bool> templatesWarmed{false};  // current's main templates are the warm-up's
+    std::string templateCacheDir;
+    ScoringConfig config;
+    ErrorCallback errorCallback;
+    ErrorInfo lastError;
+    StatsCallback statsCallback;
+    RecognitionStats lastStats;
+    bool lastTruncated = false;  // of the recognition lastStats describe
+    bool initialized = false;
+    std::unique_ptr<WorkerPool> pool;  // null when scoring serially
+
+    /**
+     * Keys a raw gesture crossed: its nearest key at every key transition.
+     * The transition count is the word length estimate.
+     */
+    struct KeyTrace {
+        std::vector<int32_t> keys;
+        uint32_t letters = 0;       // letters of those keys (PathSignature::letterMask)
+
+        void clear() {
+            keys.clear();
+            letters = 0;
+        }
+        float estimatedLength() const { return std::max(1.0f, static_cast<float>(keys.size())); }
+    };
+
+    /** Gesture between beginGesture() and endGesture(). */
+    struct Stream {
+        bool active = false;
+        DeduplicatedPath path;
+        KeyTrace trace;             // keys crossed so far
+        char startChar = 0;
+        size_t prefetched = 0;      // start-bucket positions already visited
+        int64_t nextPreviewAt = 0;
+        int64_t keyEnteredAt = 0;   // time of the point that reached the last key crossed
+        int32_t seedKey = -1;       // last key of the in-flight ranking seeds is from
+        std::vector<ScoredEntry> seeds;  // shortlist of that ranking, for endGesture()
+    } stream;
+    PreviewCallback previewCallback;
+    int previewIntervalMs = DEFAULT_PREVIEW_INTERVAL_MS;
+    int previewCandidates = DEFAULT_MAX_CANDIDATES;
+
+    /**
+     * Ideal paths of a parallel batch's candidates in dictionaries without
+     * templates, generated once for the batch since the path cache is
+     * single-threaded. Entry e of dictionary s has its points at slot
+     * slotOf[s][e] of xs and ys, count floats each. slotOf[s] is empty for
+     * dictionaries whose paths are not in the table.
+     */
+    struct BatchPaths {
+        static constexpr uint32_t NO_SLOT = 0xFFFFFFFF;
+        size_t count = 0;
+        std::vector<std::vector<uint32_t>> slotOf;
+        std::vector<float> xs, ys;
+        std::vector<char> valid;
+    };
+
+    /** Candidates of one dictionary for the gesture being ranked. */
+    struct SourceScratch {
+        std::vector<uint32_t> lexicon;      // entries traced along the key path
+        std::vector<uint32_t> filtered;     // length-filtered candidates
+        std::vector<uint32_t> coarseKept;   // candidates passed on to DTW
+        std::vector<uint32_t> byFrequency;  // candidates in frequency order (scoring budget)
+        DictionaryIndexSpan candidates;     // into one of the above or the dictionary
+        uint32_t offset = 0;                // of its positions among all dictionaries'
+        size_t firstChunk = 0;              // of its scoring chunks among all
+    };
+
+    /**
+     * Buffers reused by every recognition. They grow to the largest gesture
+     * and candidate set seen and are never shrunk, so once warm a
+     * recognition allocates nothing but its results.
+     */
+    struct Scratch {
+        GesturePath normalized;
+        KeyTrace trace;                     // of the raw gesture (recognize() only)
+        std::vector<uint32_t> nearLetters;  // keyLetters or keyNeighbors along the trace
+        std::vector<SourceScratch> sources; // one per dictionary
+        std::vector<Shortlist> lists;       // one per worker
+        std::vector<ScoredEntry> scored;    // merged shortlist
+        std::vector<ScoredEntry> coarse;    // signature pre-filter scores
+        std::vector<uint64_t> frequencyKeys; // orderByFrequency() sort keys
+        std::vector<RankedEntry> ranked;    // confidences of the shortlist
+        Shortlist seeds;                    // words of a near cached gesture (seedThreshold())
+        std::vector<uint32_t> seedTargets;  // their entry indices in one dictionary
+        std::vector<uint32_t> seedFound;    // those of them that are candidates
+        RecognitionStats stats;             // of the recognition using these buffers
+        const BatchPaths* batchPaths = nullptr;  // recognizeBatch(): paths generated for the batch
+    } scratch;
+
+    /** Per-thread state for recognizeBatch(), one per pool worker. */
+    struct BatchWorker {
+        PathProcessor pathProcessor;
+        Scratch scratch;
+        std::vector<std::vector<uint32_t>> wanted;  // per dictionary: candidates needing batch paths
+    };
+    std::vector<std::unique_ptr<BatchWorker>> batchWorkers;
+
+    /**
+     * Rankings of recent gestures (up to ScoringConfig::resultCacheSize,
+     * least recently used replaced first). A gesture is keyed by its points
+     * rounded to 1 / RESULT_CACHE_QUANTUM, its arc length in whole dp, the
+     * keys it crossed, its start and end keys and maxCandidates. The
+     * entries hold for one snapshot and user dictionary revision, and are
+     * dropped when either changes or the engine is configured. Dropped
+     * entries keep their buffers for the rankings stored next, so a warm
+     * miss allocates nothing but its results. Only the recognizing thread
+     * touches it.
+     */
+    struct ResultCache {
+        struct Entry {
+            std::vector<uint16_t> codes;            // x, y per point
+            std::vector<int32_t> keys;              // KeyTrace::keys
+            int32_t arcLength = 0;
+            int32_t startKey = -1;
+            int32_t endKey = -1;
+            int maxCandidates = 0;
+            std::vector<GestureCandidate> results;
+            std::vector<ScoredEntry> shortlist;     // for seedThreshold()
+            uint64_t lastUsed = 0;
+        };
+        std::vector<Entry> entries;
+        size_t used = 0;                            // entries in use, at the front
+        std::weak_ptr<const Snapshot> snapshot;     // the entries were ranked on
+        uint64_t userRevision = 0;                  // of those entries' user dictionaries
+        uint64_t tick = 0;
+        std::vector<uint16_t> codes;                // of the gesture being ranked
+        ResultCacheStats stats;
+    } resultCache;
+
+    // Background snapshot builds (updateLayoutAsync(), reloadDictionaryAsync())
+    std::mutex swapMutex;
+    std::condition_variable swapDone;
+    std::unique_ptr<SwapRequest> queuedSwap;  // waits for the running build
+    bool swapRunning = false;
+    std::thread swapThread;
+
+    /**
+     * Background warm-up after init (ScoringConfig::warmup). The thread
+     * builds a private path cache and template store for base and leaves
+     * them here; the recognizing thread installs them in adoptWarmup().
+     */
+    struct Warmup {
+        std::thread thread;
+        std::atomic<int> state{static_cast<int>(WarmupState::IDLE)};
+        std::atomic<uint32_t> pathsDone{0};
+        std::atomic<uint32_t> total{0};
+        TemplateCompileProgress compile;       // templates done, and the cancel flag
+        std::atomic<bool> ready{false};        // paths or templates wait for adoptWarmup()
+        std::shared_ptr<const Snapshot> base;  // they are built for
+        std::mutex mutex;                      // guards base, paths and templates
+        std::shared_ptr<IdealPathGenerator> paths;
+        std::shared_ptr<const TemplateStore> templates;
+    } warmup;
+
+    ~Impl() {
+        stopWarmup();
+        waitForSwap();
+    }
+
+    void reportError(ErrorCode code, const std::string& msg) {
+        lastError = {code, msg};
+        if (errorCallback) {
+            errorCallback(lastError);
+        }
+    }
+
+    /** Keep stats as the last recognition's and pass them to the sink. */
+    void publishStats(const RecognitionStats& stats) {
+        lastTruncated = stats.budgetTruncated > 0;
+        if constexpr (kCollectStats) {
+            lastStats = stats;
+            if (statsCallback) {
+                statsCallback(lastStats);
+            }
+        }
+    }
+
+    /** Add the counters and times of one recognition to a running total. */
+    static void addStats(RecognitionStats& total, const RecognitionStats& s) {
+        total.gestures += s.gestures;
+        total.rawPoints += s.rawPoints;
+        total.estimatedLength = s.estimatedLength;
+        total.normalizeNs += s.normalizeNs;
+        total.filterNs += s.filterNs;
+        total.coarseNs += s.coarseNs;
+        total.templateNs += s.templateNs;
+        total.dtwNs += s.dtwNs;
+        total.rankNs += s.rankNs;
+        total.totalNs += s.totalNs;
+        total.bucketCandidates += s.bucketCandidates;
+        total.filteredCandidates += s.filteredCandidates;
+        total.lengthFilterFallbacks += s.lengthFilterFallbacks;
+        total.lexiconNodes += s.lexiconNodes;
+        total.lexiconWidened += s.lexiconWidened;
+        total.coarseScored += s.coarseScored;
+        total.coarseKept += s.coarseKept;
+        total.dtwCalls += s.dtwCalls;
+        total.boundPruned += s.boundPruned;
+        total.rejected += s.rejected;
+        total.shortlisted += s.shortlisted;
+        total.pathCacheHits += s.pathCacheHits;
+        total.pathsGenerated += s.pathsGenerated;
+        total.templateReads += s.templateReads;
+        total.resultCacheHits += s.resultCacheHits;
+        total.resultCacheSeeds += s.resultCacheSeeds;
+        total.streamSeeds += s.streamSeeds;
+        total.budgetTruncated += s.budgetTruncated;
+        total.budgetSkipped += s.budgetSkipped;
+    }
+
+    /**
+     * Estimate word length by counting distinct key transitions along the raw path.
+     *
+     * Walks the raw gesture points, snapping each to the nearest key center.
+     * When the nearest key changes, that counts as one key transition.
+     * The estimated word length is the number of distinct keys visited.
+     *
+     * This replaces the previous arc-length heuristic which overestimated
+     * zigzag words (e.g. "hello" estimated as 17+ chars instead of 5).
+     *
+     * @param trace  Receives the keys visited and their letters.
+     * @return trace.estimatedLength().
+     */
+    float estimateWordLengthByKeyTransitions(const RawGesturePath& rawPath,
+                                             KeyTrace& trace) const {
+        trace.clear();
+        if (rawPath.points.size() < 2) return 1.0f;
+
+        for (const auto& pt : rawPath.points) {
+            countKeyTransition(pt, trace);
+        }
+        return trace.estimatedLength();
+    }
+
+    /**
+     * One step of the key-transition count: snap pt and, if the key changed,
+     * append it and its letter to trace.
+     */
+    void countKeyTransition(const GesturePoint& pt, KeyTrace& trace) const {
+        int32_t key = current->layout.findNearestKey(pt.x, pt.y);
+        if (key >= 0 && (trace.keys.empty() || key != trace.keys.back())) {
+            trace.keys.push_back(key);
+            if (char c = keyLetter(key)) trace.letters |= 1u << (c - 'a');
+        }
+    }
+
+    /**
+     * Build the layout's lookup tables and, for every key, its own letter
+     * and the letters of the keys whose centers lie within
+     * LEXICON_KEY_RADIUS of its size.
+     */
+    static void indexLayout(Snapshot& snap) {
+        const KeyboardLayout& layout = snap.layout;
+        snap.layout.buildLookup();
+        snap.layoutHash = TemplateStore::layoutHash(layout);
+        snap.keyLetters.assign(layout.keys.size(), 0);
+        snap.keyNeighbors.assign(layout.keys.size(), 0);
+        for (size_t k = 0; k < layout.keys.size(); ++k) {
+            const KeyDescriptor& key = layout.keys[k];
+            for (size_t j = 0; j < layout.keys.size(); ++j) {
+                char c = keyLetter(layout, static_cast<int32_t>(j));
+                if (!c) continue;
+                if (j != k) {
+                    if (key.width <= 0.0f || key.height <= 0.0f) continue;
+                    float dx = (layout.keys[j].centerX - key.centerX) / key.width;
+                    float dy = (layout.keys[j].centerY - key.centerY) / key.height;
+                    if (dx * dx + dy * dy > LEXICON_KEY_RADIUS * LEXICON_KEY_RADIUS) continue;
+                }
+                snap.keyNeighbors[k] |= 1u << (c - 'a');
+                if (j == k) snap.keyLetters[k] = 1u << (c - 'a');
+            }
+        }
+    }
+
+    /** Lowercase ASCII letter of a key, or 0 if it has none. */
+    static char keyLetter(const KeyboardLayout& layout, int32_t keyIndex) {
+        if (keyIndex < 0 || keyIndex >= static_cast<int32_t>(layout.keys.size())) return 0;
+        int32_t cp = layout.keys[static_cast<size_t>(keyIndex)].codePoint;
+        if (cp >= 'a' && cp <= 'z') return static_cast<char>(cp);
+        if (cp >= 'A' && cp <= 'Z') return static_cast<char>(std::tolower(cp));
+        return 0;
+    }
+
+    char keyLetter(int32_t keyIndex) const { return keyLetter(current->layout, keyIndex); }
+
+    const DictionaryLoader& dictionary() const {
+        return current->sources[0].store->getDictionary();
+    }
+
+    BuildOptions buildOptions() const {
+        BuildOptions options;
+        options.templates = templatesRequested;
+        options.keepTemplates = templatesWarmed.load();
+        options.templateCacheDir = templateCacheDir;
+        options.precision = config.templatePrecision;
+        options.pathCacheBytes = config.pathCacheBytes;
+        options.resampleCount = scorer.getResampleCount();
+        return options;
+    }
+
+    /**
+     * Cache file for a layout, dictionary, precision and point count inside
+     * a template cache directory. Added dictionaries get "-d<index>" after
+     * the hash; counts other than RESAMPLE_COUNT get "-n<count>".
+     */
+    static std::string templateCachePath(const Snapshot& snap, size_t source,
+                                         const BuildOptions& options) {
+        const char* suffix = "";
+        if (options.precision == TemplatePrecision::UINT16) suffix = "-u16";
+        if (options.precision == TemplatePrecision::UINT8) suffix = "-u8";
+        char dict[24] = "";
+        if (source > 0) std::snprintf(dict, sizeof(dict), "-d%zu", source);
+        char points[16] = "";
+        if (snap.resampleCount != RESAMPLE_COUNT) {
+            std::snprintf(points, sizeof(points), "-n%d", snap.resampleCount);
+        }
+        char name[96];
+        std::snprintf(name, sizeof(name), "templates-%016llx%s%s%s.bin",
+                      static_cast<unsigned long long>(snap.layoutHash), dict, points, suffix);
+        std::string path = options.templateCacheDir;
+        if (!path.empty() && path.back() != '/') path.push_back('/');
+        return path + name;
+    }
+
+    /**
+     * Load the templates of snap's layout and one of its dictionaries from
+     * the cache directory, or compile (and persist) them, into a new store.
+     *
+     * @return The store, or null if it cannot be compiled.
+     */
+    static std::shared_ptr<const TemplateStore> buildTemplates(const Snapshot& snap, size_t source,
+                                                               const BuildOptions& options) {
+        auto built = std::make_shared<TemplateStore>();
+        const DictionaryLoader& dict = snap.sources[source].store->getDictionary();
+        const std::string path = options.templateCacheDir.empty()
+            ? std::string() : templateCachePath(snap, source, options);
+        if (path.empty() ||
+            !built->load(path, snap.layout, dict, options.precision, snap.resampleCount)) {
+            if (!built->compile(snap.layout, dict, options.precision, snap.resampleCount)) {
+                return nullptr;
+            }
+            if (!path.empty()) built->save(path);  // best effort
+        }
+        return built;
+    }
+
+    /**
+     * Give every dictionary of snap templates (or none, if they are not
+     * requested), reusing those of base that are still valid. With
+     * options.keepTemplates, valid ones of base are reused even if they
+     * are not requested, but none are built.
+     *
+     * @return false if the main dictionary's templates cannot be compiled.
+     */
+    static bool buildSourceTemplates(Snapshot& snap, const Snapshot* base,
+                                     const BuildOptions& options) {
+        const bool sameLayout = snap.sameGeometry(base);
+        for (size_t i = 0; i < snap.sources.size(); ++i) {
+            Snapshot::Source& source = snap.sources[i];
+            source.templates.reset();
+            if ((!options.templates && !options.keepTemplates) || !source.store) continue;
+            if (sameLayout) {
+                for (const Snapshot::Source& old : base->sources) {
+                    if (old.store == source.store && old.templates &&
+                        old.templates->getPrecision() == options.precision) {
+                        source.templates = old.templates;
+                        break;
+                    }
+                }
+            }
+            if (!source.templates && options.templates) {
+                source.templates = buildTemplates(snap, i, options);
+            }
+        }
+        return !options.templates || snap.sources[0].templates;
+    }
+
+    /** Orders entry indices of dict by frequency descending, ties by index. */
+    static auto byFrequency(const DictionaryLoader& dict) {
+        return [&dict](uint32_t a, uint32_t b) {
+            const uint32_t fa = dict.getEntry(a).frequency, fb = dict.getEntry(b).frequency;
+            return fa > fb || (fa == fb && a < b);
+        };
+    }
+
+    /**
+     * Fill a new path cache with the most frequent words, up to half its
+     * capacity so the words of the next gestures still find free slots.
+     */
+    static void warmPaths(IdealPathGenerator& paths, const DictionaryLoader& dict) {
+        const size_t count = dict.getEntryCount();
+        const size_t warm = std::min(count, paths.getCacheStats().capacity / 2);
+        if (warm == 0) return;
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; ++i) order[i] = i;
+        std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(warm),
+                          order.end(), byFrequency(dict));
+        for (size_t i = 0; i < warm; ++i) paths.getIdealPathRef(dict.getEntry(order[i]).word);
+    }
+
+    /**
+     * The perBucket most frequent words of every start/end bucket, at most
+     * limit of them, most frequent first. Unlike the global top words of
+     * warmPaths(), every bucket a gesture can start in gets some.
+     */
+    static std::vector<uint32_t> frequentWords(const DictionaryLoader& dict,
+                                               size_t perBucket, size_t limit) {
+        static constexpr char kBucketLetters[] = "abcdefghijklmnopqrstuvwxyz#";
+        static_assert(sizeof(kBucketLetters) - 1 == DICT_BUCKET_LETTERS, "one per letter class");
+        std::vector<uint32_t> words;
+        if (perBucket == 0 || limit == 0) return words;
+        const auto order = byFrequency(dict);
+        std::vector<uint32_t> bucket;
+        for (uint32_t first = 0; first < DICT_BUCKET_LETTERS; ++first) {
+            for (uint32_t last = 0; last < DICT_BUCKET_LETTERS; ++last) {
+                const DictionaryIndexSpan span =
+                    dict.getBucket(kBucketLetters[first], kBucketLetters[last]);
+                bucket.assign(span.begin(), span.end());
+                const size_t top = std::min(perBucket, bucket.size());
+                std::partial_sort(bucket.begin(), bucket.begin() + static_cast<std::ptrdiff_t>(top),
+                                  bucket.end(), order);
+                words.insert(words.end(), bucket.begin(),
+                             bucket.begin() + static_cast<std::ptrdiff_t>(top));
+            }
+        }
+        std::sort(words.begin(), words.end(), order);
+        if (words.size() > limit) words.resize(limit);
+        return words;
+    }
+
+    /**
+     * Build a snapshot for layout with store as its main dictionary, and
+     * the added dictionaries of base. Templates and the path cache of base
+     * are reused where they are still valid for the new layout and
+     * dictionaries; otherwise templates are rebuilt (if requested) and the
+     * path cache starts empty, or warm if warm is set.
+     */
+    static std::shared_ptr<const Snapshot> buildSnapshot(
+            const KeyboardLayout& layout, std::shared_ptr<const DictionaryStore> store,
+            const Snapshot* base, const BuildOptions& options, bool warm) {
+        auto snap = std::make_shared<Snapshot>();
+        if (base) snap->sources = base->sources;
+        if (snap->sources.empty()) snap->sources.emplace_back();
+        snap->sources[0].store = std::move(store);
+        snap->layout = layout;
+        snap->resampleCount = options.resampleCount;
+        indexLayout(*snap);
+        buildSourceTemplates(*snap, base, options);
+
+        if (snap->sameGeometry(base) && base->paths) {
+            // Paths depend only on the layout and point count, and are
+            // looked up by word
+            snap->paths = base->paths;
+        } else {
+            snap->paths = std::make_shared<IdealPathGenerator>();
+            snap->paths->setLayout(snap->layout);
+            snap->paths->setResampleCount(snap->resampleCount);
+            snap->paths->setCacheBudget(options.pathCacheBytes);
+            if (warm && !snap->sources[0].templates) {
+                warmPaths(*snap->paths, snap->sources[0].store->getDictionary());
+            }
+        }
+        return snap;
+    }
+
+    /** Publish snap and use it from now on (on the recognizing thread). */
+    void install(std::shared_ptr<const Snapshot> snap) {
+        std::atomic_store(&published, std::move(snap));
+        current = std::atomic_load(&published);
+    }
+
+    /** A copy of the current snapshot with other main dictionary templates. */
+    void installTemplates(std::shared_ptr<const TemplateStore> templates) {
+        auto snap = std::make_shared<Snapshot>(*current);
+        snap->sources[0].templates = std::move(templates);
+        install(std::move(snap));
+    }
+
+    /**
+     * Compile (or reload) the templates of every dictionary into a copy of
+     * the current snapshot and install it. Templates still valid for the
+     * configured precision are kept unless rebuild is set.
+     *
+     * @return false (and templates dropped) if the main dictionary's fail.
+     */
+    bool installAllTemplates(bool rebuild) {
+        BuildOptions options = buildOptions();
+        options.templates = true;
+        auto snap = std::make_shared<Snapshot>(*current);
+        const bool ok = buildSourceTemplates(*snap, rebuild ? nullptr : current.get(), options);
+        install(std::move(snap));
+        if (!ok) dropTemplates();
+        return ok;
+    }
+
+    /**
+     * Pick up the latest published snapshot at the start of a recognition.
+     * A streamed gesture keeps the snapshot it began with.
+     */
+    void acquire() {
+        if (stream.active) return;
+        const Snapshot* previous = current.get();
+        current = std::atomic_load(&published);
+        // A background swap may have published another layout or
+        // dictionary; the swap only cancelled the warm-up, which is
+        // stopped here, where it was started
+        if (current.get() != previous && warmup.thread.joinable()) {
+            std::shared_ptr<const Snapshot> base;
+            {
+                std::lock_guard<std::mutex> lock(warmup.mutex);
+                base = warmup.base;
+            }
+            if (!warmupFits(base.get())) stopWarmup();
+        }
+        if (warmup.ready.load(std::memory_order_acquire)) adoptWarmup();
+        // After a layout or resample count change, the user dictionary's
+        // templates are regenerated here: it may only change on the
+        // recognizing thread
+        if (userDictionary && current &&
+            (userDictionary->getLayoutHash() != current->layoutHash ||
+             userDictionary->getPointCount() != current->resampleCount)) {
+            userDictionary->setLayout(current->layout, current->resampleCount);
+        }
+    }
+
+    /** Queue a background swap, merged into one that has not started yet. */
+    void requestSwap(std::unique_ptr<SwapRequest> request) {
+        std::lock_guard<std::mutex> lock(swapMutex);
+        if (swapRunning) {
+            if (!queuedSwap) {
+                queuedSwap = std::move(request);
+                return;
+            }
+            SwapRequest& queued = *queuedSwap;
+            if (request->hasLayout) {
+                queued.hasLayout = true;
+                queued.layout = std::move(request->layout);
+            }
+            if (!request->dictPath.empty() || request->store) {
+                queued.dictPath = std::move(request->dictPath);
+                queued.store = std::move(request->store);
+            }
+            queued.options = std::move(request->options);
+            for (auto& done : request->done) queued.done.push_back(std::move(done));
+            return;
+        }
+        if (swapThread.joinable()) swapThread.join();  // finished
+        swapRunning = true;
+        swapThread = std::thread(&Impl::runSwaps, this, request.release());
+    }
+
+    /** Background thread: build and publish request, then any queued one. */
+    void runSwaps(SwapRequest* first) {
+        std::unique_ptr<SwapRequest> request(first);
+        while (request) {
+            ErrorInfo error;
+            std::shared_ptr<const Snapshot> base = std::atomic_load(&published);
+            std::shared_ptr<const DictionaryStore> store = request->store;
+            if (!request->dictPath.empty()) {
+                auto loaded = std::make_shared<DictionaryStore>();
+                if (loaded->load(request->dictPath)) {
+                    store = std::move(loaded);
+                } else {
+                    error = loaded->getLastError();
+                }
+            }
+            if (!store && base) store = base->sources[0].store;
+            if (error.code == ErrorCode::NONE && base && store) {
+                const KeyboardLayout& layout = request->hasLayout ? request->layout : base->layout;
+                std::atomic_store(&published,
+                                  buildSnapshot(layout, store, base.get(), request->options, true));
+            } else if (error.code == ErrorCode::NONE) {
+                error = {ErrorCode::ENGINE_NOT_INITIALIZED, "Engine not initialized"};
+            }
+            for (auto& done : request->done) {
+                if (done) done(error.code == ErrorCode::NONE, error);
+            }
+
+            std::lock_guard<std::mutex> lock(swapMutex);
+            request = std::move(queuedSwap);
+            if (!request) {
+                swapRunning = false;
+                swapDone.notify_all();
+            }
+        }
+    }
+
+    /**
+     * Start the configured warm-up for the current snapshot, after
+     * stopping one still running (on the recognizing thread).
+     */
+    void startWarmup() {
+        stopWarmup();
+        warmup.state = static_cast<int>(WarmupState::IDLE);
+        if (config.warmup == WarmupLevel::OFF || !current) return;
+        warmup.pathsDone = 0;
+        warmup.total = 0;
+        warmup.compile.compiled = 0;
+        warmup.compile.cancel = false;
+        {
+            std::lock_guard<std::mutex> lock(warmup.mutex);
+            warmup.base = current;
+        }
+        warmup.state = static_cast<int>(WarmupState::RUNNING);
+        warmup.thread = std::thread(&Impl::runWarmup, this, current, buildOptions(),
+                                    config.warmup,
+                                    static_cast<size_t>(std::max(0, config.warmupWordsPerBucket)));
+    }
+
+    /**
+     * Cancel the warm-up, wait for its thread and drop what it left (on
+     * the recognizing thread; other threads only set the cancel flag).
+     */
+    void stopWarmup() {
+        if (warmup.thread.joinable()) {
+            warmup.compile.cancel = true;
+            warmup.thread.join();
+        }
+        std::lock_guard<std::mutex> lock(warmup.mutex);
+        warmup.ready = false;
+        warmup.paths.reset();
+        warmup.templates.reset();
+        warmup.base.reset();
+    }
+
+    /**
+     * Warm-up thread: paths of the frequent words of every bucket, then
+     * (FULL) all templates. Touches only what it builds and warmup.
+     */
+    void runWarmup(std::shared_ptr<const Snapshot> base, BuildOptions options,
+                   WarmupLevel level, size_t perBucket) {
+        const DictionaryLoader& dict = base->sources[0].store->getDictionary();
+        auto paths = std::make_shared<IdealPathGenerator>();
+        paths->setLayout(base->layout);
+        paths->setResampleCount(base->resampleCount);
+        paths->setCacheBudget(options.pathCacheBytes);
+        const std::vector<uint32_t> words =
+            frequentWords(dict, perBucket, paths->getCacheStats().capacity / 2);
+        warmup.total = static_cast<uint32_t>(words.size()) +
+                       (level == WarmupLevel::FULL ? dict.getEntryCount() : 0);
+
+        bool cancelled = false;
+        size_t done = 0;
+        for (; done < words.size(); ++done) {
+            if (warmup.compile.cancel.load(std::memory_order_relaxed)) {
+                cancelled = true;
+                break;
+            }
+            paths->getIdealPathRef(dict.getEntry(words[done]).word);
+            warmup.pathsDone.store(static_cast<uint32_t>(done + 1), std::memory_order_relaxed);
+        }
+        if (done > 0) handOverWarmup(std::move(paths), nullptr);
+
+        if (!cancelled && level == WarmupLevel::FULL) {
+            // Fails only when cancelled: init checked layout and dictionary
+            auto templates = std::make_shared<TemplateStore>();
+            cancelled = !templates->compile(base->layout, dict, options.precision,
+                                            base->resampleCount, &warmup.compile);
+            if (!cancelled) handOverWarmup(nullptr, std::move(templates));
+        }
+        warmup.state = static_cast<int>(cancelled ? WarmupState::CANCELLED : WarmupState::DONE);
+    }
+
+    /** Leave warm-up results for the next recognition (warm-up thread). */
+    void handOverWarmup(std::shared_ptr<IdealPathGenerator> paths,
+                        std::shared_ptr<const TemplateStore> templates) {
+        std::lock_guard<std::mutex> lock(warmup.mutex);
+        if (paths) warmup.paths = std::move(paths);
+        if (templates) warmup.templates = std::move(templates);
+        warmup.ready.store(true, std::memory_order_release);
+    }
+
+    /**
+     * Take up the warm-up results if the current snapshot still has the
+     * layout, dictionary and point count they were built for (on the
+     * recognizing thread). The warmed paths are merged into the live path
+     * cache, which keeps the paths already looked up; templates are
+     * installed into a copy of the snapshot. Waits for the next
+     * recognition while a background swap may publish.
+     */
+    void adoptWarmup() {
+        std::unique_lock<std::mutex> swapLock(swapMutex, std::try_to_lock);
+        if (!swapLock.owns_lock() || swapRunning) return;
+        std::shared_ptr<const Snapshot> base;
+        std::shared_ptr<IdealPathGenerator> paths;
+        std::shared_ptr<const TemplateStore> templates;
+        {
+            std::lock_guard<std::mutex> lock(warmup.mutex);
+            warmup.ready = false;
+            base = warmup.base;
+            paths = std::move(warmup.paths);
+            templates = std::move(warmup.templates);
+        }
+        if (!warmupFits(base.get())) return;
+        if (templates && (current->sources[0].templates ||
+                          templates->getPrecision() != config.templatePrecision)) {
+            templates.reset();
+        }
+        // Only the recognizing thread looks paths up, and no swap runs
+        if (paths) current->paths->mergeCache(std::move(*paths));
+        if (!templates) return;
+        // Kept while the layout stays; unlike compileTemplates(), they do
+        // not make a synchronous layout change compile new ones
+        auto snap = std::make_shared<Snapshot>(*current);
+        snap->sources[0].templates = std::move(templates);
+        templatesWarmed = true;
+        install(std::move(snap));
+    }
+
+    /** The current snapshot has the dictionary and geometry of a warm-up's base. */
+    bool warmupFits(const Snapshot* base) const {
+        return current && base && current->sources[0].store == base->sources[0].store &&
+               current->sameGeometry(base);
+    }
+
+    /** Block until no background swap is queued or running. */
+    void waitForSwap() {
+        std::unique_lock<std::mutex> lock(swapMutex);
+        swapDone.wait(lock, [this] { return !swapRunning; });
+        if (swapThread.joinable()) swapThread.join();
+    }
+
+    /**
+     * Start (or resize) the scoring pool for config.scoringThreads. Runs at
+     * init and configure(), never per gesture.
+     */
+    void startPool() {
+        int threads = config.scoringThreads;
+        if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, MAX_SCORING_THREADS));
+        if (threads == 1) {
+            pool.reset();
+        } else if (!pool || pool->threadCount() != threads) {
+            pool = std::make_unique<WorkerPool>(threads);
+        }
+    }
+
+    /**
+     * Score candidates[begin, end) of one dictionary into list, at
+     * positions offset + pos among the candidates of every dictionary.
+     *
+     * A candidate is skipped once its lower bound, and abandoned once its DTW,
+     * exceeds the smaller of the list's own threshold and the shared one.
+     * Each worker publishes its threshold to shared when its list is full:
+     * that many exact distances are at or below it, so anything above it
+     * cannot reach the merged shortlist. Comparisons are strict, so a tie
+     * with the threshold is always scored and then ranked by position.
+     *
+     * With a budget, scoring stops at the first candidate after it is used
+     * up (once list holds budget->guaranteed entries), and the candidates
+     * left are counted in list.budgetSkipped.
+     *
+     * Safe to call from several workers at once when cachePaths is false.
+     * Stats counters and times go to list.
+     *
+     * @param cachePaths  Use the IdealPathGenerator cache (serial only).
+     * @param budget      Shared scoring budget, or nullptr for none.
+     * @param batchPaths  Paths generated for a batch, read instead of
+     *                    generating those of its dictionaries, or nullptr.
+     */
+    void scoreCandidates(const DTWQuery& query, uint32_t sourceIndex,
+                         DictionaryIndexSpan candidates, uint32_t offset,
+                         size_t begin, size_t end, Shortlist& list,
+                         std::atomic<float>& shared, bool cachePaths,
+                         ScoringBudget* budget = nullptr,
+                         const BatchPaths* batchPaths = nullptr) {
+        std::array<float, MAX_RESAMPLE_COUNT> tx, ty;
+        const Snapshot::Source& source = current->sources[sourceIndex];
+        const TemplateStore* compiled = source.templates.get();
+        // User dictionary templates of another layout or point count are
+        // not used (see acquire())
+        const UserDictionary* user = source.user &&
+            source.user->getLayoutHash() == current->layoutHash &&
+            source.user->getPointCount() == current->resampleCount ? source.user.get() : nullptr;
+        const bool precomputed = compiled || user;
+        const std::vector<uint32_t>* batchSlots =
+            !precomputed && batchPaths && !batchPaths->slotOf[sourceIndex].empty()
+                ? &batchPaths->slotOf[sourceIndex] : nullptr;
+        StageClock clock;
+        for (size_t pos = begin; pos < end; ++pos) {
+            const bool budgeted = budget && list.heap.size() >= budget->guaranteed;
+            if (budgeted && budget->exhausted(pos - begin)) {
+                list.budgetSkipped += static_cast<uint32_t>(end - pos);
+                break;
+            }
+            const uint32_t idx = candidates[pos];
+            const float* x = tx.data();
+            const float* y = ty.data();
+            const uint32_t slot = batchSlots ? (*batchSlots)[idx] : BatchPaths::NO_SLOT;
+            bool valid;
+            if (precomputed) {
+                // Float templates are read in place by entry index;
+                // quantized ones are decoded onto the stack
+                TemplateView ideal = compiled ? compiled->getTemplate(idx) : user->getTemplate(idx);
+                if (ideal.x) {
+                    valid = true;
+                    x = ideal.x;
+                    y = ideal.y;
+                } else {
+                    valid = ideal.decode(tx.data(), ty.data());
+                }
+                ++list.templateReads;
+            } else if (slot != BatchPaths::NO_SLOT) {
+                const size_t at = static_cast<size_t>(slot) * batchPaths->count;
+                valid = batchPaths->valid[slot] != 0;
+                x = batchPaths->xs.data() + at;
+                y = batchPaths->ys.data() + at;
+                ++list.templateReads;
+            } else {
+                std::string_view word = source.entry(idx).word;
+                if (cachePaths) {
+                    // Hits and misses are counted by the cache (see rank())
+                    valid = copyPoints(current->paths->getIdealPathRef(word), tx, ty);
+                } else {
+                    valid = copyPoints(current->paths->generatePath(word), tx, ty);
+                    ++list.pathsGenerated;
+                }
+            }
+            // A compiled template read is an index calculation (plus a
+            // short decode): not worth a clock read, so it is timed
+            // with the DTW
+            if (!precomputed && slot == BatchPaths::NO_SLOT) list.templateNs += clock.lap();
+            if (!valid) continue;
+
+            const float threshold = std::min(list.threshold(),
+                                             shared.load(std::memory_order_relaxed));
+            const bool pruned = threshold < FLT_MAX &&
+                                scorer.lowerBound(query, x, y, threshold) > threshold;
+            float dtw = FLT_MAX;
+            if (!pruned) {
+                if (budgeted && !budget->takeDtwCall()) {
+                    list.budgetSkipped += static_cast<uint32_t>(end - pos);
+                    break;
+                }
+                dtw = scorer.computeDTWDistance(query, x, y, threshold);
+                ++list.dtwCalls;
+            }
+            list.dtwNs += clock.lap();
+            if (pruned) {
+                ++list.boundPruned;
+                continue;
+            }
+            if (dtw > threshold) {
+                ++list.rejected;
+                continue;
+            }
+            list.offer({offset + static_cast<uint32_t>(pos), idx, dtw, sourceIndex});
+            if (list.full()) lowerTo(shared, list.threshold());
+        }
+    }
+
+    /** Copy a valid ideal path into coordinate arrays; false if it is empty. */
+    static bool copyPoints(const GesturePath& ideal,
+                           std::array<float, MAX_RESAMPLE_COUNT>& tx,
+                           std::array<float, MAX_RESAMPLE_COUNT>& ty) {
+        if (!ideal.isValid()) return false;
+        for (size_t i = 0; i < ideal.points.size(); ++i) {
+            tx[i] = ideal.points[i].x;
+            ty[i] = ideal.points[i].y;
+        }
+        return true;
+    }
+
+    /**
+     * Copy candidates into ordered by frequency descending, ties by entry
+     * index. A start+end bucket or a length slice of it (lengthRuns) is
+     * already one run in that order per word length, so its runs are
+     * merged instead of sorted.
+     */
+    static void orderByFrequency(const DictionaryLoader& dict, DictionaryIndexSpan candidates,
+                                 bool lengthRuns, std::vector<uint64_t>& keys,
+                                 std::vector<uint32_t>& ordered) {
+        // Ascending keys: inverted frequency above the entry index
+        keys.clear();
+        keys.reserve(candidates.size());
+        for (uint32_t idx : candidates) {
+            const uint32_t frequency = dict.getEntry(idx).frequency;
+            keys.push_back(static_cast<uint64_t>(UINT32_MAX - frequency) << 32 | idx);
+        }
+        if (lengthRuns) {
+            size_t merged = 0;
+            for (size_t i = 1; i <= keys.size(); ++i) {
+                if (i < keys.size() && keys[i - 1] <= keys[i]) continue;
+                if (merged > 0) {
+                    std::inplace_merge(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(merged),
+                                       keys.begin() + static_cast<std::ptrdiff_t>(i));
+                }
+                merged = i;
+            }
+        } else {
+            std::sort(keys.begin(), keys.end());
+        }
+        ordered.clear();
+        for (uint64_t key : keys) ordered.push_back(static_cast<uint32_t>(key));
+    }
+
+    /** Drop every cached ranking, counted as an invalidation if there were any. */
+    void invalidateResults() {
+        if (resultCache.used > 0) ++resultCache.stats.invalidations;
+        resultCache.used = 0;
+    }
+
+    /** Sum of the revisions of the user dictionaries among current's sources. */
+    uint64_t userRevision() const {
+        uint64_t revision = 0;
+        for (const Snapshot::Source& source : current->sources) {
+            if (source.user) revision += source.user->getRevision();
+        }
+        return revision;
+    }
+
+    /**
+     * Look a gesture up in the result cache, after dropping entries ranked
+     * on another snapshot or user dictionary revision. Leaves the gesture's
+     * quantized points in resultCache.codes for storeResult().
+     *
+     * @param near  Set to the entry closest to the gesture (largest
+     *              coordinate difference at most RESULT_CACHE_NEAR_TOLERANCE,
+     *              same start and end keys), or -1, when there is no hit.
+     * @return The entry with the gesture's key, or null.
+     */
+    const ResultCache::Entry* findResult(const GesturePath& normalizedPath, const KeyTrace& trace,
+                                         int maxCandidates, int& near) {
+        ResultCache& cache = resultCache;
+        near = -1;
+        const uint64_t revision = userRevision();
+        if (cache.snapshot.owner_before(current) || current.owner_before(cache.snapshot) ||
+            cache.userRevision != revision) {
+            invalidateResults();
+            cache.snapshot = current;
+            cache.userRevision = revision;
+        }
+
+        std::vector<uint16_t>& codes = cache.codes;
+        codes.clear();
+        for (const NormalizedPoint& p : normalizedPath.points) {
+            for (float v : {p.x, p.y}) {
+                const float step = std::round(v * static_cast<float>(RESULT_CACHE_QUANTUM));
+                codes.push_back(static_cast<uint16_t>(
+                    std::max(0.0f, std::min(static_cast<float>(RESULT_CACHE_QUANTUM), step))));
+            }
+        }
+        const int32_t arcLength = static_cast<int32_t>(std::lround(normalizedPath.totalArcLength));
+
+        int nearest = static_cast<int>(RESULT_CACHE_NEAR_TOLERANCE *
+                                       static_cast<float>(RESULT_CACHE_QUANTUM)) + 1;
+        for (size_t e = 0; e < cache.used; ++e) {
+            ResultCache::Entry& entry = cache.entries[e];
+            if (entry.startKey != normalizedPath.startKeyIndex ||
+                entry.endKey != normalizedPath.endKeyIndex || entry.codes.size() != codes.size()) {
+                continue;
+            }
+            if (entry.codes == codes && entry.arcLength == arcLength && entry.keys == trace.keys &&
+                entry.maxCandidates == maxCandidates) {
+                entry.lastUsed = ++cache.tick;
+                ++cache.stats.hits;
+                return &entry;
+            }
+            int diff = 0;
+            for (size_t i = 0; i < codes.size() && diff < nearest; ++i) {
+                diff = std::max(diff, std::abs(static_cast<int>(entry.codes[i]) -
+                                               static_cast<int>(codes[i])));
+            }
+            if (diff < nearest) {
+                nearest = diff;
+                near = static_cast<int>(e);
+            }
+        }
+        ++(near >= 0 ? cache.stats.nearHits : cache.stats.misses);
+        return nullptr;
+    }
+
+    /** Keep the ranking of the gesture findResult() just missed. */
+    void storeResult(const GesturePath& normalizedPath, const KeyTrace& trace, int maxCandidates,
+                     const std::vector<GestureCandidate>& results,
+                     const std::vector<ScoredEntry>& shortlist) {
+        ResultCache& cache = resultCache;
+        const size_t capacity = static_cast<size_t>(
+            std::max(0, std::min(config.resultCacheSize, MAX_RESULT_CACHE_SIZE)));
+        if (capacity == 0) return;
+        ResultCache::Entry* entry;
+        if (cache.used < capacity) {
+            if (cache.used == cache.entries.size()) {
+                cache.entries.reserve(capacity);
+                cache.entries.emplace_back();
+            }
+            entry = &cache.entries[cache.used++];
+        } else {
+            const auto used = cache.entries.begin() + static_cast<std::ptrdiff_t>(cache.used);
+            entry = &*std::min_element(cache.entries.begin(), used,
+                [](const ResultCache::Entry& a, const ResultCache::Entry& b) {
+                    return a.lastUsed < b.lastUsed;
+                });
+        }
+        // Assignment keeps the buffers of the entry replaced
+        entry->codes = cache.codes;
+        entry->keys = trace.keys;
+        entry->arcLength = static_cast<int32_t>(std::lround(normalizedPath.totalArcLength));
+        entry->startKey = normalizedPath.startKeyIndex;
+        entry->endKey = normalizedPath.endKeyIndex;
+        entry->maxCandidates = maxCandidates;
+        entry->results = results;
+        entry->shortlist = shortlist;
+        entry->lastUsed = ++cache.tick;
+    }
+
+    /**
+     * DTW threshold from the shortlist of a similar gesture (a near cached
+     * one, or the streamed gesture's own in-flight ranking): its words that
+     * are candidates of this gesture too (work.sources, from Step 3) are
+     * scored against it, and if they fill a shortlist, the distance that
+     * shortlist ends with is returned, else FLT_MAX. The final shortlist
+     * can only be better, so scoring under this threshold from the start
+     * keeps exactly the same words while pruning far more of the others.
+     * Their scoring is added to work.stats, and their DTW calls are taken
+     * from budget; if it has fewer left than the shortlist's words, no
+     * threshold is seeded.
+     */
+    float seedThreshold(const DTWQuery& query, const std::vector<ScoredEntry>& shortlist,
+                        size_t shortlistSize, Scratch& work, bool cachePaths,
+                        ScoringBudget* budget) {
+        const auto reserved = static_cast<int64_t>(shortlist.size());
+        if (budget && !budget->reserveDtwCalls(reserved)) return FLT_MAX;
+        Shortlist& seeds = work.seeds;
+        seeds.reset(shortlistSize);
+        std::atomic<float> unbounded{FLT_MAX};
+        PathCacheStats cacheBefore;
+        if constexpr (kCollectStats) {
+            if (cachePaths) cacheBefore = current->paths->getCacheStats();
+        }
+        for (size_t s = 0; s < current->sources.size(); ++s) {
+            std::vector<uint32_t>& targets = work.seedTargets;
+            targets.clear();
+            for (const ScoredEntry& e : shortlist) {
+                if (e.source == s) targets.push_back(e.entryIndex);
+            }
+            if (targets.empty()) continue;
+            std::sort(targets.begin(), targets.end());
+            std::vector<uint32_t>& found = work.seedFound;
+            found.clear();
+            for (uint32_t idx : work.sources[s].candidates) {
+                if (std::binary_search(targets.begin(), targets.end(), idx)) found.push_back(idx);
+            }
+            DictionaryIndexSpan span;
+            span.data = found.data();
+            span.count = found.size();
+            scoreCandidates(query, static_cast<uint32_t>(s), span, 0, 0, span.size(), seeds,
+                            unbounded, cachePaths);
+        }
+        RecognitionStats& stats = work.stats;
+        if constexpr (kCollectStats) {
+            if (cachePaths) {
+                const PathCacheStats cacheAfter = current->paths->getCacheStats();
+                stats.pathCacheHits += static_cast<uint32_t>(cacheAfter.hits - cacheBefore.hits);
+                stats.pathsGenerated += static_cast<uint32_t>(cacheAfter.misses - cacheBefore.misses);
+            }
+        }
+        stats.templateNs += seeds.templateNs;
+        stats.dtwNs += seeds.dtwNs;
+        stats.dtwCalls += seeds.dtwCalls;
+        stats.pathsGenerated += seeds.pathsGenerated;
+        stats.templateReads += seeds.templateReads;
+        if (budget) budget->returnDtwCalls(reserved - static_cast<int64_t>(seeds.dtwCalls));
+        return seeds.threshold();
+    }
+
+    /**
+     * Steps 2-3 of rank(): find every dictionary's candidates for a
+     * normalized gesture, into work.sources. Counters go to stats, and the
+     * filter and coarse pre-filter times are laps of clock.
+     *
+     * @param chunkCount  Set to the number of SCORING_CHUNK_SIZE chunks the
+     *                    candidates make, dictionary by dictionary.
+     * @return Number of candidates over every dictionary.
+     */
+    size_t filterCandidates(const GesturePath& normalizedPath, const KeyTrace& trace,
+                            size_t shortlistSize, bool budgeted, Scratch& work,
+                            RecognitionStats& stats, StageClock& clock, size_t& chunkCount) {
+        const Snapshot& snap = *current;
+        const float estimatedLen = trace.estimatedLength();
+
+        // Step 2: Determine start/end key characters
+        char startChar = 0, endChar = 0;
+        bool hasStartEnd = false;
+
+        if (normalizedPath.startKeyIndex >= 0 &&
+            normalizedPath.startKeyIndex < static_cast<int>(snap.layout.keys.size()) &&
+            normalizedPath.endKeyIndex >= 0 &&
+            normalizedPath.endKeyIndex < static_cast<int>(snap.layout.keys.size())) {
+
+            startChar = keyLetter(normalizedPath.startKeyIndex);
+            endChar = keyLetter(normalizedPath.endKeyIndex);
+            hasStartEnd = (startChar != 0 && endChar != 0);
+        }
+
+
+        // Step 3: Candidate Filtering, for each dictionary. The lexicon trie
+        // is walked along the keys the raw path crossed and yields the words
+        // the gesture could have traced. If none can, the walk is repeated
+        // with every key widened to its neighbours (a start or corner just
+        // off the key). If that finds nothing too, or the trace cannot be
+        // walked, the dictionary bucket index is used: a start+end bucket is
+        // sorted by word length, so the length filter is a slice of it; the
+        // wider tiers are filtered entry by entry. The user dictionary has
+        // neither a trie nor length-sorted buckets: its start+end or start
+        // bucket is filtered entry by entry, and no start letter is needed
+        // to widen to all of its words. With a scoring budget, the
+        // candidates of a dictionary (not the user's, which is scored whole)
+        // are put in frequency order before the pre-filter, which keeps it.
+        const size_t sourceCount = snap.sources.size();
+        if (work.sources.size() < sourceCount) work.sources.resize(sourceCount);
+        const size_t chunk = static_cast<size_t>(SCORING_CHUNK_SIZE);
+        size_t candidateCount = 0;
+        chunkCount = 0;
+        for (size_t s = 0; s < sourceCount; ++s) {
+            const Snapshot::Source& source = snap.sources[s];
+            SourceScratch& src = work.sources[s];
+            DictionaryIndexSpan bucket;
+            bool walked = false;
+            bool lengthSorted = false;
+            if (source.user) {
+                if (hasStartEnd) bucket = source.user->getBucket(startChar, endChar);
+                if (bucket.empty() && startChar != 0) {
+                    bucket = source.user->getStartBucket(startChar);
+                }
+                if (bucket.empty() && startChar == 0) bucket = source.user->getEntries();
+            } else if (config.lexiconCandidates && trace.letters != 0) {
+                std::vector<uint32_t>& nearLetters = work.nearLetters;
+                for (const std::vector<uint32_t>* letters : {&snap.keyLetters, &snap.keyNeighbors}) {
+                    if (letters == &snap.keyNeighbors) {
+                        if (!walked || !src.lexicon.empty()) break;
+                        ++stats.lexiconWidened;
+                    }
+                    nearLetters.clear();
+                    for (int32_t key : trace.keys) {
+                        nearLetters.push_back((*letters)[static_cast<size_t>(key)]);
+                    }
+                    uint32_t visited = 0;
+                    walked = source.store->getLexicon().collect(nearLetters.data(),
+                                                                nearLetters.size(),
+                                                                src.lexicon, &visited);
+                    stats.lexiconNodes += visited;
+                }
+                bucket.data = src.lexicon.data();
+                bucket.count = src.lexicon.size();
+            }
+            if (!source.user) {
+                const DictionaryLoader& dict = source.store->getDictionary();
+                if (bucket.empty() && hasStartEnd) {
+                    bucket = dict.getBucket(startChar, endChar);
+                    lengthSorted = !bucket.empty();
+                }
+                if (bucket.empty() && startChar != 0) {
+                    bucket = dict.getStartBucket(startChar);
+                }
+                if (bucket.empty() && !walked) {
+                    // Last resort when the gesture gave no key path to walk
+                    bucket = dict.getIndexedEntries();
+                }
+            }
+
+            // Apply word-length filter (key-transition count, not arc length)
+            float tol = config.lengthFilterTolerance;
+
+            DictionaryIndexSpan candidates;
+            std::vector<uint32_t>& filtered = src.filtered;
+            filtered.clear();
+            if (lengthSorted) {
+                float minLen = std::max(0.0f, std::ceil(estimatedLen - tol));
+                float maxLen = std::floor(estimatedLen + tol);
+                if (maxLen >= minLen) {
+                    candidates = source.store->getDictionary().getBucket(startChar, endChar,
+                                                static_cast<uint32_t>(minLen),
+                                                static_cast<uint32_t>(maxLen));
+                }
+            } else {
+                filtered.reserve(bucket.size());
+                for (uint32_t idx : bucket) {
+                    float wordLen = static_cast<float>(source.entry(idx).word.size());
+                    if (std::abs(wordLen - estimatedLen) <= tol) {
+                        filtered.push_back(idx);
+                    }
+                }
+                candidates.data = filtered.data();
+                candidates.count = filtered.size();
+            }
+            stats.bucketCandidates += static_cast<uint32_t>(bucket.size());
+            stats.filteredCandidates += static_cast<uint32_t>(candidates.size());
+
+            // If filter removed everything, fall back to unfiltered
+            if (candidates.empty()) {
+                ++stats.lengthFilterFallbacks;
+                candidates = bucket;
+            }
+            if (budgeted && !source.user && candidates.size() > 1) {
+                orderByFrequency(source.store->getDictionary(), candidates, lengthSorted,
+                                 work.frequencyKeys, src.byFrequency);
+                candidates.data = src.byFrequency.data();
+                candidates.count = src.byFrequency.size();
+            }
+            stats.filterNs += clock.lap();
+
+            // Stage one of scoring: with compiled templates, a large
+            // candidate set is first ranked by signature (8 points, arc
+            // length, letters; no warping) and only the best
+            // coarseCandidates go on to DTW, in their original order so ties
+            // still rank by position.
+            const size_t coarseKeep = std::max(
+                shortlistSize, static_cast<size_t>(std::max(0, config.coarseCandidates)));
+            if (config.coarseCandidates > 0 && source.templates &&
+                candidates.size() > coarseKeep) {
+                PathSignature signature;
+                scorer.prepareSignature(normalizedPath, trace.letters, signature);
+                std::vector<ScoredEntry>& coarse = work.coarse;
+                coarse.clear();
+                coarse.reserve(candidates.size());
+                for (size_t pos = 0; pos < candidates.size(); ++pos) {
+                    const uint32_t idx = candidates[pos];
+                    const PathSignature* candidate = source.templates->getSignature(idx);
+                    if (!candidate) continue;
+                    coarse.push_back({static_cast<uint32_t>(pos), idx,
+                                      scorer.coarseDistance(signature, *candidate)});
+                }
+                stats.coarseScored += static_cast<uint32_t>(coarse.size());
+                if (coarse.size() > coarseKeep) {
+                    std::nth_element(coarse.begin(),
+                                     coarse.begin() + static_cast<std::ptrdiff_t>(coarseKeep),
+                                     coarse.end(), rankedBefore);
+                    coarse.resize(coarseKeep);
+                }
+                std::sort(coarse.begin(), coarse.end(),
+                    [](const ScoredEntry& a, const ScoredEntry& b) { return a.position < b.position; });
+                std::vector<uint32_t>& kept = src.coarseKept;
+                kept.clear();
+                for (const ScoredEntry& e : coarse) kept.push_back(e.entryIndex);
+                candidates.data = kept.data();
+                candidates.count = kept.size();
+                stats.coarseKept += static_cast<uint32_t>(kept.size());
+                stats.coarseNs += clock.lap();
+            }
+
+            src.candidates = candidates;
+            src.offset = static_cast<uint32_t>(candidateCount);
+            src.firstChunk = chunkCount;
+            candidateCount += candidates.size();
+            chunkCount += (candidates.size() + chunk - 1) / chunk;
+        }
+        return candidateCount;
+    }
+
+    /**
+     * Steps 2-7 of recognition for a normalized gesture: candidate
+     * filtering, scoring and ranking. Shared by recognize(), the streaming
+     * API and recognizeBatch(). A scoring budget in config is counted from
+     * the start of this call.
+     *
+     * @param trace       Keys the raw gesture crossed. Must not be work.trace
+     *                    unless the caller filled it for this gesture.
+     * @param work        Buffers for this call; one per concurrent caller.
+     *                    The call's stats are added to work.stats.
+     * @param usePool     Split the candidates across the pool (if any).
+     * @param cachePaths  Read lazily generated paths through the cache.
+     *                    Only one thread at a time may pass true.
+     * @param useResults  Answer from, seed from and fill the result cache.
+     *                    Only the recognizing thread may pass true.
+     * @param seeds       Shortlist of an in-flight ranking of the same
+     *                    (streamed) gesture to seed Step 4 from, or nullptr.
+     */
+    std::vector<GestureCandidate> rank(const GesturePath& normalizedPath, const KeyTrace& trace,
+                                       int maxCandidates, size_t rawPointCount,
+                                       Scratch& work, bool usePool, bool cachePaths,
+                                       bool useResults,
+                                       const std::vector<ScoredEntry>* seeds = nullptr) {
+        std::vector<GestureCandidate> results;
+        const float estimatedLen = trace.estimatedLength();
+        StageClock clock;
+        RecognitionStats& stats = work.stats;
+        stats.gestures += 1;
+        stats.rawPoints += static_cast<uint32_t>(rawPointCount);
+        stats.estimatedLength = estimatedLen;
+
+        // With a scoring budget, every dictionary's candidates are scored in
+        // frequency order, so the words most likely typed come first
+        ScoringBudget budget;
+        const bool budgeted = config.scoringBudgetUs > 0 || config.scoringBudgetDtwCalls > 0;
+        if (config.scoringBudgetUs > 0) {
+            budget.timed = true;
+            budget.deadline = std::chrono::steady_clock::now() +
+                              std::chrono::microseconds(config.scoringBudgetUs);
+        }
+        if (config.scoringBudgetDtwCalls > 0) budget.dtwLeft.store(config.scoringBudgetDtwCalls);
+        budget.guaranteed = static_cast<size_t>(maxCandidates);
 
-struct GestureEngine::Impl {
-    PathProcessor pathProcessor;
-    IdealPathGenerator idealPathGen;
-    Scorer scorer;
-    DictionaryLoader dictLoader;
-    KeyboardLayout layout;
-    ScoringConfig config;
-    ErrorCallback errorCallback;
-    ErrorInfo lastError;
-    bool initialized = false;
+        // Step 1b: A gesture with the key of a cached one gets its ranking
+        // back. Otherwise the closest near one, if any, seeds Step 4.
+        useResults = useResults && config.resultCacheSize > 0;
+        int near = -1;
+        if (useResults) {
+            if (const ResultCache::Entry* hit = findResult(normalizedPath, trace, maxCandidates, near)) {
+                ++stats.resultCacheHits;
+                results = hit->results;
+                stats.rankNs += clock.lap();
+                return results;
+            }
+        }
 
-    void reportError(ErrorCode code, const std::string& msg) {
-        lastError = {code, msg};
-        if (errorCallback) {
-            errorCallback(lastError);
+        const Snapshot& snap = *current;
+        const size_t shortlistSize = static_cast<size_t>(
+            std::max(maxCandidates, config.maxCandidatesEvaluated));
+        const size_t sourceCount = snap.sources.size();
+        const size_t chunk = static_cast<size_t>(SCORING_CHUNK_SIZE);
+        size_t chunkCount = 0;
+        const size_t candidateCount = filterCandidates(normalizedPath, trace, shortlistSize,
+                                                       budgeted, work, stats, clock, chunkCount);
+
+        // Step 4: Scoring.
+        // Only the shortlist of lowest DTW distances reaches ranking: the first
+        // max(maxCandidates, maxCandidatesEvaluated) candidates in rankedBefore
+        // order, over the candidates of every dictionary one after another.
+        // Lower bounds and early-abandoning DTW prune the rest (see
+        // scoreCandidates). With a pool, chunks of candidates (of any
+        // dictionary) are scored into per-worker shortlists and merged; the
+        // merged set is the same one the serial loop keeps, whichever worker
+        // scored what. A scoring budget stops every worker once it is used
+        // up; the candidates left (later in frequency order) are not scored.
+        // The threshold starts from a near cached gesture's shortlist or,
+        // failing that, from the in-flight ranking of a streamed gesture.
+        DTWQuery query;
+        if (!scorer.prepareQuery(normalizedPath, query)) return results;
+
+        std::atomic<float> sharedThreshold{FLT_MAX};
+        const bool seedable =
+            candidateCount >= shortlistSize * static_cast<size_t>(RESULT_CACHE_SEED_FACTOR);
+        float seeded = FLT_MAX;
+        if (seedable && near >= 0) {
+            seeded = seedThreshold(query, resultCache.entries[static_cast<size_t>(near)].shortlist,
+                                   shortlistSize, work, cachePaths, budgeted ? &budget : nullptr);
+            if (seeded < FLT_MAX) ++stats.resultCacheSeeds;
+        }
+        if (seedable && seeded == FLT_MAX && seeds && !seeds->empty()) {
+            seeded = seedThreshold(query, *seeds, shortlistSize, work, cachePaths,
+                                   budgeted ? &budget : nullptr);
+            if (seeded < FLT_MAX) ++stats.streamSeeds;
+        }
+        if (seeded < FLT_MAX) sharedThreshold.store(seeded, std::memory_order_relaxed);
+        std::vector<ScoredEntry>& scored = work.scored;
+        scored.clear();
+
+        const bool parallel = usePool && pool && chunkCount > 1;
+        const size_t workers = parallel ? static_cast<size_t>(pool->threadCount()) : 1;
+        std::vector<Shortlist>& lists = work.lists;
+        if (lists.size() < workers) lists.resize(workers);
+        for (size_t w = 0; w < workers; ++w) lists[w].reset(shortlistSize);
+
+        if (parallel) {
+            // Everything the chunks need behind one pointer, so the task fits
+            // std::function's inline storage and run() does not allocate.
+            struct ChunkTask {
+                Impl* self;
+                const DTWQuery* query;
+                const SourceScratch* sources;
+                size_t sourceCount;
+                std::vector<Shortlist>* lists;
+                std::atomic<float>* shared;
+                ScoringBudget* budget;
+                size_t chunk;
+            } task{this, &query, work.sources.data(), sourceCount, &lists, &sharedThreshold,
+                   budgeted ? &budget : nullptr, chunk};
+
+            pool->run(chunkCount, [&task](int worker, size_t c) {
+                size_t s = 0;
+                while (s + 1 < task.sourceCount && task.sources[s + 1].firstChunk <= c) ++s;
+                const SourceScratch& src = task.sources[s];
+                const size_t begin = (c - src.firstChunk) * task.chunk;
+                const size_t end = std::min(src.candidates.size(), begin + task.chunk);
+                task.self->scoreCandidates(*task.query, static_cast<uint32_t>(s), src.candidates,
+                                           src.offset, begin, end,
+                                           (*task.lists)[static_cast<size_t>(worker)],
+                                           *task.shared, false,
+                                           task.self->current->sources[s].user ? nullptr
+                                                                               : task.budget);
+            });
+        } else {
+            PathCacheStats cacheBefore;
+            if constexpr (kCollectStats) {
+                if (cachePaths) cacheBefore = snap.paths->getCacheStats();
+            }
+            for (size_t s = 0; s < sourceCount; ++s) {
+                const SourceScratch& src = work.sources[s];
+                scoreCandidates(query, static_cast<uint32_t>(s), src.candidates, src.offset,
+                                0, src.candidates.size(), lists[0], sharedThreshold, cachePaths,
+                                budgeted && !snap.sources[s].user ? &budget : nullptr,
+                                work.batchPaths);
+            }
+            if constexpr (kCollectStats) {
+                if (cachePaths) {
+                    const PathCacheStats cacheAfter = snap.paths->getCacheStats();
+                    lists[0].pathCacheHits += static_cast<uint32_t>(cacheAfter.hits - cacheBefore.hits);
+                    lists[0].pathsGenerated += static_cast<uint32_t>(cacheAfter.misses - cacheBefore.misses);
+                }
+            }
+        }
+        clock.lap();  // scoring is accounted per worker, as template and DTW time
+        uint32_t budgetSkipped = 0;
+        for (size_t w = 0; w < workers; ++w) {
+            const Shortlist& list = lists[w];
+            scored.insert(scored.end(), list.heap.begin(), list.heap.end());
+            stats.boundPruned += static_cast<uint32_t>(list.boundPruned);
+            stats.rejected += static_cast<uint32_t>(list.rejected);
+            stats.templateNs += list.templateNs;
+            stats.dtwNs += list.dtwNs;
+            stats.dtwCalls += list.dtwCalls;
+            stats.pathCacheHits += list.pathCacheHits;
+            stats.pathsGenerated += list.pathsGenerated;
+            stats.templateReads += list.templateReads;
+            budgetSkipped += list.budgetSkipped;
+        }
+        stats.budgetSkipped += budgetSkipped;
+        if (budgetSkipped > 0) ++stats.budgetTruncated;
+        if (parallel) {
+            std::sort(scored.begin(), scored.end(), rankedBefore);
+            if (scored.size() > shortlistSize) scored.resize(shortlistSize);
+        }
+        stats.shortlisted += static_cast<uint32_t>(scored.size());
+
+        if (scored.empty()) {
+            stats.rankNs += clock.lap();
+            return results;
+        }
+
+        // Rank the shortlist in candidate order, as if it were the whole set
+        std::sort(scored.begin(), scored.end(),
+            [](const ScoredEntry& a, const ScoredEntry& b) { return a.position < b.position; });
+
+        // Step 5: Max DTW normalization.
+        // For RANKING multiple candidates: use the actual max candidate DTW so
+        // shape differences are properly reflected. A small safety floor prevents
+        // division by zero but never compresses real differences.
+        // For SINGLE candidate confidence: use the larger maxDTWFloor so the
+        // candidate gets a meaningful absolute confidence value.
+        float rawMaxDTW = 0.0f;
+        float minCandDTW = FLT_MAX;
+        for (const auto& s : scored) {
+            if (s.dtwDistance < FLT_MAX) {
+                if (s.dtwDistance > rawMaxDTW) rawMaxDTW = s.dtwDistance;
+                if (s.dtwDistance < minCandDTW) minCandDTW = s.dtwDistance;
+            }
+        }
+        float maxDTW;
+        if (scored.size() <= 1) {
+            maxDTW = std::max(rawMaxDTW, config.maxDTWFloor);
+        } else {
+            maxDTW = std::max(rawMaxDTW, 0.01f);
+        }
+
+        // Step 5b: Adaptive frequency weight.
+        // Uses the RAW DTW range (before any floor) to detect when candidates
+        // have similar shape scores. When the spread is small, frequency weight
+        // is scaled down proportionally so shape dominates the ranking.
+        float rawRange = (minCandDTW < FLT_MAX) ? (rawMaxDTW - minCandDTW) : 0.0f;
+        float effectiveAlpha = config.frequencyWeight;
+        if (scored.size() > 1 && rawRange < 0.5f) {
+            effectiveAlpha *= std::max(0.1f, rawRange / 0.5f);
+        }
+
+        // Step 6: Compute confidence scores (inlined with adaptive alpha).
+        // Frequencies are relative to the maximum of each word's own
+        // dictionary (the main one for the user dictionary), times that
+        // dictionary's weight. Only scores are computed here; words are
+        // copied for the winners alone (Step 7).
+        std::vector<RankedEntry>& ranked = work.ranked;
+        ranked.clear();
+        for (size_t i = 0; i < scored.size(); ++i) {
+            const ScoredEntry& s = scored[i];
+            const Snapshot::Source& source = snap.sources[s.source];
+            const DictionaryStore& scale = source.user ? *snap.sources[0].store : *source.store;
+            const uint32_t maxFreq = scale.getDictionary().getMaxFrequency();
+            DictionaryEntry entry = source.entry(s.entryIndex);
+            float normalizedDTW = 1.0f;
+            if (maxDTW > 0.0f && s.dtwDistance < FLT_MAX) {
+                normalizedDTW = std::min(1.0f, s.dtwDistance / maxDTW);
+            }
+
+            float normalizedFreq = 0.0f;
+            if (maxFreq > 0) {
+                normalizedFreq = std::min(1.0f, source.weight *
+                    static_cast<float>(entry.frequency) / static_cast<float>(maxFreq));
+            }
+
+            float finalScore = (1.0f - effectiveAlpha) * normalizedDTW
+                             + effectiveAlpha * (1.0f - normalizedFreq);
+            float confidence = 1.0f - std::max(0.0f, std::min(1.0f, finalScore));
+            ranked.push_back({confidence, normalizedFreq, static_cast<uint32_t>(i), entry.word});
+        }
+
+        // Step 7: Select the top maxCandidates by confidence (ties by
+        // candidate position) and build only those. With one dictionary
+        // nth_element picks them; with several, a word found in more than
+        // one is listed once, at its best confidence, with all their flags,
+        // so the (short) list is sorted whole and walked until enough words
+        // are found, OR-ing later duplicates of the winners into them.
+        const size_t keep = std::min(ranked.size(),
+                                     static_cast<size_t>(std::max(0, maxCandidates)));
+        auto winners = ranked.begin();
+        if (sourceCount == 1) {
+            if (keep < ranked.size()) {
+                std::nth_element(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(keep),
+                                 ranked.end(), byConfidence);
+            }
+            std::sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(keep),
+                      byConfidence);
+            winners += static_cast<std::ptrdiff_t>(keep);
+        } else {
+            std::sort(ranked.begin(), ranked.end(), byConfidence);
+            for (auto it = ranked.begin(); it != ranked.end(); ++it) {
+                auto same = ranked.begin();
+                while (same != winners && same->word != it->word) ++same;
+                if (same != winners) {
+                    same->sourceFlags |= snap.sources[scored[it->scored].source].sourceFlags;
+                } else if (static_cast<size_t>(winners - ranked.begin()) < keep) {
+                    *winners++ = *it;
+                }
+            }
+        }
+
+        results.reserve(static_cast<size_t>(winners - ranked.begin()));
+        for (auto it = ranked.begin(); it != winners; ++it) {
+            const ScoredEntry& s = scored[it->scored];
+            GestureCandidate candidate;
+            candidate.word = std::string(it->word);
+            candidate.confidence = it->confidence;
+            candidate.sourceFlags = snap.sources[s.source].sourceFlags | it->sourceFlags;
+            candidate.dtwScore = s.dtwDistance;
+            candidate.frequencyScore = it->frequency;
+            results.push_back(std::move(candidate));
+        }
+        // A truncated ranking is not what the gesture scores in full
+        if (useResults && budgetSkipped == 0) {
+            storeResult(normalizedPath, trace, maxCandidates, results, scored);
         }
+
+        stats.rankNs += clock.lap();
+        return results;
+    }
+
+    void resetStream() {
+        stream.active = false;
+        stream.path.clear();
+        stream.trace.clear();
+        stream.startChar = 0;
+        stream.prefetched = 0;
+        stream.nextPreviewAt = 0;
+        stream.keyEnteredAt = 0;
+        stream.seedKey = -1;
+        stream.seeds.clear();
     }
 
     /**
-     * Estimate word length by counting distinct key transitions along the raw path.
-     *
-     * Walks the raw gesture points, snapping each to the nearest key center.
-     * When the nearest key changes, that counts as one key transition.
-     * The estimated word length is the number of distinct keys visited.
+     * Generate the ideal paths of the next few start-bucket words, so the
+     * final scoring finds them cached. Only the serial, lazily generated
+     * path reads that cache: compiled templates are read in place, and pool
+     * workers generate paths without it. The length estimate only grows
+     * while drawing, so words already too short for the final length
+     * filter are skipped.
+     */
+    void prefetchPaths() {
+        if (current->sources[0].templates || pool || stream.startChar == 0) return;
+
+        const DictionaryLoader& dict = dictionary();
+        DictionaryIndexSpan bucket = dict.getStartBucket(stream.startChar);
+        const float minLen = static_cast<float>(stream.trace.keys.size()) -
+                             config.lengthFilterTolerance;
+        int budget = STREAM_PREFETCH_BATCH;
+        while (budget > 0 && stream.prefetched < bucket.size()) {
+            DictionaryEntry entry = dict.getEntry(bucket[stream.prefetched++]);
+            if (static_cast<float>(entry.word.size()) < minLen) continue;
+            current->paths->getIdealPathRef(entry.word);
+            --budget;
+        }
+    }
+
+    /**
+     * Recognize the streamed points so far, with stats in scratch.stats.
+     * Previews pass useResults false: partial gestures would only crowd
+     * finished ones out of the result cache.
+     */
+    std::vector<GestureCandidate> rankStream(int maxCandidates, bool useResults,
+                                             const std::vector<ScoredEntry>* seeds = nullptr) {
+        StageClock total;
+        StageClock clock;
+        scratch.stats = RecognitionStats();
+        pathProcessor.normalize(stream.path, current->layout, scratch.normalized);
+        if (!scratch.normalized.isValid()) return {};
+        scratch.stats.normalizeNs = clock.lap();
+        maxCandidates = std::max(1, std::min(maxCandidates, MAX_MAX_CANDIDATES));
+        std::vector<GestureCandidate> results =
+            rank(scratch.normalized, stream.trace, maxCandidates, stream.path.rawCount,
+                 scratch, true, true, useResults, seeds);
+        scratch.stats.totalNs = total.lap();
+        return results;
+    }
+
+    /**
+     * Rank the streamed gesture so far, as a preview, and with
+     * ScoringConfig::inFlightRanking keep its shortlist to seed the final
+     * scoring in endGesture(). A gesture that ends on the same key has the
+     * same key trace and so mostly the same candidates, and its shortlist
+     * is close to the final one.
+     */
+    std::vector<GestureCandidate> rankInFlight() {
+        scratch.scored.clear();
+        std::vector<GestureCandidate> results = rankStream(previewCandidates, false);
+        if (config.inFlightRanking && !stream.trace.keys.empty()) {
+            stream.seeds.assign(scratch.scored.begin(), scratch.scored.end());
+            stream.seedKey = stream.trace.keys.back();
+        }
+        return results;
+    }
+
+    /** A normalized gesture of a batch, with the keys it is grouped by. */
+    struct BatchGesture {
+        size_t index;
+        char startChar;
+        char endChar;
+        float estimatedLen;
+    };
+
+    /** Batch order: grouped by bucket, then by length, then input order. */
+    static bool batchBefore(const BatchGesture& a, const BatchGesture& b) {
+        if (a.startChar != b.startChar) return a.startChar < b.startChar;
+        if (a.endChar != b.endChar) return a.endChar < b.endChar;
+        if (a.estimatedLen != b.estimatedLen) return a.estimatedLen < b.estimatedLen;
+        return a.index < b.index;
+    }
+
+    /** Run task(worker, chunk) for every chunk, on the pool if there is one. */
+    void runChunks(size_t chunkCount, const std::function<void(int, size_t)>& task) {
+        if (pool) {
+            pool->run(chunkCount, task);
+        } else {
+            for (size_t c = 0; c < chunkCount; ++c) task(0, c);
+        }
+    }
+
+    /**
+     * Generate the ideal path of every candidate of the gestures in order,
+     * in dictionaries without templates, into batch. The candidates are
+     * found per chunk of gestures, then each distinct word's path is
+     * generated once, both on the pool. Counters and times go to stats.
      *
-     * This replaces the previous arc-length heuristic which overestimated
-     * zigzag words (e.g. "hello" estimated as 17+ chars instead of 5).
+     * @return false (batch left empty) if every dictionary has templates.
      */
-    float estimateWordLengthByKeyTransitions(const RawGesturePath& rawPath) const {
-        if (rawPath.points.size() < 2) return 1.0f;
+    bool buildBatchPaths(const std::vector<GesturePath>& normalized,
+                         const std::vector<KeyTrace>& traces,
+                         const std::vector<BatchGesture>& order, int maxCandidates,
+                         BatchPaths& batch, RecognitionStats& stats) {
+        const Snapshot& snap = *current;
+        const size_t sourceCount = snap.sources.size();
+        bool lazy = false;
+        batch.count = static_cast<size_t>(snap.resampleCount);
+        batch.slotOf.assign(sourceCount, {});
+        for (size_t s = 0; s < sourceCount; ++s) {
+            const Snapshot::Source& source = snap.sources[s];
+            if (source.templates || source.user) continue;
+            batch.slotOf[s].assign(source.store->getDictionary().getEntryCount(),
+                                   BatchPaths::NO_SLOT);
+            lazy = true;
+        }
+        if (!lazy) return false;
 
-        int32_t prevKey = -1;
-        int transitions = 0;
-        for (const auto& pt : rawPath.points) {
-            int32_t key = layout.findNearestKey(pt.x, pt.y);
-            if (key >= 0 && key != prevKey) {
-                transitions++;
-                prevKey = key;
+        StageClock clock;
+        const size_t shortlistSize = static_cast<size_t>(
+            std::max(maxCandidates, config.maxCandidatesEvaluated));
+        const size_t chunk = static_cast<size_t>(BATCH_CHUNK_SIZE);
+        const size_t workers = static_cast<size_t>(pool->threadCount());
+        for (size_t w = 0; w < workers; ++w) {
+            std::vector<std::vector<uint32_t>>& wanted = batchWorkers[w]->wanted;
+            wanted.resize(sourceCount);
+            for (std::vector<uint32_t>& entries : wanted) entries.clear();
+        }
+        runChunks((order.size() + chunk - 1) / chunk, [&](int worker, size_t c) {
+            BatchWorker& bw = *batchWorkers[static_cast<size_t>(worker)];
+            RecognitionStats counted;   // counted again when the gesture is ranked
+            StageClock unused;
+            for (size_t k = c * chunk; k < std::min(order.size(), (c + 1) * chunk); ++k) {
+                const size_t i = order[k].index;
+                size_t chunkCount = 0;
+                filterCandidates(normalized[i], traces[i], shortlistSize, false, bw.scratch,
+                                 counted, unused, chunkCount);
+                for (size_t s = 0; s < sourceCount; ++s) {
+                    if (batch.slotOf[s].empty()) continue;
+                    const DictionaryIndexSpan candidates = bw.scratch.sources[s].candidates;
+                    bw.wanted[s].insert(bw.wanted[s].end(), candidates.begin(), candidates.end());
+                }
+            }
+            // Gestures of a chunk mostly share a bucket
+            for (std::vector<uint32_t>& entries : bw.wanted) {
+                std::sort(entries.begin(), entries.end());
+                entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+            }
+        });
+        stats.filterNs += clock.lap();
+
+        // Distinct words take consecutive slots
+        std::vector<std::pair<uint32_t, uint32_t>> words;  // dictionary and entry of each slot
+        for (size_t w = 0; w < workers; ++w) {
+            for (size_t s = 0; s < sourceCount; ++s) {
+                for (uint32_t idx : batchWorkers[w]->wanted[s]) {
+                    uint32_t& slot = batch.slotOf[s][idx];
+                    if (slot != BatchPaths::NO_SLOT) continue;
+                    slot = static_cast<uint32_t>(words.size());
+                    words.emplace_back(static_cast<uint32_t>(s), idx);
+                }
+            }
+        }
+        const size_t n = batch.count;
+        batch.xs.resize(words.size() * n);
+        batch.ys.resize(words.size() * n);
+        batch.valid.assign(words.size(), 0);
+        const size_t wordChunk = static_cast<size_t>(SCORING_CHUNK_SIZE);
+        runChunks((words.size() + wordChunk - 1) / wordChunk, [&](int, size_t c) {
+            for (size_t slot = c * wordChunk; slot < std::min(words.size(), (c + 1) * wordChunk); ++slot) {
+                const Snapshot::Source& source = snap.sources[words[slot].first];
+                const GesturePath path = snap.paths->generatePath(source.entry(words[slot].second).word);
+                if (!path.isValid()) continue;
+                for (size_t p = 0; p < n; ++p) {
+                    batch.xs[slot * n + p] = path.points[p].x;
+                    batch.ys[slot * n + p] = path.points[p].y;
+                }
+                batch.valid[slot] = 1;
+            }
+        });
+        stats.pathsGenerated += static_cast<uint32_t>(words.size());
+        stats.templateNs += clock.lap();
+        return true;
+    }
+
+    std::vector<std::vector<GestureCandidate>> recognizeBatch(
+            const RawGesturePath* paths, size_t count, int maxCandidates) {
+        StageClock total;
+        std::vector<std::vector<GestureCandidate>> results(count);
+        const size_t workers = pool ? static_cast<size_t>(pool->threadCount()) : 1;
+        while (batchWorkers.size() < workers) {
+            batchWorkers.push_back(std::make_unique<BatchWorker>());
+            batchWorkers.back()->pathProcessor.setResampleCount(current->resampleCount);
+        }
+        for (size_t w = 0; w < workers; ++w) batchWorkers[w]->scratch.stats = RecognitionStats();
+        // Lazily generated paths go through the (single-threaded) cache
+        // only when the batch runs serially. A parallel batch generates
+        // them up front instead (Step 2b).
+        const bool cachePaths = !pool;
+        const size_t chunk = static_cast<size_t>(BATCH_CHUNK_SIZE);
+        const size_t chunkCount = (count + chunk - 1) / chunk;
+
+        // Step 1: Normalize every gesture and find its bucket keys
+        std::vector<GesturePath> normalized(count);
+        std::vector<BatchGesture> order(count);
+        std::vector<KeyTrace> traces(count);
+        std::vector<char> usable(count, 0);
+        runChunks(chunkCount, [&](int worker, size_t c) {
+            BatchWorker& bw = *batchWorkers[static_cast<size_t>(worker)];
+            StageClock clock;
+            for (size_t i = c * chunk; i < std::min(count, (c + 1) * chunk); ++i) {
+                if (paths[i].isEmpty()) continue;
+                bw.pathProcessor.normalize(paths[i], current->layout, normalized[i]);
+                bw.scratch.stats.normalizeNs += clock.lap();
+                if (!normalized[i].isValid()) continue;
+                usable[i] = 1;
+                float estimatedLen = estimateWordLengthByKeyTransitions(paths[i], traces[i]);
+                order[i] = {i, keyLetter(normalized[i].startKeyIndex),
+                            keyLetter(normalized[i].endKeyIndex), estimatedLen};
+            }
+        });
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (usable[i]) {
+                order[kept++] = order[i];
+            } else if (paths[i].isEmpty()) {
+                reportError(ErrorCode::PATH_TOO_SHORT, "Gesture path too short");
+            }
+        }
+        order.resize(kept);
+
+        // Step 2: Gestures sharing a bucket become neighbours, so a chunk
+        // scores them one after another against the same candidate span
+        std::sort(order.begin(), order.end(), batchBefore);
+
+        // Step 2b: Without templates, a parallel batch generates the path of
+        // each word any of its gestures has as a candidate once, before the
+        // gestures are split across the pool
+        RecognitionStats stats;
+        BatchPaths batch;
+        const bool batched = pool && buildBatchPaths(normalized, traces, order, maxCandidates,
+                                                     batch, stats);
+        for (size_t w = 0; w < workers; ++w) {
+            batchWorkers[w]->scratch.batchPaths = batched ? &batch : nullptr;
+        }
+
+        // Steps 3-7 per gesture, serially within a chunk
+        runChunks((kept + chunk - 1) / chunk, [&](int worker, size_t c) {
+            Scratch& work = batchWorkers[static_cast<size_t>(worker)]->scratch;
+            for (size_t k = c * chunk; k < std::min(kept, (c + 1) * chunk); ++k) {
+                const size_t i = order[k].index;
+                results[i] = rank(normalized[i], traces[i], maxCandidates,
+                                  paths[i].points.size(), work, false, cachePaths, false);
+            }
+        });
+        for (size_t w = 0; w < workers; ++w) batchWorkers[w]->scratch.batchPaths = nullptr;
+
+        // Published even without stats, for wasLastRecognitionTruncated()
+        for (size_t w = 0; w < workers; ++w) addStats(stats, batchWorkers[w]->scratch.stats);
+        stats.totalNs = total.lap();
+        publishStats(stats);
+        return results;
+    }
+
+    void dropTemplates() {
+        if (current) {
+            bool any = false;
+            for (const auto& source : current->sources) any = any || source.templates;
+            if (any) {
+                auto snap = std::make_shared<Snapshot>(*current);
+                for (auto& source : snap->sources) source.templates.reset();
+                install(std::move(snap));
             }
         }
-        return std::max(1.0f, static_cast<float>(transitions));
+        templatesRequested = false;
+        templatesWarmed = false;
+        templateCacheDir.clear();
     }
 };
 
@@ -85,21 +2114,18 @@ bool GestureEngine::init(const KeyboardLayout& layout, const std::string& dictPa
         return false;
     }
 
-    if (!pImpl->dictLoader.load(dictPath)) {
-        auto err = pImpl->dictLoader.getLastError();
+    auto store = std::make_shared<DictionaryStore>();
+    if (!store->load(dictPath)) {
+        auto err = store->getLastError();
         pImpl->reportError(err.code, err.message);
         return false;
     }
-
-    pImpl->layout = layout;
-    pImpl->idealPathGen.setLayout(layout);
-    pImpl->scorer.configure(pImpl->config);
-    pImpl->initialized = true;
-    return true;
+    return initWithStore(layout, std::move(store));
 }
 
 bool GestureEngine::initWithData(const KeyboardLayout& layout,
-                                  const uint8_t* dictData, size_t dictSize) {
+                                  const uint8_t* dictData, size_t dictSize,
+                                  DictionaryStorage storage) {
     if (!pImpl) return false;
 
     if (!layout.isValid()) {
@@ -107,226 +2133,456 @@ bool GestureEngine::initWithData(const KeyboardLayout& layout,
         return false;
     }
 
-    if (!pImpl->dictLoader.loadFromMemory(dictData, dictSize)) {
-        auto err = pImpl->dictLoader.getLastError();
+    auto store = std::make_shared<DictionaryStore>();
+    if (!store->loadFromMemory(dictData, dictSize, storage)) {
+        auto err = store->getLastError();
         pImpl->reportError(err.code, err.message);
         return false;
     }
+    return initWithStore(layout, std::move(store));
+}
+
+bool GestureEngine::initWithStore(const KeyboardLayout& layout,
+                                  std::shared_ptr<const DictionaryStore> store) {
+    if (!pImpl) return false;
+
+    if (!layout.isValid()) {
+        pImpl->reportError(ErrorCode::LAYOUT_INVALID, "KeyboardLayout is invalid");
+        return false;
+    }
+    if (!store || !store->isLoaded()) {
+        pImpl->reportError(ErrorCode::DICT_NOT_FOUND, "DictionaryStore is not loaded");
+        return false;
+    }
 
-    pImpl->layout = layout;
-    pImpl->idealPathGen.setLayout(layout);
+    pImpl->waitForSwap();
+    pImpl->stopWarmup();
+    pImpl->resetStream();
+    pImpl->templatesRequested = false;
+    pImpl->templatesWarmed = false;
+    pImpl->templateCacheDir.clear();
+    pImpl->userDictionary.reset();
+    pImpl->install(Impl::buildSnapshot(layout, std::move(store), nullptr,
+                                       pImpl->buildOptions(), false));
     pImpl->scorer.configure(pImpl->config);
+    pImpl->startPool();
     pImpl->initialized = true;
+    pImpl->startWarmup();
     return true;
 }
 
+std::shared_ptr<const DictionaryStore> GestureEngine::getDictionaryStore() const {
+    if (!pImpl) return nullptr;
+    auto snap = std::atomic_load(&pImpl->published);
+    return snap ? snap->sources[0].store : nullptr;
+}
+
 std::vector<GestureCandidate> GestureEngine::recognize(const RawGesturePath& rawPath,
                                                         int maxCandidates) {
     std::vector<GestureCandidate> results;
     if (!pImpl) return results;
 
-    // Step 0: Validation
+    // Step 0: Validation. Every return below publishes stats, so they never
+    // describe an earlier gesture.
+    RecognitionStats& stats = pImpl->scratch.stats;
+    stats = RecognitionStats();
     if (!pImpl->initialized) {
         pImpl->reportError(ErrorCode::ENGINE_NOT_INITIALIZED, "Engine not initialized");
+        pImpl->publishStats(stats);
         return results;
     }
     maxCandidates = std::max(1, std::min(maxCandidates, MAX_MAX_CANDIDATES));
     if (rawPath.isEmpty()) {
         pImpl->reportError(ErrorCode::PATH_TOO_SHORT, "Gesture path too short");
+        pImpl->publishStats(stats);
         return results;
     }
 
-    // Step 1: Path Normalization
-    GesturePath normalizedPath = pImpl->pathProcessor.normalize(rawPath, pImpl->layout);
-    if (!normalizedPath.isValid()) return results;
+    // Step 1: Path Normalization, on the latest published snapshot
+    pImpl->acquire();
+    StageClock total;
+    StageClock clock;
+    GesturePath& normalizedPath = pImpl->scratch.normalized;
+    pImpl->pathProcessor.normalize(rawPath, pImpl->current->layout, normalizedPath);
+    if (!normalizedPath.isValid()) {
+        pImpl->publishStats(stats);
+        return results;
+    }
+    stats.normalizeNs = clock.lap();
 
-    // Step 2: Determine start/end key characters
-    char startChar = 0, endChar = 0;
-    bool hasStartEnd = false;
+    Impl::KeyTrace& trace = pImpl->scratch.trace;
+    pImpl->estimateWordLengthByKeyTransitions(rawPath, trace);
+    results = pImpl->rank(normalizedPath, trace, maxCandidates,
+                          rawPath.points.size(), pImpl->scratch, true, true, true);
+    stats.totalNs = total.lap();
+    pImpl->publishStats(stats);
+    return results;
+}
 
-    if (normalizedPath.startKeyIndex >= 0 &&
-        normalizedPath.startKeyIndex < static_cast<int>(pImpl->layout.keys.size()) &&
-        normalizedPath.endKeyIndex >= 0 &&
-        normalizedPath.endKeyIndex < static_cast<int>(pImpl->layout.keys.size())) {
+std::vector<std::vector<GestureCandidate>> GestureEngine::recognizeBatch(
+        const RawGesturePath* paths, size_t count, int maxCandidates) {
+    if (!pImpl) return std::vector<std::vector<GestureCandidate>>(count);
+    if (!pImpl->initialized) {
+        pImpl->reportError(ErrorCode::ENGINE_NOT_INITIALIZED, "Engine not initialized");
+        pImpl->publishStats(RecognitionStats());
+        return std::vector<std::vector<GestureCandidate>>(count);
+    }
+    maxCandidates = std::max(1, std::min(maxCandidates, MAX_MAX_CANDIDATES));
+    pImpl->acquire();
+    return pImpl->recognizeBatch(paths, count, maxCandidates);
+}
 
-        int32_t cpS = pImpl->layout.keys[static_cast<size_t>(normalizedPath.startKeyIndex)].codePoint;
-        int32_t cpE = pImpl->layout.keys[static_cast<size_t>(normalizedPath.endKeyIndex)].codePoint;
+std::vector<std::vector<GestureCandidate>> GestureEngine::recognizeBatch(
+        const std::vector<RawGesturePath>& paths, int maxCandidates) {
+    return recognizeBatch(paths.data(), paths.size(), maxCandidates);
+}
 
-        if (cpS >= 'a' && cpS <= 'z') startChar = static_cast<char>(cpS);
-        else if (cpS >= 'A' && cpS <= 'Z') startChar = static_cast<char>(std::tolower(cpS));
+bool GestureEngine::beginGesture() {
+    if (!pImpl) return false;
+    pImpl->resetStream();
+    if (!pImpl->initialized) {
+        pImpl->reportError(ErrorCode::ENGINE_NOT_INITIALIZED, "Engine not initialized");
+        return false;
+    }
+    pImpl->acquire();  // kept until the gesture ends
+    pImpl->stream.active = true;
+    return true;
+}
 
-        if (cpE >= 'a' && cpE <= 'z') endChar = static_cast<char>(cpE);
-        else if (cpE >= 'A' && cpE <= 'Z') endChar = static_cast<char>(std::tolower(cpE));
+bool GestureEngine::addPoints(const GesturePoint* points, size_t count) {
+    if (!pImpl || !pImpl->stream.active) return false;
+    if (count == 0) return true;
 
-        hasStartEnd = (startChar != 0 && endChar != 0);
+    Impl::Stream& st = pImpl->stream;
+    for (size_t i = 0; i < count; ++i) {
+        const GesturePoint& pt = points[i];
+        if (st.path.rawCount == 0) {
+            st.startChar = pImpl->keyLetter(pImpl->current->layout.findNearestKey(pt.x, pt.y));
+            st.nextPreviewAt = pt.timestamp + pImpl->previewIntervalMs;
+        }
+        pImpl->pathProcessor.appendPoint(st.path, pt);
+        const size_t keys = st.trace.keys.size();
+        pImpl->countKeyTransition(pt, st.trace);
+        if (st.trace.keys.size() != keys) st.keyEnteredAt = pt.timestamp;
     }
 
-    ST_LOGD("PIPELINE: startKey='%c' endKey='%c' hasStartEnd=%d  rawPts=%zu",
-            startChar ? startChar : '?', endChar ? endChar : '?',
-            (int)hasStartEnd, rawPath.points.size());
+    pImpl->prefetchPaths();
 
-    // Step 3: Candidate Filtering
-    std::vector<const DictionaryEntry*> dictEntries;
-    if (hasStartEnd) {
-        dictEntries = pImpl->dictLoader.getEntriesWithStartEnd(startChar, endChar);
-    }
-    if (dictEntries.empty() && startChar != 0) {
-        dictEntries = pImpl->dictLoader.getEntriesStartingWith(startChar);
-    }
-    if (dictEntries.empty()) {
-        // Last resort: score a sample of all entries
-        const auto& all = pImpl->dictLoader.getAllEntries();
-        for (const auto& e : all) {
-            dictEntries.push_back(&e);
-        }
+    // Previews at their interval; without one due, an in-flight ranking once
+    // the finger has stayed on a key it has not been ranked ending on
+    const int64_t latest = st.path.points.back().timestamp;
+    if (st.path.rawCount < static_cast<size_t>(MIN_GESTURE_POINTS)) return true;
+    if (pImpl->previewCallback && latest >= st.nextPreviewAt) {
+        st.nextPreviewAt = latest + pImpl->previewIntervalMs;
+        std::vector<GestureCandidate> preview = pImpl->rankInFlight();
+        pImpl->previewCallback(preview);
+    } else if (pImpl->config.inFlightRanking && !st.trace.keys.empty() &&
+               st.trace.keys.back() != st.seedKey &&
+               latest - st.keyEnteredAt >= STREAM_SEED_DWELL_MS) {
+        pImpl->rankInFlight();
     }
+    return true;
+}
 
-    // Apply word-length filter (key-transition count, not arc length)
-    float estimatedLen = pImpl->estimateWordLengthByKeyTransitions(rawPath);
-    float tol = pImpl->config.lengthFilterTolerance;
+bool GestureEngine::addPoints(const std::vector<GesturePoint>& points) {
+    return addPoints(points.data(), points.size());
+}
 
-    std::vector<const DictionaryEntry*> filtered;
-    filtered.reserve(dictEntries.size());
-    for (const auto* entry : dictEntries) {
-        float wordLen = static_cast<float>(entry->word.size());
-        if (std::abs(wordLen - estimatedLen) <= tol) {
-            filtered.push_back(entry);
-        }
+std::vector<GestureCandidate> GestureEngine::endGesture(int maxCandidates) {
+    std::vector<GestureCandidate> results;
+    if (!pImpl) return results;
+    if (!pImpl->stream.active) {
+        pImpl->publishStats(RecognitionStats());
+        return results;
     }
-    ST_LOGD("PIPELINE: estWordLen=%.1f  dictEntries=%zu  afterLenFilter=%zu  tol=%.1f",
-            estimatedLen, dictEntries.size(), filtered.size(), tol);
 
-    // If filter removed everything, fall back to unfiltered
-    if (filtered.empty()) {
-        ST_LOGD("PIPELINE: length filter removed ALL — falling back to unfiltered (%zu)",
-                dictEntries.size());
-        filtered = dictEntries;
+    if (pImpl->stream.path.rawCount < static_cast<size_t>(MIN_GESTURE_POINTS)) {
+        pImpl->resetStream();
+        pImpl->reportError(ErrorCode::PATH_TOO_SHORT, "Gesture path too short");
+        pImpl->publishStats(RecognitionStats());
+        return results;
     }
 
-    // Step 4: Scoring
-    struct ScoredEntry {
-        const DictionaryEntry* entry;
-        float dtwDistance;
-    };
-    std::vector<ScoredEntry> scored;
-    scored.reserve(filtered.size());
+    // rankStream() resets the stats even when the path turns out unusable
+    results = pImpl->rankStream(maxCandidates, true, &pImpl->stream.seeds);
+    pImpl->resetStream();
+    pImpl->publishStats(pImpl->scratch.stats);
+    return results;
+}
+
+void GestureEngine::cancelGesture() {
+    if (pImpl) pImpl->resetStream();
+}
+
+bool GestureEngine::isGestureInProgress() const {
+    return pImpl && pImpl->stream.active;
+}
 
-    for (const auto* entry : filtered) {
-        GesturePath ideal = pImpl->idealPathGen.getIdealPath(entry->word);
-        if (!ideal.isValid()) continue;
+void GestureEngine::setPreviewCallback(PreviewCallback callback, int intervalMs,
+                                       int maxCandidates) {
+    if (!pImpl) return;
+    pImpl->previewCallback = std::move(callback);
+    pImpl->previewIntervalMs = std::max(1, intervalMs);
+    pImpl->previewCandidates = maxCandidates;
+}
 
-        float dtw = pImpl->scorer.computeDTWDistance(normalizedPath, ideal);
-        scored.push_back({entry, dtw});
+void GestureEngine::shutdown() {
+    if (pImpl) {
+        pImpl->waitForSwap();
+        pImpl->stopWarmup();
+        pImpl->warmup.state = static_cast<int>(WarmupState::IDLE);
+        pImpl->dropTemplates();
+        pImpl->pool.reset();
+        pImpl->resetStream();
+        pImpl->install(nullptr);
+        pImpl->invalidateResults();
+        pImpl->userDictionary.reset();
+        pImpl->initialized = false;
     }
+}
 
-    if (scored.empty()) return results;
+bool GestureEngine::isInitialized() const {
+    return pImpl && pImpl->initialized;
+}
 
-    // Step 5: Max DTW normalization.
-    // For RANKING multiple candidates: use the actual max candidate DTW so
-    // shape differences are properly reflected. A small safety floor prevents
-    // division by zero but never compresses real differences.
-    // For SINGLE candidate confidence: use the larger maxDTWFloor so the
-    // candidate gets a meaningful absolute confidence value.
-    float rawMaxDTW = 0.0f;
-    float minCandDTW = FLT_MAX;
-    for (const auto& s : scored) {
-        if (s.dtwDistance < FLT_MAX) {
-            if (s.dtwDistance > rawMaxDTW) rawMaxDTW = s.dtwDistance;
-            if (s.dtwDistance < minCandDTW) minCandDTW = s.dtwDistance;
-        }
+bool GestureEngine::updateLayout(const KeyboardLayout& layout) {
+    if (!pImpl || !pImpl->initialized) return false;
+    if (!layout.isValid()) {
+        pImpl->reportError(ErrorCode::LAYOUT_INVALID, "KeyboardLayout is invalid");
+        return false;
     }
-    float maxDTW;
-    if (scored.size() <= 1) {
-        maxDTW = std::max(rawMaxDTW, pImpl->config.maxDTWFloor);
-    } else {
-        maxDTW = std::max(rawMaxDTW, 0.01f);
+    pImpl->waitForSwap();
+    pImpl->resetStream();
+    Impl::BuildOptions options = pImpl->buildOptions();
+    auto snap = Impl::buildSnapshot(layout, pImpl->current->sources[0].store,
+                                    pImpl->current.get(), options, false);
+    if (options.templates && !snap->sources[0].templates) {
+        pImpl->templatesRequested = false;
+        pImpl->templateCacheDir.clear();
     }
-
-    // Step 5b: Adaptive frequency weight.
-    // Uses the RAW DTW range (before any floor) to detect when candidates
-    // have similar shape scores. When the spread is small, frequency weight
-    // is scaled down proportionally so shape dominates the ranking.
-    float rawRange = (minCandDTW < FLT_MAX) ? (rawMaxDTW - minCandDTW) : 0.0f;
-    float effectiveAlpha = pImpl->config.frequencyWeight;
-    if (scored.size() > 1 && rawRange < 0.5f) {
-        effectiveAlpha *= std::max(0.1f, rawRange / 0.5f);
+    const bool moved = !snap->sameGeometry(pImpl->current.get());
+    // The warm-up of the old layout is of no use; the new one is warmed
+    // up like a new session, templates included
+    if (moved) pImpl->stopWarmup();
+    pImpl->install(std::move(snap));
+    if (moved) {
+        if (!pImpl->current->sources[0].templates) pImpl->templatesWarmed = false;
+        pImpl->startWarmup();
     }
+    return true;
+}
+
+bool GestureEngine::updateLayoutAsync(const KeyboardLayout& layout, SwapCallback done) {
+    if (!pImpl || !pImpl->initialized || !layout.isValid()) return false;
+    auto request = std::make_unique<Impl::SwapRequest>();
+    request->hasLayout = true;
+    request->layout = layout;
+    request->options = pImpl->buildOptions();
+    // The build compiles warmed templates anew, off this thread as well
+    request->options.templates = request->options.templates || pImpl->templatesWarmed.load();
+    request->done.push_back(std::move(done));
+    // Joined by the recognizing thread once it picks up the new layout
+    pImpl->warmup.compile.cancel = true;
+    pImpl->requestSwap(std::move(request));
+    return true;
+}
 
-    ST_LOGD("PIPELINE: scored=%zu  minDTW=%.4f  rawMaxDTW=%.4f  maxDTW=%.4f  rawRange=%.4f  alpha=%.3f(eff=%.3f)",
-            scored.size(), minCandDTW, rawMaxDTW, maxDTW, rawRange,
-            pImpl->config.frequencyWeight, effectiveAlpha);
+bool GestureEngine::reloadDictionaryAsync(const std::string& dictPath, SwapCallback done) {
+    if (!pImpl || !pImpl->initialized) return false;
+    auto request = std::make_unique<Impl::SwapRequest>();
+    request->dictPath = dictPath;
+    request->options = pImpl->buildOptions();
+    request->done.push_back(std::move(done));
+    pImpl->requestSwap(std::move(request));
+    return true;
+}
 
-    // Step 6: Compute confidence scores (inlined with adaptive alpha)
-    uint32_t maxFreq = pImpl->dictLoader.getMaxFrequency();
-    results.reserve(scored.size());
+bool GestureEngine::reloadDictionaryAsync(std::shared_ptr<const DictionaryStore> store,
+                                          SwapCallback done) {
+    if (!pImpl || !pImpl->initialized || !store || !store->isLoaded()) return false;
+    auto request = std::make_unique<Impl::SwapRequest>();
+    request->store = std::move(store);
+    request->options = pImpl->buildOptions();
+    request->done.push_back(std::move(done));
+    pImpl->requestSwap(std::move(request));
+    return true;
+}
 
-    for (const auto& s : scored) {
-        float normalizedDTW = 1.0f;
-        if (maxDTW > 0.0f && s.dtwDistance < FLT_MAX) {
-            normalizedDTW = std::min(1.0f, s.dtwDistance / maxDTW);
-        }
+void GestureEngine::waitForSwap() {
+    if (pImpl) pImpl->waitForSwap();
+}
 
-        float normalizedFreq = 0.0f;
-        if (maxFreq > 0) {
-            normalizedFreq = std::min(1.0f,
-                static_cast<float>(s.entry->frequency) / static_cast<float>(maxFreq));
-        }
+WarmupProgress GestureEngine::getWarmupProgress() const {
+    WarmupProgress progress;
+    if (!pImpl) return progress;
+    // State first: the counters of a finished warm-up are then final
+    progress.state = static_cast<WarmupState>(pImpl->warmup.state.load());
+    progress.wordsTotal = pImpl->warmup.total;
+    progress.wordsDone = std::min(progress.wordsTotal,
+                                  pImpl->warmup.pathsDone.load(std::memory_order_relaxed) +
+                                  pImpl->warmup.compile.compiled.load(std::memory_order_relaxed));
+    return progress;
+}
 
-        float finalScore = (1.0f - effectiveAlpha) * normalizedDTW
-                         + effectiveAlpha * (1.0f - normalizedFreq);
-        float confidence = 1.0f - std::max(0.0f, std::min(1.0f, finalScore));
+void GestureEngine::cancelWarmup() {
+    if (pImpl) pImpl->warmup.compile.cancel = true;
+}
 
-        GestureCandidate candidate;
-        candidate.word = s.entry->word;
-        candidate.confidence = confidence;
-        candidate.sourceFlags = SOURCE_MAIN_DICT;
-        candidate.dtwScore = s.dtwDistance;
-        candidate.frequencyScore = (maxFreq > 0)
-            ? static_cast<float>(s.entry->frequency) / static_cast<float>(maxFreq)
-            : 0.0f;
-        results.push_back(std::move(candidate));
+bool GestureEngine::addDictionary(std::shared_ptr<const DictionaryStore> store, float weight,
+                                  uint32_t sourceFlags) {
+    if (!pImpl) return false;
+    if (!pImpl->initialized) {
+        pImpl->reportError(ErrorCode::ENGINE_NOT_INITIALIZED, "Engine not initialized");
+        return false;
+    }
+    if (!store || !store->isLoaded()) {
+        pImpl->reportError(ErrorCode::DICT_NOT_FOUND, "DictionaryStore is not loaded");
+        return false;
+    }
+    if (!(weight >= 0.0f) || !std::isfinite(weight)) {
+        pImpl->reportError(ErrorCode::INVALID_ARGUMENT, "Dictionary weight must be finite and >= 0");
+        return false;
+    }
+    pImpl->waitForSwap();
+    for (const auto& source : pImpl->current->sources) {
+        if (source.store == store) {
+            pImpl->reportError(ErrorCode::INVALID_ARGUMENT, "DictionaryStore is already in use");
+            return false;
+        }
     }
 
-    // Step 7: Sort and prune
-    std::sort(results.begin(), results.end(),
-        [](const GestureCandidate& a, const GestureCandidate& b) {
-            return a.confidence > b.confidence;
-        });
+    auto snap = std::make_shared<Impl::Snapshot>(*pImpl->current);
+    Impl::Snapshot::Source source;
+    source.store = std::move(store);
+    source.weight = weight;
+    source.sourceFlags = sourceFlags;
+    snap->sources.push_back(std::move(source));
+    if (pImpl->templatesRequested) {
+        // Best effort: without templates the dictionary's paths are generated
+        snap->sources.back().templates =
+            Impl::buildTemplates(*snap, snap->sources.size() - 1, pImpl->buildOptions());
+    }
+    pImpl->install(std::move(snap));
+    return true;
+}
 
-    if (static_cast<int>(results.size()) > maxCandidates) {
-        results.resize(static_cast<size_t>(maxCandidates));
+bool GestureEngine::removeDictionary(const std::shared_ptr<const DictionaryStore>& store) {
+    if (!pImpl || !pImpl->initialized || !store) return false;
+    pImpl->waitForSwap();
+    const auto& sources = pImpl->current->sources;
+    for (size_t i = 1; i < sources.size(); ++i) {
+        if (sources[i].store != store) continue;
+        auto snap = std::make_shared<Impl::Snapshot>(*pImpl->current);
+        snap->sources.erase(snap->sources.begin() + static_cast<std::ptrdiff_t>(i));
+        pImpl->install(std::move(snap));
+        return true;
     }
+    return false;
+}
 
-    return results;
+size_t GestureEngine::getDictionaryCount() const {
+    if (!pImpl) return 0;
+    auto snap = std::atomic_load(&pImpl->published);
+    if (!snap) return 0;
+    return static_cast<size_t>(std::count_if(snap->sources.begin(), snap->sources.end(),
+        [](const Impl::Snapshot::Source& source) { return source.store != nullptr; }));
 }
 
-void GestureEngine::shutdown() {
-    if (pImpl) {
-        pImpl->dictLoader.unload();
-        pImpl->idealPathGen.clearCache();
-        pImpl->initialized = false;
+bool GestureEngine::setUserDictionary(std::shared_ptr<UserDictionary> user) {
+    if (!pImpl) return false;
+    if (!pImpl->initialized) {
+        pImpl->reportError(ErrorCode::ENGINE_NOT_INITIALIZED, "Engine not initialized");
+        return false;
+    }
+    pImpl->waitForSwap();
+    auto snap = std::make_shared<Impl::Snapshot>(*pImpl->current);
+    auto& sources = snap->sources;
+    sources.erase(std::remove_if(sources.begin(), sources.end(),
+        [](const Impl::Snapshot::Source& source) { return source.user != nullptr; }),
+        sources.end());
+    if (user) {
+        Impl::Snapshot::Source source;
+        source.user = user;
+        source.sourceFlags = SOURCE_USER_DICT;
+        sources.push_back(std::move(source));
     }
+    pImpl->userDictionary = std::move(user);
+    pImpl->install(std::move(snap));
+    pImpl->acquire();  // templates for the current layout
+    return true;
 }
 
-bool GestureEngine::isInitialized() const {
-    return pImpl && pImpl->initialized;
+std::shared_ptr<UserDictionary> GestureEngine::getUserDictionary() const {
+    return pImpl ? pImpl->userDictionary : nullptr;
 }
 
-bool GestureEngine::updateLayout(const KeyboardLayout& layout) {
+bool GestureEngine::compileTemplates(const std::string& cacheDir) {
     if (!pImpl || !pImpl->initialized) return false;
-    if (!layout.isValid()) {
-        pImpl->reportError(ErrorCode::LAYOUT_INVALID, "KeyboardLayout is invalid");
+    pImpl->waitForSwap();
+    pImpl->stopWarmup();
+    pImpl->templateCacheDir = cacheDir;
+    pImpl->templatesRequested = pImpl->installAllTemplates(true);
+    return pImpl->templatesRequested;
+}
+
+bool GestureEngine::hasCompiledTemplates() const {
+    return getTemplateStore() != nullptr;
+}
+
+bool GestureEngine::attachTemplates(std::shared_ptr<const TemplateStore> templates) {
+    if (!pImpl || !pImpl->initialized || !templates || !templates->isCompiled()) return false;
+    pImpl->waitForSwap();
+    if (templates->size() != pImpl->dictionary().getEntryCount() ||
+        templates->getLayoutHash() != pImpl->current->layoutHash ||
+        templates->getPointCount() != pImpl->current->resampleCount) {
         return false;
     }
-    pImpl->layout = layout;
-    pImpl->idealPathGen.setLayout(layout); // clears cache
+    pImpl->stopWarmup();
+    pImpl->installTemplates(std::move(templates));
+    pImpl->templatesRequested = true;
+    pImpl->templateCacheDir.clear();
     return true;
 }
 
+std::shared_ptr<const TemplateStore> GestureEngine::getTemplateStore() const {
+    if (!pImpl) return nullptr;
+    auto snap = std::atomic_load(&pImpl->published);
+    return snap ? snap->sources[0].templates : nullptr;
+}
+
 void GestureEngine::configure(const ScoringConfig& config) {
     if (pImpl) {
+        pImpl->waitForSwap();
         pImpl->config = config;
+        pImpl->invalidateResults();
         pImpl->scorer.configure(config);
+        const int points = pImpl->scorer.getResampleCount();
+        pImpl->pathProcessor.setResampleCount(points);
+        for (auto& worker : pImpl->batchWorkers) worker->pathProcessor.setResampleCount(points);
+        if (!pImpl->initialized) return;
+        if (pImpl->current->resampleCount != points) {
+            // Paths and templates are resampled to the new count
+            Impl::BuildOptions options = pImpl->buildOptions();
+            auto snap = Impl::buildSnapshot(pImpl->current->layout,
+                                            pImpl->current->sources[0].store,
+                                            pImpl->current.get(), options, false);
+            if (options.templates && !snap->sources[0].templates) {
+                pImpl->templatesRequested = false;
+                pImpl->templateCacheDir.clear();
+            }
+            pImpl->install(std::move(snap));
+        }
+        pImpl->current->paths->setCacheBudget(config.pathCacheBytes);
+        pImpl->startPool();
+        const auto& templates = pImpl->current->sources[0].templates;
+        if (pImpl->templatesRequested && templates &&
+            templates->getPrecision() != config.templatePrecision) {
+            pImpl->installAllTemplates(false);
+        } else if (pImpl->templatesWarmed && templates &&
+                   templates->getPrecision() != config.templatePrecision) {
+            pImpl->installTemplates(nullptr);
+            pImpl->templatesWarmed = false;
+        }
     }
 }
 
@@ -338,4 +2594,72 @@ ErrorInfo GestureEngine::getLastError() const {
     return pImpl ? pImpl->lastError : ErrorInfo();
 }
 
+void GestureEngine::trimMemory(MemoryTrimLevel level) {
+    if (!pImpl) return;
+    pImpl->waitForSwap();
+    if (level == MemoryTrimLevel::COMPLETE) {
+        pImpl->batchWorkers.clear();
+        pImpl->resultCache.entries.clear();
+        pImpl->resultCache.entries.shrink_to_fit();
+        pImpl->resultCache.used = 0;
+    }
+    if (!pImpl->current) return;
+    if (level == MemoryTrimLevel::COMPLETE) {
+        pImpl->current->paths->clearCache();
+    } else {
+        pImpl->current->paths->trimCache(pImpl->config.pathCacheBytes / 2);
+    }
+}
+
+PathCacheStats GestureEngine::getPathCacheStats() const {
+    if (!pImpl || !pImpl->current) return PathCacheStats();
+    return pImpl->current->paths->getCacheStats();
+}
+
+ResultCacheStats GestureEngine::getResultCacheStats() const {
+    if (!pImpl) return ResultCacheStats();
+    ResultCacheStats stats = pImpl->resultCache.stats;
+    stats.entries = pImpl->resultCache.used;
+    stats.capacity = static_cast<size_t>(
+        std::max(0, std::min(pImpl->config.resultCacheSize, MAX_RESULT_CACHE_SIZE)));
+    return stats;
+}
+
+RecognitionStats GestureEngine::getLastRecognitionStats() const {
+    return pImpl ? pImpl->lastStats : RecognitionStats();
+}
+
+bool GestureEngine::wasLastRecognitionTruncated() const {
+    return pImpl && pImpl->lastTruncated;
+}
+
+void GestureEngine::setStatsCallback(StatsCallback callback) {
+    if (pImpl) pImpl->statsCallback = std::move(callback);
+}
+
+std::string RecognitionStats::toString() const {
+    char buf[768];
+    std::snprintf(buf, sizeof(buf),
+        "gestures=%u points=%u estLen=%.1f | ns: normalize=%llu filter=%llu "
+        "coarse=%llu template=%llu dtw=%llu rank=%llu total=%llu | candidates: lexicon=%u "
+        "widened=%u bucket=%u "
+        "filtered=%u fallbacks=%u coarse=%u->%u | dtw=%u boundPruned=%u rejected=%u "
+        "shortlisted=%u | paths: cacheHits=%u generated=%u templates=%u | "
+        "results: cacheHits=%u seeds=%u streamSeeds=%u | budget: truncated=%u skipped=%u",
+        gestures, rawPoints, estimatedLength,
+        static_cast<unsigned long long>(normalizeNs),
+        static_cast<unsigned long long>(filterNs),
+        static_cast<unsigned long long>(coarseNs),
+        static_cast<unsigned long long>(templateNs),
+        static_cast<unsigned long long>(dtwNs),
+        static_cast<unsigned long long>(rankNs),
+        static_cast<unsigned long long>(totalNs),
+        lexiconNodes, lexiconWidened, bucketCandidates, filteredCandidates, lengthFilterFallbacks,
+        coarseScored, coarseKept,
+        dtwCalls, boundPruned, rejected, shortlisted,
+        pathCacheHits, pathsGenerated, templateReads, resultCacheHits, resultCacheSeeds,
+        streamSeeds, budgetTruncated, budgetSkipped);
+    return buf;
+}
+
 } // namespace swipetype
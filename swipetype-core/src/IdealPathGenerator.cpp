@@ -1,16 +1,75 @@
 #include "swipetype/IdealPathGenerator.h"
 #include "swipetype/SwipeTypeTypes.h"
-#include <unordered_map>
+#include "PathResampler.h"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cctype>
+#include <cstddef>
+#include <cstring>
 
 namespace swipetype {
 
+namespace {
+
+/**
+ * One cached ideal path, keyed by its lowercased word. Its points are in
+ * the point slab at slot * resampleCount; the rest of the path is here.
+ */
+struct CacheSlot {
+    float aspectRatio = 1.0f;
+    float totalArcLength = 0.0f;
+    int32_t startKeyIndex = -1;
+    int32_t endKeyIndex = -1;
+    uint32_t hash = 0;
+    uint8_t pointCount = 0;     // resampleCount, or 0 for a word with no path
+    uint8_t length = 0;
+    bool occupied = false;
+    bool referenced = false;    // CLOCK bit: looked up since the hand last passed
+    char key[MAX_WORD_LENGTH];
+};
+
+constexpr uint32_t SLOT_NONE = 0xFFFFFFFF;
+
+/** Bytes one entry of pointCount points is charged against the budget: slot, slab points, two index buckets. */
+constexpr size_t entryBytes(int pointCount) {
+    return sizeof(CacheSlot) + size_t(pointCount) * sizeof(NormalizedPoint) + 2 * sizeof(uint32_t);
+}
+
+/** FNV-1a. */
+uint32_t hashKey(std::string_view key) {
+    uint32_t h = 2166136261u;
+    for (char c : key) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+} // namespace
+
 struct IdealPathGenerator::Impl {
     KeyboardLayout layout;
     bool layoutSet = false;
-    std::unordered_map<std::string, GesturePath> cache;
+    int resampleCount = RESAMPLE_COUNT;
+    std::string lookupKey;      // reused so cache hits do not allocate
+
+    // Path cache: slots evicted in CLOCK order, found through an
+    // open-addressing table of slot indices (linear probing). Slot s keeps
+    // its points in points[s * resampleCount, (s + 1) * resampleCount).
+    std::vector<CacheSlot> slots;
+    std::vector<NormalizedPoint> points;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> table;
+    size_t entries = 0;
+    size_t capacity = DEFAULT_PATH_CACHE_BYTES / entryBytes(RESAMPLE_COUNT);
+    size_t budgetBytes = DEFAULT_PATH_CACHE_BYTES;
+    size_t hand = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    GesturePath found;                      // last path returned by lookup()
+    std::vector<GesturePoint> keyPoints;    // reused by cached generation
 
     static float euclidean(float x1, float y1, float x2, float y2) {
         float dx = x2 - x1;
@@ -18,107 +77,24 @@ struct IdealPathGenerator::Impl {
         return std::sqrt(dx * dx + dy * dy);
     }
 
-    // Resample helper: same algorithm as PathProcessor
-    static std::vector<GesturePoint> resamplePoints(
-            const std::vector<GesturePoint>& points, int count) {
-        if (points.size() < 2 || count < 2) return points;
-
-        float totalLen = 0.0f;
-        for (size_t i = 1; i < points.size(); ++i) {
-            totalLen += euclidean(points[i-1].x, points[i-1].y,
-                                  points[i].x,   points[i].y);
-        }
-        if (totalLen < 1e-6f) {
-            return std::vector<GesturePoint>(count, points[0]);
-        }
-
-        float interval = totalLen / static_cast<float>(count - 1);
-        std::vector<GesturePoint> result;
-        result.reserve(count);
-        result.push_back(points[0]);
-
-        float D = 0.0f;
-        std::vector<GesturePoint> pts = points;
-        size_t i = 1;
-
-        while (i < pts.size() && static_cast<int>(result.size()) < count - 1) {
-            float dx = pts[i].x - pts[i-1].x;
-            float dy = pts[i].y - pts[i-1].y;
-            float d  = std::sqrt(dx * dx + dy * dy);
-
-            if (D + d >= interval) {
-                float t = (interval - D) / d;
-                GesturePoint np;
-                np.x = pts[i-1].x + t * dx;
-                np.y = pts[i-1].y + t * dy;
-                np.timestamp = pts[i-1].timestamp +
-                    static_cast<int64_t>(t * static_cast<float>(pts[i].timestamp - pts[i-1].timestamp));
-                result.push_back(np);
-                pts.insert(pts.begin() + static_cast<int>(i), np);
-                D = 0.0f;
-                ++i;
-            } else {
-                D += d;
-                ++i;
-            }
-        }
-        while (static_cast<int>(result.size()) < count) {
-            result.push_back(pts.back());
-        }
-        result.resize(count);
-        return result;
-    }
-
-    // Normalize to [0,1] bounding box
-    static GesturePath normalizeBB(const std::vector<GesturePoint>& points, float arcLen) {
-        GesturePath result;
-        if (points.empty()) return result;
-
-        float minX = points[0].x, maxX = points[0].x;
-        float minY = points[0].y, maxY = points[0].y;
-        for (const auto& p : points) {
-            minX = std::min(minX, p.x);
-            maxX = std::max(maxX, p.x);
-            minY = std::min(minY, p.y);
-            maxY = std::max(maxY, p.y);
-        }
-        float width  = maxX - minX;
-        float height = maxY - minY;
-
-        if (width < 0.001f && height < 0.001f) {
-            result.points.assign(points.size(), NormalizedPoint(0.5f, 0.5f, 0.5f));
-            result.aspectRatio = 1.0f;
-            result.totalArcLength = arcLen;
-            return result;
-        }
-
-        float scale = std::max(width, height);
-        result.aspectRatio = (height > 0.001f) ? (width / height) : 1.0f;
-        result.totalArcLength = arcLen;
-
-        int64_t firstTs = points.front().timestamp;
-        int64_t lastTs  = points.back().timestamp;
-        float tsRange = static_cast<float>(lastTs - firstTs);
-
-        result.points.reserve(points.size());
-        for (const auto& p : points) {
-            float nx = (p.x - minX) / scale;
-            float ny = (p.y - minY) / scale;
-            float nt = (tsRange > 0.0f)
-                ? static_cast<float>(p.timestamp - firstTs) / tsRange
-                : 0.5f;
-            result.points.emplace_back(nx, ny, nt);
-        }
-        return result;
+    static void clearPath(GesturePath& path) {
+        path.points.clear();
+        path.aspectRatio = 1.0f;
+        path.totalArcLength = 0.0f;
+        path.startKeyIndex = -1;
+        path.endKeyIndex = -1;
     }
 
     /**
-     * Generate the ideal path for a word by connecting key centers.
+     * Generate the ideal path for a word by connecting key centers, into
+     * path (reusing its storage). keyPoints is scratch.
      */
-    GesturePath generate(const std::string& word) const {
-        if (!layoutSet) return GesturePath();
+    void generate(std::string_view word, std::vector<GesturePoint>& keyPoints,
+                  GesturePath& path) const {
+        clearPath(path);
+        if (!layoutSet) return;
 
-        std::vector<GesturePoint> keyPoints;
+        keyPoints.clear();
         int32_t prevKeyIdx = -1;
         int charIdx = 0;
 
@@ -141,7 +117,7 @@ struct IdealPathGenerator::Impl {
             ++charIdx;
         }
 
-        if (keyPoints.size() < 2) return GesturePath();
+        if (keyPoints.size() < 2) return;
 
         // Compute arc length through key centers
         float arcLen = 0.0f;
@@ -150,9 +126,13 @@ struct IdealPathGenerator::Impl {
                                 keyPoints[i].x,   keyPoints[i].y);
         }
 
-        // Resample and normalize
-        auto resampled = resamplePoints(keyPoints, RESAMPLE_COUNT);
-        auto path = normalizeBB(resampled, arcLen);
+        // Resample and normalize, as PathProcessor does
+        std::array<GesturePoint, MAX_RESAMPLE_COUNT> resampled;
+        resampler::Bounds bounds = resampler::resamplePath(
+            keyPoints.front(), keyPoints.back(),
+            resampler::ArraySource(keyPoints.data(), keyPoints.size()),
+            arcLen, resampled.data(), resampleCount);
+        resampler::normalizeResampled(resampled.data(), resampleCount, bounds, arcLen, path);
 
         // Set start/end key indices
         if (!keyPoints.empty()) {
@@ -169,8 +149,313 @@ struct IdealPathGenerator::Impl {
             path.startKeyIndex = (cp0 >= 0) ? layout.findKeyByCodePoint(cp0) : -1;
             path.endKeyIndex   = (cpN >= 0) ? layout.findKeyByCodePoint(cpN) : -1;
         }
+    }
+
+    // ------------------------------------------------------------------
+    // Cache index
+    // ------------------------------------------------------------------
+
+    size_t mask() const { return table.size() - 1; }
+
+    /** Table position holding key, or the empty position where it belongs. */
+    size_t probe(std::string_view key, uint32_t hash) const {
+        size_t i = hash & mask();
+        while (table[i] != SLOT_NONE) {
+            const CacheSlot& s = slots[table[i]];
+            if (s.hash == hash && s.length == key.size() &&
+                std::memcmp(s.key, key.data(), key.size()) == 0) {
+                break;
+            }
+            i = (i + 1) & mask();
+        }
+        return i;
+    }
+
+    /** Remove slot from the table, shifting later probes back into the gap. */
+    void unindex(uint32_t slot) {
+        size_t i = probe(std::string_view(slots[slot].key, slots[slot].length), slots[slot].hash);
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & mask();
+            if (table[j] == SLOT_NONE) break;
+            size_t home = slots[table[j]].hash & mask();
+            // Move table[j] into the gap unless its home lies in (i, j]
+            bool between = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!between) {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i] = SLOT_NONE;
+    }
+
+    /** Table size for capacity: a power of two, at most half full. */
+    size_t tableSize() const {
+        size_t size = 8;
+        while (size < capacity * 2) size *= 2;
+        return capacity > 0 ? size : 0;
+    }
+
+    /** Size the table for capacity and re-index the cached slots. */
+    void rebuildTable() {
+        if (table.capacity() > tableSize()) std::vector<uint32_t>().swap(table);
+        table.assign(tableSize(), SLOT_NONE);
+        if (table.empty()) return;
+        for (size_t s = 0; s < slots.size(); ++s) {
+            if (!slots[s].occupied) continue;
+            const CacheSlot& slot = slots[s];
+            table[probe(std::string_view(slot.key, slot.length), slot.hash)] =
+                static_cast<uint32_t>(s);
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // CLOCK eviction
+    // ------------------------------------------------------------------
+
+    /**
+     * Evict the first entry the hand reaches whose referenced bit is clear,
+     * clearing bits as it passes. Returns the freed slot, whose points
+     * are overwritten by the next insert.
+     * @pre entries > 0
+     */
+    uint32_t evictOne() {
+        for (;;) {
+            if (hand >= slots.size()) hand = 0;
+            CacheSlot& s = slots[hand];
+            if (s.occupied && !s.referenced) break;
+            s.referenced = false;
+            ++hand;
+        }
+        const uint32_t victim = static_cast<uint32_t>(hand++);
+        unindex(victim);
+        CacheSlot& s = slots[victim];
+        s.occupied = false;
+        freeSlots.push_back(victim);
+        --entries;
+        ++evictions;
+        return victim;
+    }
+
+    /** Evict in CLOCK order until at most maxEntries remain. */
+    void shrinkTo(size_t maxEntries) {
+        while (entries > maxEntries) evictOne();
+    }
+
+    /**
+     * Move the cached entries to the front of the slots and slab, in slot
+     * order, and free the storage behind them. The hand keeps its place
+     * among the entries.
+     */
+    void compact() {
+        const size_t n = static_cast<size_t>(resampleCount);
+        size_t kept = 0;
+        size_t newHand = 0;
+        for (size_t s = 0; s < slots.size(); ++s) {
+            if (s == hand) newHand = kept;
+            if (!slots[s].occupied) continue;
+            if (s != kept) {
+                slots[kept] = slots[s];
+                std::copy_n(points.begin() + static_cast<std::ptrdiff_t>(s * n), n,
+                            points.begin() + static_cast<std::ptrdiff_t>(kept * n));
+            }
+            ++kept;
+        }
+        slots.resize(kept);
+        slots.shrink_to_fit();
+        points.resize(kept * n);
+        points.shrink_to_fit();
+        std::vector<uint32_t>().swap(freeSlots);
+        hand = newHand;
+        rebuildTable();
+    }
+
+    /** Drop every entry and free the slots, slab and table. */
+    void clear() {
+        std::vector<CacheSlot>().swap(slots);
+        std::vector<NormalizedPoint>().swap(points);
+        std::vector<uint32_t>().swap(freeSlots);
+        table.assign(table.size(), SLOT_NONE);
+        entries = 0;
+        hand = 0;
+    }
+
+    void setBudget(size_t bytes) {
+        budgetBytes = bytes;
+        capacity = bytes / entryBytes(resampleCount);
+        shrinkTo(capacity);
+        if (capacity == 0) {
+            clear();
+        } else if (slots.capacity() > capacity) {
+            compact();
+        } else if (slots.capacity() < capacity) {
+            slots.reserve(capacity);
+            points.reserve(capacity * static_cast<size_t>(resampleCount));
+        }
+        rebuildTable();
+    }
+
+    /** Copy path's points into slot's place in the slab, the rest into slot. */
+    void store(uint32_t slot, const GesturePath& path) {
+        CacheSlot& s = slots[slot];
+        s.aspectRatio = path.aspectRatio;
+        s.totalArcLength = path.totalArcLength;
+        s.startKeyIndex = path.startKeyIndex;
+        s.endKeyIndex = path.endKeyIndex;
+        s.pointCount = static_cast<uint8_t>(std::min(path.points.size(),
+                                                     static_cast<size_t>(resampleCount)));
+        std::copy_n(path.points.begin(), s.pointCount,
+                    points.begin() + static_cast<std::ptrdiff_t>(slot) * resampleCount);
+    }
+
+    /** Fill found from slot and return it, reusing its storage. */
+    const GesturePath& load(uint32_t slot) {
+        const CacheSlot& s = slots[slot];
+        auto first = points.begin() + static_cast<std::ptrdiff_t>(slot) * resampleCount;
+        found.points.assign(first, first + s.pointCount);
+        found.aspectRatio = s.aspectRatio;
+        found.totalArcLength = s.totalArcLength;
+        found.startKeyIndex = s.startKeyIndex;
+        found.endKeyIndex = s.endKeyIndex;
+        return found;
+    }
+
+    /**
+     * Look up key (already lowercased), generating and caching its path on
+     * a miss. New entries start unreferenced: a word has to be looked up
+     * again before the hand passes to survive, so one gesture's sweep over
+     * rarely used candidates cannot flush the frequent words.
+     */
+    const GesturePath& lookup(std::string_view key) {
+        if (capacity == 0 || key.size() > MAX_WORD_LENGTH) {
+            ++misses;
+            generate(key, keyPoints, found);
+            return found;
+        }
+
+        if (table.empty()) rebuildTable();
+        const uint32_t hash = hashKey(key);
+        size_t pos = probe(key, hash);
+        if (table[pos] != SLOT_NONE) {
+            ++hits;
+            slots[table[pos]].referenced = true;
+            return load(table[pos]);
+        }
+
+        ++misses;
+        if (entries >= capacity) {
+            evictOne();
+            pos = probe(key, hash);     // eviction may have shifted the table
+        }
+        generate(key, keyPoints, found);
+        store(insert(key, hash, pos, false), found);
+        return found;
+    }
+
+    /**
+     * Take a free slot for key, index it at table position pos (from
+     * probe()) and return it for its path to be stored. New slots grow the
+     * slots and slab together, doubling up to capacity, so a trimmed cache
+     * only takes memory back as it refills.
+     * @pre entries < capacity
+     */
+    uint32_t insert(std::string_view key, uint32_t hash, size_t pos, bool referenced) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            if (slots.size() == slots.capacity()) {
+                const size_t grown = std::min(capacity, std::max<size_t>(64, slots.size() * 2));
+                slots.reserve(grown);
+                points.reserve(grown * static_cast<size_t>(resampleCount));
+            }
+            slot = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+            points.resize(points.size() + static_cast<size_t>(resampleCount));
+        }
+
+        CacheSlot& s = slots[slot];
+        s.hash = hash;
+        s.length = static_cast<uint8_t>(key.size());
+        std::memcpy(s.key, key.data(), key.size());
+        s.occupied = true;
+        s.referenced = referenced;
+        table[pos] = slot;
+        ++entries;
+        return slot;
+    }
+
+    /**
+     * Evict an entry whose referenced bit is clear, leaving every bit as it
+     * is, and return true; false if every entry has been looked up since
+     * the hand last passed.
+     * @pre entries > 0
+     */
+    bool evictUnreferenced() {
+        for (size_t n = 0; n < slots.size(); ++n, ++hand) {
+            if (hand >= slots.size()) hand = 0;
+            const CacheSlot& s = slots[hand];
+            if (s.occupied && !s.referenced) {
+                evictOne();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Exchange cached entries (not layout, budget or counters) with other. */
+    void swapEntries(Impl& other) {
+        slots.swap(other.slots);
+        points.swap(other.points);
+        freeSlots.swap(other.freeSlots);
+        table.swap(other.table);
+        std::swap(entries, other.entries);
+        std::swap(hand, other.hand);
+    }
 
-        return path;
+    /** See IdealPathGenerator::mergeCache(). */
+    void merge(Impl& other) {
+        if (capacity == 0 || other.resampleCount != resampleCount) {
+            other.clear();
+            return;
+        }
+        // The smaller cache is moved into the larger, which is kept. If
+        // that is other's, its paths give way to those looked up here and
+        // count as looked up only once these are in.
+        const bool swapped = entries < other.entries;
+        if (swapped) {
+            other.shrinkTo(capacity);
+            swapEntries(other);
+            if (table.size() != tableSize()) rebuildTable();
+            for (CacheSlot& s : slots) s.referenced = false;
+        }
+        if (table.size() != tableSize()) rebuildTable();
+        const size_t n = static_cast<size_t>(resampleCount);
+        for (size_t os = 0; os < other.slots.size(); ++os) {
+            const CacheSlot& o = other.slots[os];
+            if (!o.occupied) continue;
+            const std::string_view key(o.key, o.length);
+            size_t pos = probe(key, o.hash);
+            if (table[pos] != SLOT_NONE) continue;
+            if (entries >= capacity) {
+                if (!evictUnreferenced()) break;
+                pos = probe(key, o.hash);
+            }
+            const uint32_t slot = insert(key, o.hash, pos, true);
+            CacheSlot& s = slots[slot];
+            s.aspectRatio = o.aspectRatio;
+            s.totalArcLength = o.totalArcLength;
+            s.startKeyIndex = o.startKeyIndex;
+            s.endKeyIndex = o.endKeyIndex;
+            s.pointCount = o.pointCount;
+            std::copy_n(other.points.begin() + static_cast<std::ptrdiff_t>(os * n), n,
+                        points.begin() + static_cast<std::ptrdiff_t>(slot * n));
+        }
+        if (swapped) {
+            for (CacheSlot& s : slots) s.referenced = s.occupied;
+        }
+        other.clear();
     }
 };
 
@@ -192,44 +477,98 @@ IdealPathGenerator& IdealPathGenerator::operator=(IdealPathGenerator&& other) no
 void IdealPathGenerator::setLayout(const KeyboardLayout& layout) {
     if (pImpl) {
         pImpl->layout = layout;
+        if (!pImpl->layout.hasLookup()) pImpl->layout.buildLookup();
         pImpl->layoutSet = true;
-        pImpl->cache.clear();
+        pImpl->clear();
     }
 }
 
-GesturePath IdealPathGenerator::getIdealPath(const std::string& word) {
-    if (!pImpl || !pImpl->layoutSet) return GesturePath();
+void IdealPathGenerator::setResampleCount(int count) {
+    if (!pImpl || count < MIN_RESAMPLE_COUNT || count > MAX_RESAMPLE_COUNT) return;
+    if (count == pImpl->resampleCount) return;
+    pImpl->resampleCount = count;
+    pImpl->clear();
+    pImpl->setBudget(pImpl->budgetBytes);
+}
+
+int IdealPathGenerator::getResampleCount() const {
+    return pImpl ? pImpl->resampleCount : RESAMPLE_COUNT;
+}
+
+GesturePath IdealPathGenerator::getIdealPath(std::string_view word) {
+    return getIdealPathRef(word);
+}
+
+const GesturePath& IdealPathGenerator::getIdealPathRef(std::string_view word) {
+    static const GesturePath empty;
+    if (!pImpl || !pImpl->layoutSet) return empty;
 
     // Lowercase the word for cache key
-    std::string key;
-    key.reserve(word.size());
+    std::string& key = pImpl->lookupKey;
+    key.clear();
     for (char ch : word) {
         key.push_back(static_cast<char>(
             std::tolower(static_cast<unsigned char>(ch))));
     }
+    return pImpl->lookup(key);
+}
 
-    auto it = pImpl->cache.find(key);
-    if (it != pImpl->cache.end()) {
-        return it->second;
-    }
-
-    GesturePath path = pImpl->generate(key);
-    pImpl->cache[key] = path;
+GesturePath IdealPathGenerator::generatePath(std::string_view word) const {
+    GesturePath path;
+    if (!pImpl || !pImpl->layoutSet) return path;
+    std::vector<GesturePoint> keyPoints;
+    pImpl->generate(word, keyPoints, path);
     return path;
 }
 
 void IdealPathGenerator::pregenerate(const std::vector<std::string>& words) {
     for (const auto& word : words) {
-        getIdealPath(word);
+        getIdealPathRef(word);
     }
 }
 
+void IdealPathGenerator::mergeCache(IdealPathGenerator&& other) {
+    if (!pImpl || !other.pImpl || other.pImpl == pImpl || !pImpl->layoutSet) return;
+    pImpl->merge(*other.pImpl);
+}
+
 void IdealPathGenerator::clearCache() {
-    if (pImpl) pImpl->cache.clear();
+    if (pImpl) pImpl->clear();
 }
 
 size_t IdealPathGenerator::cacheSize() const {
-    return pImpl ? pImpl->cache.size() : 0;
+    return pImpl ? pImpl->entries : 0;
+}
+
+void IdealPathGenerator::setCacheBudget(size_t bytes) {
+    if (pImpl) pImpl->setBudget(bytes);
+}
+
+void IdealPathGenerator::trimCache(size_t bytes) {
+    if (!pImpl) return;
+    if (bytes == 0) {
+        pImpl->clear();
+    } else {
+        pImpl->shrinkTo(bytes / entryBytes(pImpl->resampleCount));
+        pImpl->compact();
+    }
+}
+
+PathCacheStats IdealPathGenerator::getCacheStats() const {
+    PathCacheStats stats;
+    if (!pImpl) return stats;
+    stats.entries = pImpl->entries;
+    stats.capacity = pImpl->capacity;
+    stats.bytes = pImpl->entries * entryBytes(pImpl->resampleCount);
+    stats.reservedBytes = pImpl->slots.capacity() * sizeof(CacheSlot) +
+                          pImpl->points.capacity() * sizeof(NormalizedPoint) +
+                          (pImpl->table.capacity() + pImpl->freeSlots.capacity()) * sizeof(uint32_t);
+    stats.budgetBytes = pImpl->budgetBytes;
+    stats.entryBytes = entryBytes(pImpl->resampleCount);
+    stats.hits = pImpl->hits;
+    stats.misses = pImpl->misses;
+    stats.evictions = pImpl->evictions;
+    return stats;
 }
 
 } // namespace swipetype
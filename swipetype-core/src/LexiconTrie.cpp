@@ -0,0 +1,216 @@
+#include "swipetype/LexiconTrie.h"
+#include <algorithm>
+#include <cstring>
+
+namespace swipetype {
+
+namespace {
+
+constexpr int LETTERS = 26;
+
+/** "No later key" in the next-key table; above every key position. */
+constexpr uint8_t NO_KEY = 0xFF;
+static_assert(LEXICON_MAX_KEYS < NO_KEY, "key positions must fit below NO_KEY");
+
+struct Node {
+    uint32_t firstChild = 0;   // children are nodes[firstChild, firstChild + childCount)
+    uint32_t firstEntry = 0;   // words ending here are entries[firstEntry, + entryCount)
+    uint32_t entryCount = 0;
+    uint8_t childCount = 0;
+    uint8_t letter = 0;        // 0 = 'a'; unused for the root
+};
+
+/** Letter index of an ASCII byte, or -1. */
+inline int letterIndex(char ch) {
+    if (ch >= 'a' && ch <= 'z') return ch - 'a';
+    if (ch >= 'A' && ch <= 'Z') return ch - 'A';
+    return -1;
+}
+
+} // namespace
+
+struct LexiconTrie::Impl {
+    std::vector<Node> nodes;       // depth-first; nodes[0] is the root
+    std::vector<uint32_t> entries;
+    bool built = false;
+
+    // Build state: letters of entry i are keyLetters[keyStart[i], keyStart[i + 1])
+    std::vector<uint8_t> keyLetters;
+    std::vector<uint32_t> keyStart;
+    std::vector<uint32_t> order;
+
+    size_t keyLength(uint32_t entry) const { return keyStart[entry + 1] - keyStart[entry]; }
+    uint8_t keyLetter(uint32_t entry, size_t depth) const {
+        return keyLetters[keyStart[entry] + depth];
+    }
+
+    /** Fill node n from order[lo, hi), whose keys share their first depth letters. */
+    void buildNode(uint32_t n, size_t lo, size_t hi, size_t depth) {
+        // Keys that end here sort before their extensions
+        size_t mid = lo;
+        while (mid < hi && keyLength(order[mid]) == depth) ++mid;
+        nodes[n].firstEntry = static_cast<uint32_t>(entries.size());
+        nodes[n].entryCount = static_cast<uint32_t>(mid - lo);
+        entries.insert(entries.end(), order.begin() + static_cast<std::ptrdiff_t>(lo),
+                       order.begin() + static_cast<std::ptrdiff_t>(mid));
+
+        // One child per distinct next letter, allocated together so they are
+        // contiguous, then filled one subtree at a time
+        uint8_t childCount = 0;
+        for (size_t i = mid; i < hi; ++i) {
+            if (i == mid || keyLetter(order[i], depth) != keyLetter(order[i - 1], depth)) {
+                ++childCount;
+            }
+        }
+        const auto first = static_cast<uint32_t>(nodes.size());
+        nodes[n].firstChild = first;
+        nodes[n].childCount = childCount;
+        nodes.resize(nodes.size() + childCount);
+
+        uint32_t child = first;
+        for (size_t begin = mid; begin < hi; ++child) {
+            const uint8_t letter = keyLetter(order[begin], depth);
+            size_t end = begin + 1;
+            while (end < hi && keyLetter(order[end], depth) == letter) ++end;
+            nodes[child].letter = letter;
+            buildNode(child, begin, end, depth + 1);
+            begin = end;
+        }
+    }
+
+    /** State of one collect() call. */
+    struct Walk {
+        const uint32_t* nearLetters;
+        size_t count;
+        const uint8_t* next;       // next[p * 26 + c]: first key >= p near c
+        std::vector<uint32_t>* out;
+        uint32_t visited;
+    };
+
+    /** Visit node n, whose letter was assigned to key pos. */
+    void visit(Walk& walk, uint32_t n, size_t pos) const {
+        ++walk.visited;
+        const Node& node = nodes[n];
+        if (node.entryCount > 0 && (walk.nearLetters[walk.count - 1] >> node.letter) & 1u) {
+            const uint32_t* e = entries.data() + node.firstEntry;
+            walk.out->insert(walk.out->end(), e, e + node.entryCount);
+        }
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+            const uint8_t letter = nodes[c].letter;
+            // A repeated letter may stay on the same key; others move on
+            const size_t from = letter == node.letter ? pos : pos + 1;
+            const uint8_t key = walk.next[from * LETTERS + letter];
+            if (key != NO_KEY) visit(walk, c, key);
+        }
+    }
+};
+
+LexiconTrie::LexiconTrie() : pImpl(new Impl()) {}
+LexiconTrie::~LexiconTrie() { delete pImpl; }
+
+LexiconTrie::LexiconTrie(LexiconTrie&& other) noexcept
+    : pImpl(other.pImpl) { other.pImpl = nullptr; }
+
+LexiconTrie& LexiconTrie::operator=(LexiconTrie&& other) noexcept {
+    if (this != &other) {
+        delete pImpl;
+        pImpl = other.pImpl;
+        other.pImpl = nullptr;
+    }
+    return *this;
+}
+
+bool LexiconTrie::build(const DictionaryLoader& dict) {
+    if (!pImpl) return false;
+    clear();
+    if (!dict.isLoaded()) return false;
+
+    const uint32_t count = dict.getEntryCount();
+    pImpl->keyStart.assign(size_t(count) + 1, 0);
+    pImpl->order.clear();
+    pImpl->order.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        bool hasLetter = false;
+        for (char ch : dict.getEntry(i).word) {
+            int letter = letterIndex(ch);
+            if (letter < 0) continue;
+            pImpl->keyLetters.push_back(static_cast<uint8_t>(letter));
+            hasLetter = true;
+        }
+        pImpl->keyStart[i + 1] = static_cast<uint32_t>(pImpl->keyLetters.size());
+        if (hasLetter) pImpl->order.push_back(i);
+    }
+
+    // Sort by key, ties by entry index so each node lists its words in order
+    const Impl& impl = *pImpl;
+    std::sort(pImpl->order.begin(), pImpl->order.end(), [&impl](uint32_t a, uint32_t b) {
+        const uint8_t* ka = impl.keyLetters.data() + impl.keyStart[a];
+        const uint8_t* kb = impl.keyLetters.data() + impl.keyStart[b];
+        const size_t la = impl.keyLength(a), lb = impl.keyLength(b);
+        int cmp = std::memcmp(ka, kb, std::min(la, lb));
+        if (cmp != 0) return cmp < 0;
+        if (la != lb) return la < lb;
+        return a < b;
+    });
+
+    pImpl->nodes.assign(1, Node());
+    pImpl->entries.reserve(pImpl->order.size());
+    pImpl->buildNode(0, 0, pImpl->order.size(), 0);
+    pImpl->nodes.shrink_to_fit();
+
+    std::vector<uint8_t>().swap(pImpl->keyLetters);
+    std::vector<uint32_t>().swap(pImpl->keyStart);
+    std::vector<uint32_t>().swap(pImpl->order);
+    pImpl->built = true;
+    return true;
+}
+
+void LexiconTrie::clear() {
+    if (!pImpl) return;
+    std::vector<Node>().swap(pImpl->nodes);
+    std::vector<uint32_t>().swap(pImpl->entries);
+    pImpl->built = false;
+}
+
+bool LexiconTrie::isBuilt() const {
+    return pImpl && pImpl->built;
+}
+
+bool LexiconTrie::collect(const uint32_t* nearLetters, size_t count, std::vector<uint32_t>& out,
+                          uint32_t* nodesVisited) const {
+    out.clear();
+    if (nodesVisited) *nodesVisited = 0;
+    if (!isBuilt() || !nearLetters || count == 0 || count > LEXICON_MAX_KEYS) return false;
+
+    // next[p * 26 + c] = first key at or after p near letter c
+    uint8_t next[(LEXICON_MAX_KEYS + 1) * LETTERS];
+    std::memset(next + count * LETTERS, NO_KEY, LETTERS);
+    for (size_t p = count; p-- > 0;) {
+        for (int c = 0; c < LETTERS; ++c) {
+            next[p * LETTERS + c] = ((nearLetters[p] >> c) & 1u)
+                ? static_cast<uint8_t>(p)
+                : next[(p + 1) * LETTERS + c];
+        }
+    }
+
+    Impl::Walk walk{nearLetters, count, next, &out, 1};
+    const Node& root = pImpl->nodes[0];
+    for (uint32_t c = root.firstChild; c < root.firstChild + root.childCount; ++c) {
+        // The first letter belongs to the first key
+        if ((nearLetters[0] >> pImpl->nodes[c].letter) & 1u) pImpl->visit(walk, c, 0);
+    }
+    if (nodesVisited) *nodesVisited = walk.visited;
+    return true;
+}
+
+size_t LexiconTrie::nodeCount() const {
+    return pImpl ? pImpl->nodes.size() : 0;
+}
+
+size_t LexiconTrie::memoryUsage() const {
+    if (!pImpl) return 0;
+    return pImpl->nodes.capacity() * sizeof(Node) +
+           pImpl->entries.capacity() * sizeof(uint32_t);
+}
+
+} // namespace swipetype
@@ -1,5 +1,6 @@
 #include "swipetype/PathProcessor.h"
 #include "swipetype/SwipeTypeTypes.h"
+#include "PathResampler.h"
 #include <cmath>
 #include <algorithm>
 #include <numeric>
@@ -15,152 +16,74 @@ struct PathProcessor::Impl {
     float minPointDistance = MIN_POINT_DISTANCE_DP;
     int resampleCount = RESAMPLE_COUNT;
 
+    // Reused by every normalize() call, so steady-state calls do not allocate
+    mutable std::vector<GesturePoint> keptPoints;
+    mutable std::vector<float> keptLengths;
+    mutable std::vector<GesturePoint> resampled;
+
     /**
-     * Remove consecutive points that are closer than minPointDistance.
-     * Always keeps the first and last points.
+     * Append a point, removing consecutive points that are closer than
+     * minPointDistance. Always keeps the first and latest points: the
+     * previous latest point is kept only if it is far enough from the last
+     * kept one.
      */
-    std::vector<GesturePoint> deduplicate(const std::vector<GesturePoint>& points) const {
-        if (points.size() <= 2) return points;
-
-        std::vector<GesturePoint> result;
-        result.reserve(points.size());
-        result.push_back(points[0]);
-
-        for (size_t i = 1; i < points.size() - 1; ++i) {
-            const GesturePoint& last = result.back();
-            const GesturePoint& cur  = points[i];
-            float dx = cur.x - last.x;
-            float dy = cur.y - last.y;
-            float dist = std::sqrt(dx * dx + dy * dy);
+    void append(DeduplicatedPath& path, const GesturePoint& point) const {
+        ++path.rawCount;
+        std::vector<GesturePoint>& kept = path.points;
+        if (kept.size() >= 2) {
+            const GesturePoint& last = kept[kept.size() - 2];
+            float dist = resampler::segmentLength(last, kept.back());
             if (dist >= minPointDistance) {
-                result.push_back(cur);
+                path.keptArcLength += dist;
+            } else {
+                kept.pop_back();
             }
         }
-
-        // Always include the last point
-        result.push_back(points.back());
-        return result;
+        kept.push_back(point);
     }
 
     /**
-     * Compute total arc length of a sequence of points.
+     * Deduplicate raw as append() would into keptPoints, recording each kept
+     * point's distance from the previous one. Returns the arc length.
      */
-    float computeArcLength(const std::vector<GesturePoint>& points) const {
-        float totalLength = 0.0f;
-        for (size_t i = 1; i < points.size(); ++i) {
-            float dx = points[i].x - points[i - 1].x;
-            float dy = points[i].y - points[i - 1].y;
-            totalLength += std::sqrt(dx * dx + dy * dy);
-        }
-        return totalLength;
-    }
-
-    /**
-     * Resample to exactly resampleCount equidistant points along the path.
-     * Based on $1 Unistroke Recognizer algorithm (Wobbrock et al., 2007).
-     */
-    std::vector<GesturePoint> resample(const std::vector<GesturePoint>& points) const {
-        if (points.size() < 2) return points;
-
-        float totalLen = computeArcLength(points);
-        if (totalLen < 1e-6f) {
-            // Degenerate path: return duplicated first point
-            std::vector<GesturePoint> filled(resampleCount, points[0]);
-            return filled;
-        }
-
-        float interval = totalLen / static_cast<float>(resampleCount - 1);
-        std::vector<GesturePoint> result;
-        result.reserve(resampleCount);
-        result.push_back(points[0]);
-
-        float D = 0.0f;
-        size_t i = 1;
-        // Copy to allow modification during traversal
-        std::vector<GesturePoint> pts = points;
-
-        while (i < pts.size() && static_cast<int>(result.size()) < resampleCount - 1) {
-            float dx = pts[i].x - pts[i - 1].x;
-            float dy = pts[i].y - pts[i - 1].y;
-            float d = std::sqrt(dx * dx + dy * dy);
-
-            if (D + d >= interval) {
-                float t = (interval - D) / d;
-                GesturePoint newPt;
-                newPt.x = pts[i - 1].x + t * dx;
-                newPt.y = pts[i - 1].y + t * dy;
-                // Linear interpolation of timestamp
-                newPt.timestamp = pts[i - 1].timestamp +
-                    static_cast<int64_t>(t * static_cast<float>(pts[i].timestamp - pts[i - 1].timestamp));
-                result.push_back(newPt);
-
-                // Insert new point back and re-process current segment
-                pts.insert(pts.begin() + static_cast<int>(i), newPt);
-                D = 0.0f;
-                ++i; // skip to segment starting at newPt
-            } else {
-                D += d;
-                ++i;
+    float deduplicate(const std::vector<GesturePoint>& raw) const {
+        keptPoints.clear();
+        keptLengths.clear();
+        keptPoints.push_back(raw.front());
+        keptLengths.push_back(0.0f);
+
+        float arcLength = 0.0f;
+        for (size_t i = 1; i + 1 < raw.size(); ++i) {
+            float dist = resampler::segmentLength(keptPoints.back(), raw[i]);
+            if (dist >= minPointDistance) {
+                arcLength += dist;
+                keptPoints.push_back(raw[i]);
+                keptLengths.push_back(dist);
             }
         }
-
-        // Fill remaining (floating-point drift)
-        while (static_cast<int>(result.size()) < resampleCount) {
-            result.push_back(pts.back());
-        }
-        // Truncate if over
-        result.resize(resampleCount);
-        return result;
+        float tail = resampler::segmentLength(keptPoints.back(), raw.back());
+        keptPoints.push_back(raw.back());
+        keptLengths.push_back(tail);
+        return arcLength + tail;
     }
 
-    /**
-     * Normalize coordinates to [0,1] bounding box preserving aspect ratio.
-     */
-    GesturePath normalizeBoundingBox(const std::vector<GesturePoint>& points,
-                                     float totalArcLength) const {
-        GesturePath result;
-
-        if (points.empty()) return result;
-
-        float minX = points[0].x, maxX = points[0].x;
-        float minY = points[0].y, maxY = points[0].y;
-        for (const auto& p : points) {
-            minX = std::min(minX, p.x);
-            maxX = std::max(maxX, p.x);
-            minY = std::min(minY, p.y);
-            maxY = std::max(maxY, p.y);
-        }
-
-        float width  = maxX - minX;
-        float height = maxY - minY;
-
-        // Degenerate: near-point path
-        if (width < 0.001f && height < 0.001f) {
-            result.points.resize(points.size(), NormalizedPoint(0.5f, 0.5f, 0.5f));
-            result.aspectRatio = 1.0f;
-            result.totalArcLength = totalArcLength;
-            return result;
-        }
-
-        float scale = std::max(width, height);
-        result.aspectRatio = (height > 0.001f) ? (width / height) : 1.0f;
-        result.totalArcLength = totalArcLength;
-
-        int64_t firstTs = points.front().timestamp;
-        int64_t lastTs  = points.back().timestamp;
-        float tsRange = static_cast<float>(lastTs - firstTs);
-
-        result.points.reserve(points.size());
-        for (const auto& p : points) {
-            float nx = (p.x - minX) / scale;
-            float ny = (p.y - minY) / scale;
-            float nt = (tsRange > 0.0f)
-                ? static_cast<float>(p.timestamp - firstTs) / tsRange
-                : 0.5f;
-            result.points.emplace_back(nx, ny, nt);
-        }
+    /** Resample from source and normalize into result. */
+    template <typename Source>
+    void resampleAndNormalize(const GesturePoint& first, const GesturePoint& last,
+                              Source&& source, float arcLength, GesturePath& result) const {
+        resampled.resize(static_cast<size_t>(resampleCount));
+        resampler::Bounds bounds = resampler::resamplePath(
+            first, last, source, arcLength, resampled.data(), resampleCount);
+        resampler::normalizeResampled(resampled.data(), resampleCount, bounds, arcLength, result);
+    }
 
-        return result;
+    /** Clear result to the empty (invalid) path, keeping its storage. */
+    static void clearPath(GesturePath& result) {
+        result.points.clear();
+        result.aspectRatio = 1.0f;
+        result.totalArcLength = 0.0f;
+        result.startKeyIndex = -1;
+        result.endKeyIndex = -1;
     }
 };
 
@@ -187,20 +110,61 @@ PathProcessor& PathProcessor::operator=(PathProcessor&& other) noexcept {
 
 GesturePath PathProcessor::normalize(const RawGesturePath& raw,
                                       const KeyboardLayout& layout) const {
-    if (raw.isEmpty()) return GesturePath();
+    GesturePath path;
+    normalize(raw, layout, path);
+    return path;
+}
 
-    auto deduped = pImpl->deduplicate(raw.points);
-    if (deduped.size() < 2) return GesturePath();
+void PathProcessor::normalize(const RawGesturePath& raw, const KeyboardLayout& layout,
+                              GesturePath& out) const {
+    Impl::clearPath(out);
+    const auto& points = raw.points;
+    if (!pImpl || points.size() < static_cast<size_t>(MIN_GESTURE_POINTS)) return;
+
+    // One pass deduplicates and measures, one resamples with the measured
+    // segment lengths, one normalizes the resampled points
+    float arcLen = pImpl->deduplicate(points);
+    const auto& kept = pImpl->keptPoints;
+    pImpl->resampleAndNormalize(kept.front(), kept.back(),
+                                resampler::ArraySource(kept.data(), kept.size(),
+                                                       pImpl->keptLengths.data()),
+                                arcLen, out);
+
+    // Determine start/end keys from original (not resampled) endpoints,
+    // which deduplication always keeps
+    out.startKeyIndex = layout.findNearestKey(points.front().x, points.front().y);
+    out.endKeyIndex   = layout.findNearestKey(points.back().x,  points.back().y);
+}
+
+void PathProcessor::appendPoint(DeduplicatedPath& path, const GesturePoint& point) const {
+    if (pImpl) pImpl->append(path, point);
+}
+
+GesturePath PathProcessor::normalize(const DeduplicatedPath& path,
+                                      const KeyboardLayout& layout) const {
+    GesturePath result;
+    normalize(path, layout, result);
+    return result;
+}
 
-    float arcLen = pImpl->computeArcLength(deduped);
-    auto resampled = pImpl->resample(deduped);
-    auto path = pImpl->normalizeBoundingBox(resampled, arcLen);
+void PathProcessor::normalize(const DeduplicatedPath& path, const KeyboardLayout& layout,
+                              GesturePath& out) const {
+    Impl::clearPath(out);
+    const auto& deduped = path.points;
+    if (!pImpl || path.rawCount < static_cast<size_t>(MIN_GESTURE_POINTS) || deduped.size() < 2) {
+        return;
+    }
 
-    // Determine start/end keys from original (not resampled) endpoints
-    path.startKeyIndex = layout.findNearestKey(raw.points.front().x, raw.points.front().y);
-    path.endKeyIndex   = layout.findNearestKey(raw.points.back().x,  raw.points.back().y);
+    float arcLen = path.keptArcLength +
+                   resampler::segmentLength(deduped[deduped.size() - 2], deduped.back());
+    pImpl->resampleAndNormalize(deduped.front(), deduped.back(),
+                                resampler::ArraySource(deduped.data(), deduped.size()),
+                                arcLen, out);
 
-    return path;
+    // Determine start/end keys from original (not resampled) endpoints,
+    // which deduplication always keeps
+    out.startKeyIndex = layout.findNearestKey(deduped.front().x, deduped.front().y);
+    out.endKeyIndex   = layout.findNearestKey(deduped.back().x,  deduped.back().y);
 }
 
 void PathProcessor::setMinPointDistance(float distanceDp) {
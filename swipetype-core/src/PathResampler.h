@@ -0,0 +1,183 @@
+#pragma once
+
+#include "swipetype/GesturePath.h"
+#include "swipetype/GesturePoint.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file PathResampler.h
+ * @brief Resampling and bounding-box normalization shared by PathProcessor
+ *        and IdealPathGenerator (internal).
+ *
+ * resamplePath() walks its input once, writing the resampled points into a
+ * caller-provided buffer and tracking their bounding box as it goes.
+ * normalizeResampled() then makes one pass over those points. Segment
+ * lengths already measured by deduplication are passed in rather than
+ * recomputed, so a long stroke costs one square root per point.
+ */
+
+namespace swipetype {
+namespace resampler {
+
+inline float segmentLength(const GesturePoint& a, const GesturePoint& b) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+/** Bounding box of a resampled path. */
+struct Bounds {
+    float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
+
+    explicit Bounds(const GesturePoint& p) : minX(p.x), minY(p.y), maxX(p.x), maxY(p.y) {}
+
+    void add(const GesturePoint& p) {
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+};
+
+/**
+ * Point source over a stored array: yields points[1..count) and each one's
+ * distance from its predecessor, taken from lengths when given.
+ */
+struct ArraySource {
+    const GesturePoint* points;
+    const float* lengths;
+    size_t count;
+    size_t next = 1;
+
+    ArraySource(const GesturePoint* points, size_t count, const float* lengths = nullptr)
+        : points(points), lengths(lengths), count(count) {}
+
+    bool operator()(GesturePoint& out, float& length) {
+        if (next >= count) return false;
+        out = points[next];
+        length = lengths ? lengths[next] : segmentLength(points[next - 1], points[next]);
+        ++next;
+        return true;
+    }
+};
+
+/**
+ * Resample a path to `count` points spaced evenly along its arc.
+ * Based on $1 Unistroke Recognizer algorithm (Wobbrock et al., 2007).
+ *
+ * Each emitted point becomes the start of the remaining segment, as if it
+ * had been inserted into the input; prev tracks that start instead.
+ *
+ * @param first      First input point.
+ * @param last       Last input point, used to fill the tail.
+ * @param source     Yields the remaining input points in order, ending with
+ *                   last, each with its distance from the previous input
+ *                   point: bool source(GesturePoint&, float&).
+ * @param arcLength  Total arc length of the input in dp.
+ * @param out        Buffer of at least count points.
+ * @param count      Number of output points, >= 2.
+ * @return Bounding box of the output points.
+ */
+template <typename Source>
+Bounds resamplePath(const GesturePoint& first, const GesturePoint& last, Source&& source,
+                    float arcLength, GesturePoint* out, int count) {
+    Bounds bounds(first);
+    if (arcLength < 1e-6f) {
+        // Degenerate path: duplicated first point
+        std::fill(out, out + count, first);
+        return bounds;
+    }
+
+    const float interval = arcLength / static_cast<float>(count - 1);
+    int emitted = 0;
+    out[emitted++] = first;
+
+    float D = 0.0f;
+    GesturePoint prev = first;
+    bool prevIsInput = true;    // else prev was emitted mid-segment
+    GesturePoint cur;
+    float curLength = 0.0f;
+    bool more = source(cur, curLength);
+
+    while (more && emitted < count - 1) {
+        float dx = cur.x - prev.x;
+        float dy = cur.y - prev.y;
+        float d = prevIsInput ? curLength : std::sqrt(dx * dx + dy * dy);
+
+        if (D + d >= interval) {
+            float t = (interval - D) / d;
+            GesturePoint newPt;
+            newPt.x = prev.x + t * dx;
+            newPt.y = prev.y + t * dy;
+            // Linear interpolation of timestamp
+            newPt.timestamp = prev.timestamp +
+                static_cast<int64_t>(t * static_cast<float>(cur.timestamp - prev.timestamp));
+            out[emitted++] = newPt;
+            bounds.add(newPt);
+
+            // Re-process the rest of the current segment from newPt
+            prev = newPt;
+            prevIsInput = false;
+            D = 0.0f;
+        } else {
+            D += d;
+            prev = cur;
+            prevIsInput = true;
+            more = source(cur, curLength);
+        }
+    }
+
+    // Fill remaining (floating-point drift)
+    while (emitted < count) {
+        out[emitted++] = last;
+    }
+    bounds.add(last);
+    return bounds;
+}
+
+/**
+ * Normalize resampled points into result: coordinates to a [0,1] bounding
+ * box preserving aspect ratio, time to [0,1]. Writes every field of result
+ * except the key indices, which it resets, and reuses its point storage.
+ */
+inline void normalizeResampled(const GesturePoint* points, int count, const Bounds& bounds,
+                               float arcLength, GesturePath& result) {
+    result.points.clear();
+    result.aspectRatio = 1.0f;
+    result.totalArcLength = arcLength;
+    result.startKeyIndex = -1;
+    result.endKeyIndex = -1;
+
+    float width  = bounds.maxX - bounds.minX;
+    float height = bounds.maxY - bounds.minY;
+
+    // Degenerate: near-point path
+    if (width < 0.001f && height < 0.001f) {
+        result.points.assign(static_cast<size_t>(count), NormalizedPoint(0.5f, 0.5f, 0.5f));
+        return;
+    }
+
+    float scale = std::max(width, height);
+    result.aspectRatio = (height > 0.001f) ? (width / height) : 1.0f;
+
+    int64_t firstTs = points[0].timestamp;
+    int64_t lastTs  = points[count - 1].timestamp;
+    float tsRange = static_cast<float>(lastTs - firstTs);
+
+    result.points.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        const GesturePoint& p = points[i];
+        float nx = (p.x - bounds.minX) / scale;
+        float ny = (p.y - bounds.minY) / scale;
+        float nt = (tsRange > 0.0f)
+            ? static_cast<float>(p.timestamp - firstTs) / tsRange
+            : 0.5f;
+        result.points.emplace_back(nx, ny, nt);
+    }
+}
+
+} // namespace resampler
+} // namespace swipetype
@@ -2,21 +2,295 @@
 #include "swipetype/SwipeTypeTypes.h"
 #include <cmath>
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <cfloat>
+#include <limits>
+
+#if !defined(SWIPETYPE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define SWIPETYPE_DTW_SSE2 1
+#elif !defined(SWIPETYPE_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SWIPETYPE_DTW_NEON 1
+#endif
+
+// Keep dx*dx + dy*dy as two roundings in every code path, so the vector
+// lanes and the scalar tail/fallback produce bit-identical costs. GCC
+// ignores the pragma and gets -ffp-contract=off from CMakeLists.txt.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
 
 namespace swipetype {
 
+namespace {
+
+constexpr float DTW_INF = std::numeric_limits<float>::infinity();
+
+/**
+ * Euclidean distance between two points (x,y only).
+ */
+inline float pointDistance(float ax, float ay, float bx, float by) {
+    float dx = ax - bx;
+    float dy = ay - by;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+/**
+ * Costs of cells (i, jMin..jMax) for one gesture point against the template.
+ * out[k] receives the cost of column jMin + k.
+ */
+inline void rowCosts(float gxi, float gyi, const float* tx, const float* ty,
+                     int jMin, int jMax, float* out) {
+    int j = jMin;
+#if defined(SWIPETYPE_DTW_SSE2)
+    const __m128 px = _mm_set1_ps(gxi);
+    const __m128 py = _mm_set1_ps(gyi);
+    for (; j + 3 <= jMax; j += 4) {
+        __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(tx + j));
+        __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(ty + j));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        _mm_storeu_ps(out + (j - jMin), _mm_sqrt_ps(d2));
+    }
+#elif defined(SWIPETYPE_DTW_NEON)
+    const float32x4_t px = vdupq_n_f32(gxi);
+    const float32x4_t py = vdupq_n_f32(gyi);
+    for (; j + 3 <= jMax; j += 4) {
+        float32x4_t dx = vsubq_f32(px, vld1q_f32(tx + j));
+        float32x4_t dy = vsubq_f32(py, vld1q_f32(ty + j));
+        float32x4_t d2 = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+        vst1q_f32(out + (j - jMin), vsqrtq_f32(d2));
+    }
+#endif
+    for (; j <= jMax; ++j) {
+        out[j - jMin] = pointDistance(gxi, gyi, tx[j], ty[j]);
+    }
+}
+
+/**
+ * out[k] = min(prev[k + 1], prev[k]) for k in [0, count): the best of the
+ * vertical and diagonal predecessors of each band cell.
+ */
+inline void rowPredecessors(const float* prev, int count, float* out) {
+    int k = 0;
+#if defined(SWIPETYPE_DTW_SSE2)
+    for (; k + 4 <= count; k += 4) {
+        _mm_storeu_ps(out + k, _mm_min_ps(_mm_loadu_ps(prev + k + 1), _mm_loadu_ps(prev + k)));
+    }
+#elif defined(SWIPETYPE_DTW_NEON)
+    for (; k + 4 <= count; k += 4) {
+        vst1q_f32(out + k, vminq_f32(vld1q_f32(prev + k + 1), vld1q_f32(prev + k)));
+    }
+#endif
+    for (; k < count; ++k) {
+        out[k] = std::min(prev[k + 1], prev[k]);
+    }
+}
+
+/**
+ * Distance of each template point to the query envelope box of its column,
+ * written to out[0..q.count). Per axis the gap is
+ * max(lower - t, t - upper, 0), which never exceeds |g - t| for any gesture
+ * point g inside the box, with the same roundings as pointDistance().
+ */
+inline void envelopeDistances(const DTWQuery& q, const float* tx, const float* ty, float* out) {
+    const int N = q.count;
+    int j = 0;
+#if defined(SWIPETYPE_DTW_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    for (; j + 4 <= N; j += 4) {
+        __m128 x = _mm_loadu_ps(tx + j);
+        __m128 y = _mm_loadu_ps(ty + j);
+        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&q.lowerX[j]), x),
+                                          _mm_sub_ps(x, _mm_loadu_ps(&q.upperX[j]))), zero);
+        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&q.lowerY[j]), y),
+                                          _mm_sub_ps(y, _mm_loadu_ps(&q.upperY[j]))), zero);
+        _mm_storeu_ps(out + j, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+    }
+#elif defined(SWIPETYPE_DTW_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; j + 4 <= N; j += 4) {
+        float32x4_t x = vld1q_f32(tx + j);
+        float32x4_t y = vld1q_f32(ty + j);
+        float32x4_t dx = vmaxq_f32(vmaxq_f32(vsubq_f32(vld1q_f32(&q.lowerX[j]), x),
+                                             vsubq_f32(x, vld1q_f32(&q.upperX[j]))), zero);
+        float32x4_t dy = vmaxq_f32(vmaxq_f32(vsubq_f32(vld1q_f32(&q.lowerY[j]), y),
+                                             vsubq_f32(y, vld1q_f32(&q.upperY[j]))), zero);
+        vst1q_f32(out + j, vsqrtq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy))));
+    }
+#endif
+    for (; j < N; ++j) {
+        float dx = std::max(std::max(q.lowerX[j] - tx[j], tx[j] - q.upperX[j]), 0.0f);
+        float dy = std::max(std::max(q.lowerY[j] - ty[j], ty[j] - q.upperY[j]), 0.0f);
+        out[j] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+/** Sum of the distances between the points of two signatures. */
+inline float signatureDistanceSum(const PathSignature& a, const PathSignature& b) {
+    static_assert(SIGNATURE_POINTS % 4 == 0, "signatures are scored four points at a time");
+#if defined(SWIPETYPE_DTW_SSE2)
+    __m128 sum = _mm_setzero_ps();
+    for (int j = 0; j < SIGNATURE_POINTS; j += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&a.x[j]), _mm_loadu_ps(&b.x[j]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&a.y[j]), _mm_loadu_ps(&b.y[j]));
+        sum = _mm_add_ps(sum, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(SWIPETYPE_DTW_NEON)
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int j = 0; j < SIGNATURE_POINTS; j += 4) {
+        float32x4_t dx = vsubq_f32(vld1q_f32(&a.x[j]), vld1q_f32(&b.x[j]));
+        float32x4_t dy = vsubq_f32(vld1q_f32(&a.y[j]), vld1q_f32(&b.y[j]));
+        sum = vaddq_f32(sum, vsqrtq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy))));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    // Same lane grouping as the vector paths, so results match them
+    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int j = 0; j < SIGNATURE_POINTS; ++j) {
+        lanes[j % 4] += pointDistance(a.x[j], a.y[j], b.x[j], b.y[j]);
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+}
+
+/** Number of set bits. */
+inline int bitCount(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return static_cast<int>((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+/**
+ * Banded DTW over n points in SoA form with band width w. Returns the raw
+ * (unnormalized) accumulated cost, or infinity if the end is unreachable or
+ * the per-point cost is certain to exceed threshold.
+ *
+ * Rows hold D[i][j] at position j + 1; position 0 is the D[i][-1] border.
+ * Cells outside the band are +inf, so min/+ need no sentinel branches.
+ * The row before row 0 is all +inf except D[-1][-1] = 0, which makes row 0
+ * the ordinary recurrence. Only the two border cells next to the band are
+ * reset per row: those are the only stale cells the next row can read.
+ *
+ * A FixedN or FixedW above 0 replaces n or w with a constant. The rows
+ * between the first and last W, whose band is not clipped by either end of
+ * the template, are then 2W + 1 cells wide at compile time, and the
+ * compiler unrolls their cost, predecessor and recurrence loops.
+ */
+template <int FixedN, int FixedW>
+float bandedDTW(const float* gx, const float* gy, const float* tx, const float* ty,
+                int n, int w, float threshold) {
+    constexpr int CAPACITY = FixedN > 0 ? FixedN : MAX_RESAMPLE_COUNT;
+    const int N = FixedN > 0 ? FixedN : n;
+    const int W = FixedW > 0 ? FixedW : w;
+    std::array<float, CAPACITY + 2> rowA;
+    std::array<float, CAPACITY + 2> rowB;
+    std::array<float, CAPACITY> cost;
+    std::array<float, CAPACITY> pred;
+    std::fill_n(rowA.data(), N + 2, DTW_INF);
+    std::fill_n(rowB.data(), N + 2, DTW_INF);
+    rowA[0] = 0.0f;
+
+    float* prev = rowA.data();
+    float* curr = rowB.data();
+
+    // Row i over the count band cells from column jMin; false once every
+    // path through it is certain to exceed threshold
+    auto row = [&](int i, int jMin, int count) {
+        const int jMax = jMin + count - 1;
+        rowCosts(gx[i], gy[i], tx, ty, jMin, jMax, cost.data());
+        rowPredecessors(prev + jMin, count, pred.data());
+
+        // Horizontal predecessor is the only sequential dependency
+        float left = DTW_INF;
+        float rowMin = DTW_INF;
+        curr[jMin] = DTW_INF;
+        for (int k = 0; k < count; ++k) {
+            left = cost[k] + std::min(pred[k], left);
+            curr[jMin + 1 + k] = left;
+            rowMin = std::min(rowMin, left);
+        }
+        if (jMax + 2 <= N) curr[jMax + 2] = DTW_INF;
+        std::swap(prev, curr);
+
+        // Every path crosses this row and costs are non-negative
+        return !(rowMin / static_cast<float>(N) > threshold);
+    };
+
+    const int head = std::min(W, N);           // rows clipped at column 0
+    const int tail = std::max(head, N - W);    // rows clipped at column N - 1
+    for (int i = 0; i < head; ++i) {
+        if (!row(i, 0, std::min(N - 1, i + W) + 1)) return DTW_INF;
+    }
+    for (int i = head; i < tail; ++i) {
+        if (!row(i, i - W, 2 * W + 1)) return DTW_INF;
+    }
+    for (int i = tail; i < N; ++i) {
+        const int jMin = std::max(0, i - W);
+        if (!row(i, jMin, N - jMin)) return DTW_INF;
+    }
+    return prev[N];
+}
+
+using DTWKernel = float (*)(const float*, const float*, const float*, const float*,
+                            int, int, float);
+
+struct PrebuiltKernel {
+    int count;
+    int bandwidth;
+    DTWKernel kernel;
+};
+
+/**
+ * Kernels specialized for 32, 64 and 96 points, each with the band widths
+ * of the ratios 0.05, 0.10, 0.15 and 0.20 (see Scorer::Impl::configure()).
+ */
+constexpr PrebuiltKernel PREBUILT_KERNELS[] = {
+    {32, 2, &bandedDTW<32, 2>},   {32, 4, &bandedDTW<32, 4>},
+    {32, 5, &bandedDTW<32, 5>},   {32, 7, &bandedDTW<32, 7>},
+    {64, 4, &bandedDTW<64, 4>},   {64, 7, &bandedDTW<64, 7>},
+    {64, 10, &bandedDTW<64, 10>}, {64, 13, &bandedDTW<64, 13>},
+    {96, 5, &bandedDTW<96, 5>},   {96, 10, &bandedDTW<96, 10>},
+    {96, 15, &bandedDTW<96, 15>}, {96, 20, &bandedDTW<96, 20>},
+};
+
+/** Kernel for count points and band width bandwidth. */
+DTWKernel selectKernel(int count, int bandwidth) {
+    for (const PrebuiltKernel& k : PREBUILT_KERNELS) {
+        if (k.count == count && k.bandwidth == bandwidth) return k.kernel;
+    }
+    return &bandedDTW<0, 0>;
+}
+
+} // namespace
+
 struct Scorer::Impl {
     ScoringConfig config;
+    int count = RESAMPLE_COUNT;
+    int bandwidth = DTW_BANDWIDTH;
+    DTWKernel kernel = nullptr;
+
+    Impl() { configure(config); }
 
-    /**
-     * Euclidean distance between two NormalizedPoints (x,y only).
-     */
-    static float pointDistance(const NormalizedPoint& a, const NormalizedPoint& b) {
-        float dx = a.x - b.x;
-        float dy = a.y - b.y;
-        return std::sqrt(dx * dx + dy * dy);
+    void configure(const ScoringConfig& c) {
+        config = c;
+        count = std::max(MIN_RESAMPLE_COUNT, std::min(c.resampleCount, MAX_RESAMPLE_COUNT));
+        // Sakoe-Chiba band width for the configured ratio
+        bandwidth = std::max(1, static_cast<int>(std::ceil(c.dtwBandwidthRatio *
+                                                          static_cast<float>(count))));
+        kernel = selectKernel(count, bandwidth);
+    }
+
+    /** Kernel for a query, which may have been prepared before configure(). */
+    DTWKernel kernelFor(const DTWQuery& query) const {
+        return query.count == count && query.bandwidth == bandwidth
+            ? kernel : selectKernel(query.count, query.bandwidth);
     }
 };
 
@@ -37,66 +311,143 @@ Scorer& Scorer::operator=(Scorer&& other) noexcept {
 }
 
 void Scorer::configure(const ScoringConfig& config) {
-    if (pImpl) pImpl->config = config;
+    if (pImpl) pImpl->configure(config);
+}
+
+int Scorer::getResampleCount() const {
+    return pImpl ? pImpl->count : RESAMPLE_COUNT;
 }
 
 float Scorer::computeDTWDistance(const GesturePath& gesture,
                                   const GesturePath& idealPath) const {
-    const int N = RESAMPLE_COUNT;
+    const int N = pImpl->count;
 
     if (static_cast<int>(gesture.points.size()) != N ||
         static_cast<int>(idealPath.points.size()) != N) {
         return FLT_MAX;
     }
 
-    // Sakoe-Chiba band width
-    int W = static_cast<int>(std::ceil(pImpl->config.dtwBandwidthRatio * static_cast<float>(N)));
-    if (W < 1) W = 1;
+    std::array<float, MAX_RESAMPLE_COUNT> gx, gy, tx, ty;
+    for (int i = 0; i < N; ++i) {
+        gx[i] = gesture.points[i].x;
+        gy[i] = gesture.points[i].y;
+        tx[i] = idealPath.points[i].x;
+        ty[i] = idealPath.points[i].y;
+    }
+    return computeDTWDistance(gx.data(), gy.data(), tx.data(), ty.data());
+}
 
-    // Use two-row rolling DTW
-    std::vector<float> dtw_prev(N, FLT_MAX);
-    std::vector<float> dtw_curr(N, FLT_MAX);
+float Scorer::computeDTWDistance(const float* gestureX, const float* gestureY,
+                                  const float* templateX, const float* templateY) const {
+    const int N = pImpl->count;
 
-    // Initialize first row
-    dtw_prev[0] = Impl::pointDistance(gesture.points[0], idealPath.points[0]);
-    for (int j = 1; j <= std::min(W, N - 1); ++j) {
-        if (dtw_prev[j - 1] < FLT_MAX) {
-            dtw_prev[j] = dtw_prev[j - 1] +
-                Impl::pointDistance(gesture.points[0], idealPath.points[j]);
-        }
+    if (!gestureX || !gestureY || !templateX || !templateY) {
+        return FLT_MAX;
     }
 
-    // Fill row by row
-    for (int i = 1; i < N; ++i) {
-        std::fill(dtw_curr.begin(), dtw_curr.end(), FLT_MAX);
+    float raw = pImpl->kernel(gestureX, gestureY, templateX, templateY,
+                              N, pImpl->bandwidth, DTW_INF);
+    if (!(raw < FLT_MAX)) return FLT_MAX;
 
-        int jMin = std::max(0, i - W);
-        int jMax = std::min(N - 1, i + W);
+    // Normalize by path length
+    return raw / static_cast<float>(N);
+}
 
-        for (int j = jMin; j <= jMax; ++j) {
-            float cost = Impl::pointDistance(gesture.points[i], idealPath.points[j]);
+bool Scorer::prepareQuery(const GesturePath& gesture, DTWQuery& query) const {
+    const int N = pImpl->count;
+    query.count = 0;
+    query.bandwidth = 0;
+    if (static_cast<int>(gesture.points.size()) != N) return false;
 
-            float best = FLT_MAX;
-            if (dtw_prev[j] < FLT_MAX)
-                best = std::min(best, dtw_prev[j]);
-            if (j > 0 && dtw_curr[j - 1] < FLT_MAX)
-                best = std::min(best, dtw_curr[j - 1]);
-            if (j > 0 && dtw_prev[j - 1] < FLT_MAX)
-                best = std::min(best, dtw_prev[j - 1]);
+    for (int i = 0; i < N; ++i) {
+        query.x[i] = gesture.points[i].x;
+        query.y[i] = gesture.points[i].y;
+    }
 
-            dtw_curr[j] = (best < FLT_MAX) ? (cost + best) : FLT_MAX;
+    const int W = pImpl->bandwidth;
+    for (int j = 0; j < N; ++j) {
+        const int iMin = std::max(0, j - W);
+        const int iMax = std::min(N - 1, j + W);
+        float loX = query.x[iMin], hiX = loX;
+        float loY = query.y[iMin], hiY = loY;
+        for (int i = iMin + 1; i <= iMax; ++i) {
+            loX = std::min(loX, query.x[i]);
+            hiX = std::max(hiX, query.x[i]);
+            loY = std::min(loY, query.y[i]);
+            hiY = std::max(hiY, query.y[i]);
         }
-
-        std::swap(dtw_prev, dtw_curr);
+        query.lowerX[j] = loX;
+        query.upperX[j] = hiX;
+        query.lowerY[j] = loY;
+        query.upperY[j] = hiY;
     }
+    query.count = N;
+    query.bandwidth = W;
+    return true;
+}
 
-    float raw = dtw_prev[N - 1];
-    if (raw >= FLT_MAX) return FLT_MAX;
+float Scorer::lowerBound(const DTWQuery& query, const float* templateX, const float* templateY,
+                         float threshold) const {
+    const int N = query.count;
+    if (!query.isValid() || !templateX || !templateY) return FLT_MAX;
 
-    // Normalize by path length
+    // The first and last cells are on every warping path
+    float endpoints = pointDistance(query.x[0], query.y[0], templateX[0], templateY[0]) +
+                      pointDistance(query.x[N - 1], query.y[N - 1],
+                                    templateX[N - 1], templateY[N - 1]);
+    float bound = endpoints / static_cast<float>(N);
+    if (bound > threshold) return bound;
+
+    // Every path also visits each template column at least once, through a
+    // gesture point inside that column's envelope box. Summed in column
+    // order, like the path itself, so rounding cannot overshoot the DTW.
+    std::array<float, MAX_RESAMPLE_COUNT> gaps;
+    envelopeDistances(query, templateX, templateY, gaps.data());
+    float keogh = 0.0f;
+    for (int j = 0; j < N; ++j) keogh += gaps[j];
+
+    return std::max(bound, keogh / static_cast<float>(N));
+}
+
+float Scorer::computeDTWDistance(const DTWQuery& query, const float* templateX,
+                                  const float* templateY, float threshold) const {
+    const int N = query.count;
+    if (!query.isValid() || !templateX || !templateY) return FLT_MAX;
+
+    float raw = pImpl->kernelFor(query)(query.x.data(), query.y.data(), templateX, templateY,
+                                        N, query.bandwidth, threshold);
+    if (!(raw < FLT_MAX)) return FLT_MAX;
     return raw / static_cast<float>(N);
 }
 
+bool Scorer::prepareSignature(const GesturePath& gesture, uint32_t letterMask,
+                              PathSignature& signature) const {
+    const int N = pImpl->count;
+    if (static_cast<int>(gesture.points.size()) != N) return false;
+    for (int k = 0; k < SIGNATURE_POINTS; ++k) {
+        const NormalizedPoint& p = gesture.points[static_cast<size_t>(signaturePointIndex(k, N))];
+        signature.x[k] = p.x;
+        signature.y[k] = p.y;
+    }
+    signature.arcLength = gesture.totalArcLength;
+    signature.letterMask = letterMask;
+    return true;
+}
+
+float Scorer::coarseDistance(const PathSignature& gesture, const PathSignature& candidate) const {
+    float d = signatureDistanceSum(gesture, candidate) / static_cast<float>(SIGNATURE_POINTS);
+
+    const float shorter = std::min(gesture.arcLength, candidate.arcLength);
+    const float longer = std::max(gesture.arcLength, candidate.arcLength);
+    if (shorter > 0.0f) d += COARSE_ARC_WEIGHT * (longer / shorter - 1.0f);
+
+    if (gesture.letterMask != 0) {
+        d += COARSE_LETTER_WEIGHT *
+             static_cast<float>(bitCount(candidate.letterMask & ~gesture.letterMask));
+    }
+    return d;
+}
+
 float Scorer::computeConfidence(float dtwDistance, float maxDTWDistance,
                                  uint32_t frequency, uint32_t maxFrequency) const {
     float normalizedDTW = 1.0f;
@@ -0,0 +1,475 @@
+#include "swipetype/TemplateStore.h"
+#include "swipetype/IdealPathGenerator.h"
+#include "swipetype/SwipeTypeTypes.h"
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+#if !defined(SWIPETYPE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define SWIPETYPE_TEMPLATE_SSE2 1
+#elif !defined(SWIPETYPE_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SWIPETYPE_TEMPLATE_NEON 1
+#endif
+
+namespace swipetype {
+
+namespace {
+
+/** Cache file magic, "STPL" in host byte order (a foreign-endian file never matches). */
+constexpr uint32_t TEMPLATE_FILE_MAGIC = 0x4C505453;
+/** Version 2 records the TemplatePrecision in header byte 12. */
+constexpr uint16_t TEMPLATE_FILE_VERSION = 2;
+constexpr size_t TEMPLATE_FILE_HEADER_SIZE = 32;
+
+/** Bytes per coordinate of a template in the given precision. */
+size_t coordinateSize(TemplatePrecision precision) {
+    switch (precision) {
+        case TemplatePrecision::UINT16: return sizeof(uint16_t);
+        case TemplatePrecision::UINT8:  return sizeof(uint8_t);
+        default:                        return sizeof(float);
+    }
+}
+
+/** Nearest code of a normalized coordinate, clamped to [0, scale]. */
+uint32_t quantize(float v, float scale) {
+    float c = std::round(v * scale);
+    if (!(c > 0.0f)) return 0;
+    return c >= scale ? static_cast<uint32_t>(scale) : static_cast<uint32_t>(c);
+}
+
+/** out[i] = codes[i] * inverse for count 16-bit codes. */
+void decodeCodes(const uint16_t* codes, int count, float inverse, float* out) {
+    int i = 0;
+#if defined(SWIPETYPE_TEMPLATE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 k = _mm_set1_ps(inverse);
+    for (; i + 8 <= count; i += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(c, zero)), k));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(c, zero)), k));
+    }
+#elif defined(SWIPETYPE_TEMPLATE_NEON)
+    const float32x4_t k = vdupq_n_f32(inverse);
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t c = vld1q_u16(codes + i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(c))), k));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(c))), k));
+    }
+#endif
+    for (; i < count; ++i) out[i] = static_cast<float>(codes[i]) * inverse;
+}
+
+/** out[i] = codes[i] * inverse for count 8-bit codes. */
+void decodeCodes(const uint8_t* codes, int count, float inverse, float* out) {
+    int i = 0;
+#if defined(SWIPETYPE_TEMPLATE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 k = _mm_set1_ps(inverse);
+    for (; i + 16 <= count; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+        __m128i lo = _mm_unpacklo_epi8(c, zero);
+        __m128i hi = _mm_unpackhi_epi8(c, zero);
+        _mm_storeu_ps(out + i,      _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), k));
+        _mm_storeu_ps(out + i + 4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), k));
+        _mm_storeu_ps(out + i + 8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), k));
+        _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), k));
+    }
+#elif defined(SWIPETYPE_TEMPLATE_NEON)
+    const float32x4_t k = vdupq_n_f32(inverse);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t c = vld1q_u8(codes + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(c));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(c));
+        vst1q_f32(out + i,      vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), k));
+        vst1q_f32(out + i + 4,  vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), k));
+        vst1q_f32(out + i + 8,  vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), k));
+        vst1q_f32(out + i + 12, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), k));
+    }
+#endif
+    for (; i < count; ++i) out[i] = static_cast<float>(codes[i]) * inverse;
+}
+
+constexpr uint64_t FNV64_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV64_PRIME = 1099511628211ull;
+
+void fnv64(uint64_t& h, const void* data, size_t size) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= FNV64_PRIME;
+    }
+}
+
+/** Fingerprint of the dictionary words, in entry order. */
+uint64_t dictionaryFingerprint(const DictionaryLoader& dict) {
+    uint64_t h = FNV64_OFFSET;
+    uint32_t count = dict.getEntryCount();
+    fnv64(h, &count, sizeof(count));
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view word = dict.getEntry(i).word;
+        fnv64(h, word.data(), word.size());
+        const uint8_t separator = 0;
+        fnv64(h, &separator, 1);
+    }
+    return h;
+}
+
+/** Letter bits of a word ('a' = bit 0), as in PathSignature::letterMask. */
+uint32_t wordLetterMask(std::string_view word) {
+    uint32_t mask = 0;
+    for (char ch : word) {
+        int c = std::tolower(static_cast<unsigned char>(ch));
+        if (c >= 'a' && c <= 'z') mask |= 1u << (c - 'a');
+    }
+    return mask;
+}
+
+/**
+ * Length of the path through the word's key centers in dp, with repeated
+ * consecutive keys collapsed, as IdealPathGenerator walks it.
+ */
+float keyPathLength(const KeyboardLayout& layout, std::string_view word) {
+    float length = 0.0f;
+    int32_t prev = -1;
+    for (char ch : word) {
+        int cp = std::tolower(static_cast<unsigned char>(ch));
+        int32_t idx = layout.findKeyByCodePoint(cp);
+        if (idx < 0 || idx == prev) continue;
+        if (prev >= 0) {
+            const KeyDescriptor& a = layout.keys[static_cast<size_t>(prev)];
+            const KeyDescriptor& b = layout.keys[static_cast<size_t>(idx)];
+            float dx = b.centerX - a.centerX;
+            float dy = b.centerY - a.centerY;
+            length += std::sqrt(dx * dx + dy * dy);
+        }
+        prev = idx;
+    }
+    return length;
+}
+
+} // namespace
+
+struct TemplateStore::Impl {
+    // Template i occupies [i * pointCount, (i + 1) * pointCount) of the x
+    // and y buffers of the store's precision; the others stay empty.
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<uint16_t> xs16;
+    std::vector<uint16_t> ys16;
+    std::vector<uint8_t> xs8;
+    std::vector<uint8_t> ys8;
+    std::vector<uint8_t> valid;  // 1 if entry i has a template
+    std::vector<PathSignature> signatures;  // one per entry
+    uint32_t count = 0;
+    int pointCount = RESAMPLE_COUNT;
+    uint64_t layoutHash = 0;
+    uint64_t dictFingerprint = 0;
+    TemplatePrecision precision = TemplatePrecision::FLOAT32;
+    bool compiled = false;
+
+    void reset() {
+        std::vector<float>().swap(xs);
+        std::vector<float>().swap(ys);
+        std::vector<uint16_t>().swap(xs16);
+        std::vector<uint16_t>().swap(ys16);
+        std::vector<uint8_t>().swap(xs8);
+        std::vector<uint8_t>().swap(ys8);
+        std::vector<uint8_t>().swap(valid);
+        std::vector<PathSignature>().swap(signatures);
+        count = 0;
+        pointCount = RESAMPLE_COUNT;
+        layoutHash = 0;
+        dictFingerprint = 0;
+        precision = TemplatePrecision::FLOAT32;
+        compiled = false;
+    }
+
+    /** Raw x and y buffers of the current precision. */
+    char* xData() {
+        switch (precision) {
+            case TemplatePrecision::UINT16: return reinterpret_cast<char*>(xs16.data());
+            case TemplatePrecision::UINT8:  return reinterpret_cast<char*>(xs8.data());
+            default:                        return reinterpret_cast<char*>(xs.data());
+        }
+    }
+    char* yData() {
+        switch (precision) {
+            case TemplatePrecision::UINT16: return reinterpret_cast<char*>(ys16.data());
+            case TemplatePrecision::UINT8:  return reinterpret_cast<char*>(ys8.data());
+            default:                        return reinterpret_cast<char*>(ys.data());
+        }
+    }
+
+    /** Size the x and y buffers of precision p for count templates of points points. */
+    void allocate(TemplatePrecision p, uint32_t templates, int points) {
+        precision = p;
+        pointCount = points;
+        const size_t n = size_t(templates) * size_t(points);
+        switch (p) {
+            case TemplatePrecision::UINT16: xs16.assign(n, 0); ys16.assign(n, 0); break;
+            case TemplatePrecision::UINT8:  xs8.assign(n, 0);  ys8.assign(n, 0);  break;
+            default:                        xs.assign(n, 0.0f); ys.assign(n, 0.0f); break;
+        }
+    }
+
+    /** Store coordinate p of template i in the current precision. */
+    void set(uint32_t i, size_t p, float x, float y) {
+        const size_t at = size_t(i) * size_t(pointCount) + p;
+        switch (precision) {
+            case TemplatePrecision::UINT16:
+                xs16[at] = static_cast<uint16_t>(quantize(x, TEMPLATE_UINT16_SCALE));
+                ys16[at] = static_cast<uint16_t>(quantize(y, TEMPLATE_UINT16_SCALE));
+                break;
+            case TemplatePrecision::UINT8:
+                xs8[at] = static_cast<uint8_t>(quantize(x, TEMPLATE_UINT8_SCALE));
+                ys8[at] = static_cast<uint8_t>(quantize(y, TEMPLATE_UINT8_SCALE));
+                break;
+            default:
+                xs[at] = x;
+                ys[at] = y;
+                break;
+        }
+    }
+
+    TemplateView view(uint32_t i) const {
+        TemplateView v;
+        if (i >= count || !valid[i]) return v;
+        const size_t at = size_t(i) * size_t(pointCount);
+        v.count = pointCount;
+        switch (precision) {
+            case TemplatePrecision::UINT16: v.x16 = xs16.data() + at; v.y16 = ys16.data() + at; break;
+            case TemplatePrecision::UINT8:  v.x8 = xs8.data() + at;   v.y8 = ys8.data() + at;   break;
+            default:                        v.x = xs.data() + at;     v.y = ys.data() + at;     break;
+        }
+        return v;
+    }
+
+    /** Derive every entry's signature from its (decoded) template and word. */
+    void buildSignatures(const KeyboardLayout& layout, const DictionaryLoader& dict) {
+        KeyboardLayout indexed = layout;
+        if (!indexed.hasLookup()) indexed.buildLookup();
+        signatures.assign(count, PathSignature());
+        std::array<float, MAX_RESAMPLE_COUNT> x, y;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!view(i).decode(x.data(), y.data())) continue;
+            PathSignature& sig = signatures[i];
+            for (int k = 0; k < SIGNATURE_POINTS; ++k) {
+                sig.x[k] = x[signaturePointIndex(k, pointCount)];
+                sig.y[k] = y[signaturePointIndex(k, pointCount)];
+            }
+            std::string_view word = dict.getEntry(i).word;
+            sig.arcLength = keyPathLength(indexed, word);
+            sig.letterMask = wordLetterMask(word);
+        }
+    }
+};
+
+TemplateStore::TemplateStore() : pImpl(new Impl()) {}
+TemplateStore::~TemplateStore() { delete pImpl; }
+
+TemplateStore::TemplateStore(TemplateStore&& other) noexcept
+    : pImpl(other.pImpl) { other.pImpl = nullptr; }
+
+TemplateStore& TemplateStore::operator=(TemplateStore&& other) noexcept {
+    if (this != &other) {
+        delete pImpl;
+        pImpl = other.pImpl;
+        other.pImpl = nullptr;
+    }
+    return *this;
+}
+
+bool TemplateView::decode(float* outX, float* outY) const {
+    if (x) {
+        std::memcpy(outX, x, size_t(count) * sizeof(float));
+        std::memcpy(outY, y, size_t(count) * sizeof(float));
+    } else if (x16) {
+        decodeCodes(x16, count, 1.0f / TEMPLATE_UINT16_SCALE, outX);
+        decodeCodes(y16, count, 1.0f / TEMPLATE_UINT16_SCALE, outY);
+    } else if (x8) {
+        decodeCodes(x8, count, 1.0f / TEMPLATE_UINT8_SCALE, outX);
+        decodeCodes(y8, count, 1.0f / TEMPLATE_UINT8_SCALE, outY);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool TemplateStore::compile(const KeyboardLayout& layout, const DictionaryLoader& dict,
+                            TemplatePrecision precision, int pointCount,
+                            TemplateCompileProgress* progress) {
+    if (!pImpl) return false;
+    pImpl->reset();
+    if (!layout.isValid() || !dict.isLoaded() ||
+        pointCount < MIN_RESAMPLE_COUNT || pointCount > MAX_RESAMPLE_COUNT) {
+        return false;
+    }
+
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    generator.setResampleCount(pointCount);
+
+    const uint32_t count = dict.getEntryCount();
+    pImpl->allocate(precision, count, pointCount);
+    pImpl->valid.assign(count, 0);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (progress && i % TEMPLATE_COMPILE_STRIDE == 0) {
+            if (progress->cancel.load(std::memory_order_relaxed)) {
+                pImpl->reset();
+                return false;
+            }
+            progress->compiled.store(i, std::memory_order_relaxed);
+        }
+        GesturePath path = generator.generatePath(dict.getEntry(i).word);
+        if (!path.isValid()) continue;
+
+        for (size_t p = 0; p < path.points.size(); ++p) {
+            pImpl->set(i, p, path.points[p].x, path.points[p].y);
+        }
+        pImpl->valid[i] = 1;
+    }
+
+    pImpl->count = count;
+    pImpl->buildSignatures(layout, dict);
+    pImpl->layoutHash = layoutHash(layout);
+    pImpl->dictFingerprint = dictionaryFingerprint(dict);
+    pImpl->compiled = true;
+    if (progress) progress->compiled.store(count, std::memory_order_relaxed);
+    return true;
+}
+
+bool TemplateStore::save(const std::string& filePath) const {
+    if (!pImpl || !pImpl->compiled) return false;
+
+    std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    uint8_t header[TEMPLATE_FILE_HEADER_SIZE] = {};
+    const auto pointCount = static_cast<uint16_t>(pImpl->pointCount);
+    std::memcpy(header + 0, &TEMPLATE_FILE_MAGIC, 4);
+    std::memcpy(header + 4, &TEMPLATE_FILE_VERSION, 2);
+    std::memcpy(header + 6, &pointCount, 2);
+    std::memcpy(header + 8, &pImpl->count, 4);
+    header[12] = static_cast<uint8_t>(pImpl->precision);
+    std::memcpy(header + 16, &pImpl->layoutHash, 8);
+    std::memcpy(header + 24, &pImpl->dictFingerprint, 8);
+
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(pImpl->valid.data()),
+              static_cast<std::streamsize>(pImpl->valid.size()));
+    const auto bytes = static_cast<std::streamsize>(
+            size_t(pImpl->count) * size_t(pointCount) * coordinateSize(pImpl->precision));
+    out.write(pImpl->xData(), bytes);
+    out.write(pImpl->yData(), bytes);
+    return static_cast<bool>(out);
+}
+
+bool TemplateStore::load(const std::string& filePath, const KeyboardLayout& layout,
+                         const DictionaryLoader& dict, TemplatePrecision precision,
+                         int points) {
+    if (!pImpl || !dict.isLoaded()) return false;
+
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    uint8_t header[TEMPLATE_FILE_HEADER_SIZE];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+
+    uint32_t magic, count;
+    uint16_t version, fileCount;
+    uint64_t fileLayoutHash, fileFingerprint;
+    std::memcpy(&magic, header + 0, 4);
+    std::memcpy(&version, header + 4, 2);
+    std::memcpy(&fileCount, header + 6, 2);
+    std::memcpy(&count, header + 8, 4);
+    std::memcpy(&fileLayoutHash, header + 16, 8);
+    std::memcpy(&fileFingerprint, header + 24, 8);
+
+    if (magic != TEMPLATE_FILE_MAGIC || version != TEMPLATE_FILE_VERSION ||
+        fileCount != points || count != dict.getEntryCount() ||
+        header[12] != static_cast<uint8_t>(precision) ||
+        fileLayoutHash != layoutHash(layout)) {
+        return false;
+    }
+    if (fileFingerprint != dictionaryFingerprint(dict)) return false;
+
+    // Read into a fresh Impl so a short file leaves this store untouched
+    Impl loaded;
+    loaded.allocate(precision, count, points);
+    loaded.valid.resize(count);
+    const auto bytes = static_cast<std::streamsize>(
+            size_t(count) * size_t(points) * coordinateSize(precision));
+    if (!in.read(reinterpret_cast<char*>(loaded.valid.data()), static_cast<std::streamsize>(count)) ||
+        !in.read(loaded.xData(), bytes) || !in.read(loaded.yData(), bytes)) {
+        return false;
+    }
+
+    *pImpl = std::move(loaded);
+    pImpl->count = count;
+    pImpl->buildSignatures(layout, dict);
+    pImpl->layoutHash = fileLayoutHash;
+    pImpl->dictFingerprint = fileFingerprint;
+    pImpl->compiled = true;
+    return true;
+}
+
+void TemplateStore::clear() {
+    if (pImpl) pImpl->reset();
+}
+
+bool TemplateStore::isCompiled() const {
+    return pImpl && pImpl->compiled;
+}
+
+uint32_t TemplateStore::size() const {
+    return pImpl ? pImpl->count : 0;
+}
+
+TemplatePrecision TemplateStore::getPrecision() const {
+    return pImpl ? pImpl->precision : TemplatePrecision::FLOAT32;
+}
+
+int TemplateStore::getPointCount() const {
+    return pImpl ? pImpl->pointCount : RESAMPLE_COUNT;
+}
+
+const PathSignature* TemplateStore::getSignature(uint32_t index) const {
+    if (!pImpl || index >= pImpl->count || !pImpl->valid[index]) return nullptr;
+    return &pImpl->signatures[index];
+}
+
+TemplateView TemplateStore::getTemplate(uint32_t index) const {
+    return pImpl ? pImpl->view(index) : TemplateView();
+}
+
+uint64_t TemplateStore::getLayoutHash() const {
+    return pImpl ? pImpl->layoutHash : 0;
+}
+
+size_t TemplateStore::memoryUsage() const {
+    if (!pImpl) return 0;
+    return (pImpl->xs.capacity() + pImpl->ys.capacity()) * sizeof(float) +
+           (pImpl->xs16.capacity() + pImpl->ys16.capacity()) * sizeof(uint16_t) +
+           pImpl->xs8.capacity() + pImpl->ys8.capacity() +
+           pImpl->valid.capacity() +
+           pImpl->signatures.capacity() * sizeof(PathSignature);
+}
+
+uint64_t TemplateStore::layoutHash(const KeyboardLayout& layout) {
+    uint64_t h = FNV64_OFFSET;
+    for (const auto& key : layout.keys) {
+        if (!key.isCharacterKey()) continue;
+        fnv64(h, &key.codePoint, sizeof(key.codePoint));
+        fnv64(h, &key.centerX, sizeof(key.centerX));
+        fnv64(h, &key.centerY, sizeof(key.centerY));
+    }
+    return h;
+}
+
+} // namespace swipetype
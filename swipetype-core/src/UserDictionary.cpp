@@ -0,0 +1,485 @@
+#include "swipetype/UserDictionary.h"
+#include "swipetype/IdealPathGenerator.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace swipetype {
+
+namespace {
+
+constexpr uint8_t JOURNAL_MAGIC[4] = {'G', 'L', 'U', 'J'};
+constexpr uint8_t JOURNAL_VERSION = 1;
+constexpr size_t JOURNAL_HEADER_SIZE = 8;
+constexpr size_t JOURNAL_RECORD_HEADER_SIZE = 7;  // op, flags, length, value
+
+enum JournalOp : uint8_t {
+    OP_SET = 1,
+    OP_REMOVE = 2,
+    OP_BUMP = 3
+};
+
+/** "Not in a list" position of a free slot. */
+constexpr uint32_t NO_POS = std::numeric_limits<uint32_t>::max();
+
+/** Bucket letter class as in DictionaryLoader: 'a'–'z' → 0–25, anything else → 26. */
+uint32_t letterClass(char ch) {
+    int lc = std::tolower(static_cast<unsigned char>(ch));
+    return (lc >= 'a' && lc <= 'z') ? static_cast<uint32_t>(lc - 'a')
+                                    : DICT_BUCKET_LETTERS - 1;
+}
+
+bool validWord(std::string_view word) {
+    return !word.empty() && word.size() <= MAX_WORD_LENGTH;
+}
+
+uint32_t readU32LE(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void appendRecord(std::vector<uint8_t>& out, uint8_t op, uint8_t flags, std::string_view word,
+                  uint32_t value) {
+    out.push_back(op);
+    out.push_back(flags);
+    out.push_back(static_cast<uint8_t>(word.size()));
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>((value >> shift) & 0xFF));
+    }
+    out.insert(out.end(), word.begin(), word.end());
+}
+
+std::vector<uint8_t> journalHeader() {
+    std::vector<uint8_t> header(JOURNAL_HEADER_SIZE, 0);
+    std::copy(std::begin(JOURNAL_MAGIC), std::end(JOURNAL_MAGIC), header.begin());
+    header[4] = JOURNAL_VERSION;
+    return header;
+}
+
+} // namespace
+
+struct UserDictionary::Impl {
+    /** One word. A free slot has an empty word and NO_POS positions. */
+    struct Slot {
+        std::string word;
+        uint32_t frequency = 0;
+        uint8_t flags = 0;
+        uint32_t pairPos = NO_POS;   // in pairBuckets[pair]
+        uint32_t startPos = NO_POS;  // in startBuckets[start]
+        uint32_t livePos = NO_POS;   // in live
+        uint16_t pair = 0;
+        uint8_t start = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<std::string, uint32_t> lookup;  // exact bytes → slot
+
+    std::array<std::vector<uint32_t>, DICT_BUCKET_COUNT> pairBuckets;
+    std::array<std::vector<uint32_t>, DICT_BUCKET_LETTERS> startBuckets;
+    std::vector<uint32_t> live;
+    uint64_t revision = 0;  // bumped by every change of words or templates
+
+    // Templates, points() coordinates per slot
+    IdealPathGenerator generator;
+    uint64_t layoutHash = 0;
+    std::vector<float> xs, ys;
+    std::vector<uint8_t> valid;
+
+    size_t points() const { return static_cast<size_t>(generator.getResampleCount()); }
+
+    std::string journalPath;
+    std::ofstream journal;
+    size_t journalRecords = 0;
+
+    ErrorInfo lastError;
+
+    void reportError(ErrorCode code, const std::string& msg) {
+        lastError = {code, msg};
+    }
+
+    /** Append slot to list; returns its position there. */
+    static uint32_t push(std::vector<uint32_t>& list, uint32_t slot) {
+        list.push_back(slot);
+        return static_cast<uint32_t>(list.size() - 1);
+    }
+
+    /** Swap-remove the entry at pos; member names the moved slot's position field. */
+    void erase(std::vector<uint32_t>& list, uint32_t pos, uint32_t Slot::*member) {
+        const uint32_t moved = list.back();
+        list[pos] = moved;
+        slots[moved].*member = pos;
+        list.pop_back();
+    }
+
+    void generateTemplate(uint32_t slot) {
+        if (layoutHash == 0) return;
+        GesturePath path = generator.generatePath(slots[slot].word);
+        valid[slot] = path.isValid() ? 1 : 0;
+        if (!valid[slot]) return;
+        const size_t base = size_t(slot) * points();
+        for (size_t p = 0; p < points(); ++p) {
+            xs[base + p] = path.points[p].x;
+            ys[base + p] = path.points[p].y;
+        }
+    }
+
+    /** Slot of word, or NO_POS. */
+    uint32_t find(std::string_view word) const {
+        auto it = lookup.find(std::string(word));
+        return it == lookup.end() ? NO_POS : it->second;
+    }
+
+    void insert(std::string_view word, uint32_t frequency, uint8_t flags) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+            valid.push_back(0);
+            if (layoutHash != 0) {
+                xs.resize(slots.size() * points());
+                ys.resize(slots.size() * points());
+            }
+        }
+        Slot& s = slots[slot];
+        s.word.assign(word.data(), word.size());
+        s.frequency = frequency;
+        s.flags = flags;
+        s.start = static_cast<uint8_t>(letterClass(word.front()));
+        s.pair = static_cast<uint16_t>(s.start * DICT_BUCKET_LETTERS + letterClass(word.back()));
+        s.pairPos = push(pairBuckets[s.pair], slot);
+        s.startPos = push(startBuckets[s.start], slot);
+        s.livePos = push(live, slot);
+        lookup.emplace(s.word, slot);
+        generateTemplate(slot);
+    }
+
+    void remove(uint32_t slot) {
+        Slot& s = slots[slot];
+        erase(pairBuckets[s.pair], s.pairPos, &Slot::pairPos);
+        erase(startBuckets[s.start], s.startPos, &Slot::startPos);
+        erase(live, s.livePos, &Slot::livePos);
+        lookup.erase(s.word);
+        s = Slot();
+        valid[slot] = 0;
+        freeSlots.push_back(slot);
+    }
+
+    /** Apply one change in memory; false if it changes nothing (remove of a missing word). */
+    bool apply(uint8_t op, uint8_t flags, std::string_view word, uint32_t value) {
+        const uint32_t slot = find(word);
+        if (op == OP_SET || op == OP_BUMP || (op == OP_REMOVE && slot != NO_POS)) ++revision;
+        switch (op) {
+            case OP_SET:
+                if (slot == NO_POS) {
+                    insert(word, value, flags);
+                } else {
+                    slots[slot].frequency = value;
+                    slots[slot].flags = flags;
+                }
+                return true;
+            case OP_REMOVE:
+                if (slot == NO_POS) return false;
+                remove(slot);
+                return true;
+            case OP_BUMP:
+                if (slot == NO_POS) {
+                    insert(word, value, flags);
+                } else {
+                    uint32_t& f = slots[slot].frequency;
+                    f = value > std::numeric_limits<uint32_t>::max() - f
+                        ? std::numeric_limits<uint32_t>::max() : f + value;
+                }
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /** Journal a change, then apply it. Nothing changes if the write fails. */
+    bool change(uint8_t op, uint8_t flags, std::string_view word, uint32_t value) {
+        if (journal.is_open()) {
+            std::vector<uint8_t> record;
+            appendRecord(record, op, flags, word, value);
+            journal.write(reinterpret_cast<const char*>(record.data()),
+                          static_cast<std::streamsize>(record.size()));
+            journal.flush();
+            if (!journal) {
+                reportError(ErrorCode::DICT_NOT_FOUND,
+                            "Failed to write user dictionary journal: " + journalPath);
+                return false;
+            }
+            ++journalRecords;
+        }
+        return apply(op, flags, word, value);
+    }
+
+    void clearWords() {
+        ++revision;
+        slots.clear();
+        freeSlots.clear();
+        lookup.clear();
+        for (auto& b : pairBuckets) b.clear();
+        for (auto& b : startBuckets) b.clear();
+        live.clear();
+        xs.clear();
+        ys.clear();
+        valid.clear();
+    }
+
+    /** Reopen the journal for appending. */
+    bool reopen() {
+        journal.close();
+        journal.clear();
+        journal.open(journalPath, std::ios::binary | std::ios::app);
+        if (!journal) {
+            reportError(ErrorCode::DICT_NOT_FOUND,
+                        "Failed to open user dictionary journal: " + journalPath);
+            return false;
+        }
+        return true;
+    }
+};
+
+UserDictionary::UserDictionary() : pImpl(new Impl()) {}
+UserDictionary::~UserDictionary() { delete pImpl; }
+
+UserDictionary::UserDictionary(UserDictionary&& other) noexcept
+    : pImpl(other.pImpl) { other.pImpl = nullptr; }
+
+UserDictionary& UserDictionary::operator=(UserDictionary&& other) noexcept {
+    if (this != &other) {
+        delete pImpl;
+        pImpl = other.pImpl;
+        other.pImpl = nullptr;
+    }
+    return *this;
+}
+
+bool UserDictionary::open(const std::string& journalPath) {
+    if (!pImpl) return false;
+    close();
+    pImpl->clearWords();
+    pImpl->lastError = {};
+    pImpl->journalPath = journalPath;
+
+    std::vector<uint8_t> data;
+    {
+        std::ifstream in(journalPath, std::ios::binary);
+        if (in) data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    if (data.empty()) {
+        // New journal
+        std::ofstream out(journalPath, std::ios::binary | std::ios::trunc);
+        std::vector<uint8_t> header = journalHeader();
+        out.write(reinterpret_cast<const char*>(header.data()),
+                  static_cast<std::streamsize>(header.size()));
+        if (!out) {
+            pImpl->reportError(ErrorCode::DICT_NOT_FOUND,
+                               "Failed to create user dictionary journal: " + journalPath);
+            return false;
+        }
+        out.close();
+        return pImpl->reopen();
+    }
+
+    if (data.size() < JOURNAL_HEADER_SIZE ||
+        !std::equal(std::begin(JOURNAL_MAGIC), std::end(JOURNAL_MAGIC), data.begin())) {
+        pImpl->reportError(ErrorCode::DICT_CORRUPT,
+                           "Not a user dictionary journal: " + journalPath);
+        return false;
+    }
+    if (data[4] != JOURNAL_VERSION) {
+        pImpl->reportError(ErrorCode::DICT_VERSION_MISMATCH,
+                           "Unsupported user dictionary journal version " +
+                           std::to_string(data[4]));
+        return false;
+    }
+
+    size_t pos = JOURNAL_HEADER_SIZE;
+    size_t records = 0;
+    while (pos + JOURNAL_RECORD_HEADER_SIZE <= data.size()) {
+        const uint8_t op = data[pos];
+        const uint8_t flags = data[pos + 1];
+        const size_t len = data[pos + 2];
+        const uint32_t value = readU32LE(&data[pos + 3]);
+        const size_t end = pos + JOURNAL_RECORD_HEADER_SIZE + len;
+        if (op < OP_SET || op > OP_BUMP || len == 0 || len > MAX_WORD_LENGTH ||
+            end > data.size()) {
+            break;
+        }
+        std::string_view word(reinterpret_cast<const char*>(&data[pos + JOURNAL_RECORD_HEADER_SIZE]),
+                              len);
+        pImpl->apply(op, flags, word, value);
+        ++records;
+        pos = end;
+    }
+
+    pImpl->journalRecords = records;
+    if (!pImpl->reopen()) {
+        pImpl->clearWords();
+        return false;
+    }
+    // A crash mid-append leaves a partial record; rewrite without it so
+    // later records are not appended after garbage
+    if (pos != data.size() && !compact()) {
+        close();
+        pImpl->clearWords();
+        return false;
+    }
+    return true;
+}
+
+void UserDictionary::close() {
+    if (!pImpl) return;
+    pImpl->journal.close();
+    pImpl->journal.clear();
+    pImpl->journalRecords = 0;
+}
+
+bool UserDictionary::isOpen() const {
+    return pImpl && pImpl->journal.is_open();
+}
+
+bool UserDictionary::addWord(std::string_view word, uint32_t frequency, uint8_t flags) {
+    if (!pImpl || !validWord(word)) return false;
+    return pImpl->change(OP_SET, flags, word, frequency);
+}
+
+bool UserDictionary::removeWord(std::string_view word) {
+    if (!pImpl || pImpl->find(word) == NO_POS) return false;
+    return pImpl->change(OP_REMOVE, 0, word, 0);
+}
+
+bool UserDictionary::bumpFrequency(std::string_view word, uint32_t delta) {
+    if (!pImpl || !validWord(word)) return false;
+    return pImpl->change(OP_BUMP, 0, word, delta);
+}
+
+bool UserDictionary::contains(std::string_view word) const {
+    return pImpl && pImpl->find(word) != NO_POS;
+}
+
+uint32_t UserDictionary::getFrequency(std::string_view word) const {
+    if (!pImpl) return 0;
+    const uint32_t slot = pImpl->find(word);
+    return slot == NO_POS ? 0 : pImpl->slots[slot].frequency;
+}
+
+size_t UserDictionary::size() const {
+    return pImpl ? pImpl->live.size() : 0;
+}
+
+bool UserDictionary::compact() {
+    if (!pImpl || !pImpl->journal.is_open()) return false;
+
+    std::vector<uint8_t> data = journalHeader();
+    for (uint32_t slot : pImpl->live) {
+        const Impl::Slot& s = pImpl->slots[slot];
+        appendRecord(data, OP_SET, s.flags, s.word, s.frequency);
+    }
+
+    const std::string tmpPath = pImpl->journalPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()),
+                  static_cast<std::streamsize>(data.size()));
+        out.flush();
+        if (!out) {
+            out.close();
+            std::remove(tmpPath.c_str());
+            pImpl->reportError(ErrorCode::DICT_NOT_FOUND,
+                               "Failed to write user dictionary journal: " + tmpPath);
+            return false;
+        }
+    }
+
+    pImpl->journal.close();
+    if (std::rename(tmpPath.c_str(), pImpl->journalPath.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        pImpl->reportError(ErrorCode::DICT_NOT_FOUND,
+                           "Failed to replace user dictionary journal: " + pImpl->journalPath);
+        pImpl->reopen();
+        return false;
+    }
+    pImpl->journalRecords = pImpl->live.size();
+    return pImpl->reopen();
+}
+
+size_t UserDictionary::getJournalRecordCount() const {
+    return isOpen() ? pImpl->journalRecords : 0;
+}
+
+void UserDictionary::setLayout(const KeyboardLayout& layout, int pointCount) {
+    if (!pImpl || pointCount < MIN_RESAMPLE_COUNT || pointCount > MAX_RESAMPLE_COUNT) return;
+    pImpl->generator.setLayout(layout);
+    pImpl->generator.setResampleCount(pointCount);
+    pImpl->layoutHash = TemplateStore::layoutHash(layout);
+    ++pImpl->revision;
+    pImpl->xs.assign(pImpl->slots.size() * pImpl->points(), 0.0f);
+    pImpl->ys.assign(pImpl->slots.size() * pImpl->points(), 0.0f);
+    pImpl->valid.assign(pImpl->slots.size(), 0);
+    for (uint32_t slot : pImpl->live) pImpl->generateTemplate(slot);
+}
+
+uint64_t UserDictionary::getLayoutHash() const {
+    return pImpl ? pImpl->layoutHash : 0;
+}
+
+int UserDictionary::getPointCount() const {
+    return pImpl ? pImpl->generator.getResampleCount() : RESAMPLE_COUNT;
+}
+
+uint64_t UserDictionary::getRevision() const {
+    return pImpl ? pImpl->revision : 0;
+}
+
+DictionaryIndexSpan UserDictionary::getBucket(char startChar, char endChar) const {
+    if (!pImpl) return {};
+    const auto& b = pImpl->pairBuckets[letterClass(startChar) * DICT_BUCKET_LETTERS +
+                                       letterClass(endChar)];
+    return {b.data(), b.size()};
+}
+
+DictionaryIndexSpan UserDictionary::getStartBucket(char startChar) const {
+    if (!pImpl) return {};
+    const auto& b = pImpl->startBuckets[letterClass(startChar)];
+    return {b.data(), b.size()};
+}
+
+DictionaryIndexSpan UserDictionary::getEntries() const {
+    if (!pImpl) return {};
+    return {pImpl->live.data(), pImpl->live.size()};
+}
+
+DictionaryEntry UserDictionary::getEntry(uint32_t slot) const {
+    if (!pImpl || slot >= pImpl->slots.size()) return {};
+    const Impl::Slot& s = pImpl->slots[slot];
+    return {s.word, s.frequency, s.flags};
+}
+
+TemplateView UserDictionary::getTemplate(uint32_t slot) const {
+    TemplateView view;
+    if (!pImpl || slot >= pImpl->valid.size() || !pImpl->valid[slot]) return view;
+    view.x = pImpl->xs.data() + size_t(slot) * pImpl->points();
+    view.y = pImpl->ys.data() + size_t(slot) * pImpl->points();
+    view.count = static_cast<int>(pImpl->points());
+    return view;
+}
+
+ErrorInfo UserDictionary::getLastError() const {
+    return pImpl ? pImpl->lastError : ErrorInfo();
+}
+
+} // namespace swipetype
@@ -0,0 +1,126 @@
+#include "swipetype/WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace swipetype {
+
+struct WorkerPool::Impl {
+    // One run of chunks per worker; next is claimed by the owner and thieves alike.
+    struct alignas(64) Cursor {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    int workers = 1;
+    std::unique_ptr<Cursor[]> cursors;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int pending = 0;            // threads still working on the current generation
+    bool stopping = false;
+    const std::function<void(int, size_t)>* task = nullptr;
+
+    explicit Impl(int count) : workers(std::max(1, count)), cursors(new Cursor[workers]) {
+        threads.reserve(static_cast<size_t>(workers - 1));
+        for (int w = 1; w < workers; ++w) {
+            threads.emplace_back([this, w] { threadLoop(w); });
+        }
+    }
+
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    /** Drain this worker's own run, then steal from the others in turn. */
+    void work(int worker) {
+        for (int k = 0; k < workers; ++k) {
+            Cursor& c = cursors[(worker + k) % workers];
+            for (size_t chunk = c.next.fetch_add(1, std::memory_order_relaxed);
+                 chunk < c.end;
+                 chunk = c.next.fetch_add(1, std::memory_order_relaxed)) {
+                (*task)(worker, chunk);
+            }
+        }
+    }
+
+    void threadLoop(int worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            work(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) done.notify_one();
+            }
+        }
+    }
+};
+
+WorkerPool::WorkerPool(int threadCount) : pImpl(new Impl(threadCount)) {}
+WorkerPool::~WorkerPool() { delete pImpl; }
+
+WorkerPool::WorkerPool(WorkerPool&& other) noexcept
+    : pImpl(other.pImpl) { other.pImpl = nullptr; }
+
+WorkerPool& WorkerPool::operator=(WorkerPool&& other) noexcept {
+    if (this != &other) {
+        delete pImpl;
+        pImpl = other.pImpl;
+        other.pImpl = nullptr;
+    }
+    return *this;
+}
+
+int WorkerPool::threadCount() const {
+    return pImpl ? pImpl->workers : 0;
+}
+
+void WorkerPool::run(size_t chunkCount, const std::function<void(int worker, size_t chunk)>& task) {
+    if (!pImpl || chunkCount == 0) return;
+
+    // Not worth waking anyone for a single chunk
+    if (pImpl->workers == 1 || chunkCount == 1) {
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) task(0, chunk);
+        return;
+    }
+
+    const size_t workers = static_cast<size_t>(pImpl->workers);
+    for (size_t w = 0; w < workers; ++w) {
+        pImpl->cursors[w].next.store(chunkCount * w / workers, std::memory_order_relaxed);
+        pImpl->cursors[w].end = chunkCount * (w + 1) / workers;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        pImpl->task = &task;
+        pImpl->pending = pImpl->workers - 1;
+        ++pImpl->generation;
+    }
+    pImpl->wake.notify_all();
+
+    pImpl->work(0);
+
+    std::unique_lock<std::mutex> lock(pImpl->mutex);
+    pImpl->done.wait(lock, [&] { return pImpl->pending == 0; });
+    pImpl->task = nullptr;
+}
+
+} // namespace swipetype
@@ -2,9 +2,12 @@
 #include <swipetype/DictionaryLoader.h>
 #include <swipetype/SwipeTypeTypes.h>
 #include "TestHelpers.h"
+#include <string>
+#include <utility>
 #include <vector>
 #include <cstdio>
 #include <cstring>
+#include <cctype>
 #include <fstream>
 #include <unistd.h>
 
@@ -32,8 +35,12 @@ protected:
         buf[offset + 2] = static_cast<uint8_t>((val >> 16) & 0xFF);
         buf[offset + 3] = static_cast<uint8_t>((val >> 24) & 0xFF);
     }
+    static uint32_t readU32LE(const std::vector<uint8_t>& buf, size_t offset) {
+        return uint32_t(buf[offset]) | uint32_t(buf[offset + 1]) << 8 |
+               uint32_t(buf[offset + 2]) << 16 | uint32_t(buf[offset + 3]) << 24;
+    }
 
-    /// Create a minimal valid .glide file in memory and return as byte vector.
+    /// Create a minimal valid version-1 .glide file in memory and return as byte vector.
     /// Format:
     ///   32-byte header: magic(4) version(2) flags(2) entryCount(4) langLen(2) langTag(N) pad
     ///   Each entry:     wordLen(1) word(N) frequency(4) flags(1)
@@ -59,7 +66,7 @@ protected:
         // Header: exactly 32 bytes
         std::vector<uint8_t> buf(DICT_HEADER_SIZE, 0);
         writeU32LE(buf, 0, DICT_MAGIC);
-        writeU16LE(buf, 4, DICT_VERSION);
+        writeU16LE(buf, 4, DICT_VERSION_V1);
         writeU16LE(buf, 6, 0);  // flags
         writeU32LE(buf, 8, static_cast<uint32_t>(words.size()));
         uint16_t langLen = static_cast<uint16_t>(std::min(lang.size(), size_t(18)));
@@ -174,3 +181,206 @@ TEST_F(DictionaryLoaderTest, EmptyFileFails) {
     EXPECT_FALSE(ok);
     EXPECT_NE(loader.getLastError().code, ErrorCode::NONE);
 }
+
+TEST_F(DictionaryLoaderTest, BucketIsSortedByLength) {
+    auto data = makeMinimalDict("en-US",
+        {{"hello", 100}, {"halo", 90}, {"hero", 60}, {"hippo", 10}, {"ho", 5}, {"world", 200}});
+    ASSERT_TRUE(loader.loadFromMemory(data.data(), data.size()));
+
+    DictionaryIndexSpan bucket = loader.getBucket('h', 'o');
+    ASSERT_EQ(bucket.size(), 5u);
+    for (size_t i = 1; i < bucket.size(); ++i) {
+        EXPECT_LE(loader.getEntry(bucket[i - 1]).word.size(),
+                  loader.getEntry(bucket[i]).word.size());
+    }
+
+    // Slicing by length keeps only 4-char words: "halo", "hero"
+    DictionaryIndexSpan four = loader.getBucket('h', 'o', 4, 4);
+    ASSERT_EQ(four.size(), 2u);
+    for (uint32_t idx : four) {
+        EXPECT_EQ(loader.getEntry(idx).word.size(), 4u);
+    }
+    EXPECT_TRUE(loader.getBucket('h', 'o', 6, 10).empty());
+    EXPECT_TRUE(loader.getBucket('h', 'o', 5, 4).empty());
+}
+
+TEST_F(DictionaryLoaderTest, LengthGroupsAreFrequencyOrdered) {
+    auto data = makeMinimalDict("en-US",
+        {{"halo", 10}, {"hello", 100}, {"hero", 60}, {"hippo", 300}, {"hullo", 100}, {"ho", 5}});
+    ASSERT_TRUE(loader.loadFromMemory(data.data(), data.size()));
+
+    // Length ascending, then frequency descending, equal frequencies by index
+    std::vector<std::string> order;
+    for (uint32_t idx : loader.getBucket('h', 'o')) order.emplace_back(loader.getEntry(idx).word);
+    EXPECT_EQ(order, std::vector<std::string>({"ho", "hero", "halo", "hippo", "hello", "hullo"}));
+
+    // A version-2 file without DICT_HEADER_FREQUENCY_BUCKETS gets its
+    // bucket order rebuilt
+    std::vector<uint8_t> v2;
+    ASSERT_TRUE(loader.serialize(v2));
+    DictionaryLoader reopened;
+    ASSERT_TRUE(reopened.loadFromMemory(v2.data(), v2.size()));
+    EXPECT_TRUE(reopened.getHeader().flags & DICT_HEADER_FREQUENCY_BUCKETS);
+
+    const uint32_t orderAt = readU32LE(v2, 44);
+    const uint32_t bucket = ('h' - 'a') * DICT_BUCKET_LETTERS + ('o' - 'a');
+    const uint32_t first = readU32LE(v2, readU32LE(v2, 40) + bucket * 4);
+    std::vector<uint8_t> stale = v2;
+    writeU16LE(stale, 6, 0);
+    for (int k = 0; k < 4; ++k) {  // swap "hero" and "halo"
+        std::swap(stale[orderAt + (first + 1) * 4 + k], stale[orderAt + (first + 2) * 4 + k]);
+    }
+    DictionaryLoader rebuilt;
+    ASSERT_TRUE(rebuilt.loadFromMemory(stale.data(), stale.size()));
+    std::vector<std::string> again;
+    for (uint32_t idx : rebuilt.getBucket('h', 'o')) again.emplace_back(rebuilt.getEntry(idx).word);
+    EXPECT_EQ(again, order);
+}
+
+TEST_F(DictionaryLoaderTest, StartBucketCoversAllEndLetters) {
+    auto data = makeMinimalDict("en-US",
+        {{"Hello", 100}, {"help", 80}, {"hi", 60}, {"world", 200}, {"42", 1}});
+    ASSERT_TRUE(loader.loadFromMemory(data.data(), data.size()));
+
+    // Case-insensitive: 'H' and 'h' select the same bucket
+    EXPECT_EQ(loader.getStartBucket('h').size(), 3u);
+    EXPECT_EQ(loader.getStartBucket('H').size(), 3u);
+    EXPECT_EQ(loader.getBucket('H', 'O').size(), 1u);
+    EXPECT_EQ(loader.getIndexedEntries().size(), 5u);
+
+    // Non-letters share a bucket class; the wrapper still matches exactly
+    EXPECT_EQ(loader.getEntriesStartingWith('4').size(), 1u);
+    EXPECT_TRUE(loader.getEntriesStartingWith('7').empty());
+}
+
+TEST_F(DictionaryLoaderTest, FileLoadIsMemoryMapped) {
+    auto data = makeMinimalDict("en-US", {{"hello", 100}, {"world", 200}});
+    std::string path = writeToTempFile(data);
+    ASSERT_TRUE(loader.load(path)) << loader.getLastError().message;
+    EXPECT_EQ(loader.getStorage(), DictionaryStorage::MEMORY_MAP);
+
+    // The mapping outlives the directory entry
+    std::remove(path.c_str());
+    ASSERT_TRUE(loader.lookup("world").has_value());
+    EXPECT_EQ(loader.lookup("world")->frequency, 200u);
+
+    DictionaryLoader copied;
+    ASSERT_TRUE(copied.load(writeToTempFile(data), DictionaryStorage::COPY));
+    EXPECT_EQ(copied.getStorage(), DictionaryStorage::COPY);
+    EXPECT_EQ(copied.getEntryCount(), 2u);
+}
+
+TEST_F(DictionaryLoaderTest, BorrowedBufferIsNotCopied) {
+    auto data = makeMinimalDict("en-US", {{"hello", 100}, {"world", 200}});
+    ASSERT_TRUE(loader.loadFromMemory(data.data(), data.size(), DictionaryStorage::BORROW));
+    EXPECT_EQ(loader.getStorage(), DictionaryStorage::BORROW);
+
+    const char* begin = reinterpret_cast<const char*>(data.data());
+    for (const auto& entry : loader.getAllEntries()) {
+        EXPECT_GE(entry.word.data(), begin);
+        EXPECT_LT(entry.word.data(), begin + data.size());
+    }
+
+    // Default COPY mode owns its bytes
+    DictionaryLoader copied;
+    ASSERT_TRUE(copied.loadFromMemory(data.data(), data.size()));
+    std::fill(data.begin(), data.end(), 0);
+    ASSERT_TRUE(copied.lookup("hello").has_value());
+}
+
+TEST_F(DictionaryLoaderTest, Version2RoundTripMatchesVersion1) {
+    auto v1 = makeMinimalDict("en-US", {
+        {"hello", 100}, {"Help", 300}, {"hero", 50}, {"world", 200}, {"hello", 7}});
+    ASSERT_TRUE(loader.loadFromMemory(v1.data(), v1.size()));
+
+    std::vector<uint8_t> v2;
+    ASSERT_TRUE(loader.serialize(v2));
+
+    DictionaryLoader reopened;
+    ASSERT_TRUE(reopened.loadFromMemory(v2.data(), v2.size(), DictionaryStorage::BORROW))
+        << reopened.getLastError().message;
+    EXPECT_EQ(reopened.getHeader().version, DICT_VERSION);
+    EXPECT_EQ(reopened.getHeader().languageTag, "en-US");
+    EXPECT_EQ(reopened.getEntryCount(), loader.getEntryCount());
+    EXPECT_EQ(reopened.getMaxFrequency(), 300u);
+
+    for (uint32_t i = 0; i < loader.getEntryCount(); ++i) {
+        EXPECT_EQ(reopened.getEntry(i).word, loader.getEntry(i).word);
+        EXPECT_EQ(reopened.getEntry(i).frequency, loader.getEntry(i).frequency);
+    }
+
+    DictionaryIndexSpan before = loader.getBucket('h', 'o');
+    DictionaryIndexSpan after = reopened.getBucket('h', 'o');
+    ASSERT_EQ(after.size(), before.size());
+    for (size_t i = 0; i < after.size(); ++i) EXPECT_EQ(after[i], before[i]);
+
+    // Hashed lookup: case-insensitive, first of several folded duplicates wins
+    auto help = reopened.lookup("HELP");
+    ASSERT_TRUE(help.has_value());
+    EXPECT_EQ(help->frequency, 300u);
+    EXPECT_EQ(reopened.lookup("hello")->frequency, 100u);
+    EXPECT_FALSE(reopened.lookup("helm").has_value());
+}
+
+TEST_F(DictionaryLoaderTest, Version2UsesUnalignedBufferViaFallback) {
+    auto v1 = makeMinimalDict("en-US", {{"foo", 1000}, {"bar", 2000}});
+    ASSERT_TRUE(loader.loadFromMemory(v1.data(), v1.size()));
+    std::vector<uint8_t> v2;
+    ASSERT_TRUE(loader.serialize(v2));
+
+    std::vector<uint8_t> shifted(v2.size() + 1);
+    std::copy(v2.begin(), v2.end(), shifted.begin() + 1);
+
+    DictionaryLoader reopened;
+    ASSERT_TRUE(reopened.loadFromMemory(shifted.data() + 1, v2.size(), DictionaryStorage::BORROW));
+    EXPECT_EQ(reopened.lookup("bar")->frequency, 2000u);
+    EXPECT_EQ(reopened.getBucket('f', 'o').size(), 1u);
+}
+
+TEST_F(DictionaryLoaderTest, Version2RejectsBadSections) {
+    auto v1 = makeMinimalDict("en-US", {{"hello", 100}, {"world", 200}});
+    ASSERT_TRUE(loader.loadFromMemory(v1.data(), v1.size()));
+    std::vector<uint8_t> v2;
+    ASSERT_TRUE(loader.serialize(v2));
+
+    // Offset table pointing past the end of the file
+    auto badOffsets = v2;
+    writeU32LE(badOffsets, 36, static_cast<uint32_t>(v2.size()));
+    EXPECT_FALSE(loader.loadFromMemory(badOffsets.data(), badOffsets.size()));
+    EXPECT_EQ(loader.getLastError().code, ErrorCode::DICT_CORRUPT);
+
+    // Hash table size that is not a power of two
+    auto badHash = v2;
+    writeU32LE(badHash, 52, 3);
+    EXPECT_FALSE(loader.loadFromMemory(badHash.data(), badHash.size()));
+    EXPECT_EQ(loader.getLastError().code, ErrorCode::DICT_CORRUPT);
+
+    // Truncated inside the section directory
+    auto truncated = v2;
+    truncated.resize(DICT_HEADER_V2_SIZE - 4);
+    EXPECT_FALSE(loader.loadFromMemory(truncated.data(), truncated.size()));
+    EXPECT_FALSE(loader.isLoaded());
+}
+
+TEST_F(DictionaryLoaderTest, HashedLookupFindsEveryWord) {
+    // Enough words to force long probe chains on a half-full table
+    std::vector<std::pair<std::string, uint32_t>> words;
+    for (uint32_t i = 0; i < 2000; ++i) {
+        std::string w;
+        for (uint32_t n = i + 1; n > 0; n /= 26) w.push_back(static_cast<char>('a' + n % 26));
+        words.push_back({w, i + 1});
+    }
+    auto data = makeMinimalDict("en-US", words);
+    ASSERT_TRUE(loader.loadFromMemory(data.data(), data.size()));
+
+    for (const auto& [word, freq] : words) {
+        std::string upper = word;
+        for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        auto entry = loader.lookup(upper);
+        ASSERT_TRUE(entry.has_value()) << word;
+        EXPECT_EQ(entry->frequency, freq);
+        EXPECT_EQ(entry->word, word);
+    }
+    EXPECT_FALSE(loader.lookup("zzzzzzz").has_value());
+    EXPECT_FALSE(loader.lookup("").has_value());
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <swipetype/DictionaryStore.h>
+#include <swipetype/SwipeTypeTypes.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace swipetype;
+
+class DictionaryStoreTest : public ::testing::Test {
+protected:
+    std::vector<uint8_t> dictData;
+    std::vector<std::string> words = {"hello", "help", "world"};
+
+    void SetUp() override {
+        // Version-1 dictionary: header + wordLen(1) word(N) frequency(4) flags(1)
+        std::vector<uint8_t> entries;
+        for (const auto& w : words) {
+            entries.push_back(static_cast<uint8_t>(w.size()));
+            for (char c : w) entries.push_back(static_cast<uint8_t>(c));
+            for (uint8_t b : {100, 0, 0, 0, 0}) entries.push_back(b);  // frequency, flags
+        }
+        dictData.assign(DICT_HEADER_SIZE, 0);
+        dictData[0] = 0x44; dictData[1] = 0x49; dictData[2] = 0x4C; dictData[3] = 0x47;  // GLID
+        dictData[4] = static_cast<uint8_t>(DICT_VERSION_V1);
+        dictData[8] = static_cast<uint8_t>(words.size());
+        dictData.insert(dictData.end(), entries.begin(), entries.end());
+    }
+};
+
+TEST_F(DictionaryStoreTest, LoadBuildsDictionaryAndLexicon) {
+    DictionaryStore store;
+    EXPECT_FALSE(store.isLoaded());
+    EXPECT_FALSE(store.getLexicon().isBuilt());
+
+    ASSERT_TRUE(store.loadFromMemory(dictData.data(), dictData.size()));
+    EXPECT_TRUE(store.isLoaded());
+    EXPECT_EQ(store.getDictionary().getEntryCount(), 3u);
+    EXPECT_TRUE(store.getLexicon().isBuilt());
+
+    store.unload();
+    EXPECT_FALSE(store.isLoaded());
+    EXPECT_FALSE(store.getLexicon().isBuilt());
+}
+
+TEST_F(DictionaryStoreTest, FailedLoadReportsError) {
+    DictionaryStore store;
+    ASSERT_TRUE(store.loadFromMemory(dictData.data(), dictData.size()));
+
+    EXPECT_FALSE(store.load("/nonexistent/path/dict.glide"));
+    EXPECT_EQ(store.getLastError().code, ErrorCode::DICT_NOT_FOUND);
+    EXPECT_FALSE(store.isLoaded());
+    EXPECT_FALSE(store.getLexicon().isBuilt());
+}
+
+TEST_F(DictionaryStoreTest, SharedStoreOutlivesItsCreator) {
+    std::shared_ptr<const DictionaryStore> shared;
+    {
+        auto store = std::make_shared<DictionaryStore>();
+        ASSERT_TRUE(store->loadFromMemory(dictData.data(), dictData.size()));
+        shared = store;
+    }
+    dictData.assign(dictData.size(), 0);  // COPY storage does not refer to it
+    ASSERT_TRUE(shared->isLoaded());
+    EXPECT_EQ(shared->getDictionary().getEntry(2).word, "world");
+}
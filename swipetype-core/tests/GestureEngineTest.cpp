@@ -4,6 +4,12 @@
 #include <swipetype/GesturePoint.h>
 #include <swipetype/GestureCandidate.h>
 #include <swipetype/DictionaryLoader.h>
+#include <swipetype/DictionaryStore.h>
+#include <swipetype/TemplateStore.h>
+#include <swipetype/UserDictionary.h>
+#include <swipetype/PathProcessor.h>
+#include <swipetype/IdealPathGenerator.h>
+#include <swipetype/Scorer.h>
 #include <swipetype/SwipeTypeTypes.h>
 #include "TestHelpers.h"
 #include <vector>
@@ -11,17 +17,62 @@
 #include <chrono>
 #include <memory>
 #include <fstream>
+#include <algorithm>
+#include <limits>
+#include <atomic>
 #include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
 #include <unistd.h>
 
 using namespace swipetype;
 using namespace swipetype::test;
 
+// ---------------------------------------------------------------------------
+// Allocation counting: global operator new counts while a scope is open
+// ---------------------------------------------------------------------------
+
+static std::atomic<bool> gCountAllocations{false};
+static std::atomic<size_t> gAllocationCount{0};
+
+void* operator new(size_t size) {
+    if (gCountAllocations.load(std::memory_order_relaxed)) {
+        gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+// GCC flags free() inlined into delete expressions; it is the matching call here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+/** Counts heap allocations on any thread for the lifetime of the scope. */
+struct AllocationCounter {
+    AllocationCounter() {
+        gAllocationCount.store(0);
+        gCountAllocations.store(true);
+    }
+    ~AllocationCounter() { gCountAllocations.store(false); }
+    size_t count() const { return gAllocationCount.load(); }
+};
+
 // ---------------------------------------------------------------------------
 // Build a small in-memory dictionary with words relevant for testing
 // ---------------------------------------------------------------------------
 
-static std::vector<uint8_t> buildTestDict() {
+static std::vector<uint8_t> buildTestDict(
+        const std::vector<std::pair<std::string, uint32_t>>& words) {
     // Header helpers
     auto writeU16 = [](std::vector<uint8_t>& b, size_t off, uint16_t v) {
         b[off] = v & 0xFF; b[off+1] = (v>>8) & 0xFF;
@@ -31,18 +82,6 @@ static std::vector<uint8_t> buildTestDict() {
         b[off+2] = (v>>16) & 0xFF; b[off+3] = (v>>24) & 0xFF;
     };
 
-    const std::vector<std::pair<std::string, uint32_t>> words = {
-        {"the",         1'000'000},
-        {"and",           800'000},
-        {"hello",          50'000},
-        {"world",          40'000},
-        {"help",           30'000},
-        {"hero",           20'000},
-        {"go",            200'000},
-        {"do",            180'000},
-        {"a",             900'000},
-    };
-
     std::vector<uint8_t> entries;
     for (const auto& [w, freq] : words) {
         entries.push_back(static_cast<uint8_t>(w.size()));
@@ -56,7 +95,7 @@ static std::vector<uint8_t> buildTestDict() {
 
     std::vector<uint8_t> buf(DICT_HEADER_SIZE, 0);
     writeU32(buf, 0, DICT_MAGIC);
-    writeU16(buf, 4, DICT_VERSION);
+    writeU16(buf, 4, DICT_VERSION_V1);
     writeU16(buf, 6, 0);
     writeU32(buf, 8, static_cast<uint32_t>(words.size()));
     const char* lang = "en";
@@ -67,6 +106,21 @@ static std::vector<uint8_t> buildTestDict() {
     return buf;
 }
 
+static std::vector<uint8_t> buildTestDict() {
+    const std::vector<std::pair<std::string, uint32_t>> words = {
+        {"the",         1'000'000},
+        {"and",           800'000},
+        {"hello",          50'000},
+        {"world",          40'000},
+        {"help",           30'000},
+        {"hero",           20'000},
+        {"go",            200'000},
+        {"do",            180'000},
+        {"a",             900'000},
+    };
+    return buildTestDict(words);
+}
+
 // ---------------------------------------------------------------------------
 
 class GestureEngineTest : public ::testing::Test {
@@ -190,6 +244,1567 @@ TEST_F(GestureEngineTest, UpdateLayoutChangesResults) {
     SUCCEED(); // Layout update should not crash
 }
 
+// ----- Precompiled templates -----
+
+TEST_F(GestureEngineTest, CompiledTemplatesGiveIdenticalResults) {
+    std::vector<RawGesturePath> gestures;
+    for (const char* word : {"hello", "the", "world", "go"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        gestures.push_back(raw);
+    }
+
+    std::vector<std::vector<GestureCandidate>> lazy;
+    for (const auto& raw : gestures) lazy.push_back(engine->recognize(raw, 8));
+
+    char dir[] = "/tmp/swipetype_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    ASSERT_TRUE(engine->compileTemplates(dir));
+    EXPECT_TRUE(engine->hasCompiledTemplates());
+
+    // A second engine picks the persisted store up from the cache directory
+    GestureEngine cached;
+    ASSERT_TRUE(cached.initWithData(layout, testDict.data(), testDict.size()));
+    ASSERT_TRUE(cached.compileTemplates(dir));
+
+    for (size_t g = 0; g < gestures.size(); ++g) {
+        for (GestureEngine* e : {engine.get(), &cached}) {
+            auto compiled = e->recognize(gestures[g], 8);
+            ASSERT_EQ(compiled.size(), lazy[g].size());
+            for (size_t i = 0; i < compiled.size(); ++i) {
+                EXPECT_EQ(compiled[i].word, lazy[g][i].word);
+                EXPECT_EQ(compiled[i].dtwScore, lazy[g][i].dtwScore);
+                EXPECT_EQ(compiled[i].confidence, lazy[g][i].confidence);
+            }
+        }
+    }
+
+    std::string cacheFile = std::string(dir) + "/templates-";
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(TemplateStore::layoutHash(layout)));
+    cacheFile += std::string(hash) + ".bin";
+    EXPECT_EQ(std::remove(cacheFile.c_str()), 0) << "cache file not written";
+    rmdir(dir);
+
+    engine->shutdown();
+    EXPECT_FALSE(engine->hasCompiledTemplates());
+}
+
+// ----- Shared stores -----
+
+/** Expect two candidate lists to be identical. */
+static void expectSameCandidates(const std::vector<GestureCandidate>& got,
+                                 const std::vector<GestureCandidate>& expected) {
+    ASSERT_EQ(got.size(), expected.size());
+    for (size_t i = 0; i < got.size(); ++i) {
+        EXPECT_EQ(got[i].word, expected[i].word);
+        EXPECT_EQ(got[i].dtwScore, expected[i].dtwScore);
+        EXPECT_EQ(got[i].confidence, expected[i].confidence);
+    }
+}
+
+TEST_F(GestureEngineTest, EnginesShareDictionaryAndTemplateStores) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto expected = engine->recognize(raw, 8);
+    ASSERT_FALSE(expected.empty());
+
+    std::shared_ptr<const DictionaryStore> store = engine->getDictionaryStore();
+    ASSERT_NE(store, nullptr);
+    GestureEngine second;
+    EXPECT_FALSE(second.initWithStore(layout, nullptr));
+    EXPECT_EQ(second.getLastError().code, ErrorCode::DICT_NOT_FOUND);
+    ASSERT_TRUE(second.initWithStore(layout, store));
+    EXPECT_EQ(second.getDictionaryStore(), store);
+    EXPECT_EQ(store.use_count(), 3);
+    expectSameCandidates(second.recognize(raw, 8), expected);
+
+    // Templates are shared only between engines with the same layout
+    EXPECT_EQ(engine->getTemplateStore(), nullptr);
+    ASSERT_TRUE(engine->compileTemplates());
+    std::shared_ptr<const TemplateStore> templates = engine->getTemplateStore();
+    ASSERT_TRUE(second.attachTemplates(templates));
+    EXPECT_EQ(second.getTemplateStore(), templates);
+    expectSameCandidates(second.recognize(raw, 8), expected);
+
+    KeyboardLayout moved = makeQwertyLayout();
+    for (auto& key : moved.keys) key.centerY += 4.0f;
+    GestureEngine third;
+    ASSERT_TRUE(third.initWithStore(moved, store));
+    EXPECT_FALSE(third.attachTemplates(templates));
+    EXPECT_FALSE(third.hasCompiledTemplates());
+
+    // Recompiling for a new layout replaces only that engine's reference
+    ASSERT_TRUE(second.updateLayout(moved));
+    EXPECT_TRUE(second.hasCompiledTemplates());
+    EXPECT_NE(second.getTemplateStore(), templates);
+    EXPECT_EQ(engine->getTemplateStore(), templates);
+    EXPECT_TRUE(third.attachTemplates(second.getTemplateStore()));
+
+    // The store outlives the engine that loaded it
+    engine->shutdown();
+    EXPECT_EQ(engine->getDictionaryStore(), nullptr);
+    ASSERT_TRUE(second.updateLayout(layout));
+    expectSameCandidates(second.recognize(raw, 8), expected);
+}
+
+TEST_F(GestureEngineTest, SharedStoresRecognizeInParallel) {
+    std::vector<RawGesturePath> gestures;
+    for (const char* word : {"hello", "the", "world", "go", "help"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        gestures.push_back(raw);
+    }
+    ASSERT_TRUE(engine->compileTemplates());
+    std::vector<std::vector<GestureCandidate>> expected;
+    for (const auto& raw : gestures) expected.push_back(engine->recognize(raw, 8));
+
+    // One engine per thread, all reading the same dictionary and templates
+    constexpr int kThreads = 4;
+    std::vector<GestureEngine> engines(kThreads);
+    for (auto& e : engines) {
+        ASSERT_TRUE(e.initWithStore(layout, engine->getDictionaryStore()));
+        ASSERT_TRUE(e.attachTemplates(engine->getTemplateStore()));
+    }
+    std::vector<std::vector<std::vector<GestureCandidate>>> results(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < 20; ++round) {
+                for (const auto& raw : gestures) {
+                    results[t].push_back(engines[static_cast<size_t>(t)].recognize(raw, 8));
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    for (int t = 0; t < kThreads; ++t) {
+        ASSERT_EQ(results[t].size(), 20 * gestures.size());
+        for (size_t r = 0; r < results[t].size(); ++r) {
+            expectSameCandidates(results[t][r], expected[r % gestures.size()]);
+        }
+    }
+}
+
+// ----- Background swaps -----
+
+/** The QWERTY layout with every key moved down by dy. */
+static KeyboardLayout shiftedLayout(float dy) {
+    KeyboardLayout shifted = makeQwertyLayout();
+    for (auto& key : shifted.keys) key.centerY += dy;
+    return shifted;
+}
+
+TEST_F(GestureEngineTest, UpdateLayoutAsyncSwapsOnNextRecognition) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    ASSERT_TRUE(engine->compileTemplates());
+    auto before = engine->recognize(raw, 8);
+    std::shared_ptr<const TemplateStore> oldTemplates = engine->getTemplateStore();
+
+    KeyboardLayout moved = shiftedLayout(12.0f);
+    GestureEngine reference;
+    ASSERT_TRUE(reference.initWithData(moved, testDict.data(), testDict.size()));
+    auto expected = reference.recognize(raw, 8);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_NE(expected[0].dtwScore, before[0].dtwScore);
+
+    GestureEngine idle;
+    EXPECT_FALSE(idle.updateLayoutAsync(moved));
+    EXPECT_FALSE(engine->updateLayoutAsync(KeyboardLayout()));
+
+    std::atomic<int> calls{0};
+    std::atomic<bool> swapped{false};
+    ASSERT_TRUE(engine->updateLayoutAsync(moved, [&](bool ok, const ErrorInfo& error) {
+        swapped = ok && error.code == ErrorCode::NONE;
+        ++calls;
+    }));
+    engine->waitForSwap();
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_TRUE(swapped.load());
+
+    // Templates were recompiled for the new layout
+    expectSameCandidates(engine->recognize(raw, 8), expected);
+    ASSERT_TRUE(engine->hasCompiledTemplates());
+    EXPECT_NE(engine->getTemplateStore(), oldTemplates);
+    EXPECT_EQ(engine->getTemplateStore()->getLayoutHash(), TemplateStore::layoutHash(moved));
+}
+
+TEST_F(GestureEngineTest, StreamedGestureFinishesOnItsSnapshot) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto before = engine->recognize(raw, 8);
+
+    ASSERT_TRUE(engine->beginGesture());
+    const size_t half = raw.points.size() / 2;
+    ASSERT_TRUE(engine->addPoints(raw.points.data(), half));
+    ASSERT_TRUE(engine->updateLayoutAsync(shiftedLayout(12.0f)));
+    engine->waitForSwap();
+    ASSERT_TRUE(engine->addPoints(raw.points.data() + half, raw.points.size() - half));
+    expectSameCandidates(engine->endGesture(8), before);
+
+    // The next gesture uses the new layout
+    auto after = engine->recognize(raw, 8);
+    ASSERT_FALSE(after.empty());
+    EXPECT_NE(after[0].dtwScore, before[0].dtwScore);
+}
+
+TEST_F(GestureEngineTest, ReloadDictionaryAsyncKeepsOldDictionaryOnFailure) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto before = engine->recognize(raw, 8);
+    ASSERT_FALSE(before.empty());
+    EXPECT_EQ(before[0].word, "hello");
+
+    ErrorInfo failure;
+    bool swapped = true;
+    ASSERT_TRUE(engine->reloadDictionaryAsync("/nonexistent/words.glide",
+                                              [&](bool ok, const ErrorInfo& error) {
+        swapped = ok;
+        failure = error;
+    }));
+    engine->waitForSwap();
+    EXPECT_FALSE(swapped);
+    EXPECT_EQ(failure.code, ErrorCode::DICT_NOT_FOUND);
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::NONE);  // not reported there
+    expectSameCandidates(engine->recognize(raw, 8), before);
+
+    // A loaded store replaces the dictionary (and is shared, not copied)
+    EXPECT_FALSE(engine->reloadDictionaryAsync(std::make_shared<DictionaryStore>()));
+    auto words = buildTestDict({{"help", 30'000}, {"hero", 20'000}, {"the", 1'000'000}});
+    auto store = std::make_shared<DictionaryStore>();
+    ASSERT_TRUE(store->loadFromMemory(words.data(), words.size()));
+    ASSERT_TRUE(engine->reloadDictionaryAsync(store));
+    engine->waitForSwap();
+    EXPECT_EQ(engine->getDictionaryStore(), store);
+    auto after = engine->recognize(raw, 8);
+    for (const auto& c : after) EXPECT_NE(c.word, "hello");
+}
+
+/**
+ * Recognize on this thread while another swaps layouts in the background:
+ * every recognition must see one whole layout, never a mix of two. With
+ * relayout, this thread also changes the layout itself now and then.
+ */
+static void recognizeWhileSwappingLayouts(GestureEngine& engine, const KeyboardLayout& layout,
+                                          bool relayout = false) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    const KeyboardLayout moved = shiftedLayout(12.0f);
+    auto onLayout = engine.recognize(raw, 8);
+    ASSERT_TRUE(engine.updateLayout(moved));
+    auto onMoved = engine.recognize(raw, 8);
+    ASSERT_TRUE(engine.updateLayout(layout));
+    ASSERT_FALSE(onLayout.empty());
+    ASSERT_FALSE(onMoved.empty());
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> swaps{0};
+    std::thread swapper([&] {
+        for (int i = 0; i < 40; ++i) {
+            engine.updateLayoutAsync(i % 2 ? layout : moved, [&](bool ok, const ErrorInfo&) {
+                if (ok) ++swaps;
+            });
+            if (i % 4 == 3) engine.waitForSwap();
+        }
+        engine.waitForSwap();
+        stop = true;
+    });
+    int recognized = 0;
+    while (!stop.load() || recognized < 20) {
+        auto got = engine.recognize(raw, 8);
+        const auto& expected = got.size() == onLayout.size() &&
+                               got[0].dtwScore == onLayout[0].dtwScore ? onLayout : onMoved;
+        expectSameCandidates(got, expected);
+        ++recognized;
+        if (relayout && !stop.load() && recognized % 4 == 0) {
+            ASSERT_TRUE(engine.updateLayout(recognized % 8 ? layout : moved));
+        }
+    }
+    swapper.join();
+    EXPECT_EQ(swaps.load(), 40);
+    if (relayout) {
+        ASSERT_TRUE(engine.updateLayout(layout));
+    }
+    expectSameCandidates(engine.recognize(raw, 8), onLayout);  // last request wins
+}
+
+TEST_F(GestureEngineTest, RecognizeInParallelWithBackgroundSwaps) {
+    recognizeWhileSwappingLayouts(*engine, layout);
+}
+
+TEST_F(GestureEngineTest, RecognizeInParallelWithBackgroundSwapsDuringWarmup) {
+    // Each synchronous updateLayout() that moves keys restarts the
+    // warm-up, which the swaps then cancel while recognitions take up its
+    // results
+    ScoringConfig config;
+    config.warmup = WarmupLevel::FULL;
+    engine->configure(config);
+    ASSERT_TRUE(engine->initWithData(layout, testDict.data(), testDict.size()));
+    recognizeWhileSwappingLayouts(*engine, layout, true);
+}
+
+// ----- Several dictionaries -----
+
+/** A loaded store of the given words. */
+static std::shared_ptr<DictionaryStore> makeStore(
+        const std::vector<std::pair<std::string, uint32_t>>& words) {
+    auto data = buildTestDict(words);
+    auto store = std::make_shared<DictionaryStore>();
+    EXPECT_TRUE(store->loadFromMemory(data.data(), data.size()));
+    return store;
+}
+
+TEST_F(GestureEngineTest, AddedDictionariesMergeIntoOneRanking) {
+    RawGesturePath hallo;
+    hallo.points = makePathForWord(layout, "hallo");
+    for (const auto& c : engine->recognize(hallo, 8)) EXPECT_NE(c.word, "hallo");
+
+    auto german = makeStore({{"hallo", 60'000}, {"hello", 30'000}, {"die", 900'000}});
+    EXPECT_EQ(engine->getDictionaryCount(), 1u);
+    EXPECT_FALSE(engine->addDictionary(engine->getDictionaryStore()));
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::INVALID_ARGUMENT);
+    EXPECT_FALSE(engine->addDictionary(std::make_shared<DictionaryStore>()));
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::DICT_NOT_FOUND);
+    EXPECT_FALSE(engine->addDictionary(german, -1.0f));
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::INVALID_ARGUMENT);
+    EXPECT_FALSE(engine->addDictionary(german, std::numeric_limits<float>::infinity()));
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::INVALID_ARGUMENT);
+    ASSERT_TRUE(engine->addDictionary(german, 0.5f, SOURCE_USER_DICT));
+    EXPECT_FALSE(engine->addDictionary(german));
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::INVALID_ARGUMENT);
+    EXPECT_EQ(engine->getDictionaryCount(), 2u);
+
+    // Frequencies count relative to their own dictionary, times its weight
+    auto got = engine->recognize(hallo, 8);
+    ASSERT_FALSE(got.empty());
+    EXPECT_EQ(got[0].word, "hallo");
+    EXPECT_EQ(got[0].sourceFlags, SOURCE_USER_DICT);
+    EXPECT_FLOAT_EQ(got[0].frequencyScore, 0.5f * 60'000 / 900'000);
+
+    // A word of both dictionaries is listed once, with both flags
+    RawGesturePath hello;
+    hello.points = makePathForWord(layout, "hello");
+    size_t hellos = 0;
+    for (const auto& c : engine->recognize(hello, 8)) {
+        if (c.word != "hello") continue;
+        ++hellos;
+        EXPECT_EQ(c.sourceFlags, SOURCE_MAIN_DICT | SOURCE_USER_DICT);
+    }
+    EXPECT_EQ(hellos, 1u);
+
+    // Added dictionaries survive a layout change and get templates too
+    std::vector<GestureCandidate> lazy = engine->recognize(hallo, 8);
+    ASSERT_TRUE(engine->compileTemplates());
+    expectSameCandidates(engine->recognize(hallo, 8), lazy);
+    ASSERT_TRUE(engine->updateLayout(shiftedLayout(2.0f)));
+    EXPECT_EQ(engine->getDictionaryCount(), 2u);
+    EXPECT_EQ(engine->recognize(hallo, 8)[0].word, "hallo");
+
+    EXPECT_FALSE(engine->removeDictionary(engine->getDictionaryStore()));
+    ASSERT_TRUE(engine->removeDictionary(german));
+    EXPECT_FALSE(engine->removeDictionary(german));
+    EXPECT_EQ(engine->getDictionaryCount(), 1u);
+    for (const auto& c : engine->recognize(hallo, 8)) EXPECT_NE(c.word, "hallo");
+}
+
+TEST_F(GestureEngineTest, UserDictionaryChangesApplyWithoutReload) {
+    auto user = std::make_shared<UserDictionary>();
+    GestureEngine idle;
+    EXPECT_FALSE(idle.setUserDictionary(user));
+    EXPECT_EQ(idle.getLastError().code, ErrorCode::ENGINE_NOT_INITIALIZED);
+
+    RawGesturePath hallo;
+    hallo.points = makePathForWord(layout, "hallo");
+    ASSERT_TRUE(engine->setUserDictionary(user));
+    EXPECT_EQ(engine->getUserDictionary(), user);
+    EXPECT_EQ(engine->getDictionaryCount(), 1u);
+    EXPECT_EQ(user->getLayoutHash(), TemplateStore::layoutHash(layout));
+    for (const auto& c : engine->recognize(hallo, 8)) EXPECT_NE(c.word, "hallo");
+
+    // Frequencies count in units of the main dictionary (max 1'000'000)
+    ASSERT_TRUE(user->addWord("hallo", 100'000));
+    auto got = engine->recognize(hallo, 8);
+    ASSERT_FALSE(got.empty());
+    EXPECT_EQ(got[0].word, "hallo");
+    EXPECT_EQ(got[0].sourceFlags, SOURCE_USER_DICT);
+    EXPECT_FLOAT_EQ(got[0].frequencyScore, 0.1f);
+    ASSERT_TRUE(user->bumpFrequency("hallo", 100'000));
+    EXPECT_FLOAT_EQ(engine->recognize(hallo, 8)[0].frequencyScore, 0.2f);
+
+    // Learning a dictionary word lists it once, at its learned frequency
+    RawGesturePath hello;
+    hello.points = makePathForWord(layout, "hello");
+    ASSERT_TRUE(user->bumpFrequency("hello", 500'000));
+    size_t hellos = 0;
+    for (const auto& c : engine->recognize(hello, 8)) {
+        if (c.word != "hello") continue;
+        ++hellos;
+        EXPECT_EQ(c.sourceFlags, SOURCE_MAIN_DICT | SOURCE_USER_DICT);
+        EXPECT_FLOAT_EQ(c.frequencyScore, 0.5f);
+    }
+    EXPECT_EQ(hellos, 1u);
+
+    // Compiled main templates leave the ranking as it was; the user
+    // dictionary's templates follow a new layout
+    std::vector<GestureCandidate> onLayout = engine->recognize(hallo, 8);
+    ASSERT_TRUE(engine->compileTemplates());
+    expectSameCandidates(engine->recognize(hallo, 8), onLayout);
+    const KeyboardLayout moved = shiftedLayout(2.0f);
+    ASSERT_TRUE(engine->updateLayout(moved));
+    EXPECT_EQ(engine->recognize(hallo, 8)[0].word, "hallo");
+    EXPECT_EQ(user->getLayoutHash(), TemplateStore::layoutHash(moved));
+
+    ASSERT_TRUE(user->removeWord("hallo"));
+    for (const auto& c : engine->recognize(hallo, 8)) EXPECT_NE(c.word, "hallo");
+
+    ASSERT_TRUE(engine->setUserDictionary(nullptr));
+    EXPECT_EQ(engine->getUserDictionary(), nullptr);
+    for (const auto& c : engine->recognize(hello, 8)) {
+        if (c.word == "hello") {
+            EXPECT_EQ(c.sourceFlags, SOURCE_MAIN_DICT);
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, ResampleCountAppliesToPathsAndTemplates) {
+    RawGesturePath hello, hallo;
+    hello.points = makePathForWord(layout, "hello");
+    hallo.points = makePathForWord(layout, "hallo");
+    auto user = std::make_shared<UserDictionary>();
+    ASSERT_TRUE(user->addWord("hallo", 100'000));
+    ASSERT_TRUE(engine->setUserDictionary(user));
+    const auto full = engine->recognize(hello, 8);
+
+    ScoringConfig config;
+    config.resampleCount = 32;
+    engine->configure(config);
+    const auto lazy = engine->recognize(hello, 8);
+    ASSERT_FALSE(lazy.empty());
+    EXPECT_EQ(lazy[0].word, "hello");
+    EXPECT_EQ(engine->recognize(hallo, 8)[0].word, "hallo");
+    EXPECT_EQ(user->getPointCount(), 32);
+    expectSameCandidates(engine->recognizeBatch({hello}, 8)[0], lazy);
+
+    // Templates are compiled at the configured count, and recompiled when it changes
+    ASSERT_TRUE(engine->compileTemplates());
+    EXPECT_EQ(engine->getTemplateStore()->getPointCount(), 32);
+    expectSameCandidates(engine->recognize(hello, 8), lazy);
+    config.resampleCount = RESAMPLE_COUNT;
+    engine->configure(config);
+    ASSERT_TRUE(engine->hasCompiledTemplates());
+    EXPECT_EQ(engine->getTemplateStore()->getPointCount(), RESAMPLE_COUNT);
+    expectSameCandidates(engine->recognize(hello, 8), full);
+
+    auto other = std::make_shared<TemplateStore>();
+    ASSERT_TRUE(other->compile(layout, engine->getDictionaryStore()->getDictionary(),
+                               TemplatePrecision::FLOAT32, 32));
+    EXPECT_FALSE(engine->attachTemplates(other));
+}
+
+TEST_F(GestureEngineTest, ParallelScoringAcrossDictionariesMatchesSerial) {
+    std::vector<std::pair<std::string, uint32_t>> first, second;
+    const std::string letters = "aeiltrsw";
+    uint32_t freq = 5000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters) {
+                auto& words = (b < 'l') ? first : second;
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq = freq * 7 % 100'003});
+            }
+    std::vector<uint8_t> data = buildTestDict(first);
+    auto other = makeStore(second);
+
+    std::vector<RawGesturePath> gestures;
+    for (const char* word : {"hello", "hairo", "hwsto"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        gestures.push_back(raw);
+    }
+
+    GestureEngine serial;
+    ASSERT_TRUE(serial.initWithData(layout, data.data(), data.size()));
+    ASSERT_TRUE(serial.addDictionary(other, 0.7f, SOURCE_USER_DICT));
+    std::vector<std::vector<GestureCandidate>> expected;
+    for (const auto& raw : gestures) expected.push_back(serial.recognize(raw, 10));
+    EXPECT_EQ(expected[2][0].word, "hwsto");
+    EXPECT_EQ(expected[2][0].sourceFlags, SOURCE_USER_DICT);
+
+    for (int threads : {2, 4}) {
+        for (bool compiled : {false, true}) {
+            GestureEngine parallel;
+            ScoringConfig config;
+            config.scoringThreads = threads;
+            parallel.configure(config);
+            ASSERT_TRUE(parallel.initWithData(layout, data.data(), data.size()));
+            ASSERT_TRUE(parallel.addDictionary(other, 0.7f, SOURCE_USER_DICT));
+            if (compiled) {
+                ASSERT_TRUE(parallel.compileTemplates());
+            }
+            for (size_t g = 0; g < gestures.size(); ++g) {
+                expectSameCandidates(parallel.recognize(gestures[g], 10), expected[g]);
+            }
+            auto batch = parallel.recognizeBatch(gestures, 10);
+            for (size_t g = 0; g < gestures.size(); ++g) {
+                expectSameCandidates(batch[g], expected[g]);
+            }
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, TopCandidatesArePrefixOfFullRanking) {
+    // Many similar words, several sharing a frequency, some in both dictionaries
+    std::vector<std::pair<std::string, uint32_t>> first, second;
+    const std::string letters = "aeiltrsw";
+    for (char a : letters)
+        for (char b : letters) {
+            const uint32_t freq = 1000u * static_cast<uint32_t>((a + b) % 7 + 1);
+            first.push_back({std::string{'h', a, b, 'l', 'o'}, freq});
+            if (b != 'e') second.push_back({std::string{'h', a, b, 'l', 'o'}, freq * 2});
+        }
+    std::vector<uint8_t> data = buildTestDict(first);
+
+    GestureEngine single;
+    ASSERT_TRUE(single.initWithData(layout, data.data(), data.size()));
+    GestureEngine merged;
+    ASSERT_TRUE(merged.initWithData(layout, data.data(), data.size()));
+    ASSERT_TRUE(merged.addDictionary(makeStore(second), 0.5f, SOURCE_USER_DICT));
+
+    for (const char* word : {"hello", "hairo", "hwllo"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        for (GestureEngine* e : {&single, &merged}) {
+            auto all = e->recognize(raw, MAX_MAX_CANDIDATES);
+            ASSERT_GT(all.size(), 8u) << word;
+            for (size_t i = 1; i < all.size(); ++i) {
+                EXPECT_GE(all[i - 1].confidence, all[i].confidence);
+            }
+            for (int k : {1, 3, 8}) {
+                std::vector<GestureCandidate> prefix(all.begin(), all.begin() + k);
+                expectSameCandidates(e->recognize(raw, k), prefix);
+            }
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, QuantizedTemplatesKeepRanking) {
+    ASSERT_TRUE(engine->compileTemplates());
+    std::vector<RawGesturePath> gestures;
+    std::vector<std::vector<GestureCandidate>> exact;
+    for (const char* word : {"hello", "the", "world", "go"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        gestures.push_back(raw);
+        exact.push_back(engine->recognize(raw, 8));
+    }
+
+    // configure() recompiles the active templates in the new precision
+    ScoringConfig config;
+    config.templatePrecision = TemplatePrecision::UINT16;
+    engine->configure(config);
+    ASSERT_TRUE(engine->hasCompiledTemplates());
+
+    for (size_t g = 0; g < gestures.size(); ++g) {
+        auto quantized = engine->recognize(gestures[g], 8);
+        ASSERT_EQ(quantized.size(), exact[g].size());
+        for (size_t i = 0; i < quantized.size(); ++i) {
+            EXPECT_EQ(quantized[i].word, exact[g][i].word);
+            EXPECT_NEAR(quantized[i].dtwScore, exact[g][i].dtwScore,
+                        1.5f / TEMPLATE_UINT16_SCALE);
+        }
+    }
+
+    config.templatePrecision = TemplatePrecision::UINT8;
+    engine->configure(config);
+    for (size_t g = 0; g < gestures.size(); ++g) {
+        auto quantized = engine->recognize(gestures[g], 8);
+        ASSERT_FALSE(quantized.empty());
+        EXPECT_EQ(quantized[0].word, exact[g][0].word);
+        EXPECT_NEAR(quantized[0].dtwScore, exact[g][0].dtwScore,
+                    1.5f / TEMPLATE_UINT8_SCALE);
+    }
+}
+
+TEST_F(GestureEngineTest, ShortlistHoldsLowestDTWCandidates) {
+    // 216 five-letter h...o words share one bucket, far more than the shortlist
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    const int shortlist = 20;
+    GestureEngine big;
+    ASSERT_TRUE(big.initWithData(layout, data.data(), data.size()));
+    ScoringConfig config;
+    config.maxCandidatesEvaluated = shortlist;
+    config.lexiconCandidates = false;  // score the whole bucket, not just words near the path
+    big.configure(config);
+
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto results = big.recognize(raw, shortlist);
+    ASSERT_EQ(results.size(), static_cast<size_t>(shortlist));
+
+    // Exhaustive DTW over the same words with the same components
+    PathProcessor processor;
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    Scorer scorer;
+    GesturePath gesture = processor.normalize(raw, layout);
+    std::vector<float> all;
+    for (const auto& w : words) {
+        all.push_back(scorer.computeDTWDistance(gesture, generator.getIdealPath(w.first)));
+    }
+    std::sort(all.begin(), all.end());
+    all.resize(static_cast<size_t>(shortlist));
+
+    std::vector<float> got;
+    for (const auto& c : results) got.push_back(c.dtwScore);
+    std::sort(got.begin(), got.end());
+    EXPECT_EQ(got, all);
+
+    // Compiled templates prune the same way
+    ASSERT_TRUE(big.compileTemplates());
+    auto compiled = big.recognize(raw, shortlist);
+    ASSERT_EQ(compiled.size(), results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(compiled[i].word, results[i].word);
+        EXPECT_EQ(compiled[i].confidence, results[i].confidence);
+    }
+}
+
+TEST_F(GestureEngineTest, ParallelScoringMatchesSerial) {
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltrsw";
+    uint32_t freq = 5000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq = freq * 7 % 100'003});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    std::vector<RawGesturePath> gestures;
+    for (const char* word : {"hello", "hairo", "hwsto"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        gestures.push_back(raw);
+    }
+
+    GestureEngine serial;
+    ASSERT_TRUE(serial.initWithData(layout, data.data(), data.size()));
+    std::vector<std::vector<GestureCandidate>> expected;
+    for (const auto& raw : gestures) expected.push_back(serial.recognize(raw, 10));
+
+    for (int threads : {2, 4, 0}) {
+        for (bool compiled : {false, true}) {
+            GestureEngine parallel;
+            ScoringConfig config;
+            config.scoringThreads = threads;
+            parallel.configure(config);
+            ASSERT_TRUE(parallel.initWithData(layout, data.data(), data.size()));
+            if (compiled) {
+                ASSERT_TRUE(parallel.compileTemplates());
+            }
+
+            for (size_t g = 0; g < gestures.size(); ++g) {
+                auto got = parallel.recognize(gestures[g], 10);
+                ASSERT_EQ(got.size(), expected[g].size()) << threads << " threads";
+                for (size_t i = 0; i < got.size(); ++i) {
+                    EXPECT_EQ(got[i].word, expected[g][i].word) << threads << " threads";
+                    EXPECT_EQ(got[i].dtwScore, expected[g][i].dtwScore);
+                    EXPECT_EQ(got[i].confidence, expected[g][i].confidence);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, WarmRecognizeOnlyAllocatesResults) {
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    RawGesturePath hello, heart;
+    hello.points = makePathForWord(layout, "hello");
+    heart.points = makePathForWord(layout, "hearo");
+
+    // Parallel scoring without templates generates paths per call, so it is
+    // not covered
+    for (int threads : {1, 4}) {
+        for (bool compiled : {false, true}) {
+            if (threads > 1 && !compiled) continue;
+            GestureEngine warm;
+            ScoringConfig config;
+            config.scoringThreads = threads;
+            config.resultCacheSize = 0;  // repeats would be answered from it
+            warm.configure(config);
+            ASSERT_TRUE(warm.initWithData(layout, data.data(), data.size()));
+            if (compiled) {
+                ASSERT_TRUE(warm.compileTemplates());
+            }
+            // First calls size the scratch buffers and fill the path cache
+            warm.recognize(hello, 10);
+            warm.recognize(heart, 10);
+
+            for (const RawGesturePath* raw : {&hello, &heart}) {
+                std::vector<GestureCandidate> results;
+                {
+                    AllocationCounter counter;
+                    results = warm.recognize(*raw, 10);
+                    // The result vector itself; its words fit in SSO storage
+                    EXPECT_EQ(counter.count(), 1u)
+                        << threads << " threads, compiled=" << compiled;
+                }
+                EXPECT_EQ(results.size(), 10u);
+            }
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, WarmResultCacheMissOnlyAllocatesResults) {
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    RawGesturePath hello, heart;
+    hello.points = makePathForWord(layout, "hello");
+    heart.points = makePathForWord(layout, "hearo");
+
+    // One entry: each gesture evicts the other. The default size: the
+    // entries are dropped by configure() and stored again.
+    for (int cacheSize : {1, DEFAULT_RESULT_CACHE_SIZE}) {
+        GestureEngine warm;
+        ScoringConfig config;
+        config.resultCacheSize = cacheSize;
+        warm.configure(config);
+        ASSERT_TRUE(warm.initWithData(layout, data.data(), data.size()));
+        // Two rounds size the scratch buffers and the cache entries for both
+        for (int round = 0; round < 2; ++round) {
+            warm.recognize(hello, 10);
+            warm.recognize(heart, 10);
+        }
+        if (cacheSize > 1) warm.configure(config);
+
+        const ResultCacheStats before = warm.getResultCacheStats();
+        for (const RawGesturePath* raw : {&hello, &heart}) {
+            std::vector<GestureCandidate> results;
+            {
+                AllocationCounter counter;
+                results = warm.recognize(*raw, 10);
+                // Storing the ranking reuses a cache entry's buffers
+                EXPECT_EQ(counter.count(), 1u) << "resultCacheSize=" << cacheSize;
+            }
+            EXPECT_EQ(results.size(), 10u);
+        }
+        EXPECT_EQ(warm.getResultCacheStats().misses, before.misses + 2);
+        EXPECT_EQ(warm.getResultCacheStats().hits, before.hits);
+    }
+}
+
+TEST_F(GestureEngineTest, BatchMatchesRecognizeInInputOrder) {
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltrsw";
+    uint32_t freq = 5000;
+    for (char a : letters)
+        for (char b : letters)
+            words.push_back({std::string{'h', a, b, 'o'}, freq = freq * 7 % 100'003});
+    for (const char* w : {"the", "toe", "tie", "world", "would", "go", "help", "hello"})
+        words.push_back({w, freq = freq * 7 % 100'003});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    // Interleave buckets so grouping has to reorder, plus an unusable path
+    std::vector<RawGesturePath> gestures;
+    for (int round = 0; round < 6; ++round) {
+        for (const char* word : {"hello", "the", "hairo", "world", "help", "hwso", "go"}) {
+            RawGesturePath raw;
+            raw.points = makePathForWord(layout, word, 6 + round);
+            gestures.push_back(raw);
+        }
+    }
+    gestures.insert(gestures.begin() + 5, RawGesturePath());
+
+    GestureEngine single;
+    ScoringConfig uncached;
+    uncached.resultCacheSize = 0;  // the rounds differ by less than its quantum
+    single.configure(uncached);
+    ASSERT_TRUE(single.initWithData(layout, data.data(), data.size()));
+    std::vector<std::vector<GestureCandidate>> expected;
+    for (const auto& raw : gestures) expected.push_back(single.recognize(raw, 6));
+
+    for (int threads : {1, 4}) {
+        for (bool compiled : {false, true}) {
+            GestureEngine batch;
+            ScoringConfig config;
+            config.scoringThreads = threads;
+            batch.configure(config);
+            ASSERT_TRUE(batch.initWithData(layout, data.data(), data.size()));
+            if (compiled) {
+                ASSERT_TRUE(batch.compileTemplates());
+            }
+
+            auto got = batch.recognizeBatch(gestures, 6);
+            ASSERT_EQ(got.size(), gestures.size());
+            EXPECT_TRUE(got[5].empty());
+#ifndef SWIPETYPE_NO_STATS
+            // A lazy batch generates each word's path at most once, even
+            // with its gestures split across threads
+            const RecognitionStats stats = batch.getLastRecognitionStats();
+            if (!compiled) {
+                EXPECT_GT(stats.pathsGenerated, 0u);
+                EXPECT_LE(stats.pathsGenerated, words.size()) << threads << " threads";
+            }
+#endif
+            for (size_t g = 0; g < gestures.size(); ++g) {
+                ASSERT_EQ(got[g].size(), expected[g].size()) << "gesture " << g;
+                for (size_t i = 0; i < got[g].size(); ++i) {
+                    EXPECT_EQ(got[g][i].word, expected[g][i].word)
+                        << "gesture " << g << ", " << threads << " threads";
+                    EXPECT_EQ(got[g][i].confidence, expected[g][i].confidence);
+                }
+            }
+        }
+    }
+
+    GestureEngine uninitialized;
+    auto none = uninitialized.recognizeBatch(gestures);
+    EXPECT_EQ(none.size(), gestures.size());
+    EXPECT_EQ(uninitialized.getLastError().code, ErrorCode::ENGINE_NOT_INITIALIZED);
+}
+
+// ----- Recognition stats -----
+
+TEST_F(GestureEngineTest, CoarsePrefilterKeepsBestCandidates) {
+    // 512 five-letter h???o words share the gesture's bucket and length
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeilnrst";
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, 1000});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+
+    auto recognizeWith = [&](int coarseCandidates, RecognitionStats& stats) {
+        GestureEngine e;
+        ScoringConfig config;
+        config.coarseCandidates = coarseCandidates;
+        config.lexiconCandidates = false;  // all 512 words, not just those near the path
+        e.configure(config);
+        EXPECT_TRUE(e.initWithData(layout, data.data(), data.size()));
+        EXPECT_TRUE(e.compileTemplates());
+        auto results = e.recognize(raw, 5);
+        stats = e.getLastRecognitionStats();
+        return results;
+    };
+
+    RecognitionStats exact, coarse;
+    auto reference = recognizeWith(0, exact);
+    auto filtered = recognizeWith(64, coarse);
+    ASSERT_FALSE(reference.empty());
+    ASSERT_FALSE(filtered.empty());
+    EXPECT_EQ(filtered[0].word, reference[0].word);
+    EXPECT_EQ(filtered[0].dtwScore, reference[0].dtwScore);
+
+#ifndef SWIPETYPE_NO_STATS
+    EXPECT_EQ(exact.coarseScored, 0u);
+    EXPECT_EQ(exact.templateReads, 512u);
+    EXPECT_EQ(coarse.coarseScored, 512u);
+    EXPECT_EQ(coarse.coarseKept, 64u);
+    EXPECT_EQ(coarse.templateReads, 64u);
+#endif
+}
+
+TEST_F(GestureEngineTest, LexiconWalkReplacesFullScan) {
+    RawGesturePath exact;
+    exact.points = makePathForWord(layout, "world");
+    auto traced = engine->recognize(exact, 5);
+    ASSERT_FALSE(traced.empty());
+    EXPECT_EQ(traced[0].word, "world");
+#ifndef SWIPETYPE_NO_STATS
+    EXPECT_EQ(engine->getLastRecognitionStats().lexiconWidened, 0u);
+#endif
+
+    // "world" started on 'q': no word is traced along the crossed keys alone,
+    // and the q/d bucket and the q bucket are empty
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "world");
+    raw.points.insert(raw.points.begin(), GesturePoint(16.0f, 26.0f, 0));
+    for (size_t i = 1; i < raw.points.size(); ++i) raw.points[i].timestamp += 16;
+
+    auto candidates = engine->recognize(raw, 5);
+    ASSERT_FALSE(candidates.empty());
+    EXPECT_EQ(candidates[0].word, "world");
+#ifndef SWIPETYPE_NO_STATS
+    RecognitionStats walked = engine->getLastRecognitionStats();
+    EXPECT_GT(walked.lexiconNodes, 0u);
+    EXPECT_EQ(walked.lexiconWidened, 1u);
+    EXPECT_GE(walked.bucketCandidates, 1u);
+    EXPECT_LT(walked.bucketCandidates, 9u);
+#endif
+
+    ScoringConfig config;
+    config.lexiconCandidates = false;
+    engine->configure(config);
+    candidates = engine->recognize(raw, 5);
+    ASSERT_FALSE(candidates.empty());
+    EXPECT_EQ(candidates[0].word, "world");
+#ifndef SWIPETYPE_NO_STATS
+    RecognitionStats scanned = engine->getLastRecognitionStats();
+    EXPECT_EQ(scanned.lexiconNodes, 0u);
+    EXPECT_EQ(scanned.lexiconWidened, 0u);
+    EXPECT_EQ(scanned.bucketCandidates, 9u);  // whole dictionary
+#endif
+}
+
+TEST_F(GestureEngineTest, StatsDescribeLastRecognition) {
+    ScoringConfig config;
+    config.resultCacheSize = 0;  // score the repeated gesture again
+    engine->configure(config);
+    std::vector<RecognitionStats> sunk;
+    engine->setStatsCallback([&](const RecognitionStats& stats) { sunk.push_back(stats); });
+
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto first = engine->recognize(raw, 5);
+    RecognitionStats cold = engine->getLastRecognitionStats();
+    engine->recognize(raw, 5);
+    RecognitionStats warm = engine->getLastRecognitionStats();
+
+#ifdef SWIPETYPE_NO_STATS
+    EXPECT_TRUE(sunk.empty());
+    EXPECT_EQ(cold.gestures, 0u);
+    EXPECT_EQ(warm.totalNs, 0u);
+#else
+    ASSERT_EQ(sunk.size(), 2u);
+    EXPECT_EQ(sunk[1].totalNs, warm.totalNs);
+
+    EXPECT_EQ(cold.gestures, 1u);
+    EXPECT_EQ(cold.rawPoints, raw.points.size());
+    EXPECT_GT(cold.estimatedLength, 0.0f);
+    EXPECT_LE(cold.filteredCandidates, cold.bucketCandidates);
+    EXPECT_EQ(cold.shortlisted, first.size());
+    EXPECT_GE(cold.dtwCalls, cold.shortlisted + cold.rejected);
+    EXPECT_GT(cold.totalNs, 0u);
+    EXPECT_GE(cold.totalNs, cold.normalizeNs + cold.filterNs + cold.rankNs);
+
+    // Every scored candidate's path is generated once, then found cached
+    const uint32_t scored = cold.lengthFilterFallbacks ? cold.bucketCandidates
+                                                       : cold.filteredCandidates;
+    EXPECT_EQ(cold.pathCacheHits + cold.pathsGenerated, scored);
+    EXPECT_GT(cold.pathsGenerated, 0u);
+    EXPECT_EQ(warm.pathsGenerated, 0u);
+    EXPECT_EQ(warm.pathCacheHits, scored);
+    EXPECT_EQ(warm.dtwCalls + warm.boundPruned, scored);
+    EXPECT_EQ(warm.templateReads, 0u);
+
+    ASSERT_TRUE(engine->compileTemplates());
+    engine->recognize(raw, 5);
+    RecognitionStats compiled = engine->getLastRecognitionStats();
+    EXPECT_EQ(compiled.templateReads, scored);
+    EXPECT_EQ(compiled.pathCacheHits + compiled.pathsGenerated, 0u);
+
+    EXPECT_NE(compiled.toString().find("gestures=1 "), std::string::npos);
+#endif
+}
+
+TEST_F(GestureEngineTest, StatsCoverBatchesAndStreamsButNotPreviews) {
+    std::vector<RecognitionStats> sunk;
+    engine->setStatsCallback([&](const RecognitionStats& stats) { sunk.push_back(stats); });
+
+    std::vector<RawGesturePath> gestures;
+    size_t points = 0;
+    for (const char* word : {"hello", "the", "world"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        points += raw.points.size();
+        gestures.push_back(raw);
+    }
+    engine->recognizeBatch(gestures);
+    RecognitionStats batch = engine->getLastRecognitionStats();
+
+    engine->setPreviewCallback([](const std::vector<GestureCandidate>&) {}, 20);
+    ASSERT_TRUE(engine->beginGesture());
+    for (const auto& pt : gestures[0].points) engine->addPoints(&pt, 1);
+    engine->endGesture();
+    RecognitionStats streamed = engine->getLastRecognitionStats();
+
+#ifdef SWIPETYPE_NO_STATS
+    EXPECT_TRUE(sunk.empty());
+    EXPECT_EQ(batch.gestures + streamed.gestures, 0u);
+#else
+    ASSERT_EQ(sunk.size(), 2u);
+    EXPECT_EQ(batch.gestures, 3u);
+    EXPECT_EQ(batch.rawPoints, points);
+    EXPECT_GT(batch.normalizeNs, 0u);
+    EXPECT_EQ(streamed.gestures, 1u);
+    EXPECT_EQ(streamed.rawPoints, gestures[0].points.size());
+#endif
+
+    const size_t delivered = sunk.size();
+    engine->setStatsCallback(nullptr);
+    engine->recognize(gestures[1]);
+    EXPECT_EQ(sunk.size(), delivered);
+}
+
+// ----- Streaming -----
+
+TEST_F(GestureEngineTest, TrimMemoryEmptiesPathCacheWithoutChangingResults) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto before = engine->recognize(raw, 5);
+    PathCacheStats full = engine->getPathCacheStats();
+    ASSERT_GT(full.entries, 1u);
+    EXPECT_EQ(full.budgetBytes, DEFAULT_PATH_CACHE_BYTES);
+    EXPECT_LE(full.bytes, full.budgetBytes);
+
+    engine->trimMemory(MemoryTrimLevel::COMPLETE);
+    EXPECT_EQ(engine->getPathCacheStats().entries, 0u);
+
+    auto after = engine->recognize(raw, 5);
+    ASSERT_EQ(after.size(), before.size());
+    for (size_t i = 0; i < after.size(); ++i) {
+        EXPECT_EQ(after[i].word, before[i].word);
+        EXPECT_FLOAT_EQ(after[i].confidence, before[i].confidence);
+    }
+    EXPECT_EQ(engine->getPathCacheStats().entries, full.entries);
+
+    // MODERATE keeps at most half the budget
+    ScoringConfig config;
+    config.pathCacheBytes = full.entryBytes * 4;
+    engine->configure(config);
+    EXPECT_EQ(engine->getPathCacheStats().entries, std::min<size_t>(full.entries, 4u));
+    RawGesturePath other;
+    other.points = makePathForWord(layout, "world");
+    engine->recognize(other, 5);
+    ASSERT_GT(engine->getPathCacheStats().entries, 2u);
+    const size_t reserved = engine->getPathCacheStats().reservedBytes;
+    engine->trimMemory(MemoryTrimLevel::MODERATE);
+    EXPECT_LE(engine->getPathCacheStats().entries, 2u);
+    EXPECT_LT(engine->getPathCacheStats().reservedBytes, reserved);
+    EXPECT_EQ(engine->recognize(raw, 5)[0].word, before[0].word);
+}
+
+TEST_F(GestureEngineTest, ResultCacheAnswersRepeatedGestures) {
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    auto first = engine->recognize(raw, 5);
+    ASSERT_FALSE(first.empty());
+    ResultCacheStats stats = engine->getResultCacheStats();
+    EXPECT_EQ(stats.capacity, static_cast<size_t>(DEFAULT_RESULT_CACHE_SIZE));
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+
+    expectSameCandidates(engine->recognize(raw, 5), first);
+    stats = engine->getResultCacheStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+#ifndef SWIPETYPE_NO_STATS
+    RecognitionStats hit = engine->getLastRecognitionStats();
+    EXPECT_EQ(hit.resultCacheHits, 1u);
+    EXPECT_EQ(hit.gestures, 1u);
+    EXPECT_EQ(hit.dtwCalls + hit.filteredCandidates, 0u);
+#endif
+
+    // Another maxCandidates is another key, and the streaming API shares the cache
+    EXPECT_EQ(engine->recognize(raw, 3).size(), std::min<size_t>(3, first.size()));
+    EXPECT_EQ(engine->getResultCacheStats().entries, 2u);
+    ASSERT_TRUE(engine->beginGesture());
+    engine->addPoints(raw.points);
+    expectSameCandidates(engine->endGesture(5), first);
+    EXPECT_EQ(engine->getResultCacheStats().hits, 2u);
+
+    // Changes drop the cached rankings
+    auto user = std::make_shared<UserDictionary>();
+    ASSERT_TRUE(engine->setUserDictionary(user));
+    engine->recognize(raw, 5);
+    stats = engine->getResultCacheStats();
+    EXPECT_EQ(stats.invalidations, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    ASSERT_TRUE(user->addWord("hello", 1'000'000));
+    auto learned = engine->recognize(raw, 5);
+    EXPECT_EQ(learned[0].sourceFlags, SOURCE_MAIN_DICT | SOURCE_USER_DICT);
+    EXPECT_EQ(engine->getResultCacheStats().invalidations, 2u);
+
+    ScoringConfig config;
+    config.resultCacheSize = 0;
+    engine->configure(config);
+    stats = engine->getResultCacheStats();
+    EXPECT_EQ(stats.invalidations, 3u);
+    EXPECT_EQ(stats.entries, 0u);
+    EXPECT_EQ(stats.capacity, 0u);
+    engine->recognize(raw, 5);
+    engine->recognize(raw, 5);
+    EXPECT_EQ(engine->getResultCacheStats().hits, stats.hits);
+    EXPECT_EQ(engine->getResultCacheStats().entries, 0u);
+
+    engine->configure(ScoringConfig());
+    engine->recognize(raw, 5);
+    engine->trimMemory(MemoryTrimLevel::COMPLETE);
+    EXPECT_EQ(engine->getResultCacheStats().entries, 0u);
+}
+
+TEST_F(GestureEngineTest, NearCachedGestureSeedsSameRanking) {
+    // 216 h...o words in one bucket, so a shortlist fills and can be seeded
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    // The same words drawn a little differently each round: near, never equal
+    std::vector<RawGesturePath> gestures;
+    for (int round = 0; round < 4; ++round) {
+        for (const char* word : {"hello", "hatro", "hitlo"}) {
+            RawGesturePath raw;
+            raw.points = makePathForWord(layout, word);
+            for (size_t i = 0; i < raw.points.size(); ++i) {
+                raw.points[i].x += static_cast<float>(static_cast<int>((i + round) % 5) - 2) * round;
+                raw.points[i].y += static_cast<float>(static_cast<int>((i * 3 + round) % 5) - 2);
+            }
+            gestures.push_back(raw);
+        }
+    }
+
+    for (int threads : {1, 4}) {
+        for (bool compiled : {false, true}) {
+            ScoringConfig config;
+            config.scoringThreads = threads;
+            config.lexiconCandidates = false;  // score the whole bucket
+            GestureEngine cached;
+            cached.configure(config);
+            config.resultCacheSize = 0;
+            GestureEngine uncached;
+            uncached.configure(config);
+            ASSERT_TRUE(cached.initWithData(layout, data.data(), data.size()));
+            ASSERT_TRUE(uncached.initWithData(layout, data.data(), data.size()));
+            if (compiled) {
+                ASSERT_TRUE(cached.compileTemplates());
+                ASSERT_TRUE(uncached.compileTemplates());
+            }
+
+            uint32_t seeds = 0;
+            for (const auto& raw : gestures) {
+                expectSameCandidates(cached.recognize(raw, 4), uncached.recognize(raw, 4));
+                seeds += cached.getLastRecognitionStats().resultCacheSeeds;
+            }
+            ResultCacheStats stats = cached.getResultCacheStats();
+            EXPECT_EQ(stats.hits, 0u);
+            EXPECT_GT(stats.nearHits, 0u);
+            EXPECT_EQ(stats.hits + stats.nearHits + stats.misses, gestures.size());
+#ifndef SWIPETYPE_NO_STATS
+            EXPECT_GT(seeds, 0u);
+#else
+            EXPECT_EQ(seeds, 0u);
+#endif
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, ScoringBudgetScoresFrequentWordsFirst) {
+    // 216 h...o words, more frequent the later they sort
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+
+    ScoringConfig config;
+    config.lexiconCandidates = false;  // score the whole bucket
+    config.resultCacheSize = 0;
+    GestureEngine full;
+    full.configure(config);
+    ASSERT_TRUE(full.initWithData(layout, data.data(), data.size()));
+    std::vector<GestureCandidate> expected = full.recognize(raw, 4);
+    EXPECT_FALSE(full.wasLastRecognitionTruncated());
+
+    // The first 4 shortlisted words are free, then 10 more DTW calls: the
+    // ranking comes from the 14 most frequent words alone
+    config.scoringBudgetDtwCalls = 10;
+    GestureEngine budgeted;
+    budgeted.configure(config);
+    ASSERT_TRUE(budgeted.initWithData(layout, data.data(), data.size()));
+    std::vector<GestureCandidate> got = budgeted.recognize(raw, 4);
+    EXPECT_TRUE(budgeted.wasLastRecognitionTruncated());
+    ASSERT_EQ(got.size(), 4u);
+    for (const auto& c : got) {
+        auto it = std::find_if(words.begin(), words.end(),
+                               [&](const auto& w) { return w.first == c.word; });
+        ASSERT_NE(it, words.end());
+        EXPECT_GE(it - words.begin(), static_cast<std::ptrdiff_t>(words.size() - 14)) << c.word;
+    }
+#ifndef SWIPETYPE_NO_STATS
+    RecognitionStats stats = budgeted.getLastRecognitionStats();
+    EXPECT_EQ(stats.budgetTruncated, 1u);
+    EXPECT_EQ(stats.dtwCalls, 14u);
+    EXPECT_EQ(stats.budgetSkipped, words.size() - 14u);
+#endif
+
+    // A budget that is never reached changes nothing
+    config.scoringBudgetDtwCalls = 1000;
+    config.scoringBudgetUs = 10'000'000;
+    GestureEngine roomy;
+    roomy.configure(config);
+    ASSERT_TRUE(roomy.initWithData(layout, data.data(), data.size()));
+    expectSameCandidates(roomy.recognize(raw, 4), expected);
+    EXPECT_FALSE(roomy.wasLastRecognitionTruncated());
+
+    // A spent time budget still returns maxCandidates words, on any number
+    // of threads, and a truncated ranking is not cached
+    for (int threads : {1, 4}) {
+        config.scoringThreads = threads;
+        config.scoringBudgetDtwCalls = 0;
+        config.scoringBudgetUs = 1;
+        config.resultCacheSize = DEFAULT_RESULT_CACHE_SIZE;
+        GestureEngine hurried;
+        hurried.configure(config);
+        ASSERT_TRUE(hurried.initWithData(layout, data.data(), data.size()));
+        for (int round = 0; round < 2; ++round) {
+            EXPECT_EQ(hurried.recognize(raw, 4).size(), 4u);
+            EXPECT_TRUE(hurried.wasLastRecognitionTruncated());
+        }
+        EXPECT_EQ(hurried.getResultCacheStats().hits, 0u);
+        EXPECT_EQ(hurried.recognizeBatch({raw, raw}, 4)[1].size(), 4u);
+        EXPECT_TRUE(hurried.wasLastRecognitionTruncated());
+
+        // A gesture too short to score was not truncated either
+        RawGesturePath tap;
+        tap.points = {raw.points[0]};
+        EXPECT_TRUE(hurried.recognize(tap, 4).empty());
+        EXPECT_FALSE(hurried.wasLastRecognitionTruncated());
+        EXPECT_EQ(hurried.getLastRecognitionStats().dtwCalls, 0u);
+        ASSERT_TRUE(hurried.beginGesture());
+        EXPECT_TRUE(hurried.endGesture(4).empty());
+        EXPECT_FALSE(hurried.wasLastRecognitionTruncated());
+    }
+}
+
+TEST_F(GestureEngineTest, ScoringBudgetIncludesSeedWords) {
+    // 216 h...o words in one bucket, so a shortlist fills and can be seeded
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    // The in-flight ranking leaves 20 seed words. Scoring them takes up to
+    // 20 of the budget's calls, so the gesture's own DTW calls stay within
+    // the budget plus the 4 free ones.
+    ScoringConfig config;
+    config.lexiconCandidates = false;  // score the whole bucket
+    config.resultCacheSize = 0;
+    config.scoringBudgetDtwCalls = 24;
+    GestureEngine budgeted;
+    budgeted.configure(config);
+    ASSERT_TRUE(budgeted.initWithData(layout, data.data(), data.size()));
+
+    uint32_t seeds = 0;
+    for (const char* word : {"hello", "hatro", "hitlo"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);  // 10 ms between points
+        addNoise(raw.points, 2.0f, 2.0f);
+        ASSERT_TRUE(budgeted.beginGesture());
+        for (const auto& pt : raw.points) budgeted.addPoints(&pt, 1);
+        EXPECT_EQ(budgeted.endGesture(4).size(), 4u);
+        const RecognitionStats stats = budgeted.getLastRecognitionStats();
+        seeds += stats.streamSeeds;
+        EXPECT_LE(stats.dtwCalls, 24u + 4u) << word;
+    }
+#ifndef SWIPETYPE_NO_STATS
+    EXPECT_GT(seeds, 0u);
+#endif
+}
+
+// ----- Warm-up -----
+
+/** Poll until the engine's warm-up is no longer running. */
+static WarmupProgress waitForWarmup(const GestureEngine& engine) {
+    WarmupProgress progress = engine.getWarmupProgress();
+    for (int i = 0; i < 20'000 && progress.state == WarmupState::RUNNING; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        progress = engine.getWarmupProgress();
+    }
+    return progress;
+}
+
+TEST_F(GestureEngineTest, WarmupPreparesFrequentWordsThenTemplates) {
+    EXPECT_EQ(engine->getWarmupProgress().state, WarmupState::IDLE);  // OFF by default
+    std::vector<RawGesturePath> gestures;
+    std::vector<std::vector<GestureCandidate>> cold;
+    for (const char* word : {"hello", "the", "world", "go"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        gestures.push_back(raw);
+        cold.push_back(engine->recognize(raw, 8));
+    }
+
+    // One word per start/end bucket: hero shares h...o with the more frequent hello
+    ScoringConfig config;
+    config.warmup = WarmupLevel::FREQUENT;
+    config.warmupWordsPerBucket = 1;
+    GestureEngine frequent;
+    frequent.configure(config);
+    ASSERT_TRUE(frequent.initWithData(layout, testDict.data(), testDict.size()));
+    WarmupProgress progress = waitForWarmup(frequent);
+    EXPECT_EQ(progress.state, WarmupState::DONE);
+    EXPECT_EQ(progress.wordsTotal, 8u);
+    EXPECT_EQ(progress.wordsDone, 8u);
+    EXPECT_EQ(frequent.getPathCacheStats().entries, 0u);  // taken up by the next gesture
+    ASSERT_TRUE(frequent.beginGesture());
+    EXPECT_EQ(frequent.getPathCacheStats().entries, 8u);
+    frequent.cancelGesture();
+    EXPECT_FALSE(frequent.hasCompiledTemplates());
+
+    // Merged into the live cache (whether or not the first gesture came
+    // first): the paths it looked up are still cached for the second
+    GestureEngine early;
+    config.resultCacheSize = 0;
+    early.configure(config);
+    ASSERT_TRUE(early.initWithData(layout, testDict.data(), testDict.size()));
+    early.recognize(gestures[2], 8);
+    EXPECT_EQ(waitForWarmup(early).state, WarmupState::DONE);
+    const uint64_t misses = early.getPathCacheStats().misses;
+    early.recognize(gestures[2], 8);
+    EXPECT_EQ(early.getPathCacheStats().misses, misses);
+    EXPECT_GE(early.getPathCacheStats().entries, 8u);
+    config.resultCacheSize = DEFAULT_RESULT_CACHE_SIZE;
+
+    config.warmup = WarmupLevel::FULL;
+    config.warmupWordsPerBucket = DEFAULT_WARMUP_WORDS_PER_BUCKET;
+    GestureEngine full;
+    full.configure(config);
+    ASSERT_TRUE(full.initWithData(layout, testDict.data(), testDict.size()));
+    progress = waitForWarmup(full);
+    EXPECT_EQ(progress.state, WarmupState::DONE);
+    EXPECT_EQ(progress.wordsTotal, 9u + 9u);  // every word's path, then its template
+    EXPECT_EQ(progress.wordsDone, progress.wordsTotal);
+    for (size_t g = 0; g < gestures.size(); ++g) {
+        expectSameCandidates(full.recognize(gestures[g], 8), cold[g]);
+        EXPECT_TRUE(full.hasCompiledTemplates());
+    }
+
+    // Kept while the layout stays. A new layout is not compiled for on the
+    // spot, but warmed up again in the background.
+    ASSERT_TRUE(full.updateLayout(layout));
+    EXPECT_TRUE(full.hasCompiledTemplates());
+    EXPECT_EQ(full.getWarmupProgress().state, WarmupState::DONE);
+    KeyboardLayout moved = makeQwertyLayout();
+    for (auto& key : moved.keys) key.centerY += 1.0f;
+    ASSERT_TRUE(full.updateLayout(moved));
+    EXPECT_FALSE(full.hasCompiledTemplates());
+    EXPECT_EQ(waitForWarmup(full).state, WarmupState::DONE);
+    full.recognize(gestures[0], 8);
+    EXPECT_TRUE(full.hasCompiledTemplates());
+
+    full.shutdown();
+    EXPECT_EQ(full.getWarmupProgress().state, WarmupState::IDLE);
+}
+
+TEST_F(GestureEngineTest, WarmupIsCancellableAndDroppedWhenStale) {
+    // 32768 words: long enough to still be compiling when cancelled
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "adeghlot";
+    uint32_t freq = 1;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                for (char d : letters)
+                    for (char e : letters)
+                        words.push_back({std::string{a, b, c, d, e}, freq++});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    ScoringConfig config;
+    config.warmup = WarmupLevel::FULL;
+    GestureEngine warm;
+    warm.configure(config);
+    ASSERT_TRUE(warm.initWithData(layout, data.data(), data.size()));
+    EXPECT_EQ(warm.getWarmupProgress().state, WarmupState::RUNNING);
+    warm.cancelWarmup();
+    WarmupProgress progress = waitForWarmup(warm);
+    EXPECT_EQ(progress.state, WarmupState::CANCELLED);
+    EXPECT_LT(progress.wordsDone, progress.wordsTotal);
+
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");
+    EXPECT_FALSE(warm.recognize(raw, 5).empty());
+    EXPECT_FALSE(warm.hasCompiledTemplates());
+
+    // Results built for another layout are not used
+    ASSERT_TRUE(warm.initWithData(layout, testDict.data(), testDict.size()));
+    ASSERT_EQ(waitForWarmup(warm).state, WarmupState::DONE);
+    KeyboardLayout moved = makeQwertyLayout();
+    for (auto& key : moved.keys) key.centerY += 1.0f;
+    ASSERT_TRUE(warm.updateLayout(moved));
+    EXPECT_FALSE(warm.recognize(raw, 5).empty());
+    EXPECT_FALSE(warm.hasCompiledTemplates());
+
+    // Re-init and destruction stop a running warm-up
+    ASSERT_TRUE(warm.initWithData(layout, data.data(), data.size()));
+    config.warmup = WarmupLevel::OFF;
+    warm.configure(config);
+    ASSERT_TRUE(warm.initWithData(layout, testDict.data(), testDict.size()));
+    EXPECT_EQ(warm.getWarmupProgress().state, WarmupState::IDLE);
+    config.warmup = WarmupLevel::FULL;
+    GestureEngine dropped;
+    dropped.configure(config);
+    ASSERT_TRUE(dropped.initWithData(layout, data.data(), data.size()));
+}
+
+TEST_F(GestureEngineTest, StreamedGestureMatchesRecognize) {
+    for (const char* word : {"hello", "the", "world", "go", "help"}) {
+        RawGesturePath raw;
+        raw.points = makePathForWord(layout, word);
+        addNoise(raw.points, 3.0f, 3.0f);
+        auto expected = engine->recognize(raw, 8);
+
+        ASSERT_TRUE(engine->beginGesture());
+        EXPECT_TRUE(engine->isGestureInProgress());
+        for (size_t i = 0; i < raw.points.size(); i += 5) {
+            size_t n = std::min<size_t>(5, raw.points.size() - i);
+            ASSERT_TRUE(engine->addPoints(raw.points.data() + i, n));
+        }
+        auto streamed = engine->endGesture(8);
+        EXPECT_FALSE(engine->isGestureInProgress());
+
+        ASSERT_EQ(streamed.size(), expected.size()) << word;
+        for (size_t i = 0; i < streamed.size(); ++i) {
+            EXPECT_EQ(streamed[i].word, expected[i].word) << word;
+            EXPECT_EQ(streamed[i].dtwScore, expected[i].dtwScore) << word;
+            EXPECT_EQ(streamed[i].confidence, expected[i].confidence) << word;
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, InFlightRankingSeedsEndGesture) {
+    // 216 h...o words in one bucket, so a shortlist fills and can be seeded
+    std::vector<std::pair<std::string, uint32_t>> words;
+    const std::string letters = "aeiltr";
+    uint32_t freq = 1000;
+    for (char a : letters)
+        for (char b : letters)
+            for (char c : letters)
+                words.push_back({std::string{'h', a, b, c, 'o'}, freq += 37});
+    std::vector<uint8_t> data = buildTestDict(words);
+
+    for (int threads : {1, 4}) {
+        for (bool compiled : {false, true}) {
+            ScoringConfig config;
+            config.scoringThreads = threads;
+            config.lexiconCandidates = false;  // score the whole bucket
+            config.resultCacheSize = 0;
+            GestureEngine seeded;
+            seeded.configure(config);
+            config.inFlightRanking = false;
+            GestureEngine unseeded;
+            unseeded.configure(config);
+            for (GestureEngine* e : {&seeded, &unseeded}) {
+                ASSERT_TRUE(e->initWithData(layout, data.data(), data.size()));
+                if (compiled) {
+                    ASSERT_TRUE(e->compileTemplates());
+                }
+            }
+
+            uint32_t seeds = 0;
+            for (const char* word : {"hello", "hatro", "hitlo"}) {
+                RawGesturePath raw;
+                raw.points = makePathForWord(layout, word);  // 10 ms between points
+                addNoise(raw.points, 2.0f, 2.0f);
+                std::vector<GestureCandidate> streamed[2];
+                for (GestureEngine* e : {&seeded, &unseeded}) {
+                    ASSERT_TRUE(e->beginGesture());
+                    for (const auto& pt : raw.points) e->addPoints(&pt, 1);
+                    streamed[e == &unseeded] = e->endGesture(4);
+                }
+                expectSameCandidates(streamed[0], streamed[1]);
+                expectSameCandidates(streamed[0], unseeded.recognize(raw, 4));
+                seeds += seeded.getLastRecognitionStats().streamSeeds;
+                EXPECT_EQ(unseeded.getLastRecognitionStats().streamSeeds, 0u);
+            }
+#ifndef SWIPETYPE_NO_STATS
+            EXPECT_GT(seeds, 0u) << threads << " threads, compiled " << compiled;
+#else
+            EXPECT_EQ(seeds, 0u);
+#endif
+        }
+    }
+}
+
+TEST_F(GestureEngineTest, StreamingPreviewsFollowGestureTime) {
+    std::vector<size_t> previewSizes;
+    engine->setPreviewCallback([&](const std::vector<GestureCandidate>& candidates) {
+        previewSizes.push_back(candidates.size());
+    }, 50, 3);
+
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "hello");  // 10 ms between points
+    const int64_t duration = raw.points.back().timestamp - raw.points.front().timestamp;
+
+    ASSERT_TRUE(engine->beginGesture());
+    for (const auto& pt : raw.points) engine->addPoints(&pt, 1);
+    auto final = engine->endGesture(3);
+
+    EXPECT_EQ(static_cast<int64_t>(previewSizes.size()), duration / 50);
+    for (size_t n : previewSizes) EXPECT_LE(n, 3u);
+    ASSERT_FALSE(final.empty());
+    EXPECT_EQ(final[0].word, "hello");
+
+    engine->setPreviewCallback(nullptr);
+    previewSizes.clear();
+    ASSERT_TRUE(engine->beginGesture());
+    engine->addPoints(raw.points);
+    engine->endGesture();
+    EXPECT_TRUE(previewSizes.empty());
+}
+
+TEST_F(GestureEngineTest, StreamingRequiresActiveGesture) {
+    GesturePoint pt(10.0f, 10.0f, 0);
+    EXPECT_FALSE(engine->addPoints(&pt, 1));
+    EXPECT_TRUE(engine->endGesture().empty());
+
+    ASSERT_TRUE(engine->beginGesture());
+    EXPECT_TRUE(engine->addPoints(&pt, 1));
+    EXPECT_TRUE(engine->endGesture().empty());
+    EXPECT_EQ(engine->getLastError().code, ErrorCode::PATH_TOO_SHORT);
+
+    ASSERT_TRUE(engine->beginGesture());
+    engine->addPoints(makePathForWord(layout, "the"));
+    engine->cancelGesture();
+    EXPECT_FALSE(engine->isGestureInProgress());
+    EXPECT_TRUE(engine->endGesture().empty());
+
+    GestureEngine uninitialized;
+    EXPECT_FALSE(uninitialized.beginGesture());
+    EXPECT_EQ(uninitialized.getLastError().code, ErrorCode::ENGINE_NOT_INITIALIZED);
+}
+
 // ----- Edge cases -----
 
 TEST_F(GestureEngineTest, EmptyGestureReturnsEmpty) {
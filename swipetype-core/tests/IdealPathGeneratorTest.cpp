@@ -140,3 +140,201 @@ TEST_F(IdealPathGeneratorTest, LayoutChangeInvalidatesCache) {
     }
     EXPECT_TRUE(anyDiff) << "Path for 'hello' should change after layout update";
 }
+
+TEST_F(IdealPathGeneratorTest, ResampleCountChangeInvalidatesCache) {
+    GesturePath before = generator.getIdealPath("hello");
+    const size_t entryBytes = generator.getCacheStats().entryBytes;
+    ASSERT_EQ(generator.getResampleCount(), RESAMPLE_COUNT);
+
+    generator.setResampleCount(32);
+    EXPECT_EQ(generator.getResampleCount(), 32);
+    EXPECT_EQ(generator.cacheSize(), 0u) << "setResampleCount should clear cache";
+    EXPECT_LT(generator.getCacheStats().entryBytes, entryBytes);
+
+    GesturePath after = generator.getIdealPath("hello");
+    ASSERT_TRUE(after.isValid());
+    ASSERT_EQ(after.points.size(), 32u);
+    EXPECT_EQ(after.totalArcLength, before.totalArcLength);
+
+    // Unsupported counts are ignored
+    generator.setResampleCount(MAX_RESAMPLE_COUNT + 1);
+    EXPECT_EQ(generator.getResampleCount(), 32);
+    EXPECT_EQ(generator.cacheSize(), 1u);
+}
+
+namespace {
+
+/// count distinct words of three letters ("aaa", "aab", ...).
+std::vector<std::string> threeLetterWords(size_t count) {
+    std::vector<std::string> words;
+    for (size_t i = 0; i < count; ++i) {
+        std::string w(3, 'a');
+        w[0] = static_cast<char>('a' + (i / 676) % 26);
+        w[1] = static_cast<char>('a' + (i / 26) % 26);
+        w[2] = static_cast<char>('a' + i % 26);
+        words.push_back(w);
+    }
+    return words;
+}
+
+bool samePath(const GesturePath& a, const GesturePath& b) {
+    if (a.points.size() != b.points.size()) return false;
+    for (size_t i = 0; i < a.points.size(); ++i) {
+        if (a.points[i].x != b.points[i].x || a.points[i].y != b.points[i].y) return false;
+    }
+    return a.aspectRatio == b.aspectRatio && a.totalArcLength == b.totalArcLength &&
+           a.startKeyIndex == b.startKeyIndex && a.endKeyIndex == b.endKeyIndex;
+}
+
+} // namespace
+
+TEST_F(IdealPathGeneratorTest, CachedPathsMatchGeneratedPaths) {
+    for (const char* word : {"hello", "the", "a", "Hello", "zzz", "qwertyuiop"}) {
+        GesturePath generated = generator.generatePath(word);
+        EXPECT_TRUE(samePath(generator.getIdealPathRef(word), generated)) << word;
+        EXPECT_TRUE(samePath(generator.getIdealPathRef(word), generated)) << word << " (hit)";
+    }
+}
+
+TEST_F(IdealPathGeneratorTest, CacheStaysWithinBudget) {
+    const size_t entryBytes = generator.getCacheStats().entryBytes;
+    ASSERT_GT(entryBytes, 0u);
+    generator.setCacheBudget(entryBytes * 10 + entryBytes / 2);
+
+    for (const std::string& word : threeLetterWords(100)) generator.getIdealPathRef(word);
+
+    PathCacheStats stats = generator.getCacheStats();
+    EXPECT_EQ(stats.capacity, 10u);
+    EXPECT_EQ(stats.entries, 10u);
+    EXPECT_EQ(generator.cacheSize(), 10u);
+    EXPECT_LE(stats.bytes, stats.budgetBytes);
+    EXPECT_EQ(stats.misses, 100u);
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_EQ(stats.evictions, 90u);
+}
+
+TEST_F(IdealPathGeneratorTest, ClockKeepsFrequentlyUsedWords) {
+    const size_t entryBytes = generator.getCacheStats().entryBytes;
+    generator.setCacheBudget(entryBytes * 8);
+
+    // "the" and "and" are looked up between every rare word
+    generator.getIdealPathRef("the");
+    generator.getIdealPathRef("and");
+    for (const std::string& word : threeLetterWords(200)) {
+        generator.getIdealPathRef(word);
+        generator.getIdealPathRef("the");
+        generator.getIdealPathRef("and");
+    }
+
+    PathCacheStats before = generator.getCacheStats();
+    generator.getIdealPathRef("the");
+    generator.getIdealPathRef("and");
+    PathCacheStats after = generator.getCacheStats();
+    EXPECT_EQ(after.hits - before.hits, 2u) << "frequent words should survive the scan";
+    EXPECT_EQ(after.misses, before.misses);
+    // Apart from their first lookups, "the" and "and" are always hits
+    EXPECT_GE(before.hits, 2u * 200u - 4u);
+}
+
+TEST_F(IdealPathGeneratorTest, TrimCacheReleasesEntries) {
+    for (const std::string& word : threeLetterWords(50)) generator.getIdealPathRef(word);
+    ASSERT_EQ(generator.cacheSize(), 50u);
+    const size_t entryBytes = generator.getCacheStats().entryBytes;
+
+    const size_t reserved = generator.getCacheStats().reservedBytes;
+    ASSERT_GE(reserved, 50u * (entryBytes - 2 * sizeof(uint32_t)));
+
+    // Kept paths are compacted and the memory of evicted ones is freed
+    generator.trimCache(entryBytes * 20);
+    EXPECT_EQ(generator.cacheSize(), 20u);
+    EXPECT_EQ(generator.getCacheStats().evictions, 30u);
+    const size_t trimmed = generator.getCacheStats().reservedBytes;
+
+    // Only the index table is kept
+    generator.trimCache(0);
+    EXPECT_EQ(generator.cacheSize(), 0u);
+    const size_t index = generator.getCacheStats().reservedBytes;
+    EXPECT_LE(trimmed, index + 20u * entryBytes);
+    EXPECT_LT(index, entryBytes * 20);
+
+    // The budget is unchanged, so the cache fills again
+    GesturePath path = generator.getIdealPathRef("hello");
+    EXPECT_TRUE(samePath(path, generator.generatePath("hello")));
+    EXPECT_EQ(generator.cacheSize(), 1u);
+}
+
+TEST_F(IdealPathGeneratorTest, ZeroBudgetDisablesCache) {
+    generator.setCacheBudget(0);
+    GesturePath first = generator.getIdealPathRef("hello");
+    GesturePath second = generator.getIdealPathRef("hello");
+    EXPECT_TRUE(first.isValid());
+    EXPECT_TRUE(samePath(first, second));
+    EXPECT_EQ(generator.cacheSize(), 0u);
+    PathCacheStats stats = generator.getCacheStats();
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.hits, 0u);
+}
+
+TEST_F(IdealPathGeneratorTest, MergeCacheKeepsRecentlyUsedPaths) {
+    const std::vector<std::string> words = threeLetterWords(20);
+    const size_t entryBytes = generator.getCacheStats().entryBytes;
+    generator.setCacheBudget(entryBytes * 8);
+    for (size_t i = 0; i < 4; ++i) generator.getIdealPathRef(words[i]);
+    generator.getIdealPathRef(words[0]);  // looked up again: referenced
+    generator.getIdealPathRef(words[1]);
+
+    IdealPathGenerator warm;
+    warm.setLayout(layout);
+    for (size_t i = 2; i < 10; ++i) warm.getIdealPathRef(words[i]);
+
+    // The 4 cached here go into the 8 warmed ones: words[0] and [1]
+    // are kept, and replace entries no one has looked up
+    const PathCacheStats before = generator.getCacheStats();
+    generator.mergeCache(std::move(warm));
+    EXPECT_EQ(warm.cacheSize(), 0u);
+    EXPECT_EQ(generator.cacheSize(), 8u);
+    EXPECT_EQ(generator.getCacheStats().misses, before.misses);  // counters stay
+    for (size_t i : {0, 1}) {
+        EXPECT_TRUE(samePath(generator.getIdealPathRef(words[i]),
+                             generator.generatePath(words[i]))) << words[i];
+    }
+    EXPECT_EQ(generator.getCacheStats().hits - before.hits, 2u);
+
+    // Every entry is referenced, so nothing more is merged in, whichever
+    // cache is larger
+    IdealPathGenerator few;
+    few.setLayout(layout);
+    few.getIdealPathRef(words[10]);
+    generator.mergeCache(std::move(few));
+    EXPECT_EQ(generator.cacheSize(), 8u);
+    EXPECT_EQ(few.cacheSize(), 0u);
+    size_t hits = 0;
+    for (const std::string& word : words) {
+        const uint64_t h = generator.getCacheStats().hits;
+        generator.getIdealPathRef(word);
+        if (generator.getCacheStats().hits > h) ++hits;
+    }
+    EXPECT_GE(hits, 2u);  // at least words[0] and [1] stayed
+
+    // Merging into an empty cache takes the other's paths as they are
+    generator.clearCache();
+    IdealPathGenerator full;
+    full.setLayout(layout);
+    for (size_t i = 0; i < 6; ++i) full.getIdealPathRef(words[i]);
+    generator.mergeCache(std::move(full));
+    EXPECT_EQ(generator.cacheSize(), 6u);
+    for (size_t i = 0; i < 6; ++i) {
+        EXPECT_TRUE(samePath(generator.getIdealPathRef(words[i]),
+                             generator.generatePath(words[i]))) << words[i];
+    }
+
+    // Paths of another point count are dropped
+    IdealPathGenerator other;
+    other.setLayout(layout);
+    other.setResampleCount(32);
+    other.getIdealPathRef("zzz");
+    generator.clearCache();
+    generator.mergeCache(std::move(other));
+    EXPECT_EQ(generator.cacheSize(), 0u);
+    EXPECT_EQ(other.cacheSize(), 0u);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <swipetype/KeyboardLayout.h>
+#include "TestHelpers.h"
+#include <cstdint>
+#include <cmath>
+
+using namespace swipetype;
+using namespace swipetype::test;
+
+class KeyboardLayoutTest : public ::testing::Test {
+protected:
+    KeyboardLayout scan = makeQwertyLayout();   // no lookup tables
+    KeyboardLayout grid = makeQwertyLayout();
+
+    void SetUp() override {
+        grid.buildLookup();
+    }
+};
+
+TEST_F(KeyboardLayoutTest, GridNearestKeyMatchesScan) {
+    ASSERT_TRUE(grid.hasLookup());
+    EXPECT_FALSE(scan.hasLookup());
+
+    // Dense sweep, including points off the keyboard and on cell and key edges
+    for (float y = -20.0f; y <= 180.0f; y += 0.5f) {
+        for (float x = -20.0f; x <= 340.0f; x += 0.5f) {
+            ASSERT_EQ(grid.findNearestKey(x, y), scan.findNearestKey(x, y))
+                << "at (" << x << ", " << y << ")";
+        }
+    }
+}
+
+TEST_F(KeyboardLayoutTest, GridHandlesIrregularKeys) {
+    // Non-character keys, duplicate centers (ties go to the first key) and
+    // keys of mixed sizes
+    for (KeyboardLayout* layout : {&scan, &grid}) {
+        layout->keys.push_back(KeyDescriptor("shift", -1, 16, 134, 48, 52));
+        layout->keys.push_back(KeyDescriptor("A", 'A', 32, 80, 32, 52));
+        layout->keys.push_back(KeyDescriptor("'", '\'', 300, 150, 8, 12));
+        layout->keys.push_back(KeyDescriptor("\xC3\xA9", 0xE9, 150.5f, 40.25f, 20, 20));
+    }
+    grid.buildLookup();
+
+    uint32_t seed = 12345;
+    auto next = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+    };
+    for (int i = 0; i < 200'000; ++i) {
+        float x = -10.0f + next() * 340.0f;
+        float y = -10.0f + next() * 180.0f;
+        ASSERT_EQ(grid.findNearestKey(x, y), scan.findNearestKey(x, y))
+            << "at (" << x << ", " << y << ")";
+    }
+    EXPECT_EQ(grid.findNearestKey(NAN, 10.0f), scan.findNearestKey(NAN, 10.0f));
+}
+
+TEST_F(KeyboardLayoutTest, CodePointTableMatchesScan) {
+    scan.keys.push_back(KeyDescriptor("\xC3\xA9", 0xE9, 150, 40, 20, 20));
+    scan.keys.push_back(KeyDescriptor("Q", 'Q', 10, 10, 20, 20));  // shadowed by 'q'
+    grid = scan;
+    grid.buildLookup();
+
+    for (int32_t cp = -2; cp < 300; ++cp) {
+        EXPECT_EQ(grid.findKeyByCodePoint(cp), scan.findKeyByCodePoint(cp)) << cp;
+    }
+    EXPECT_EQ(grid.findKeyByCodePoint('H'), grid.findKeyByCodePoint('h'));
+    EXPECT_EQ(grid.findKeyByCodePoint('Q'), 0);
+    EXPECT_EQ(grid.findKeyByCodePoint(0xE9), static_cast<int32_t>(grid.keys.size()) - 2);
+}
+
+TEST_F(KeyboardLayoutTest, EditedKeysFallBackToScan) {
+    KeyboardLayout copy = grid;
+    EXPECT_TRUE(copy.hasLookup());
+
+    // A key added after buildLookup() is still found
+    copy.keys.push_back(KeyDescriptor("\xC3\xA9", 0xE9, 150, 40, 20, 20));
+    EXPECT_FALSE(copy.hasLookup());
+    EXPECT_EQ(copy.findKeyByCodePoint(0xE9), static_cast<int32_t>(copy.keys.size()) - 1);
+    EXPECT_EQ(copy.findNearestKey(150, 40), static_cast<int32_t>(copy.keys.size()) - 1);
+
+    // The original's tables are unaffected
+    EXPECT_TRUE(grid.hasLookup());
+    EXPECT_EQ(grid.findKeyByCodePoint(0xE9), -1);
+}
+
+TEST_F(KeyboardLayoutTest, MovedKeysNeedRebuildOrReset) {
+    KeyboardLayout copy = grid;
+    int32_t q = copy.findKeyByCodePoint('q');
+    int32_t p = copy.findKeyByCodePoint('p');
+    ASSERT_GE(q, 0);
+    ASSERT_GE(p, 0);
+
+    // Same key count: 'q' moves onto 'p' and 'p' changes letter. The
+    // tables are still used until rebuilt or reset
+    KeyDescriptor& moved = copy.keys[static_cast<size_t>(q)];
+    moved.centerX = copy.keys[static_cast<size_t>(p)].centerX + 1.0f;
+    copy.keys[static_cast<size_t>(p)].codePoint = 0xE9;
+    EXPECT_TRUE(copy.hasLookup());
+
+    KeyboardLayout reset = copy;
+    reset.lookup.reset();
+    EXPECT_FALSE(reset.hasLookup());
+    EXPECT_EQ(reset.findNearestKey(moved.centerX, moved.centerY), q);
+    EXPECT_EQ(reset.findKeyByCodePoint('p'), -1);
+    EXPECT_EQ(reset.findKeyByCodePoint(0xE9), p);
+
+    copy.buildLookup();
+    EXPECT_TRUE(copy.hasLookup());
+    EXPECT_EQ(copy.findNearestKey(moved.centerX, moved.centerY), q);
+    EXPECT_EQ(copy.findKeyByCodePoint('p'), -1);
+    EXPECT_EQ(copy.findKeyByCodePoint(0xE9), p);
+    EXPECT_EQ(grid.findKeyByCodePoint('p'), p);
+}
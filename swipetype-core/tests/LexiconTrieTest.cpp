@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <swipetype/LexiconTrie.h>
+#include <swipetype/DictionaryLoader.h>
+#include <swipetype/SwipeTypeTypes.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace swipetype;
+
+namespace {
+
+/** Letter mask of the given letters. */
+uint32_t near(const std::string& letters) {
+    uint32_t mask = 0;
+    for (char c : letters) mask |= 1u << (c - 'a');
+    return mask;
+}
+
+} // namespace
+
+class LexiconTrieTest : public ::testing::Test {
+protected:
+    DictionaryLoader dict;
+    std::vector<uint8_t> dictData;
+    std::vector<std::string> words = {
+        "hello", "help", "hero", "he", "hell", "don't", "Dont", "world", "123"};
+
+    void SetUp() override {
+        // Version-1 dictionary: header + wordLen(1) word(N) frequency(4) flags(1)
+        std::vector<uint8_t> entries;
+        for (const auto& w : words) {
+            entries.push_back(static_cast<uint8_t>(w.size()));
+            for (char c : w) entries.push_back(static_cast<uint8_t>(c));
+            for (uint8_t b : {100, 0, 0, 0, 0}) entries.push_back(b);  // frequency, flags
+        }
+        dictData.assign(DICT_HEADER_SIZE, 0);
+        dictData[0] = 0x44; dictData[1] = 0x49; dictData[2] = 0x4C; dictData[3] = 0x47;  // GLID
+        dictData[4] = static_cast<uint8_t>(DICT_VERSION_V1);
+        dictData[8] = static_cast<uint8_t>(words.size());
+        dictData.insert(dictData.end(), entries.begin(), entries.end());
+        ASSERT_TRUE(dict.loadFromMemory(dictData.data(), dictData.size()));
+    }
+
+    /** Words collected along the given key path, sorted. */
+    std::vector<std::string> traced(const LexiconTrie& trie, const std::vector<uint32_t>& keys) {
+        std::vector<uint32_t> entries;
+        EXPECT_TRUE(trie.collect(keys.data(), keys.size(), entries));
+        std::vector<std::string> found;
+        for (uint32_t idx : entries) found.emplace_back(dict.getEntry(idx).word);
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+};
+
+TEST_F(LexiconTrieTest, SharesPrefixes) {
+    LexiconTrie trie;
+    EXPECT_FALSE(trie.isBuilt());
+    ASSERT_TRUE(trie.build(dict));
+    EXPECT_TRUE(trie.isBuilt());
+
+    // root; h he hel hell hello help her hero; d do don dont; w wo wor worl world
+    EXPECT_EQ(trie.nodeCount(), 18u);
+    EXPECT_GT(trie.memoryUsage(), 0u);
+
+    trie.clear();
+    EXPECT_FALSE(trie.isBuilt());
+    EXPECT_EQ(trie.nodeCount(), 0u);
+}
+
+TEST_F(LexiconTrieTest, CollectsWordsTracedAlongKeys) {
+    LexiconTrie trie;
+    ASSERT_TRUE(trie.build(dict));
+
+    // "ll" stays on one key; "hell" and "help" do not end near 'o'
+    EXPECT_EQ(traced(trie, {near("h"), near("e"), near("l"), near("o")}),
+              std::vector<std::string>({"hello"}));
+    EXPECT_EQ(traced(trie, {near("h"), near("e"), near("l"), near("op")}),
+              std::vector<std::string>({"hello", "help"}));
+    EXPECT_EQ(traced(trie, {near("h"), near("e"), near("lr"), near("lo")}),
+              std::vector<std::string>({"hell", "hello", "hero"}));
+    EXPECT_EQ(traced(trie, {near("h"), near("e")}), std::vector<std::string>({"he"}));
+
+    // Apostrophes and case do not take part
+    EXPECT_EQ(traced(trie, {near("d"), near("o"), near("n"), near("t")}),
+              std::vector<std::string>({"Dont", "don't"}));
+}
+
+TEST_F(LexiconTrieTest, PrunesLettersOffThePath) {
+    LexiconTrie trie;
+    ASSERT_TRUE(trie.build(dict));
+
+    // The first letter must be near the first key
+    EXPECT_TRUE(traced(trie, {near("w"), near("h"), near("e"), near("l"), near("o")}).empty());
+    // Distinct letters need distinct keys, in order
+    EXPECT_TRUE(traced(trie, {near("he"), near("lo")}).empty());
+    EXPECT_TRUE(traced(trie, {near("h"), near("l"), near("e"), near("o")}).empty());
+
+    // Only the prefixes the path allows are walked
+    std::vector<uint32_t> keys = {near("h"), near("e"), near("l"), near("o")};
+    std::vector<uint32_t> entries;
+    uint32_t visited = 0;
+    ASSERT_TRUE(trie.collect(keys.data(), keys.size(), entries, &visited));
+    EXPECT_EQ(visited, 6u);  // root h he hel hell hello; "help" and "her" pruned
+    EXPECT_LT(visited, trie.nodeCount());
+}
+
+TEST_F(LexiconTrieTest, RejectsUnusableKeyPaths) {
+    LexiconTrie trie;
+    std::vector<uint32_t> keys = {near("h"), near("e")};
+    std::vector<uint32_t> entries = {1, 2, 3};
+    EXPECT_FALSE(trie.collect(keys.data(), keys.size(), entries));  // not built
+    EXPECT_TRUE(entries.empty());
+
+    ASSERT_TRUE(trie.build(dict));
+    EXPECT_FALSE(trie.collect(keys.data(), 0, entries));
+    std::vector<uint32_t> tooLong(LEXICON_MAX_KEYS + 1, near("h"));
+    EXPECT_FALSE(trie.collect(tooLong.data(), tooLong.size(), entries));
+    std::vector<uint32_t> longest(LEXICON_MAX_KEYS, near("hel"));
+    longest.back() = near("hlo");
+    EXPECT_TRUE(trie.collect(longest.data(), longest.size(), entries));
+    EXPECT_EQ(entries.size(), 2u);  // hell, hello
+}
@@ -5,10 +5,81 @@
 #include "TestHelpers.h"
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 using namespace swipetype;
 using namespace swipetype::test;
 
+// ---------------------------------------------------------------------------
+// Reference: the separate dedup / arc length / insert-based resample /
+// bounding-box passes the fused normalizer must reproduce
+// ---------------------------------------------------------------------------
+
+static GesturePath referenceNormalize(const std::vector<GesturePoint>& raw,
+                                      float minDist, int count) {
+    auto seg = [](const GesturePoint& a, const GesturePoint& b) {
+        float dx = b.x - a.x, dy = b.y - a.y;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+    std::vector<GesturePoint> pts;
+    pts.push_back(raw.front());
+    for (size_t i = 1; i + 1 < raw.size(); ++i) {
+        if (seg(pts.back(), raw[i]) >= minDist) pts.push_back(raw[i]);
+    }
+    pts.push_back(raw.back());
+
+    float arcLen = 0.0f;
+    for (size_t i = 1; i < pts.size(); ++i) arcLen += seg(pts[i - 1], pts[i]);
+
+    std::vector<GesturePoint> res;
+    if (arcLen < 1e-6f) {
+        res.assign(static_cast<size_t>(count), pts[0]);
+    } else {
+        float interval = arcLen / static_cast<float>(count - 1);
+        res.push_back(pts[0]);
+        float D = 0.0f;
+        for (size_t i = 1; i < pts.size() && static_cast<int>(res.size()) < count - 1; ++i) {
+            float d = seg(pts[i - 1], pts[i]);
+            if (D + d >= interval) {
+                float t = (interval - D) / d;
+                GesturePoint np;
+                np.x = pts[i - 1].x + t * (pts[i].x - pts[i - 1].x);
+                np.y = pts[i - 1].y + t * (pts[i].y - pts[i - 1].y);
+                np.timestamp = pts[i - 1].timestamp + static_cast<int64_t>(
+                    t * static_cast<float>(pts[i].timestamp - pts[i - 1].timestamp));
+                res.push_back(np);
+                pts.insert(pts.begin() + static_cast<long>(i), np);
+                D = 0.0f;
+            } else {
+                D += d;
+            }
+        }
+        while (static_cast<int>(res.size()) < count) res.push_back(pts.back());
+    }
+
+    GesturePath out;
+    out.totalArcLength = arcLen;
+    float minX = res[0].x, maxX = res[0].x, minY = res[0].y, maxY = res[0].y;
+    for (const auto& p : res) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+    }
+    float w = maxX - minX, h = maxY - minY;
+    if (w < 0.001f && h < 0.001f) {
+        out.points.assign(res.size(), NormalizedPoint(0.5f, 0.5f, 0.5f));
+        return out;
+    }
+    float scale = std::max(w, h);
+    out.aspectRatio = (h > 0.001f) ? (w / h) : 1.0f;
+    float tsRange = static_cast<float>(res.back().timestamp - res.front().timestamp);
+    for (const auto& p : res) {
+        out.points.emplace_back((p.x - minX) / scale, (p.y - minY) / scale,
+            tsRange > 0.0f ? static_cast<float>(p.timestamp - res.front().timestamp) / tsRange
+                           : 0.5f);
+    }
+    return out;
+}
+
 class PathProcessorTest : public ::testing::Test {
 protected:
     PathProcessor processor;
@@ -73,6 +144,77 @@ TEST_F(PathProcessorTest, DeduplicateHandlesSinglePoint) {
 
 // ----- Resampling -----
 
+TEST_F(PathProcessorTest, IncrementalPathMatchesBatchNormalize) {
+    KeyboardLayout layout = makeQwertyLayout();
+    RawGesturePath raw;
+    raw.points = makePathForWord(layout, "keyboard", 6);
+    addNoise(raw.points, 1.5f, 1.5f);   // plenty of sub-threshold steps
+    raw.points.push_back(raw.points.back());
+
+    GesturePath batch = processor.normalize(raw, layout);
+    ASSERT_TRUE(batch.isValid());
+
+    DeduplicatedPath incremental;
+    for (const auto& pt : raw.points) processor.appendPoint(incremental, pt);
+    EXPECT_EQ(incremental.rawCount, raw.points.size());
+
+    GesturePath streamed = processor.normalize(incremental, layout);
+    ASSERT_EQ(streamed.points.size(), batch.points.size());
+    for (size_t i = 0; i < batch.points.size(); ++i) {
+        EXPECT_EQ(streamed.points[i].x, batch.points[i].x) << i;
+        EXPECT_EQ(streamed.points[i].y, batch.points[i].y) << i;
+        EXPECT_EQ(streamed.points[i].t, batch.points[i].t) << i;
+    }
+    EXPECT_EQ(streamed.totalArcLength, batch.totalArcLength);
+    EXPECT_EQ(streamed.aspectRatio, batch.aspectRatio);
+    EXPECT_EQ(streamed.startKeyIndex, batch.startKeyIndex);
+    EXPECT_EQ(streamed.endKeyIndex, batch.endKeyIndex);
+
+    DeduplicatedPath single;
+    processor.appendPoint(single, raw.points[0]);
+    EXPECT_FALSE(processor.normalize(single, layout).isValid());
+}
+
+TEST_F(PathProcessorTest, FusedNormalizeMatchesSeparatePasses) {
+    KeyboardLayout layout = makeQwertyLayout();
+    uint32_t seed = 7;
+    auto next = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+    };
+
+    std::vector<RawGesturePath> paths;
+    // Jittery random walks, short to MAX_GESTURE_POINTS long
+    for (int n : {2, 3, 10, 57, 400, MAX_GESTURE_POINTS}) {
+        RawGesturePath raw;
+        float x = 160.0f, y = 80.0f;
+        for (int i = 0; i < n; ++i) {
+            x = std::min(320.0f, std::max(0.0f, x + (next() - 0.5f) * 6.0f));
+            y = std::min(160.0f, std::max(0.0f, y + (next() - 0.5f) * 6.0f));
+            raw.points.push_back(GesturePoint(x, y, static_cast<int64_t>(i * 8)));
+        }
+        paths.push_back(raw);
+    }
+    paths.push_back(makeLine(20.0f, 300.0f, 80.0f));
+    paths.push_back(makeLine(100.0f, 100.0f, 80.0f));   // degenerate: one spot
+
+    for (int count : {RESAMPLE_COUNT, 7}) {
+        processor.setResampleCount(count);
+        for (const auto& raw : paths) {
+            GesturePath got = processor.normalize(raw, layout);
+            GesturePath want = referenceNormalize(raw.points, MIN_POINT_DISTANCE_DP, count);
+            ASSERT_EQ(got.points.size(), want.points.size()) << raw.points.size() << " points";
+            EXPECT_FLOAT_EQ(got.totalArcLength, want.totalArcLength);
+            EXPECT_FLOAT_EQ(got.aspectRatio, want.aspectRatio);
+            for (size_t i = 0; i < got.points.size(); ++i) {
+                EXPECT_FLOAT_EQ(got.points[i].x, want.points[i].x) << i;
+                EXPECT_FLOAT_EQ(got.points[i].y, want.points[i].y) << i;
+                EXPECT_FLOAT_EQ(got.points[i].t, want.points[i].t) << i;
+            }
+        }
+    }
+}
+
 TEST_F(PathProcessorTest, ResampleProducesExactly64Points) {
     KeyboardLayout layout = makeQwertyLayout();
     RawGesturePath raw = makeLine(16.0f, 304.0f, 80.0f, 30);
@@ -2,10 +2,12 @@
 #include <swipetype/Scorer.h>
 #include <swipetype/GesturePath.h>
 #include <swipetype/GestureCandidate.h>
+#include <swipetype/IdealPathGenerator.h>
 #include "TestHelpers.h"
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cfloat>
 
 using namespace swipetype;
 using namespace swipetype::test;
@@ -37,6 +39,32 @@ static GesturePath makeLinePath(float x0, float y0, float x1, float y1) {
     return p;
 }
 
+// Straightforward two-row banded DTW with FLT_MAX sentinels: the reference
+// the vectorized kernel must reproduce.
+static float referenceDTW(const GesturePath& a, const GesturePath& b, float bandwidthRatio) {
+    const int N = static_cast<int>(a.points.size());
+    int W = std::max(1, static_cast<int>(std::ceil(bandwidthRatio * static_cast<float>(N))));
+    auto cost = [&](int i, int j) {
+        float dx = a.points[i].x - b.points[j].x;
+        float dy = a.points[i].y - b.points[j].y;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    std::vector<float> prev(N, FLT_MAX), curr(N, FLT_MAX);
+    prev[0] = cost(0, 0);
+    for (int j = 1; j <= std::min(W, N - 1); ++j) prev[j] = prev[j - 1] + cost(0, j);
+    for (int i = 1; i < N; ++i) {
+        std::fill(curr.begin(), curr.end(), FLT_MAX);
+        for (int j = std::max(0, i - W); j <= std::min(N - 1, i + W); ++j) {
+            float best = prev[j];
+            if (j > 0) best = std::min({best, curr[j - 1], prev[j - 1]});
+            curr[j] = (best < FLT_MAX) ? cost(i, j) + best : FLT_MAX;
+        }
+        std::swap(prev, curr);
+    }
+    return prev[N - 1] / static_cast<float>(N);
+}
+
 // ---------------------------------------------------------------------------
 
 class ScorerTest : public ::testing::Test {
@@ -47,6 +75,173 @@ protected:
 
 // ----- DTW Scoring -----
 
+TEST_F(ScorerTest, KernelMatchesReferenceDTW) {
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    const char* words[] = {"hello", "world", "the", "quick", "zap", "mnbvcxz", "qp"};
+
+    for (float ratio : {0.02f, 0.10f, 0.25f, 1.0f}) {
+        ScoringConfig config;
+        config.dtwBandwidthRatio = ratio;
+        scorer.configure(config);
+        for (const char* a : words) {
+            for (const char* b : words) {
+                GesturePath pa = generator.getIdealPath(a);
+                GesturePath pb = generator.getIdealPath(b);
+                EXPECT_FLOAT_EQ(scorer.computeDTWDistance(pa, pb), referenceDTW(pa, pb, ratio))
+                    << a << " vs " << b << " ratio " << ratio;
+            }
+        }
+    }
+}
+
+TEST_F(ScorerTest, EveryResampleCountMatchesReferenceDTW) {
+    const char* words[] = {"hello", "world", "the", "quick", "zap", "mnbvcxz", "qp"};
+
+    // 32 and 96 points with ratios 0.05 to 0.20 have prebuilt kernels; the
+    // other counts and ratio 0.12 use the generic one
+    for (int points : {MIN_RESAMPLE_COUNT, 32, 48, 96, MAX_RESAMPLE_COUNT}) {
+        IdealPathGenerator generator;
+        generator.setLayout(layout);
+        generator.setResampleCount(points);
+        for (float ratio : {0.05f, 0.10f, 0.12f, 0.15f, 0.20f}) {
+            ScoringConfig config;
+            config.resampleCount = points;
+            config.dtwBandwidthRatio = ratio;
+            scorer.configure(config);
+            ASSERT_EQ(scorer.getResampleCount(), points);
+            for (const char* a : words) {
+                GesturePath gesture = generator.getIdealPath(a);
+                ASSERT_EQ(static_cast<int>(gesture.points.size()), points);
+                DTWQuery query;
+                ASSERT_TRUE(scorer.prepareQuery(gesture, query));
+                for (const char* b : words) {
+                    GesturePath ideal = generator.getIdealPath(b);
+                    std::vector<float> tx, ty;
+                    for (const auto& p : ideal.points) { tx.push_back(p.x); ty.push_back(p.y); }
+
+                    float dtw = scorer.computeDTWDistance(gesture, ideal);
+                    EXPECT_FLOAT_EQ(dtw, referenceDTW(gesture, ideal, ratio))
+                        << a << " vs " << b << " points " << points << " ratio " << ratio;
+                    EXPECT_EQ(scorer.computeDTWDistance(query, tx.data(), ty.data()), dtw);
+                    EXPECT_LE(scorer.lowerBound(query, tx.data(), ty.data()), dtw);
+                }
+            }
+        }
+    }
+
+    // Counts are clamped to the supported range; other paths are rejected
+    ScoringConfig config;
+    config.resampleCount = 4;
+    scorer.configure(config);
+    EXPECT_EQ(scorer.getResampleCount(), MIN_RESAMPLE_COUNT);
+    config.resampleCount = 1000;
+    scorer.configure(config);
+    EXPECT_EQ(scorer.getResampleCount(), MAX_RESAMPLE_COUNT);
+    GesturePath line = makeLinePath(0.0f, 0.0f, 1.0f, 1.0f);
+    DTWQuery query;
+    EXPECT_EQ(scorer.computeDTWDistance(line, line), FLT_MAX);
+    EXPECT_FALSE(scorer.prepareQuery(line, query));
+}
+
+TEST_F(ScorerTest, LowerBoundNeverExceedsDTW) {
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    const char* words[] = {"hello", "world", "the", "quick", "zap", "mnbvcxz", "qp", "help"};
+
+    for (float ratio : {0.02f, 0.10f, 0.25f}) {
+        ScoringConfig config;
+        config.dtwBandwidthRatio = ratio;
+        scorer.configure(config);
+        for (const char* a : words) {
+            GesturePath gesture = generator.getIdealPath(a);
+            DTWQuery query;
+            ASSERT_TRUE(scorer.prepareQuery(gesture, query));
+            for (const char* b : words) {
+                GesturePath ideal = generator.getIdealPath(b);
+                std::vector<float> tx, ty;
+                for (const auto& p : ideal.points) { tx.push_back(p.x); ty.push_back(p.y); }
+
+                float dtw = scorer.computeDTWDistance(gesture, ideal);
+                float bound = scorer.lowerBound(query, tx.data(), ty.data());
+                EXPECT_LE(bound, dtw) << a << " vs " << b << " ratio " << ratio;
+                EXPECT_GE(bound, 0.0f);
+            }
+        }
+    }
+}
+
+TEST_F(ScorerTest, ThresholdedDTWIsExactOrAbandoned) {
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    const char* words[] = {"hello", "world", "the", "quick", "zap", "mnbvcxz"};
+
+    GesturePath gesture = generator.getIdealPath("hello");
+    DTWQuery query;
+    ASSERT_TRUE(scorer.prepareQuery(gesture, query));
+    for (const char* word : words) {
+        GesturePath ideal = generator.getIdealPath(word);
+        std::vector<float> tx, ty;
+        for (const auto& p : ideal.points) { tx.push_back(p.x); ty.push_back(p.y); }
+
+        float exact = scorer.computeDTWDistance(gesture, ideal);
+        EXPECT_EQ(scorer.computeDTWDistance(query, tx.data(), ty.data()), exact) << word;
+        EXPECT_EQ(scorer.computeDTWDistance(query, tx.data(), ty.data(), exact), exact) << word;
+        EXPECT_EQ(scorer.computeDTWDistance(query, tx.data(), ty.data(), exact * 2.0f), exact) << word;
+        if (exact > 0.0f) {
+            EXPECT_EQ(scorer.computeDTWDistance(query, tx.data(), ty.data(), exact * 0.5f), FLT_MAX)
+                << word;
+        }
+    }
+
+    DTWQuery unprepared;
+    EXPECT_FALSE(unprepared.isValid());
+    EXPECT_EQ(scorer.computeDTWDistance(unprepared, query.x.data(), query.y.data()), FLT_MAX);
+    EXPECT_EQ(scorer.lowerBound(unprepared, query.x.data(), query.y.data()), FLT_MAX);
+}
+
+TEST_F(ScorerTest, CoarseDistanceCombinesShapeArcAndLetters) {
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    GesturePath hello = generator.getIdealPath("hello");
+    GesturePath world = generator.getIdealPath("world");
+
+    PathSignature a, b;
+    ASSERT_TRUE(scorer.prepareSignature(hello, 0, a));
+    ASSERT_TRUE(scorer.prepareSignature(world, 0, b));
+    EXPECT_EQ(a.x[0], hello.points[0].x);
+    EXPECT_EQ(a.y[SIGNATURE_POINTS - 1], hello.points[RESAMPLE_COUNT - 1].y);
+    EXPECT_EQ(a.arcLength, hello.totalArcLength);
+
+    // Shape only: mean distance of the signature points
+    PathSignature flat = b;
+    flat.arcLength = a.arcLength;
+    float expected = 0.0f;
+    for (int k = 0; k < SIGNATURE_POINTS; ++k) {
+        expected += std::sqrt((a.x[k] - b.x[k]) * (a.x[k] - b.x[k]) +
+                              (a.y[k] - b.y[k]) * (a.y[k] - b.y[k]));
+    }
+    expected /= SIGNATURE_POINTS;
+    EXPECT_FLOAT_EQ(scorer.coarseDistance(a, flat), expected);
+    EXPECT_EQ(scorer.coarseDistance(a, a), 0.0f);
+
+    // Twice the arc length costs COARSE_ARC_WEIGHT
+    PathSignature longer = a;
+    longer.arcLength = a.arcLength * 2.0f;
+    EXPECT_FLOAT_EQ(scorer.coarseDistance(a, longer), COARSE_ARC_WEIGHT);
+
+    // Each template letter the gesture did not cross costs COARSE_LETTER_WEIGHT
+    PathSignature gesture = a;
+    gesture.letterMask = (1u << ('h' - 'a')) | (1u << ('e' - 'a')) | (1u << ('o' - 'a'));
+    PathSignature word = a;
+    word.letterMask = gesture.letterMask | (1u << ('l' - 'a')) | (1u << ('z' - 'a'));
+    EXPECT_FLOAT_EQ(scorer.coarseDistance(gesture, word), 2.0f * COARSE_LETTER_WEIGHT);
+    EXPECT_EQ(scorer.coarseDistance(a, word), 0.0f) << "unknown gesture letters are not scored";
+
+    GesturePath empty;
+    EXPECT_FALSE(scorer.prepareSignature(empty, 0, a));
+}
+
 TEST_F(ScorerTest, IdenticalPathsScorePerfect) {
     GesturePath path = makeLinePath(0.0f, 0.1f, 1.0f, 0.1f);
     float dist = scorer.computeDTWDistance(path, path);
@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+#include <swipetype/TemplateStore.h>
+#include <swipetype/IdealPathGenerator.h>
+#include <swipetype/Scorer.h>
+#include <swipetype/DictionaryLoader.h>
+#include <swipetype/SwipeTypeTypes.h>
+#include "TestHelpers.h"
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace swipetype;
+using namespace swipetype::test;
+
+class TemplateStoreTest : public ::testing::Test {
+protected:
+    KeyboardLayout layout = makeQwertyLayout();
+    DictionaryLoader dict;
+    std::vector<uint8_t> dictData;
+    std::string cacheFile;
+
+    void SetUp() override {
+        // Version-1 dictionary: header + wordLen(1) word(N) frequency(4) flags(1)
+        const std::vector<std::string> words = {"hello", "the", "a", "world", "x1y"};
+        std::vector<uint8_t> entries;
+        for (const auto& w : words) {
+            entries.push_back(static_cast<uint8_t>(w.size()));
+            for (char c : w) entries.push_back(static_cast<uint8_t>(c));
+            for (uint8_t b : {100, 0, 0, 0, 0}) entries.push_back(b);  // frequency, flags
+        }
+        dictData.assign(DICT_HEADER_SIZE, 0);
+        dictData[0] = 0x44; dictData[1] = 0x49; dictData[2] = 0x4C; dictData[3] = 0x47;  // GLID
+        dictData[4] = static_cast<uint8_t>(DICT_VERSION_V1);
+        dictData[8] = static_cast<uint8_t>(words.size());
+        dictData.insert(dictData.end(), entries.begin(), entries.end());
+        ASSERT_TRUE(dict.loadFromMemory(dictData.data(), dictData.size()));
+
+        char tmp[] = "/tmp/swipetype_tpl_XXXXXX";
+        int fd = mkstemp(tmp);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        cacheFile = tmp;
+    }
+
+    void TearDown() override {
+        std::remove(cacheFile.c_str());
+    }
+};
+
+TEST_F(TemplateStoreTest, TemplatesMatchIdealPathGenerator) {
+    TemplateStore store;
+    ASSERT_TRUE(store.compile(layout, dict));
+    EXPECT_TRUE(store.isCompiled());
+    EXPECT_EQ(store.size(), dict.getEntryCount());
+
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    for (uint32_t i = 0; i < dict.getEntryCount(); ++i) {
+        GesturePath ideal = generator.getIdealPath(dict.getEntry(i).word);
+        TemplateView view = store.getTemplate(i);
+        ASSERT_EQ(view.isValid(), ideal.isValid()) << dict.getEntry(i).word;
+        if (!view.isValid()) continue;
+        for (int p = 0; p < RESAMPLE_COUNT; ++p) {
+            EXPECT_EQ(view.x[p], ideal.points[p].x);
+            EXPECT_EQ(view.y[p], ideal.points[p].y);
+        }
+    }
+
+    // Single-key words have no template
+    EXPECT_FALSE(store.getTemplate(2).isValid());
+    EXPECT_FALSE(store.getTemplate(store.size()).isValid());
+}
+
+TEST_F(TemplateStoreTest, CompileReportsProgressAndCancels) {
+    TemplateStore store;
+    TemplateCompileProgress progress;
+    ASSERT_TRUE(store.compile(layout, dict, TemplatePrecision::FLOAT32, RESAMPLE_COUNT, &progress));
+    EXPECT_EQ(progress.compiled.load(), dict.getEntryCount());
+
+    progress.cancel = true;
+    EXPECT_FALSE(store.compile(layout, dict, TemplatePrecision::FLOAT32, RESAMPLE_COUNT, &progress));
+    EXPECT_FALSE(store.isCompiled());
+    EXPECT_EQ(store.size(), 0u);
+}
+
+TEST_F(TemplateStoreTest, SoADistanceMatchesPathDistance) {
+    TemplateStore store;
+    ASSERT_TRUE(store.compile(layout, dict));
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    Scorer scorer;
+
+    GesturePath gesture = generator.getIdealPath("hello");
+    GesturePath ideal = generator.getIdealPath("world");
+    std::vector<float> gx, gy;
+    for (const auto& p : gesture.points) { gx.push_back(p.x); gy.push_back(p.y); }
+
+    TemplateView view = store.getTemplate(3);  // "world"
+    ASSERT_TRUE(view.isValid());
+    EXPECT_EQ(scorer.computeDTWDistance(gx.data(), gy.data(), view.x, view.y),
+              scorer.computeDTWDistance(gesture, ideal));
+}
+
+TEST_F(TemplateStoreTest, SignaturesSummarizeTemplates) {
+    TemplateStore store;
+    ASSERT_TRUE(store.compile(layout, dict));
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+
+    for (uint32_t i = 0; i < store.size(); ++i) {
+        const PathSignature* sig = store.getSignature(i);
+        TemplateView view = store.getTemplate(i);
+        ASSERT_EQ(sig != nullptr, view.isValid());
+        if (!sig) continue;
+        for (int k = 0; k < SIGNATURE_POINTS; ++k) {
+            EXPECT_EQ(sig->x[k], view.x[k * SIGNATURE_STRIDE]);
+            EXPECT_EQ(sig->y[k], view.y[k * SIGNATURE_STRIDE]);
+        }
+        EXPECT_FLOAT_EQ(sig->arcLength, generator.getIdealPath(dict.getEntry(i).word).totalArcLength);
+    }
+
+    // "hello": h, e, l, o
+    const uint32_t hello = (1u << ('h' - 'a')) | (1u << ('e' - 'a')) |
+                           (1u << ('l' - 'a')) | (1u << ('o' - 'a'));
+    ASSERT_NE(store.getSignature(0), nullptr);
+    EXPECT_EQ(store.getSignature(0)->letterMask, hello);
+    EXPECT_EQ(store.getSignature(2), nullptr);  // "a" has no template
+
+    // Signatures are rebuilt on load
+    ASSERT_TRUE(store.save(cacheFile));
+    TemplateStore loaded;
+    ASSERT_TRUE(loaded.load(cacheFile, layout, dict));
+    for (uint32_t i = 0; i < store.size(); ++i) {
+        const PathSignature* a = store.getSignature(i);
+        const PathSignature* b = loaded.getSignature(i);
+        ASSERT_EQ(a != nullptr, b != nullptr);
+        if (!a) continue;
+        EXPECT_EQ(a->x, b->x);
+        EXPECT_EQ(a->y, b->y);
+        EXPECT_EQ(a->arcLength, b->arcLength);
+        EXPECT_EQ(a->letterMask, b->letterMask);
+    }
+}
+
+TEST_F(TemplateStoreTest, QuantizedTemplatesStayWithinBound) {
+    TemplateStore exact;
+    ASSERT_TRUE(exact.compile(layout, dict));
+    Scorer scorer;
+    DTWQuery query;
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    ASSERT_TRUE(scorer.prepareQuery(generator.getIdealPath("hello"), query));
+
+    const std::pair<TemplatePrecision, float> formats[] = {
+        {TemplatePrecision::UINT16, TEMPLATE_UINT16_SCALE},
+        {TemplatePrecision::UINT8, TEMPLATE_UINT8_SCALE},
+    };
+    for (const auto& format : formats) {
+        TemplateStore store;
+        ASSERT_TRUE(store.compile(layout, dict, format.first));
+        EXPECT_EQ(store.getPrecision(), format.first);
+        EXPECT_LT(store.memoryUsage(), exact.memoryUsage());
+
+        for (uint32_t i = 0; i < store.size(); ++i) {
+            TemplateView a = exact.getTemplate(i);
+            TemplateView q = store.getTemplate(i);
+            ASSERT_EQ(a.isValid(), q.isValid());
+            if (!q.isValid()) continue;
+            EXPECT_EQ(q.x, nullptr);
+
+            float qx[RESAMPLE_COUNT], qy[RESAMPLE_COUNT];
+            ASSERT_TRUE(q.decode(qx, qy));
+            for (int p = 0; p < RESAMPLE_COUNT; ++p) {
+                EXPECT_LE(std::fabs(qx[p] - a.x[p]), 0.5f / format.second + 1e-6f);
+                EXPECT_LE(std::fabs(qy[p] - a.y[p]), 0.5f / format.second + 1e-6f);
+            }
+            float dExact = scorer.computeDTWDistance(query, a.x, a.y, FLT_MAX);
+            float dQuant = scorer.computeDTWDistance(query, qx, qy, FLT_MAX);
+            EXPECT_LT(std::fabs(dQuant - dExact), 1.5f / format.second);
+            EXPECT_LE(scorer.lowerBound(query, qx, qy, FLT_MAX), dQuant);
+        }
+    }
+
+    float x[RESAMPLE_COUNT], y[RESAMPLE_COUNT];
+    EXPECT_FALSE(TemplateView().decode(x, y));
+}
+
+TEST_F(TemplateStoreTest, QuantizedSaveAndLoadRoundTrip) {
+    TemplateStore store;
+    ASSERT_TRUE(store.compile(layout, dict, TemplatePrecision::UINT16));
+    ASSERT_TRUE(store.save(cacheFile));
+
+    // The precision is part of the cache key
+    TemplateStore loaded;
+    EXPECT_FALSE(loaded.load(cacheFile, layout, dict));
+    EXPECT_FALSE(loaded.load(cacheFile, layout, dict, TemplatePrecision::UINT8));
+    ASSERT_TRUE(loaded.load(cacheFile, layout, dict, TemplatePrecision::UINT16));
+    EXPECT_EQ(loaded.getPrecision(), TemplatePrecision::UINT16);
+    for (uint32_t i = 0; i < store.size(); ++i) {
+        TemplateView a = store.getTemplate(i);
+        TemplateView b = loaded.getTemplate(i);
+        ASSERT_EQ(a.isValid(), b.isValid());
+        if (!a.isValid()) continue;
+        for (int p = 0; p < RESAMPLE_COUNT; ++p) {
+            EXPECT_EQ(a.x16[p], b.x16[p]);
+            EXPECT_EQ(a.y16[p], b.y16[p]);
+        }
+        EXPECT_EQ(store.getSignature(i)->x, loaded.getSignature(i)->x);
+    }
+}
+
+TEST_F(TemplateStoreTest, OtherPointCountsRoundTrip) {
+    // 40 points leave a partial vector block for the decoders
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+    generator.setResampleCount(40);
+    for (TemplatePrecision precision : {TemplatePrecision::FLOAT32, TemplatePrecision::UINT8}) {
+        TemplateStore store;
+        ASSERT_TRUE(store.compile(layout, dict, precision, 40));
+        EXPECT_EQ(store.getPointCount(), 40);
+        ASSERT_TRUE(store.save(cacheFile));
+
+        // The point count is part of the cache key
+        TemplateStore loaded;
+        EXPECT_FALSE(loaded.load(cacheFile, layout, dict, precision));
+        ASSERT_TRUE(loaded.load(cacheFile, layout, dict, precision, 40));
+        EXPECT_EQ(loaded.getPointCount(), 40);
+
+        for (uint32_t i = 0; i < store.size(); ++i) {
+            GesturePath ideal = generator.getIdealPath(dict.getEntry(i).word);
+            TemplateView view = loaded.getTemplate(i);
+            ASSERT_EQ(view.isValid(), ideal.isValid());
+            if (!view.isValid()) continue;
+            EXPECT_EQ(view.count, 40);
+            float x[40], y[40];
+            ASSERT_TRUE(view.decode(x, y));
+            for (int p = 0; p < 40; ++p) {
+                EXPECT_NEAR(x[p], ideal.points[p].x, 0.5f / TEMPLATE_UINT8_SCALE + 1e-6f);
+                EXPECT_NEAR(y[p], ideal.points[p].y, 0.5f / TEMPLATE_UINT8_SCALE + 1e-6f);
+            }
+            // Signatures still end on the last point
+            EXPECT_EQ(loaded.getSignature(i)->x[SIGNATURE_POINTS - 1], x[39]);
+        }
+    }
+
+    TemplateStore store;
+    EXPECT_FALSE(store.compile(layout, dict, TemplatePrecision::FLOAT32, MIN_RESAMPLE_COUNT - 1));
+    EXPECT_FALSE(store.compile(layout, dict, TemplatePrecision::FLOAT32, MAX_RESAMPLE_COUNT + 1));
+}
+
+TEST_F(TemplateStoreTest, SaveAndLoadRoundTrip) {
+    TemplateStore store;
+    ASSERT_TRUE(store.compile(layout, dict));
+    ASSERT_TRUE(store.save(cacheFile));
+
+    TemplateStore loaded;
+    ASSERT_TRUE(loaded.load(cacheFile, layout, dict));
+    EXPECT_EQ(loaded.size(), store.size());
+    EXPECT_EQ(loaded.getLayoutHash(), TemplateStore::layoutHash(layout));
+    for (uint32_t i = 0; i < store.size(); ++i) {
+        TemplateView a = store.getTemplate(i);
+        TemplateView b = loaded.getTemplate(i);
+        ASSERT_EQ(a.isValid(), b.isValid());
+        if (!a.isValid()) continue;
+        for (int p = 0; p < RESAMPLE_COUNT; ++p) {
+            EXPECT_EQ(a.x[p], b.x[p]);
+            EXPECT_EQ(a.y[p], b.y[p]);
+        }
+    }
+}
+
+TEST_F(TemplateStoreTest, LoadRejectsOtherLayout) {
+    TemplateStore store;
+    ASSERT_TRUE(store.compile(layout, dict));
+    ASSERT_TRUE(store.save(cacheFile));
+
+    KeyboardLayout moved = layout;
+    moved.keys[0].centerX += 1.0f;
+    EXPECT_NE(TemplateStore::layoutHash(moved), TemplateStore::layoutHash(layout));
+
+    TemplateStore loaded;
+    EXPECT_FALSE(loaded.load(cacheFile, moved, dict));
+    EXPECT_FALSE(loaded.isCompiled());
+
+    // Labels do not affect templates
+    KeyboardLayout relabeled = layout;
+    relabeled.keys[0].label = "?";
+    EXPECT_TRUE(loaded.load(cacheFile, relabeled, dict));
+}
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+#include <swipetype/UserDictionary.h>
+#include <swipetype/IdealPathGenerator.h>
+#include <swipetype/SwipeTypeTypes.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace swipetype;
+using namespace swipetype::test;
+
+class UserDictionaryTest : public ::testing::Test {
+protected:
+    std::string journalFile;
+
+    void SetUp() override {
+        char tmp[] = "/tmp/swipetype_user_XXXXXX";
+        int fd = mkstemp(tmp);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        journalFile = tmp;
+    }
+
+    void TearDown() override {
+        std::remove(journalFile.c_str());
+        std::remove((journalFile + ".tmp").c_str());
+    }
+
+    static std::vector<std::string> words(const UserDictionary& user, DictionaryIndexSpan span) {
+        std::vector<std::string> found;
+        for (uint32_t slot : span) found.emplace_back(user.getEntry(slot).word);
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+
+    size_t journalSize() const {
+        std::ifstream in(journalFile, std::ios::binary | std::ios::ate);
+        return static_cast<size_t>(in.tellg());
+    }
+};
+
+TEST_F(UserDictionaryTest, AddsRemovesAndBumpsWords) {
+    UserDictionary user;
+    EXPECT_FALSE(user.isOpen());
+    EXPECT_TRUE(user.addWord("Dettmer", 500, DICT_FLAG_PROPER_NOUN));
+    EXPECT_TRUE(user.addWord("swipe", 100));
+    EXPECT_EQ(user.size(), 2u);
+    EXPECT_TRUE(user.contains("Dettmer"));
+    EXPECT_FALSE(user.contains("dettmer"));  // exact bytes
+    EXPECT_EQ(user.getFrequency("Dettmer"), 500u);
+
+    EXPECT_TRUE(user.addWord("swipe", 300));  // sets, does not add
+    EXPECT_EQ(user.size(), 2u);
+    EXPECT_EQ(user.getFrequency("swipe"), 300u);
+
+    EXPECT_TRUE(user.bumpFrequency("swipe", 5));
+    EXPECT_EQ(user.getFrequency("swipe"), 305u);
+    EXPECT_TRUE(user.bumpFrequency("glide"));  // adds
+    EXPECT_EQ(user.getFrequency("glide"), 1u);
+    EXPECT_TRUE(user.bumpFrequency("swipe", std::numeric_limits<uint32_t>::max()));
+    EXPECT_EQ(user.getFrequency("swipe"), std::numeric_limits<uint32_t>::max());
+
+    EXPECT_TRUE(user.removeWord("Dettmer"));
+    EXPECT_FALSE(user.removeWord("Dettmer"));
+    EXPECT_FALSE(user.contains("Dettmer"));
+    EXPECT_EQ(user.getFrequency("Dettmer"), 0u);
+    EXPECT_EQ(user.size(), 2u);
+
+    EXPECT_FALSE(user.addWord("", 1));
+    EXPECT_FALSE(user.addWord(std::string(MAX_WORD_LENGTH + 1, 'a'), 1));
+    EXPECT_TRUE(user.addWord(std::string(MAX_WORD_LENGTH, 'a'), 1));
+}
+
+TEST_F(UserDictionaryTest, RevisionCountsChanges) {
+    UserDictionary user;
+    uint64_t revision = user.getRevision();
+    user.addWord("swipe", 10);
+    EXPECT_GT(user.getRevision(), revision);
+    revision = user.getRevision();
+    EXPECT_FALSE(user.removeWord("glide"));  // changes nothing
+    EXPECT_EQ(user.getRevision(), revision);
+    user.bumpFrequency("swipe");
+    EXPECT_GT(user.getRevision(), revision);
+    revision = user.getRevision();
+    user.setLayout(makeQwertyLayout());
+    EXPECT_GT(user.getRevision(), revision);
+}
+
+TEST_F(UserDictionaryTest, BucketsFollowChanges) {
+    UserDictionary user;
+    for (const char* w : {"hello", "Hero", "help", "world", "1st"}) user.addWord(w, 10);
+
+    using V = std::vector<std::string>;
+    EXPECT_EQ(words(user, user.getBucket('h', 'o')), V({"Hero", "hello"}));
+    EXPECT_EQ(words(user, user.getBucket('H', 'P')), V({"help"}));
+    EXPECT_EQ(words(user, user.getStartBucket('h')), V({"Hero", "hello", "help"}));
+    EXPECT_EQ(words(user, user.getStartBucket('1')), V({"1st"}));
+    EXPECT_EQ(user.getEntries().size(), 5u);
+
+    // Removing from the middle of a bucket moves its last slot into the gap
+    user.removeWord("hello");
+    EXPECT_EQ(words(user, user.getBucket('h', 'o')), V({"Hero"}));
+    EXPECT_EQ(words(user, user.getStartBucket('h')), V({"Hero", "help"}));
+    user.removeWord("Hero");
+    EXPECT_TRUE(user.getBucket('h', 'o').empty());
+
+    // Freed slots are reused
+    user.addWord("halo", 10);
+    user.addWord("hippo", 10);
+    EXPECT_EQ(words(user, user.getBucket('h', 'o')), V({"halo", "hippo"}));
+    EXPECT_EQ(user.getEntries().size(), 5u);
+    EXPECT_EQ(words(user, user.getEntries()), V({"1st", "halo", "help", "hippo", "world"}));
+
+    for (uint32_t slot : user.getBucket('h', 'o')) {
+        DictionaryEntry e = user.getEntry(slot);
+        EXPECT_EQ(e.frequency, 10u);
+    }
+}
+
+TEST_F(UserDictionaryTest, TemplatesMatchIdealPaths) {
+    KeyboardLayout layout = makeQwertyLayout();
+    IdealPathGenerator generator;
+    generator.setLayout(layout);
+
+    UserDictionary user;
+    user.addWord("hello", 10);
+    EXPECT_EQ(user.getLayoutHash(), 0u);
+    EXPECT_FALSE(user.getTemplate(user.getEntries()[0]).isValid());
+
+    user.setLayout(layout);
+    EXPECT_EQ(user.getLayoutHash(), TemplateStore::layoutHash(layout));
+    user.addWord("world", 10);  // generated on change
+    user.addWord("123", 10);    // no letter on the layout
+
+    for (uint32_t slot : user.getEntries()) {
+        DictionaryEntry e = user.getEntry(slot);
+        GesturePath path = generator.generatePath(e.word);
+        TemplateView t = user.getTemplate(slot);
+        ASSERT_EQ(t.isValid(), path.isValid()) << e.word;
+        if (!path.isValid()) continue;
+        for (size_t p = 0; p < RESAMPLE_COUNT; ++p) {
+            EXPECT_EQ(t.x[p], path.points[p].x);
+            EXPECT_EQ(t.y[p], path.points[p].y);
+        }
+    }
+}
+
+TEST_F(UserDictionaryTest, JournalReplaysChanges) {
+    {
+        UserDictionary user;
+        ASSERT_TRUE(user.open(journalFile));
+        EXPECT_TRUE(user.isOpen());
+        user.addWord("Dettmer", 500, DICT_FLAG_PROPER_NOUN);
+        user.addWord("swipe", 100);
+        user.bumpFrequency("swipe", 20);
+        user.bumpFrequency("glide", 3);
+        user.removeWord("glide");
+        EXPECT_EQ(user.getJournalRecordCount(), 5u);
+    }
+
+    UserDictionary user;
+    ASSERT_TRUE(user.open(journalFile));
+    EXPECT_EQ(user.size(), 2u);
+    EXPECT_EQ(user.getFrequency("swipe"), 120u);
+    EXPECT_EQ(user.getFrequency("Dettmer"), 500u);
+    EXPECT_EQ(user.getEntry(user.getBucket('d', 'r')[0]).flags, DICT_FLAG_PROPER_NOUN);
+    EXPECT_FALSE(user.contains("glide"));
+
+    // Changes after close() are not journaled
+    user.close();
+    EXPECT_EQ(user.getJournalRecordCount(), 0u);
+    user.addWord("later", 1);
+    UserDictionary again;
+    ASSERT_TRUE(again.open(journalFile));
+    EXPECT_FALSE(again.contains("later"));
+    EXPECT_EQ(again.size(), 2u);
+}
+
+TEST_F(UserDictionaryTest, TruncatedRecordIsDropped) {
+    {
+        UserDictionary user;
+        ASSERT_TRUE(user.open(journalFile));
+        user.addWord("hello", 10);
+        user.addWord("world", 20);
+    }
+    // Cut the last record short, as a crash mid-append would
+    const size_t full = journalSize();
+    ASSERT_EQ(truncate(journalFile.c_str(), static_cast<off_t>(full - 2)), 0);
+
+    UserDictionary user;
+    ASSERT_TRUE(user.open(journalFile));
+    EXPECT_TRUE(user.contains("hello"));
+    EXPECT_FALSE(user.contains("world"));
+    EXPECT_LT(journalSize(), full - 2);  // rewritten without the partial record
+
+    // New records land after the last good one
+    user.addWord("again", 5);
+    UserDictionary replayed;
+    ASSERT_TRUE(replayed.open(journalFile));
+    EXPECT_EQ(replayed.size(), 2u);
+    EXPECT_EQ(replayed.getFrequency("again"), 5u);
+}
+
+TEST_F(UserDictionaryTest, CompactKeepsOneRecordPerWord) {
+    UserDictionary user;
+    EXPECT_FALSE(user.compact());  // not open
+    ASSERT_TRUE(user.open(journalFile));
+    for (int i = 0; i < 50; ++i) user.bumpFrequency("swipe", 2);
+    user.addWord("gone", 1);
+    user.removeWord("gone");
+    EXPECT_EQ(user.getJournalRecordCount(), 52u);
+    const size_t before = journalSize();
+
+    ASSERT_TRUE(user.compact());
+    EXPECT_EQ(user.getJournalRecordCount(), 1u);
+    EXPECT_LT(journalSize(), before);
+
+    user.bumpFrequency("swipe", 1);  // still appends after compacting
+    EXPECT_EQ(user.getJournalRecordCount(), 2u);
+
+    UserDictionary replayed;
+    ASSERT_TRUE(replayed.open(journalFile));
+    EXPECT_EQ(replayed.size(), 1u);
+    EXPECT_EQ(replayed.getFrequency("swipe"), 101u);
+}
+
+TEST_F(UserDictionaryTest, RejectsForeignFiles) {
+    {
+        std::ofstream out(journalFile, std::ios::binary | std::ios::trunc);
+        out << "not a journal";
+    }
+    UserDictionary user;
+    user.addWord("kept", 1);
+    EXPECT_FALSE(user.open(journalFile));
+    EXPECT_EQ(user.getLastError().code, ErrorCode::DICT_CORRUPT);
+    EXPECT_FALSE(user.isOpen());
+    EXPECT_EQ(user.size(), 0u);
+
+    {
+        std::ofstream out(journalFile, std::ios::binary | std::ios::trunc);
+        const char header[8] = {'G', 'L', 'U', 'J', 9, 0, 0, 0};
+        out.write(header, sizeof(header));
+    }
+    EXPECT_FALSE(user.open(journalFile));
+    EXPECT_EQ(user.getLastError().code, ErrorCode::DICT_VERSION_MISMATCH);
+
+    EXPECT_FALSE(user.open("/nonexistent/dir/user.gluj"));
+    EXPECT_EQ(user.getLastError().code, ErrorCode::DICT_NOT_FOUND);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <swipetype/WorkerPool.h>
+#include <atomic>
+#include <vector>
+
+using namespace swipetype;
+
+TEST(WorkerPoolTest, ThreadCountIsClampedToOne) {
+    EXPECT_EQ(WorkerPool(0).threadCount(), 1);
+    EXPECT_EQ(WorkerPool(-3).threadCount(), 1);
+    EXPECT_EQ(WorkerPool(4).threadCount(), 4);
+}
+
+TEST(WorkerPoolTest, EveryChunkRunsExactlyOnce) {
+    WorkerPool pool(4);
+    for (size_t chunks : {0u, 1u, 3u, 4u, 17u, 1000u}) {
+        std::vector<std::atomic<int>> hits(chunks);
+        pool.run(chunks, [&](int worker, size_t chunk) {
+            EXPECT_GE(worker, 0);
+            EXPECT_LT(worker, pool.threadCount());
+            hits[chunk].fetch_add(1);
+        });
+        for (size_t c = 0; c < chunks; ++c) {
+            EXPECT_EQ(hits[c].load(), 1) << "chunk " << c << " of " << chunks;
+        }
+    }
+}
+
+TEST(WorkerPoolTest, PerWorkerStateNeedsNoLocking) {
+    WorkerPool pool(3);
+    std::vector<std::atomic<int>> busy(3);
+    std::vector<long> sums(3, 0);
+    std::atomic<int> overlaps{0};
+
+    pool.run(300, [&](int worker, size_t chunk) {
+        if (busy[worker].fetch_add(1) != 0) overlaps.fetch_add(1);
+        sums[worker] += static_cast<long>(chunk);
+        busy[worker].fetch_sub(1);
+    });
+
+    EXPECT_EQ(overlaps.load(), 0);
+    EXPECT_EQ(sums[0] + sums[1] + sums[2], 299L * 300L / 2);
+}
+
+TEST(WorkerPoolTest, SerialPoolRunsOnCallingThread) {
+    WorkerPool pool(1);
+    std::vector<size_t> order;
+    pool.run(5, [&](int worker, size_t chunk) {
+        EXPECT_EQ(worker, 0);
+        order.push_back(chunk);
+    });
+    EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2, 3, 4}));
+}